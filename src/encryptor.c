@@ -4,11 +4,22 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
-#include <time.h>
 
 #include "commons.h"
 #include "ciphers.h"
 #include "data_input.h"
+#include "engine.h"
+#include "server.h"
+#include "coproc.h"
+#include "bulk.h"
+#include "batch.h"
+#include "stream.h"
+#include "crack.h"
+#include "cpu.h"
+#include "budget.h"
+#include "history.h"
+#include "cache.h"
+#include "keyring.h"
 
 #define true 1
 #define false 0
@@ -18,177 +29,448 @@ typedef char *string;
 typedef const char *const_str;
 
 /**
- * Get the current system date as a string.
+ * Prepares the key entered by the user for the cipher (or takes the one picked from the
+ * keyring) - blocked, if asked for.
+ *
+ * @remarks
+ * 		Will force-stop the program if the key is invalid.
+ *
+ * @param prepared: Pointer to the key that is to be populated.
+ * @param data: Pointer to the user input.
+ */
+void prepare_key(struct cipher_key *prepared, const struct user_data *data) {
+	if (data->key_id != KEYRING_NONE)
+		// Prepared ahead of time - checked while reading the input.
+		*prepared = *keyring_find(data->key_id);
+	else if (!engine_prepare(prepared, data->cipher, data->cipher_key)) {
+		printf("\nError: Invalid key `%.*s`\n", data->cipher_key.length, data->cipher_key.data);
+		exit(-10);
+	}
+
+	if (data->rf_block != 0)
+		rf_prepare_blocked(&prepared->schedule.railfence, data->rf_block);
+}
+
+/**
+ * Accounts for the buffers of a single message against the memory budget - the message as
+ * entered, normalized, and its result are all held at once.
+ *
+ * @remarks
+ * 		Will force-stop the program if the message does not fit - the message is in memory
+ * 		already, as such it cannot be split up anymore.
+ *
+ * @param prepared: Pointer to the prepared key.
+ * @param data: Pointer to the user input.
+ */
+void reserve_message(const struct cipher_key *prepared, const struct user_data *data) {
+	unsigned long long needed = engine_footprint(prepared, data->cipher_message.length) + data->cipher_message.length;
+
+	if (!budget_reserve(needed)) {
+		printf(
+			"\nError: The message needs %llu bytes, over the memory budget of %llu bytes - "
+			"pipe it through `--stream` instead\n", needed, budget_limit()
+		);
+		exit(-10);
+	}
+}
+
+/**
+ * Reserves the matrix printed in verbose mode by railfence from the memory budget - it holds
+ * a character for every rail, at every position of the (padded) message.
+ *
+ * @param data: Pointer to the user input.
  *
  * @return
- * 	A string containing the system date in a pre-formatted manner.
+ * 		Unsigned integer containing the bytes reserved - to be given back using `budget_release`
+ * 		once the cipher has run. Zero if the matrix does not fit, after printing a note.
  */
-string get_date() {
-	// Getting an instance of the timer - will be used to fetch system time
-	time_t time_manager = time(NULL);
-
-	// Getting the local time as a structure - relative to epoc time.
-	struct tm time_container = *localtime(&time_manager);
-
-	// Creating string to store and return the result.
-	const unsigned int MAX_LENGTH = 20;
-	string result = (string) malloc(sizeof(char) * MAX_LENGTH);
-
-	// Formatting the string to contain the date.
-	snprintf(
-		result,
-		MAX_LENGTH,
-		"%02d/%02d/%02d",
-
-		// Adjusting the values to be human-friendly.
-		time_container.tm_mday,
-		time_container.tm_mon + 1,
-		time_container.tm_year + 1990
-	);
+unsigned long long rail_matrix_reserve(const struct user_data *data) {
+	struct cipher_key prepared;
+	prepare_key(&prepared, data);
+
+	unsigned long long rows = prepared.schedule.railfence.rows;
+	unsigned long long needed = rows * (data->processed_message.length + 2 * rows);
 
-	return result;
+	if (budget_reserve(needed))
+		return needed;
+
+	printf("\nNote: The rail matrix needs %llu bytes, over the memory budget - it is not printed\n", needed);
+	return 0;
 }
 
-string get_time() {
-	// Getting an instance of the timer - will be used to fetch system time
-	time_t time_manager = time(NULL);
-
-	// Getting the local time as a structure - relative to epoc time.
-	struct tm time_container = *localtime(&time_manager);
-
-	// Creating string to store and return the result.
-	const unsigned int MAX_LENGTH = 20;
-	string result = (string) malloc(sizeof(char) * MAX_LENGTH);
-
-	// Formatting the string to contain the current date and time.
-	snprintf(
-		result,
-		MAX_LENGTH,
-		"%02d:%02d:%02d",
-		time_container.tm_hour,
-		time_container.tm_min,
-		time_container.tm_sec
-	);
+/**
+ * Runs the message through a chain of ciphers (`--cipher=a,b,...`).
+ *
+ * @remarks
+ * 		Will force-stop the program if the keys are invalid, or the message cannot be ciphered.
+ *
+ * @param data: Pointer to the user input.
+ *
+ * @return
+ * 		Span over a new string containing the result.
+ */
+struct span run_chain(const struct user_data *data) {
+	struct cipher_chain chain;
+	if (!engine_prepare_chain(&chain, data->chain, data->stages, data->cipher_key)) {
+		printf("\nError: Invalid keys `%.*s` for the chain\n", data->cipher_key.length, data->cipher_key.data);
+		exit(-10);
+	}
 
-	return result;
+	unsigned int size = engine_chain_into(&chain, data->encrypt, NULL, 0, data->processed_message);
+	if (size == CIPHER_INVALID) {
+		printf("\nError: The message cannot be ciphered by this chain\n");
+		exit(-10);
+	}
+
+	string result = (string) malloc(size + 1);
+	return make_span(result, engine_chain_into(&chain, data->encrypt, result, size + 1, data->processed_message));
 }
 
-int main(int argc, string *argv) {
-	// Opening a file to dump the output - the file will be stored along with its
-	// executable.
-	FILE *file = fopen("usage_logs.txt", "a");
-	if (file == NULL)
-		printf(
-			"\n\nError: Ran into unexpected error while attempting "
-			"to open a connection to the log file\n\n"
+/**
+ * Runs the (processed) message through the engine - for railfence (unless its matrix is
+ * printed), autokey and the columnar transpositions, whose formatting is restored while
+ * printing.
+ *
+ * @remarks
+ * 		Will force-stop the program if the key is invalid, the message does not fit in the
+ * 		memory budget, or a message being decrypted is not padded.
+ *
+ * @param data: Pointer to the user input.
+ *
+ * @return
+ * 		Span over a new string containing the result.
+ */
+struct span run_prepared(const struct user_data *data) {
+	struct cipher_key prepared;
+	prepare_key(&prepared, data);
+	reserve_message(&prepared, data);
+
+	unsigned int size = engine_run_into(&prepared, data->encrypt, NULL, 0, data->processed_message);
+
+	if (size == CIPHER_INVALID && data->cipher == AUTOKEY) {
+		printf("\nError: Only alphabets can be ciphered with `autokey`.\n");
+		exit(-10);
+	}
+
+	if (size == CIPHER_INVALID) {
+		// Otherwise only railfence runs through here - and only a message without the padding
+		// it is ciphered with fails.
+		printf("\n\nError: Invalid input detected. \n\n\tThe input string has "
+			   "incorrect padding \n\tAre you sure the input is correct?\n\n");
+		exit(-10);
+	}
+
+	string result = (string) malloc(size + 1);
+	return make_span(result, engine_run_into(&prepared, data->encrypt, result, size + 1, data->processed_message));
+}
+
+/**
+ * Runs the message through a cipher that works within its own blocks (play-fair, hill
+ * cipher) - straight from the message as entered, with its formatting restored.
+ *
+ * @remarks
+ * 		Will force-stop the program if the key is invalid, or the message cannot be ciphered.
+ *
+ * @param data: Pointer to the user input.
+ *
+ * @return
+ * 		Span over a new string containing the (formatted) result.
+ */
+struct span run_restored(const struct user_data *data) {
+	struct cipher_key prepared;
+	prepare_key(&prepared, data);
+	reserve_message(&prepared, data);
+
+	unsigned int capacity = engine_run_restored(&prepared, data->encrypt, NULL, 0, data->cipher_message);
+
+	string result = (string) malloc(capacity + 1);
+	unsigned int length = engine_run_restored(&prepared, data->encrypt, result, capacity + 1, data->cipher_message);
+
+	if (length == CIPHER_INVALID) {
+		// Only decrypting with a key that cannot be inverted fails - or, with `hill95`, a
+		// message holding characters that cannot be printed.
+		if (data->cipher == HILL95)
+			printf("\nError: Only printable characters can be ciphered with `hill95`.\n");
+		else
+			printf(
+				"\nError: The key `%.*s` cannot be inverted (Hill Cipher).\n",
+				data->processed_key.length, data->processed_key.data
+			);
+		exit(-10);
+	}
+
+	return make_span(result, length);
+}
+
+/**
+ * Checks if the message runs straight from the message as entered, with its formatting
+ * restored (see `run_restored`).
+ *
+ * @remarks
+ * 		Unless each step is to be printed, block ciphers run straight over the message as
+ * 		entered - normalized, ciphered and restored in one pass. The alphanumeric play-fair,
+ * 		the byte-oriented hill ciphers, the Vigenère family and the substitution ciphers
+ * 		have no verbose mode. Autokey reads the plaintext as its key, and the columnar
+ * 		transpositions move the letters across the whole message - they run over the
+ * 		processed message instead, like chains.
+ *
+ * @param data: Pointer to the user input.
+ *
+ * @return
+ * 		Boolean indicating if the result is restored while ciphering.
+ */
+bool runs_restored(const struct user_data *data) {
+	if (data->stages > 1 || data->cipher == AUTOKEY || data->cipher == COLUMNAR || data->cipher == DOUBLE_COLUMNAR)
+		return false;
+
+	return data->cipher == PLAYFAIR6 || data->cipher == HILL256 || data->cipher == HILL95 ||
+		(data->cipher >= VIGENERE && data->cipher <= KEYWORD) ||
+		(!data->verbose && (data->cipher == PLAYFAIR || data->cipher == HILL_CIPHER));
+}
+
+/**
+ * Prints the result of a cipher with the formatting of the original message restored.
+ *
+ * @remarks
+ * 		Since the original message loses its formatting before being ciphered (spaces being
+ * 		removed, capitals being lowered), the appropriate changes are undone while printing.
+ *
+ * @param original: Span containing the message as entered by the user.
+ * @param result: Span containing the result of the cipher.
+ */
+void print_restored(struct span original, struct span result) {
+	unsigned int counter = 0;
+
+	for (unsigned int i = 0; counter < result.length; i++)
+		putchar(
+			(i < original.length) ?
+			isalpha(original.data[i]) ?
+			(isupper(original.data[i]) ? toupper(result.data[counter++]) : result.data[counter++]) :
+			original.data[i] : result.data[counter++]
 		);
+}
 
+int main(int argc, string *argv) {
 	// Declaring a structure to accept/process user input.
 	struct user_data data;
 
 	// Reading user input - either from stdin, or in interactive mode with the user.
 	populate_data(&data, argc, argv);
 
+	// Selecting the kernels for the processor (or the instruction set forced) before anything
+	// is ciphered.
+	enum isa isa = (data.force_isa.data != NULL) ? map_isa(data.force_isa) : ISA_UNDEFINED;
+	if (!cpu_dispatch(isa)) {
+		printf("\nError: The processor does not support `%.*s`\n", data.force_isa.length, data.force_isa.data);
+		return -10;
+	}
+
+	if (data.kernels) {
+		cpu_report();
+		return 0;
+	}
+
+	budget_set(data.max_memory);
+
+	// In daemon (and co-process) mode, the program keeps answering requests until it is
+	// stopped - individual requests are not logged.
+	if (data.serve_path.data != NULL)
+		return serve(data.serve_path);
+
+	if (data.coproc)
+		return coproc_run();
+
+	if (data.history)
+		return history_query(data.history_days, (data.cipher == CIPHER_UNSET) ? UNDEFINED : data.cipher);
+
+	// In crack mode, the best candidates are printed instead of a single result.
+	if (data.crack) {
+		struct crack_options options;
+		options.top = data.top;
+		options.threads = data.threads;
+		options.max_rails = data.max_rails;
+		options.rounds = data.rounds;
+		options.seed = data.seed;
+		options.corpus = data.corpus;
+		options.ngrams = data.ngrams;
+		options.known = data.known;
+
+		switch (data.cipher) {
+			case PLAYFAIR:
+				return crack_play_fair(data.processed_message, &options);
+
+			case RAILFENCE:
+				return crack_railfence(data.processed_message, &options);
+
+			case HILL_CIPHER:
+				return crack_hill(data.processed_message, &options);
+
+			default:
+				printf("\nError: Cracking is not supported for this cipher\n");
+				return -10;
+		}
+	}
+
+	// In bulk mode every file in the input directory is ciphered, in batch mode every line
+	// of stdin, and in stream mode all of stdin at once - the output is the record of the run,
+	// as such nothing is logged.
+	if (data.bulk_input.data != NULL || data.batch || data.stream) {
+		struct cipher_key prepared;
+		prepare_key(&prepared, &data);
+
+		if (data.batch)
+			return batch_run(&prepared, data.encrypt, data.threads);
+
+		if (data.stream)
+			return data.pipeline ? stream_run_pipelined(&prepared, data.encrypt) : stream_run(&prepared, data.encrypt);
+
+		return bulk_run(data.bulk_input, data.bulk_output, &prepared, data.encrypt, data.threads);
+	}
+
 	// Printing the input received so far as a part of the result.
-	printf("\nOriginal Key: `%s` \n\tProcessed Key: `%s`"
-		   "\n\nOriginal Message: \n\t%s \n\nProcessed Message: \n\t%s\n",
-		   data.cipher_key,
-		   data.processed_key,
-		   data.cipher_message,
-		   data.processed_message
+	printf("\nOriginal Key: `%.*s` \n\tProcessed Key: `%.*s`"
+		   "\n\nOriginal Message: \n\t%.*s \n\nProcessed Message: \n\t%.*s\n",
+		   data.cipher_key.length, data.cipher_key.data,
+		   data.processed_key.length, data.processed_key.data,
+		   data.cipher_message.length, data.cipher_message.data,
+		   data.processed_message.length, data.processed_message.data
 	);
 
-	string result = NULL;
-
-	// Depending on the values selected by the user, using the appropriate
-	// cipher algorithm with relevant data.
-	switch (data.cipher) {
-		case PLAYFAIR:
-			if (data.encrypt) {
-				result = crypt_play_fair(
-					data.processed_message,
-					data.processed_key,
-					data.verbose
-				);
-			} else {
-				result = decrypt_play_fair(
-					data.processed_message,
-					data.processed_key,
-					data.verbose
-				);
-			}
-
-			break;
-
-		case HILL_CIPHER:
-			if (data.encrypt) {
-				result = crypt_hill_cipher(
-					data.processed_message,
-					data.processed_key,
-					data.verbose
-				);
-			} else {
-				result = decrypt_hill_cipher(
-					data.processed_message,
-					data.processed_key,
-					data.verbose
-				);
-			}
-
-			break;
-
-		case RAILFENCE:
-			if (data.encrypt)
-				result = crypt_railfence(
-					data.processed_key,
-					data.processed_message,
-					data.verbose
-				);
-
-			else
-				result = decrypt_railfence(
-					data.processed_key,
-					data.processed_message,
-					data.verbose
-				);
-
-			break;
-
-		default:
-			printf("No state found in the main switch :(");
-			exit(-10);
+	struct span result;
+
+	// Boolean indicating if the result has its formatting restored already.
+	bool restored = runs_restored(&data);
+
+	// Results are cached under the message the ciphers read - as entered if its formatting
+	// is restored while ciphering, processed otherwise (see `cache.h`). Verbose runs print
+	// every step, as such always run the ciphers.
+	struct result_cache cache;
+	bool cached = data.cache_path.data != NULL && !data.verbose;
+
+	if (cached && !cache_open(&cache, data.cache_path, data.cache_size)) {
+		printf(
+			"\nNote: The cache `%.*s` could not be opened - ciphering without it\n",
+			data.cache_path.length, data.cache_path.data
+		);
+		cached = false;
+	}
+
+	struct cache_key key;
+	key.chain = data.chain;
+	key.stages = data.stages;
+	key.encrypt = data.encrypt;
+	key.rf_block = data.rf_block;
+	key.key = data.cipher_key;
+	key.message = restored ? data.cipher_message : data.processed_message;
+
+	bool hit = cached && cache_lookup(&cache, &key, &result);
+
+	if (hit) {
+		// Ciphered before - nothing left to run.
+	} else if (data.stages > 1) {
+		// A chain of ciphers runs through the engine.
+		result = run_chain(&data);
+	} else if (data.cipher == AUTOKEY || data.cipher == COLUMNAR || data.cipher == DOUBLE_COLUMNAR) {
+		// Autokey and the columnar transpositions run over the processed message, and have
+		// their formatting restored while printing. No verbose mode.
+		result = run_prepared(&data);
+	} else if (restored) {
+		result = run_restored(&data);
+	} else {
+		// Bytes reserved for the rail matrix, if it is printed.
+		unsigned long long matrix_bytes = 0;
+
+		// Depending on the values selected by the user, using the appropriate
+		// cipher algorithm with relevant data.
+		switch (data.cipher) {
+			case PLAYFAIR:
+				if (data.encrypt) {
+					result = crypt_play_fair(
+						data.processed_message,
+						data.processed_key,
+						data.verbose
+					);
+				} else {
+					result = decrypt_play_fair(
+						data.processed_message,
+						data.processed_key,
+						data.verbose
+					);
+				}
+
+				break;
+
+			case HILL_CIPHER:
+				if (data.encrypt) {
+					result = crypt_hill_cipher(
+						data.processed_message,
+						data.processed_key,
+						data.verbose
+					);
+				} else {
+					result = decrypt_hill_cipher(
+						data.processed_message,
+						data.processed_key,
+						data.verbose
+					);
+				}
+
+				break;
+
+			case RAILFENCE:
+				if (data.rf_block != 0 || !data.verbose || (matrix_bytes = rail_matrix_reserve(&data)) == 0)
+					// Unless the rail matrix is to be printed, railfence runs through the engine -
+					// straight over the message, without the matrix. Blocked railfence has no
+					// verbose mode.
+					result = run_prepared(&data);
+
+				else if (data.encrypt)
+					result = crypt_railfence(
+						data.processed_message,
+						data.processed_key,
+						data.verbose
+					);
+
+				else
+					result = decrypt_railfence(
+						data.processed_message,
+						data.processed_key,
+						data.verbose
+					);
+
+				budget_release(matrix_bytes);
+				break;
+
+			default:
+				printf("No state found in the main switch :(");
+				exit(-10);
+		}
 	}
 
-	unsigned int counter = 0;
-	unsigned int len_message = strlen(data.cipher_message);
+	if (cached) {
+		if (!hit)
+			cache_store(&cache, &key, result);
 
-	// Printing the result. Since the original message loses its formatting before being
-	// ciphered (spaces being removed, capitals being lowered), undo the appropriate changes
-	// while printing the output string.
+		cache_close(&cache);
+	}
+
+	// Printing the result - with the formatting of the original message.
 	printf("\nCipher Result: \n\t");
-	for (unsigned int i = 0; result[counter] != '\0'; i++)
-		printf("%c",
-			   (i < len_message) ?
-			   isalpha(data.cipher_message[i]) ?
-			   (isupper(data.cipher_message[i]) ? toupper(result[counter++]) : result[counter++]) :
-			   data.cipher_message[i] : result[counter++]
-		);
+	if (restored)
+		fwrite(result.data, sizeof(char), result.length, stdout);
+	else
+		print_restored(data.cipher_message, result);
 
 	fflush(stdout);
 
-	// Logging the results of the current run into the log file.
-	if (file != NULL) {
-		fprintf(
-			file,
-			"%s %s \nOriginal Message: %s\nResult: %s\n\n",
-			get_date(),
-			get_time(),
-			data.cipher_message,
-			result
-		);
-
+	// Logging the results of the current run into the usage history (see `history.h`).
+	if (history_append(data.chain, data.stages, data.encrypt, data.cipher_message, result))
 		printf("\n\nLogged the result of the current run\n");
-	}
+	else
+		printf(
+			"\n\nError: Ran into unexpected error while attempting "
+			"to log the result into the usage history\n"
+		);
 
 	printf("\n\n");
 
@@ -0,0 +1,15 @@
+// Header exposing the batch mode - ciphers every line read from stdin on a pool of
+// threads, writing the results to stdout in the same order as the lines.
+
+#ifndef __encryptor_batch
+#define __encryptor_batch
+
+#include "commons.h"
+#include "engine.h"
+
+typedef short bool;
+
+int batch_run(const struct cipher_key *prepared, bool encrypt, unsigned int threads);
+
+
+#endif //__encryptor_batch
@@ -0,0 +1,28 @@
+// Header exposing the memory budget (`--max-memory`). The modes that hold whole messages in
+// memory (bulk, batch, single messages) account for their buffers here before creating them,
+// and run a job in chunks instead - or wait for other jobs to finish - when the buffers would
+// take the program past the budget.
+
+#ifndef __encryptor_budget
+#define __encryptor_budget
+
+#include "commons.h"
+
+typedef short bool;
+
+void budget_set(unsigned long long limit);
+
+unsigned long long budget_limit();
+
+bool budget_fits(unsigned long long bytes);
+
+bool budget_reserve(unsigned long long bytes);
+
+void budget_release(unsigned long long bytes);
+
+unsigned long long budget_peak();
+
+unsigned long long parse_size(struct span text);
+
+
+#endif //__encryptor_budget
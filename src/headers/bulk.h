@@ -0,0 +1,19 @@
+// Header exposing the bulk mode - ciphers every file in a directory, writing the results
+// to another directory. Reads and writes are batched through `io_uring` (with a plain
+// read/write fallback where it is not available).
+
+#ifndef __encryptor_bulk
+#define __encryptor_bulk
+
+#include "commons.h"
+#include "engine.h"
+
+typedef short bool;
+
+int bulk_run(
+	struct span input_dir, struct span output_dir, const struct cipher_key *prepared, bool encrypt,
+	unsigned int threads
+);
+
+
+#endif //__encryptor_bulk
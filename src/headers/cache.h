@@ -0,0 +1,130 @@
+// Header exposing the result cache (`--cache`) - the results of the messages ciphered from the
+// command-line are kept in a file, found by a hash of what went into them (the ciphers, the
+// direction, the key and the message), so that a message ciphered again is answered without
+// running the ciphers.
+//
+// The file is mapped into memory, and holds:
+//  a `cache_header`;
+//  a table of `cache_slot`s - open addressing, a key is looked for in the `CACHE_PROBE` slots
+//  starting at the one its hash points to;
+//  the arena - the records, each a `cache_record` followed by the key, the message and the
+//  result, written one after the other around a ring. A record is lost once the ring comes
+//  back over it - the file never grows past the size it was created with.
+//
+// Any number of processes can share a cache - lookups hold a shared lock on the file, and
+// stores an exclusive one. All the fields are in the byte order of the machine.
+
+#ifndef __encryptor_cache
+#define __encryptor_cache
+
+#include <stdint.h>
+
+#include "commons.h"
+
+typedef short bool;
+
+// Marks the start of the file, and of every record - and the version of their layout.
+#define CACHE_MAGIC 0x31484352u
+
+// Size of a cache created without `--cache-size`, and the smallest one allowed.
+#define CACHE_DEFAULT_SIZE (64u << 20)
+#define CACHE_MIN_SIZE (64u << 10)
+
+// Number of slots a key can be found in - past the one its hash points to.
+#define CACHE_PROBE 8
+
+/**
+ * Header at the start of the file.
+ */
+struct cache_header {
+	// A value of `CACHE_MAGIC`.
+	uint32_t magic;
+
+	// Number of slots in the table.
+	uint32_t slots;
+
+	// Number of bytes in the arena.
+	uint64_t arena;
+
+	// Number of bytes ever written to the arena - the next record goes at this position,
+	// modulo the size of the arena.
+	uint64_t head;
+};
+
+/**
+ * Slot of the table - points to a record.
+ */
+struct cache_slot {
+	// Hash of the key the record is for - zero if the slot has never been used.
+	uint64_t hash;
+
+	// Position the record was written at (see `cache_header.head`) - the record is gone once
+	// the head has moved an arena past it.
+	uint64_t position;
+};
+
+/**
+ * Header of a record in the arena.
+ */
+struct cache_record {
+	// A value of `CACHE_MAGIC`.
+	uint32_t magic;
+
+	// Number of characters following the header - the key, the message, then the result.
+	uint32_t key_length;
+	uint32_t message_length;
+	uint32_t result_length;
+
+	// Hash of the key the record is for.
+	uint64_t hash;
+
+	// Size of the blocks railfence was run over - zero for the complete message.
+	uint32_t rf_block;
+
+	// Boolean indicating if the message was encrypted (or decrypted).
+	uint8_t encrypt;
+
+	// Number of ciphers the message was run through, and the ciphers - values of `enum crypt`.
+	uint8_t stages;
+	uint8_t chain[CHAIN_MAX];
+
+	uint8_t reserved[2];
+};
+
+/**
+ * What a result depends on - the key a result is stored and looked up under.
+ */
+struct cache_key {
+	const enum crypt *chain;
+	unsigned int stages;
+	bool encrypt;
+	unsigned int rf_block;
+
+	// Span containing the key, as entered by the user.
+	struct span key;
+
+	// Span containing the message - as the ciphers read it.
+	struct span message;
+};
+
+/**
+ * A cache opened by the program.
+ */
+struct result_cache {
+	int fd;
+
+	// The file, mapped into memory - and its size.
+	unsigned char *base;
+	unsigned long long size;
+};
+
+bool cache_open(struct result_cache *cache, struct span path, unsigned long long size);
+
+bool cache_lookup(struct result_cache *cache, const struct cache_key *key, struct span *result);
+
+bool cache_store(struct result_cache *cache, const struct cache_key *key, struct span result);
+
+void cache_close(struct result_cache *cache);
+
+
+#endif //__encryptor_cache
@@ -2,6 +2,19 @@
 // algorithms available in the program. Used to reveal only a select amount of
 // methods to the rest of the program while isolating the rest of it inside the
 // source files.
+//
+// Each cipher has two flavours of entry points - the plain variant returns a new
+// string (created using `malloc`), while the `_into` variant writes the result into
+// a buffer owned by the caller and returns the length of the result. Passing a null
+// (or small) buffer to an `_into` variant writes nothing and returns the size needed.
+//
+// Messages and keys are passed around as spans (see `commons.h`) - no method relies on
+// the string terminator to find the end of its input.
+//
+// Keys can also be prepared once into a schedule (`*_prepare`), and used with the
+// `*_run_into` methods any number of times - these never print anything, never exit the
+// program, and do not touch any global state. The `*_run_slice` methods run a cipher over
+// a part of a message, so that a large message can be split across threads.
 
 #ifndef __encryptor_ciphers
 #define __encryptor_ciphers
@@ -13,20 +26,331 @@ typedef short bool;
 typedef char *string;
 typedef const char *const_str;
 
+#include "commons.h"
+#include "cpu.h"
 
-string crypt_play_fair(string message, string key, bool verbose);
+// Value returned by the `_run_into` methods in case the message cannot be ciphered with
+// the key supplied (for example, decrypting with a key that has no inverse).
+#define CIPHER_INVALID ((unsigned int) -1)
 
-string decrypt_play_fair(string message, string key, bool verbose);
+// Length of edge of a single side in the play-fair key matrix.
+#define PF_MATRIX_EDGE 5
 
-string crypt_hill_cipher(string message, string key, bool verbose);
+// Length of edge of the key matrix of the alphanumeric play-fair (`playfair6`) - holds
+// every alphabet (including `j`) along with the digits.
+#define PF6_MATRIX_EDGE 6
 
-string decrypt_hill_cipher(string message, string key, bool verbose);
+// The size of the hill cipher key matrix - a size of three forms a `trigraph`.
+#define HC_MATRIX_SIZE 3
 
-void validate_key_railfence(string key);
+// Moduli of the byte-oriented hill ciphers - over every byte (`hill256`), and over the
+// printable characters, from a space to a tilde (`hill95`).
+#define HC_BYTES 256
+#define HC_PRINTABLE 95
 
-string crypt_railfence(string key, string message, bool verbose);
+// Longest key taken by the Vigenère family - the period of the periodic ciphers, and the
+// primer of autokey.
+#define VG_KEY_MAX 256
 
-string decrypt_railfence(string key, string message, bool verbose);
+// Number of characters the Vigenère kernels cipher at once - one per lane of a vector,
+// sized for AVX-512.
+#define VG_LANES 64
+
+// Size of the tables of the substitution ciphers - the alphabets, padded to two vectors of
+// 16 entries (see `sb_schedule`).
+#define SB_TABLE 32
+
+// Longest key of the columnar transpositions - each letter is a column.
+#define CT_KEY_MAX 256
+
+// Marks a lane of a transposition made of a single column (see `tp_layout`).
+#define TP_NONE ((unsigned long long) -1)
+
+
+/**
+ * Prepared form of a play-fair key. Populated once from the key, and can then be used
+ * (read-only) to cipher any number of messages - from any number of threads.
+ */
+struct pf_schedule {
+	// Length of the edge of the matrix - `PF_MATRIX_EDGE`, or `PF6_MATRIX_EDGE` for the
+	// alphanumeric variant.
+	unsigned int edge;
+
+	// The key matrix formed from the key and the remaining characters - only the first
+	// `edge` rows and columns are used.
+	char matrix[PF6_MATRIX_EDGE][PF6_MATRIX_EDGE];
+
+	// Position of each character in the matrix (as `row * edge + column`), indexed by the
+	// character itself - -1 if the character is missing from the matrix.
+	signed char position[256];
+};
+
+/**
+ * Prepared form of a hill cipher key - contains the key matrix and its inverse, both
+ * stored as numbers in the range `[0, modulus)`.
+ */
+struct hc_schedule {
+	// The modulus the cipher works in - 26 for alphabets, `HC_BYTES` or `HC_PRINTABLE`
+	// for the byte-oriented variants.
+	unsigned int modulus;
+
+	unsigned char forward[HC_MATRIX_SIZE][HC_MATRIX_SIZE];
+
+	unsigned char inverse[HC_MATRIX_SIZE][HC_MATRIX_SIZE];
+
+	// Boolean indicating if the key matrix has an inverse - messages cannot be
+	// decrypted otherwise.
+	bool invertible;
+};
+
+/**
+ * A message ciphered along with others, each running in a lane of its own (see the
+ * `*_run_many` methods) - the messages are independent, and can use different keys.
+ */
+struct cipher_lane {
+	// The prepared key - a `pf_schedule` or an `hc_schedule`, depending on the method.
+	const void *schedule;
+
+	// Boolean indicating if the message is to be encrypted (or decrypted).
+	bool encrypt;
+
+	// Span containing the (normalized) message.
+	struct span message;
+
+	// Buffer in which the result is to be written - with room for the result (as sized by
+	// the `*_run_into` method of the cipher) and its terminator.
+	string dest;
+
+	// Length of the result, or `CIPHER_INVALID` if the message could not be ciphered -
+	// written once the lane is done.
+	unsigned int length;
+};
+
+/**
+ * Prepared form of a railfence key.
+ */
+struct rf_schedule {
+	// Number of rails (rows) the message is spread over.
+	unsigned int rows;
+
+	// Size of the blocks the zigzag runs over, one block at a time - zero to run over the
+	// complete message (see `rf_prepare_blocked`).
+	unsigned int block;
+};
+
+/**
+ * Prepared form of a key of the Vigenère family - Vigenère, Beaufort, variant Beaufort and
+ * autokey. Each of them shifts every letter of the message by the letter of the key at the
+ * same position - they only differ in the direction of the shift, and in where the key comes
+ * from once it runs out.
+ */
+struct vg_schedule {
+	// Length of the key - the periodic ciphers repeat it every `period` characters, autokey
+	// follows it with the plaintext itself.
+	unsigned int period;
+
+	// Boolean indicating if the key is only a primer (autokey).
+	bool autokey;
+
+	// Mask applied to the letters before being shifted - `0xFF` for Beaufort, which runs
+	// the alphabet backwards (see `_vg_step`), zero for everything else.
+	unsigned char reflect;
+
+	// Shift applied to each position of the key while encrypting, and while decrypting - in
+	// the range `[0, 26]`. Repeated past the end of the key, so that `VG_LANES` shifts can be
+	// read starting at any position of it.
+	unsigned char forward[VG_KEY_MAX + VG_LANES];
+	unsigned char inverse[VG_KEY_MAX + VG_LANES];
+};
+/**
+ * Prepared form of a key of the (monoalphabetic) substitution ciphers - Caesar, ROT13,
+ * Atbash, affine and keyword. Every one of them replaces each letter with another one,
+ * the same everywhere in the message, as such all of them come down to a table.
+ */
+struct sb_schedule {
+	// The letter each letter (from `a`, in order) is replaced with while encrypting, and
+	// while decrypting. The entries past the alphabet are unused.
+	char forward[SB_TABLE];
+	char inverse[SB_TABLE];
+};
+
+/**
+ * Prepared form of a key of the columnar transpositions - columnar transposition, and the
+ * double transposition (columnar transposition run twice, with a key of its own each time).
+ */
+struct ct_schedule {
+	// Number of keys - one, or two for the double transposition.
+	unsigned int keys;
+
+	// Length of each key - the number of columns the message is written into.
+	unsigned int width[2];
+
+	// The columns of each key in the order they are read - ranked by the letter of the key
+	// above them, and by position between equal letters.
+	unsigned char order[2][CT_KEY_MAX];
+};
+
+/**
+ * Layout of a transposition - the message is written row after row into a matrix of
+ * `width` columns (the last row can be short), and read back one lane after the other. A
+ * lane is a single column, or a pair of columns read alternately - a character from the
+ * first one, then from the second one, on every row.
+ *
+ * Columnar transposition reads every column on its own, in the order of its key - railfence
+ * writes every cycle of the zigzag on a row, and reads each rail as a pair of columns (the
+ * characters on the way down and on the way back up).
+ */
+struct tp_layout {
+	// Number of columns of the matrix.
+	unsigned long long width;
+
+	// Number of lanes the matrix is read through.
+	unsigned long long lanes;
+
+	// Maps a lane to its columns - the second one is `TP_NONE` for a lane of a single column.
+	void (*columns)(const void *context, unsigned long long lane, unsigned long long *first, unsigned long long *second);
+
+	// Passed on to `columns`.
+	const void *context;
+};
+
+
+void pf_prepare(struct pf_schedule *schedule, struct span key);
+
+void pf6_prepare(struct pf_schedule *schedule, struct span key);
+
+unsigned int pf_run_into(
+	const struct pf_schedule *schedule, bool encrypt, string dest, unsigned int dest_cap, struct span message
+);
+
+void pf_run_slice(
+	const struct pf_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+);
+
+void pf_run_many(struct cipher_lane *lanes, unsigned int count);
+
+void hc_prepare(struct hc_schedule *schedule, struct span key);
+
+bool hc_prepare_bytes(struct hc_schedule *schedule, struct span key, unsigned int modulus);
+
+bool hc_invert(const unsigned char matrix[HC_MATRIX_SIZE][HC_MATRIX_SIZE], unsigned char inverse[HC_MATRIX_SIZE][HC_MATRIX_SIZE]);
+
+bool hc_invert_mod(
+	const unsigned char matrix[HC_MATRIX_SIZE][HC_MATRIX_SIZE], unsigned char inverse[HC_MATRIX_SIZE][HC_MATRIX_SIZE],
+	unsigned int modulus
+);
+
+unsigned int hc_run_into(
+	const struct hc_schedule *schedule, bool encrypt, string dest, unsigned int dest_cap, struct span message
+);
+
+bool hc_run_slice(
+	const struct hc_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+);
+
+void hc_run_many(struct cipher_lane *lanes, unsigned int count);
+
+enum isa hc_select_kernel(enum isa isa);
+
+bool rf_prepare(struct rf_schedule *schedule, struct span key);
+
+void rf_prepare_blocked(struct rf_schedule *schedule, unsigned int block);
+
+unsigned int rf_run_into(
+	const struct rf_schedule *schedule, bool encrypt, string dest, unsigned int dest_cap, struct span message
+);
+
+void rf_run_slice(
+	const struct rf_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+);
+
+void rf_run_unpadded(unsigned int rows, bool encrypt, string dest, struct span message);
+
+void rf_decrypt_range(unsigned int rows, string dest, struct span cipher, unsigned int begin, unsigned int end);
+
+bool vg_prepare(struct vg_schedule *schedule, struct span key, enum crypt cipher);
+
+unsigned int vg_run_into(
+	const struct vg_schedule *schedule, bool encrypt, string dest, unsigned int dest_cap, struct span message
+);
+
+bool vg_run_slice(
+	const struct vg_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+);
+
+enum isa vg_select_kernel(enum isa isa);
+
+bool sb_prepare(struct sb_schedule *schedule, struct span key, enum crypt cipher);
+
+unsigned int sb_run_into(
+	const struct sb_schedule *schedule, bool encrypt, string dest, unsigned int dest_cap, struct span message
+);
+
+bool sb_run_slice(
+	const struct sb_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+);
+
+enum isa sb_select_kernel(enum isa isa);
+
+void tp_permute(
+	const struct tp_layout *layout, string dest, struct span source, unsigned int total_length, bool encrypt,
+	unsigned int begin, unsigned int end
+);
+
+bool ct_prepare(struct ct_schedule *schedule, struct span key, enum crypt cipher);
+
+unsigned int ct_run_into(
+	const struct ct_schedule *schedule, bool encrypt, string dest, unsigned int dest_cap, struct span message
+);
+
+void ct_run_slice(
+	const struct ct_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+);
+
+
+struct span crypt_play_fair(struct span message, struct span key, bool verbose);
+
+struct span decrypt_play_fair(struct span message, struct span key, bool verbose);
+
+unsigned int crypt_play_fair_into(
+	string dest, unsigned int dest_cap, struct span message, struct span key, bool verbose
+);
+
+unsigned int decrypt_play_fair_into(
+	string dest, unsigned int dest_cap, struct span message, struct span key, bool verbose
+);
+
+struct span crypt_hill_cipher(struct span message, struct span key, bool verbose);
+
+struct span decrypt_hill_cipher(struct span message, struct span key, bool verbose);
+
+unsigned int crypt_hill_cipher_into(
+	string dest, unsigned int dest_cap, struct span message, struct span key, bool verbose
+);
+
+unsigned int decrypt_hill_cipher_into(
+	string dest, unsigned int dest_cap, struct span message, struct span key, bool verbose
+);
+
+void validate_key_railfence(struct span key);
+
+struct span crypt_railfence(struct span message, struct span key, bool verbose);
+
+struct span decrypt_railfence(struct span message, struct span key, bool verbose);
+
+unsigned int crypt_railfence_into(
+	string dest, unsigned int dest_cap, struct span message, struct span key, bool verbose
+);
+
+unsigned int decrypt_railfence_into(
+	string dest, unsigned int dest_cap, struct span message, struct span key, bool verbose
+);
 
 
 #endif //__encryptor_ciphers
@@ -10,26 +10,54 @@
 
 typedef short bool;
 typedef char *string;
+typedef const char *const_str;
 
-extern bool compare(char *, char *, bool);
+/**
+ * A view over a run of characters - pairs a pointer with the number of characters it
+ * covers. Used to pass text around without relying on (or scanning for) the string
+ * terminator; the characters covered may contain null characters, and a span can
+ * point into the middle of a larger buffer.
+ */
+struct span {
+	// Pointer to the first character covered by the span.
+	string data;
+
+	// Number of characters covered by the span.
+	unsigned int length;
+};
+
+extern inline struct span make_span(string data, unsigned int length);
+
+extern inline struct span span_of(string data);
+
+extern bool compare(struct span, struct span, bool);
+
+extern inline pcre *regex_compile(const_str);
 
-extern inline pcre *regex_compile(char *);
+extern inline bool l_compare(struct span, const_str);
 
-extern inline bool l_compare(string, string);
+extern struct span convert_lower(struct span message);
 
-extern string convert_lower(string message);
+extern inline struct span gen_str(struct span);
 
-extern inline string gen_str(string);
+extern inline struct span raw_gen_str(struct span, unsigned int);
 
-extern inline string raw_gen_str(string, unsigned int);
+extern inline struct span gen_str_pad(struct span, unsigned int);
 
-extern inline string gen_str_pad(string, unsigned int);
+bool validate(const_str pattern, struct span message);
 
-bool validate(string pattern, string message);
+struct span extract_data(const_str pattern, struct span message);
 
-string extract_data(string pattern, string message);
+extern inline struct span scan_str(string destination, unsigned int capacity);
 
-extern inline string scan_str(string destination, unsigned int length);
+unsigned int normalize_into(string destination, struct span source);
+
+unsigned int normalize_alnum_into(string destination, struct span source);
+
+// Initial value to be used with `hash_span` (FNV-1a offset basis).
+#define HASH_SEED 0xcbf29ce484222325ULL
+
+extern inline unsigned long long hash_span(struct span data, unsigned long long seed);
 
 /**
  * An enum to define the types of ciphers being used. Will be used to keep a track of the cipher selected
@@ -39,15 +67,40 @@ extern inline string scan_str(string destination, unsigned int length);
  * 		If a new crypt technique is being added, the relevant changes are to be made in:
  * 		`commons.c/map_cipher`;
  * 		`data_input.c/interactive`;
- * 		`data_input.c/fetch_cli_args`
+ * 		`data_input.c/fetch_cli_args`;
+ * 		`engine.c` (every method switching over the cipher)
+ *
+ * 		New values go before `UNDEFINED` - the values are a part of the daemon protocol.
  */
 enum crypt {
 	PLAYFAIR,
 	HILL_CIPHER,
 	RAILFENCE,
+	PLAYFAIR6,
+	HILL256,
+	HILL95,
+	VIGENERE,
+	BEAUFORT,
+	VARIANT_BEAUFORT,
+	AUTOKEY,
+	CAESAR,
+	ROT13,
+	ATBASH,
+	AFFINE,
+	KEYWORD,
+	COLUMNAR,
+	DOUBLE_COLUMNAR,
 	UNDEFINED
 };
 
-extern inline enum crypt map_cipher(string cipher_name);
+// Marks a cipher that has not been picked yet - neither on the command line nor interactively.
+#define CIPHER_UNSET ((enum crypt) -2)
+
+// Longest chain of ciphers that can be run over a message in one go (`--cipher=a,b,...`).
+#define CHAIN_MAX 8
+
+extern inline enum crypt map_cipher(struct span cipher_name);
+
+const_str cipher_name(enum crypt cipher);
 
 #endif //__encryptor_commons
@@ -0,0 +1,11 @@
+// Header exposing the co-process mode - answers framed requests (see `protocol.h`) read
+// from stdin, writing the responses to stdout. Meant to be kept alive by another program,
+// talking to it over a pair of pipes.
+
+#ifndef __encryptor_coproc
+#define __encryptor_coproc
+
+int coproc_run();
+
+
+#endif //__encryptor_coproc
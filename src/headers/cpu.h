@@ -0,0 +1,40 @@
+// Header exposing the selection of cipher kernels at startup. Ciphers with SIMD kernels
+// keep a table of them - one per instruction set - and the best one the processor can run
+// is picked once, before anything is ciphered (see `cpu_dispatch`).
+
+#ifndef __encryptor_cpu
+#define __encryptor_cpu
+
+#include "commons.h"
+
+typedef short bool;
+typedef const char *const_str;
+
+/**
+ * Instruction sets the kernels are built for - each one includes the ones before it.
+ */
+enum isa {
+	// Whatever the compiler targets by default - SSE2 on x86-64.
+	ISA_GENERIC,
+	ISA_AVX2,
+
+	// AVX-512 with the byte and word instructions (AVX512BW) - the 32-bit hill lanes only
+	// use the foundation (AVX512F), the byte kernels need the rest.
+	ISA_AVX512,
+	ISA_UNDEFINED
+};
+
+enum isa cpu_detect();
+
+enum isa map_isa(struct span name);
+
+const_str isa_name(enum isa isa);
+
+bool cpu_dispatch(enum isa isa);
+
+enum isa normalize_select_kernel(enum isa isa);
+
+void cpu_report();
+
+
+#endif //__encryptor_cpu
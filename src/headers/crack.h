@@ -0,0 +1,88 @@
+// Header exposing the crack modes - recovering the key (and the plaintext) of a message
+// ciphered with an unknown key, by trying keys and ranking the results by how much they
+// look like English (see `scoring.h`).
+
+#ifndef __encryptor_crack
+#define __encryptor_crack
+
+#include <pthread.h>
+
+#include "commons.h"
+#include "cpu.h"
+#include "scoring.h"
+
+typedef short bool;
+typedef char *string;
+
+/**
+ * Options controlling a crack run - populated from the command-line.
+ */
+struct crack_options {
+	// Number of best candidates to be reported.
+	unsigned int top;
+
+	// Number of threads to be used - zero for one per processor.
+	unsigned int threads;
+
+	// Largest rail count to be tried with railfence - zero to pick a limit automatically.
+	unsigned int max_rails;
+
+	// Number of annealing chains run by the play-fair crack - zero to pick automatically.
+	unsigned int rounds;
+
+	// Seed of the random numbers used by the play-fair crack - zero to seed from the clock.
+	unsigned long long seed;
+
+	// Span containing the path of a text file to build the n-gram statistics from - null
+	// to use the built-in sample.
+	struct span corpus;
+
+	// Span containing the path of a file of n-gram tables (see `ngram_save`) - takes the
+	// place of the corpus. Null if not used.
+	struct span ngrams;
+
+	// Span containing plaintext known to be at the start of the message - empty if none.
+	struct span known;
+};
+
+/**
+ * A candidate key, along with the score of the plaintext it gives.
+ */
+struct crack_candidate {
+	unsigned long long key;
+	long long score;
+};
+
+/**
+ * The best candidates found so far, best first - shared by every thread of a crack run.
+ */
+struct crack_ranking {
+	pthread_mutex_t lock;
+
+	struct crack_candidate *items;
+	unsigned int count;
+	unsigned int capacity;
+
+	// Score a candidate has to beat to make it into a full ranking - read without the lock
+	// to skip most candidates cheaply.
+	long long threshold;
+};
+
+void ranking_init(struct crack_ranking *ranking, unsigned int capacity);
+
+void ranking_offer(struct crack_ranking *ranking, unsigned long long key, long long score);
+
+void ranking_free(struct crack_ranking *ranking);
+
+bool crack_table(struct ngram_table *table, unsigned int n, const struct crack_options *options);
+
+int crack_railfence(struct span cipher, const struct crack_options *options);
+
+int crack_hill(struct span cipher, const struct crack_options *options);
+
+enum isa hc_crack_select_kernel(enum isa isa);
+
+int crack_play_fair(struct span cipher, const struct crack_options *options);
+
+
+#endif //__encryptor_crack
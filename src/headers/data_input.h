@@ -5,6 +5,7 @@
 #define scan(c, limit) fgets(c, limit, stdin)
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <ctype.h>
 #include <math.h>
 
@@ -17,7 +18,7 @@ typedef short bool;
 typedef char *string;
 
 // Macro for fast creation of new strings.
-#define new_str(size) (string) malloc(size * sizeof(char))
+#define new_str(size) (string) malloc((size) * sizeof(char))
 
 // Size of a small string - 15 characters.
 #define STRING_SMALL 15
@@ -30,11 +31,11 @@ typedef char *string;
 
 
 struct user_data {
-	// String containing the message that is to be ciphered.
-	string cipher_message;
+	// Span containing the message that is to be ciphered.
+	struct span cipher_message;
 
-	// String containing the key that is to be used in the cipher
-	string cipher_key;
+	// Span containing the key that is to be used in the cipher
+	struct span cipher_key;
 
 	// Boolean indicating if the message is to be encrypted/decrypted.
 	// A value of `true` indicates that the message is to be encrypted.
@@ -46,14 +47,110 @@ struct user_data {
 
 	// The final version of the message string. Will be stripped of spaces,
 	// and any excess characters as needed by the algorithm.
-	string processed_message;
+	struct span processed_message;
 
 	// The final version of the cipher key, will be stripped of spaces and any
 	// excess characters as needed by the cipher algorithm.
-	string processed_key;
+	struct span processed_key;
 
-	// An enum indicating the type of cipher that is to be used.
+	// An enum indicating the type of cipher that is to be used - the first one, if a chain
+	// of ciphers is used.
 	enum crypt cipher;
+
+	// The ciphers the message is to be run through in turn, and their number. A single
+	// cipher unless a chain has been asked for - the key then holds one key per cipher,
+	// separated by commas.
+	enum crypt chain[CHAIN_MAX];
+	unsigned int stages;
+
+	// Span containing the path of the socket to listen on in daemon mode. Null unless
+	// the program is to run as a daemon - nothing else is asked from the user then.
+	struct span serve_path;
+
+	// Boolean indicating if the program is to answer requests framed the same way on stdin
+	// and stdout instead (co-process mode) - nothing else is asked from the user then either.
+	bool coproc;
+
+	// Spans containing the directories to read from, and write to, in bulk mode. Null
+	// unless the program is to cipher whole directories - no message is asked for then.
+	struct span bulk_input;
+	struct span bulk_output;
+
+	// Boolean indicating if every line read from stdin is to be ciphered (batch mode) - no
+	// message is asked for then.
+	bool batch;
+
+	// Boolean indicating if everything read from stdin is to be ciphered as one message, a
+	// chunk at a time (stream mode) - no message is asked for then either.
+	bool stream;
+
+	// Boolean indicating if stream mode is to run every step (reading, normalizing, ciphering,
+	// writing) on a thread of its own (`--pipeline`).
+	bool pipeline;
+
+	// Size of the blocks railfence runs over one at a time - zero to run over the complete
+	// message (see `rf_prepare_blocked`).
+	unsigned int rf_block;
+
+	// Span containing the instruction set the kernels are to be selected for (`--force-isa`) -
+	// null to use the best one the processor supports.
+	struct span force_isa;
+
+	// Boolean indicating if the kernels selected are to be reported, instead of ciphering.
+	bool kernels;
+
+	// Boolean indicating if the usage history is to be queried (`--history`), instead of
+	// ciphering - for the days in `history_days` (every run if empty), and only the runs
+	// using the cipher, if one was given.
+	bool history;
+	struct span history_days;
+
+	// Memory budget in bytes (`--max-memory`) - zero for no budget (see `budget.h`).
+	unsigned long long max_memory;
+
+	// Span containing the path of the result cache (`--cache`) - null unless results are to
+	// be cached - and the size it is created with, zero for the default (see `cache.h`).
+	struct span cache_path;
+	unsigned long long cache_size;
+
+	// Span containing the path of a keyring built by `encryptor_keyring` (`--keyring`) - null
+	// if not used - and the id of the key to be taken from it (`--key-id`) instead of a key
+	// being prepared, `KEYRING_NONE` if none (see `keyring.h`).
+	struct span keyring_path;
+	unsigned int key_id;
+
+	// Number of threads to be used where the work can be spread out - zero to use one
+	// thread for every processor.
+	unsigned int threads;
+
+	// Boolean indicating if the message is to be cracked - the key is unknown, and is
+	// searched for instead of being asked for.
+	bool crack;
+
+	// Number of best candidates reported by the crack mode.
+	unsigned int top;
+
+	// Largest rail count tried by the railfence crack - zero for the default.
+	unsigned int max_rails;
+
+	// Number of annealing chains run by the play-fair crack - zero for the default.
+	unsigned int rounds;
+
+	// Seed of the random numbers used by the play-fair crack (`--seed`) - zero to seed
+	// from the clock. A seeded run always reports the same squares.
+	unsigned long long seed;
+
+	// Span containing the path of a text file to build the n-gram statistics (used by the
+	// crack mode) from. Null to use the built-in sample.
+	struct span corpus;
+
+	// Span containing the path of a file of n-gram tables built by `encryptor_ngrams` -
+	// used instead of the corpus. Null if not used.
+	struct span ngrams;
+
+	// Span containing plaintext known to be at the start of the message being cracked -
+	// empty if none.
+	struct span known;
 };
 
 void populate_data(struct user_data *self, int argc, string *argv);
@@ -0,0 +1,99 @@
+// Header exposing the cipher engine - a single entry point to prepare a key for any of
+// the ciphers, and to run a cipher using a prepared key. Used wherever messages are
+// ciphered without a user sitting in front of the program (daemon mode and friends),
+// as such nothing in here prints to the console or force-stops the program.
+
+#ifndef __encryptor_engine
+#define __encryptor_engine
+
+#include "commons.h"
+#include "ciphers.h"
+
+typedef short bool;
+typedef char *string;
+
+/**
+ * A key prepared for one of the ciphers. Populating this is the expensive part of
+ * setting up a cipher - once prepared, it can be used (read-only) for any number of
+ * messages.
+ */
+struct cipher_key {
+	// The cipher this key has been prepared for.
+	enum crypt cipher;
+
+	// The prepared form of the key - the member in use depends on the cipher.
+	union {
+		struct pf_schedule playfair;
+		struct hc_schedule hill;
+		struct rf_schedule railfence;
+		struct vg_schedule vigenere;
+		struct sb_schedule substitution;
+		struct ct_schedule columnar;
+	} schedule;
+};
+
+/**
+ * A chain of prepared keys - a message is run through every stage in turn while being
+ * encrypted, and through the stages in reverse while being decrypted.
+ */
+struct cipher_chain {
+	// Number of stages in the chain.
+	unsigned int length;
+
+	struct cipher_key stages[CHAIN_MAX];
+};
+
+unsigned int engine_normalize_into(const struct cipher_key *prepared, string dest, struct span source);
+
+/**
+ * A cipher running over a message that arrives in chunks (see `engine_stream_update`).
+ */
+struct engine_stream {
+	const struct cipher_key *prepared;
+	bool encrypt;
+
+	// Characters of an incomplete block at the end of the last chunk - held back until the
+	// rest of the block arrives. Has room for one block.
+	string pending;
+	unsigned int pending_length;
+};
+
+bool engine_prepare(struct cipher_key *prepared, enum crypt cipher, struct span key);
+
+const struct cipher_key *engine_cached_key(enum crypt cipher, struct span key);
+
+unsigned int engine_run_into(
+	const struct cipher_key *prepared, bool encrypt, string dest, unsigned int dest_cap, struct span message
+);
+
+unsigned int engine_block_size(const struct cipher_key *prepared);
+
+unsigned long long engine_footprint(const struct cipher_key *prepared, unsigned int length);
+
+bool engine_run_slice(
+	const struct cipher_key *prepared, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+);
+
+unsigned int engine_run_restored(
+	const struct cipher_key *prepared, bool encrypt, string dest, unsigned int dest_cap, struct span text
+);
+
+void engine_run_many(const struct cipher_key *const *prepared, struct cipher_lane *lanes, unsigned int count);
+
+
+bool engine_prepare_chain(struct cipher_chain *chain, const enum crypt *ciphers, unsigned int count, struct span keys);
+
+unsigned int engine_chain_into(
+	const struct cipher_chain *chain, bool encrypt, string dest, unsigned int dest_cap, struct span message
+);
+
+
+bool engine_stream_init(struct engine_stream *stream, const struct cipher_key *prepared, bool encrypt);
+
+unsigned int engine_stream_update(struct engine_stream *stream, string dest, struct span chunk);
+
+unsigned int engine_stream_finish(struct engine_stream *stream, string dest);
+
+
+#endif //__encryptor_engine
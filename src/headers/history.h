@@ -0,0 +1,75 @@
+// Header exposing the usage history - every message ciphered from the command-line (or the
+// interactive mode) is appended to a binary log, indexed by time and by cipher, so that the
+// runs of a day (`--history`) can be found without reading through the whole log.
+//
+// The history lives in `HISTORY_DIR`:
+//  `records` holds the runs, one after the other - a `history_record` header followed by the
+//  message and the result;
+//  `index` holds a `history_entry` for every record, and `index.<cipher>` one for every record
+//  using that cipher (a chain is indexed under each of its ciphers) - in the order the records
+//  were written, as such sorted by time, and searched by halving.
+//
+// Nothing is ever rewritten - records and entries are only appended, under a lock on the
+// records, as such any number of runs can log at once. All the fields are in the byte order
+// of the machine.
+
+#ifndef __encryptor_history
+#define __encryptor_history
+
+#include <stdint.h>
+
+#include "commons.h"
+
+typedef short bool;
+
+// Directory holding the history - relative to where the program is run, like the text log
+// it replaces.
+#define HISTORY_DIR "usage_history"
+
+// Marks the start of every record - and the version of its layout.
+#define HISTORY_MAGIC 0x31524845u
+
+/**
+ * Header of a single run in the records.
+ */
+struct history_record {
+	// A value of `HISTORY_MAGIC`.
+	uint32_t magic;
+
+	// Number of characters following the header - the message, then the result.
+	uint32_t message_length;
+	uint32_t result_length;
+
+	// Boolean indicating if the message was encrypted (or decrypted).
+	uint8_t encrypt;
+
+	// Number of ciphers the message was run through, and the ciphers - values of `enum crypt`.
+	uint8_t stages;
+	uint8_t chain[CHAIN_MAX];
+
+	uint8_t reserved[2];
+
+	// Time of the run - seconds since the epoch.
+	int64_t time;
+};
+
+/**
+ * Entry of an index - where a record starts, and the time it is filed under.
+ */
+struct history_entry {
+	// Time of the run - or, if the clock went back between two runs, the time of the entry
+	// before it, so that the entries stay sorted.
+	int64_t time;
+
+	// Position of the record in the records.
+	uint64_t offset;
+};
+
+bool history_append(const enum crypt *chain, unsigned int stages, bool encrypt, struct span message, struct span result);
+
+bool history_parse_days(struct span days, int64_t *from, int64_t *to);
+
+int history_query(struct span days, enum crypt cipher);
+
+
+#endif //__encryptor_history
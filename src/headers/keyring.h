@@ -0,0 +1,51 @@
+// Header exposing the keyring - keys prepared ahead of time (see `encryptor_keyring`), saved
+// to a file that is mapped instead of preparing the keys on every run. A key is picked by its
+// id - its position in the keyring.
+//
+// The keys are stored as the program holds them in memory (`struct cipher_key`) - a keyring
+// can only be used by a build laying them out the same way, which is checked as it is loaded.
+
+#ifndef __encryptor_keyring
+#define __encryptor_keyring
+
+#include <stdint.h>
+
+#include "commons.h"
+#include "engine.h"
+
+typedef short bool;
+typedef const char *const_str;
+
+// Identifies a keyring (and the version of the format).
+#define KEYRING_MAGIC "KEYRNG01"
+
+// Marks a key id that has not been given.
+#define KEYRING_NONE ((unsigned int) -1)
+
+/**
+ * Header of a keyring. The keys follow the header, one after the other - the file is mapped
+ * as-is, the keys are never copied.
+ */
+struct keyring_file {
+	// Should be `KEYRING_MAGIC` - not terminated.
+	char magic[8];
+
+	// Size of a single key - should be the size of `struct cipher_key`.
+	uint32_t key_size;
+
+	// Number of keys.
+	uint32_t count;
+
+	uint8_t reserved[48];
+};
+
+bool keyring_load(const_str path);
+
+bool keyring_save(const struct cipher_key *keys, unsigned int count, const_str path);
+
+const struct cipher_key *keyring_find(unsigned int id);
+
+unsigned int keyring_count();
+
+
+#endif //__encryptor_keyring
@@ -0,0 +1,74 @@
+// Header defining the framing used to talk to a long-lived encryptor - over a socket (see
+// `server.c`), or over the stdin/stdout of a co-process (see `coproc.c`).
+// Kept free of any other project header, so that clients can include it on its own.
+//
+// Every request starts with a `frame_request` header, followed by the key and then the
+// message (`length` characters in total). Every response starts with a `frame_response`
+// header, followed by the result. Responses are sent in the same order as the requests,
+// as such a client can have any number of requests in flight on a single connection.
+//
+// All the fields are in the byte order of the machine - frames never leave the machine.
+
+#ifndef __encryptor_protocol
+#define __encryptor_protocol
+
+#include <stdint.h>
+
+// Request flag: encrypt the message (decrypt if missing).
+#define FRAME_ENCRYPT 0x01
+
+// Request flag: the message has already been normalized (lower-case alphabets only),
+// no need to strip it again.
+#define FRAME_NORMALIZED 0x02
+
+// Request flag: the key is the id of a key in the keyring the encryptor was started with
+// (`--keyring`, see `keyring.h`) - 4 characters, holding an unsigned 32-bit integer. The
+// key should have been prepared for the cipher of the request.
+#define FRAME_KEY_ID 0x04
+
+// Largest payload accepted in a single request (16 MiB).
+#define FRAME_MAX_LENGTH (16u << 20)
+
+/**
+ * Header of a request.
+ */
+struct frame_request {
+	// Number of characters following the header - the key and the message.
+	uint32_t length;
+
+	// Number of characters at the start of the payload that make up the key.
+	uint16_t key_length;
+
+	// The cipher to be used - a value of `enum crypt`.
+	uint8_t cipher;
+
+	// Combination of the `FRAME_*` request flags.
+	uint8_t flags;
+};
+
+/**
+ * Status of a response - anything other than `FRAME_OK` is sent without a payload.
+ */
+enum frame_status {
+	FRAME_OK,
+	FRAME_BAD_CIPHER,
+	FRAME_BAD_KEY,
+	FRAME_BAD_MESSAGE,
+	FRAME_TOO_LARGE
+};
+
+/**
+ * Header of a response.
+ */
+struct frame_response {
+	// Number of characters following the header - the result.
+	uint32_t length;
+
+	// A value of `enum frame_status`.
+	uint8_t status;
+
+	uint8_t reserved[3];
+};
+
+
+#endif //__encryptor_protocol
@@ -0,0 +1,38 @@
+// Header exposing a single-producer, single-consumer ring - a bounded queue of pointers
+// between two threads, without any lock. Only one thread may push to a ring, and only one
+// (other) thread may pop from it.
+
+#ifndef __encryptor_ring
+#define __encryptor_ring
+
+typedef short bool;
+
+// Size of a cache line - the ends of a ring are kept on lines of their own, so that the two
+// threads do not keep taking the same line from each other.
+#define RING_LINE 64
+
+/**
+ * A single-producer, single-consumer ring of pointers.
+ */
+struct spsc_ring {
+	// The items - `capacity` of them, always a power of two.
+	void **items;
+	unsigned int capacity;
+
+	// Number of items ever pushed - only written by the producer.
+	unsigned int tail __attribute__((aligned(RING_LINE)));
+
+	// Number of items ever popped - only written by the consumer.
+	unsigned int head __attribute__((aligned(RING_LINE)));
+};
+
+void ring_init(struct spsc_ring *ring, unsigned int capacity);
+
+void ring_push(struct spsc_ring *ring, void *item);
+
+void *ring_pop(struct spsc_ring *ring);
+
+void ring_free(struct spsc_ring *ring);
+
+
+#endif //__encryptor_ring
@@ -0,0 +1,81 @@
+// Header exposing the scoring of text - how much a run of characters looks like English,
+// measured using n-gram statistics. Used by the crack modes to rank candidate plaintexts.
+
+#ifndef __encryptor_scoring
+#define __encryptor_scoring
+
+#include <stddef.h>
+
+#include "commons.h"
+
+typedef short bool;
+typedef const char *const_str;
+
+// Longest n-gram supported.
+#define NGRAM_MAX 4
+
+// Scores are stored as `log10(probability) * NGRAM_SCALE`, rounded to an integer.
+#define NGRAM_SCALE 1000
+
+// Identifies a file of n-gram tables (and the version of the format).
+#define NGRAM_MAGIC "NGRAMS01"
+
+// Tables in a file start on a multiple of this many bytes - a cache line.
+#define NGRAM_ALIGN 64
+
+/**
+ * Log-probabilities of every n-gram of lower-case alphabets - a dense array of `26^n`
+ * entries, indexed by reading the n-gram as a number in base 26 (`a` being 0).
+ */
+struct ngram_table {
+	// Number of characters in an n-gram.
+	unsigned int n;
+
+	// Number of entries in the table - `26^n`.
+	unsigned int size;
+
+	// The scores, see `NGRAM_SCALE`.
+	const short *scores;
+
+	// The file the scores are mapped from (read-only), and its length - null if the
+	// scores were built in memory.
+	void *mapping;
+	size_t mapped;
+};
+
+/**
+ * Header of a file of n-gram tables (see `ngram_save`). The tables follow the header,
+ * each a dense array of `26^n` scores starting on a multiple of `NGRAM_ALIGN` - the file
+ * is mapped as-is, the scores are never copied.
+ */
+struct ngram_file {
+	// Should be `NGRAM_MAGIC` - not terminated.
+	char magic[8];
+
+	// Scale the scores are stored at - should be `NGRAM_SCALE`.
+	unsigned int scale;
+
+	unsigned int reserved;
+
+	// Offset of the table of each length from the start of the file - zero if the file has
+	// no table of that length.
+	unsigned long long offsets[NGRAM_MAX + 1];
+
+	// Pads the header to `NGRAM_ALIGN`.
+	unsigned char padding[NGRAM_ALIGN - 16 - 8 * (NGRAM_MAX + 1)];
+};
+
+bool ngram_build(struct ngram_table *table, unsigned int n, struct span corpus);
+
+bool ngram_load(struct ngram_table *table, unsigned int n, const_str path);
+
+bool ngram_save(const struct ngram_table *tables, unsigned int count, const_str path);
+
+void ngram_free(struct ngram_table *table);
+
+long long ngram_score(const struct ngram_table *table, struct span text);
+
+struct span scoring_sample();
+
+
+#endif //__encryptor_scoring
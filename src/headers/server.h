@@ -0,0 +1,37 @@
+// Header exposing the daemon mode - a long-lived process answering framed requests
+// (see `protocol.h`) over a unix domain socket.
+
+#ifndef __encryptor_server
+#define __encryptor_server
+
+#include "commons.h"
+#include "protocol.h"
+
+typedef short bool;
+typedef char *string;
+
+/**
+ * A growable buffer of frames - responses are appended to it as requests are handled,
+ * and it is drained as the responses are written out.
+ */
+struct frame_buffer {
+	// The characters in the buffer - created using `malloc`, grown as needed.
+	string data;
+
+	// Number of characters in the buffer.
+	unsigned int length;
+
+	// Number of characters the buffer can hold before it has to be grown.
+	unsigned int capacity;
+};
+
+void frame_reserve(struct frame_buffer *buffer, unsigned int extra);
+
+void handle_frame(const struct frame_request *request, struct span payload, struct frame_buffer *output);
+
+bool handle_buffered(struct frame_buffer *input, struct frame_buffer *output);
+
+int serve(struct span socket_path);
+
+
+#endif //__encryptor_server
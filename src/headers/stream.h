@@ -0,0 +1,17 @@
+// Header exposing the stream mode - ciphers everything read from stdin as a single message,
+// a chunk at a time, writing the result to stdout as it goes.
+
+#ifndef __encryptor_stream
+#define __encryptor_stream
+
+#include "commons.h"
+#include "engine.h"
+
+typedef short bool;
+
+int stream_run(const struct cipher_key *prepared, bool encrypt);
+
+int stream_run_pipelined(const struct cipher_key *prepared, bool encrypt);
+
+
+#endif //__encryptor_stream
@@ -0,0 +1,54 @@
+// Header exposing a work-stealing thread pool. Every worker owns a queue of work - it
+// takes work from its own end of the queue, and when it runs out, steals from the other
+// end of the queues of other workers. Large jobs are split in halves (on block boundaries)
+// as they are picked up, so an idle worker always has something left to steal.
+
+#ifndef __encryptor_thread_pool
+#define __encryptor_thread_pool
+
+typedef short bool;
+
+/**
+ * A job to be run on the pool - covers a range of `length` units (characters, usually),
+ * which can be split into parts that run on different workers.
+ *
+ * @remarks
+ * 		Meant to be embedded as the first member of a larger structure holding the data of
+ * 		the job - the pointer passed to the callbacks can then be cast back to it.
+ */
+struct pool_job {
+	// Runs the part `[begin, end)` of the job - called from any of the workers, possibly
+	// at the same time for different parts.
+	void (*run)(struct pool_job *job, unsigned int begin, unsigned int end);
+
+	// Called once after every part of the job has run - may be null. The job is not
+	// touched by the pool once this has been called.
+	void (*finish)(struct pool_job *job);
+
+	// Number of units covered by the job.
+	unsigned int length;
+
+	// Parts longer than this are split further.
+	unsigned int grain;
+
+	// Parts are split only on multiples of this - the block size of the cipher.
+	unsigned int align;
+
+	// Number of parts that have not run yet - managed by the pool.
+	unsigned int pending;
+};
+
+struct thread_pool;
+
+struct thread_pool *pool_create(unsigned int threads);
+
+unsigned int pool_size(const struct thread_pool *pool);
+
+void pool_submit(struct thread_pool *pool, struct pool_job *job);
+
+void pool_wait(struct thread_pool *pool);
+
+void pool_destroy(struct thread_pool *pool);
+
+
+#endif //__encryptor_thread_pool
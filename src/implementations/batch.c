@@ -0,0 +1,301 @@
+// Implementation of the batch mode. Every line read from stdin is a message - the lines
+// are handed to a work-stealing pool (see `thread_pool.h`) as they are read, with long
+// lines split into block-aligned parts that run on different workers. Lines finish out
+// of order; a reorder buffer holds the results until every line before them has been
+// written, so the output lines up with the input.
+//
+// Under a memory budget (see `budget.h`), fewer lines are kept in flight - the oldest ones
+// are written out to make room - and a line too large for the budget on its own is streamed
+// through the cipher (see `engine_stream_update`) instead of being copied.
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch.h"
+#include "budget.h"
+#include "thread_pool.h"
+
+#define true 1
+#define false 0
+
+// Number of lines that can be in flight (read, but not written yet) at once.
+#define BATCH_WINDOW 4096
+
+// Lines longer than this are split into parts of about this size.
+#define BATCH_GRAIN (64u << 10)
+
+// Size of the buffer used to write to stdout.
+#define BATCH_OUTPUT_BUFFER (1u << 20)
+
+/**
+ * The reorder buffer - a ring of the lines in flight, in the order they were read.
+ */
+struct batch_reorder {
+	pthread_mutex_t lock;
+
+	// Signalled when the line to be written next is done.
+	pthread_cond_t ready;
+
+	struct batch_line *lines[BATCH_WINDOW];
+
+	// Sequence number of the line to be written next.
+	unsigned long long next;
+};
+
+/**
+ * A single line moving through the pool.
+ */
+struct batch_line {
+	// The job run on the pool - should stay the first member.
+	struct pool_job job;
+
+	const struct cipher_key *prepared;
+	bool encrypt;
+
+	// The normalized message, and the result.
+	struct span message;
+	string result;
+	unsigned int result_length;
+
+	// Number of bytes reserved from the memory budget for the buffers of the line.
+	unsigned long long reserved;
+
+	// Boolean indicating if a part of the line could not be ciphered.
+	bool failed;
+
+	// Boolean indicating if the line is done with - guarded by the lock of the reorder buffer.
+	bool done;
+
+	unsigned long long sequence;
+	struct batch_reorder *reorder;
+};
+
+/**
+ * Internal method to run a part of a line - called on the workers.
+ */
+void batch_run_part(struct pool_job *job, unsigned int begin, unsigned int end) {
+	struct batch_line *line = (struct batch_line *) job;
+
+	if (!engine_run_slice(line->prepared, line->encrypt, line->result, line->message, begin, end))
+		__atomic_store_n(&line->failed, true, __ATOMIC_RELAXED);
+}
+
+/**
+ * Internal method to mark a line as done, waking the writer if it is waiting for it.
+ */
+void batch_finish(struct pool_job *job) {
+	struct batch_line *line = (struct batch_line *) job;
+	struct batch_reorder *reorder = line->reorder;
+
+	pthread_mutex_lock(&reorder->lock);
+
+	line->done = true;
+	if (line->sequence == reorder->next)
+		pthread_cond_signal(&reorder->ready);
+
+	pthread_mutex_unlock(&reorder->lock);
+}
+
+/**
+ * Internal method to wait for the next line in order, write it out and release it.
+ *
+ * @return
+ * 		Boolean indicating if the line could be ciphered.
+ */
+bool batch_write_next(struct batch_reorder *reorder) {
+	pthread_mutex_lock(&reorder->lock);
+
+	struct batch_line *line = reorder->lines[reorder->next % BATCH_WINDOW];
+	while (!line->done)
+		pthread_cond_wait(&reorder->ready, &reorder->lock);
+
+	reorder->next++;
+	pthread_mutex_unlock(&reorder->lock);
+
+	bool failed = line->failed;
+
+	if (failed)
+		// An empty line keeps the output lined up with the input.
+		fprintf(stderr, "Error: Line %llu cannot be ciphered with the key provided\n", line->sequence + 1);
+	else
+		fwrite(line->result, sizeof(char), line->result_length, stdout);
+
+	putchar('\n');
+
+	free(line->message.data);
+	free(line->result);
+	budget_release(line->reserved);
+	free(line);
+
+	return !failed;
+}
+
+/**
+ * Internal method to cipher a line too large for the memory budget - normalized in-place,
+ * and streamed to the output a part at a time.
+ *
+ * @remarks
+ * 		Meant to be called once every line before has been written. A line that cannot be
+ * 		ciphered part-way through is cut short - what came before has been written already.
+ *
+ * @param prepared: Pointer to the prepared key.
+ * @param encrypt: Boolean indicating if the line is to be encrypted (or decrypted).
+ * @param text: Span containing the line as read - overwritten.
+ * @param number: Unsigned integer containing the number of the line, for errors.
+ *
+ * @return
+ * 		Boolean indicating if the line could be ciphered.
+ */
+bool batch_stream_line(const struct cipher_key *prepared, bool encrypt, struct span text, unsigned long long number) {
+	struct engine_stream stream;
+	if (!engine_stream_init(&stream, prepared, encrypt)) {
+		fprintf(stderr, "Error: Line %llu does not fit in the memory budget, and this cipher needs it whole\n", number);
+		putchar('\n');
+		return false;
+	}
+
+	unsigned int block = engine_block_size(prepared);
+	unsigned int length = engine_normalize_into(prepared, text.data, text);
+
+	string output = (string) malloc(BATCH_GRAIN + block + 1);
+	bool failed = false;
+
+	for (unsigned int done = 0; done < length && !failed; done += BATCH_GRAIN) {
+		unsigned int part = (length - done < BATCH_GRAIN) ? length - done : BATCH_GRAIN;
+		unsigned int written = engine_stream_update(&stream, output, make_span(text.data + done, part));
+
+		if (written == CIPHER_INVALID)
+			failed = true;
+		else
+			fwrite(output, sizeof(char), written, stdout);
+	}
+
+	// Ending the stream either way - the block held back is released along with it.
+	unsigned int written = engine_stream_finish(&stream, output);
+
+	if (!failed && written != CIPHER_INVALID)
+		fwrite(output, sizeof(char), written, stdout);
+	else
+		fprintf(stderr, "Error: Line %llu cannot be ciphered with the key provided\n", number);
+
+	putchar('\n');
+	free(output);
+
+	return !failed && written != CIPHER_INVALID;
+}
+
+/**
+ * Runs the program in batch mode - ciphers every line read from stdin (until the end of
+ * the input), and writes the results to stdout, one line each, in the same order.
+ *
+ * @remarks
+ * 		Each line is normalized (see `engine_normalize_into`) before being ciphered. Lines
+ * 		that cannot be ciphered are reported on stderr and written as empty lines.
+ *
+ * @param prepared: Pointer to the prepared key.
+ * @param encrypt: Boolean indicating if the lines are to be encrypted (or decrypted).
+ * @param threads: Unsigned integer containing the number of workers - zero for one per processor.
+ *
+ * @return
+ * 		Integer containing the exit code for the program.
+ */
+int batch_run(const struct cipher_key *prepared, bool encrypt, unsigned int threads) {
+	struct thread_pool *pool = pool_create(threads);
+
+	struct batch_reorder *reorder = (struct batch_reorder *) calloc(1, sizeof(struct batch_reorder));
+	pthread_mutex_init(&reorder->lock, NULL);
+	pthread_cond_init(&reorder->ready, NULL);
+
+	setvbuf(stdout, NULL, _IOFBF, BATCH_OUTPUT_BUFFER);
+
+	unsigned int block = engine_block_size(prepared);
+	unsigned long long read = 0, failures = 0;
+
+	string input = NULL;
+	size_t input_capacity = 0;
+	ssize_t length;
+
+	while ((length = getline(&input, &input_capacity, stdin)) >= 0) {
+		// The line break is not a part of the message - the byte-oriented ciphers would keep it.
+		if (length > 0 && input[length - 1] == '\n')
+			length--;
+
+		if (read - reorder->next == BATCH_WINDOW)
+			// The window is full - making room by writing out the oldest line.
+			failures += !batch_write_next(reorder);
+
+		unsigned long long needed = engine_footprint(prepared, (unsigned int) length);
+
+		if (!budget_fits(needed)) {
+			// Too large for the budget even on its own - streamed once the lines before it are out.
+			while (reorder->next < read)
+				failures += !batch_write_next(reorder);
+
+			failures += !batch_stream_line(prepared, encrypt, make_span(input, (unsigned int) length), read + 1);
+			reorder->next = ++read;
+			continue;
+		}
+
+		// Making room in the budget by writing out the oldest lines.
+		bool reserved;
+		while (!(reserved = budget_reserve(needed)) && reorder->next < read)
+			failures += !batch_write_next(reorder);
+
+		struct batch_line *line = (struct batch_line *) calloc(1, sizeof(struct batch_line));
+		line->reserved = reserved ? needed : 0;
+		line->prepared = prepared;
+		line->encrypt = encrypt;
+		line->sequence = read;
+		line->reorder = reorder;
+
+		line->message.data = (string) malloc(length + 1);
+		line->message.length = engine_normalize_into(
+			prepared, line->message.data, make_span(input, (unsigned int) length)
+		);
+
+		reorder->lines[read++ % BATCH_WINDOW] = line;
+
+		unsigned int size = engine_run_into(prepared, encrypt, NULL, 0, line->message);
+		if (size == CIPHER_INVALID) {
+			line->failed = true;
+			line->done = true;
+			continue;
+		}
+
+		line->result = (string) malloc(size + 1);
+		line->result_length = size;
+
+		line->job.run = batch_run_part;
+		line->job.finish = batch_finish;
+		line->job.length = size;
+		line->job.align = block;
+		line->job.grain = (BATCH_GRAIN / block) * block;
+
+		if ((prepared->cipher == AUTOKEY && !encrypt) || prepared->cipher == DOUBLE_COLUMNAR)
+			// Every part would recover the plaintext before it from the start (see `vg_run_slice`),
+			// or run both passes over the whole line (see `ct_run_slice`) - the line runs in one
+			// go instead.
+			line->job.grain = size;
+
+		pool_submit(pool, &line->job);
+	}
+
+	// Writing out whatever is left.
+	while (reorder->next < read)
+		failures += !batch_write_next(reorder);
+
+	fflush(stdout);
+
+	pool_destroy(pool);
+	free(input);
+
+	pthread_mutex_destroy(&reorder->lock);
+	pthread_cond_destroy(&reorder->ready);
+	free(reorder);
+
+	return failures == 0 ? 0 : -10;
+}
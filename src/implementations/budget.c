@@ -0,0 +1,127 @@
+// Implementation of the memory budget. Only the buffers that grow with the messages are
+// accounted for - the few fixed-size buffers of each mode are left out. The counters are
+// atomic, as the buffers of the batch mode are released from the workers.
+
+#include "budget.h"
+
+#define true 1
+#define false 0
+
+// The budget, in bytes - zero for no budget at all.
+unsigned long long budget_bytes = 0;
+
+// Bytes currently reserved, and the most that have been at once.
+unsigned long long budget_used = 0;
+unsigned long long budget_high = 0;
+
+/**
+ * Sets the budget - to be called once at startup, before anything is reserved.
+ *
+ * @param limit: Unsigned integer containing the budget, in bytes - zero for no budget.
+ */
+void budget_set(unsigned long long limit) {
+	budget_bytes = limit;
+}
+
+/**
+ * Returns the budget.
+ *
+ * @return
+ * 		Unsigned integer containing the budget, in bytes - zero if there is none.
+ */
+unsigned long long budget_limit() {
+	return budget_bytes;
+}
+
+/**
+ * Checks if a job needing a number of bytes could ever be run as a whole - with nothing
+ * else reserved.
+ *
+ * @param bytes: Unsigned integer containing the bytes needed by the job.
+ *
+ * @return
+ * 		Boolean indicating if the job fits in the budget.
+ */
+bool budget_fits(unsigned long long bytes) {
+	return budget_bytes == 0 || bytes <= budget_bytes;
+}
+
+/**
+ * Reserves a number of bytes from the budget - to be called before creating the buffers.
+ *
+ * @remarks
+ * 		Safe to call from any number of threads at once. Nothing is reserved if the budget
+ * 		cannot hold the bytes on top of what is already reserved.
+ *
+ * @param bytes: Unsigned integer containing the bytes to be reserved.
+ *
+ * @return
+ * 		Boolean indicating if the bytes could be reserved - to be given back using
+ * 		`budget_release` once the buffers are released.
+ */
+bool budget_reserve(unsigned long long bytes) {
+	unsigned long long used = __atomic_load_n(&budget_used, __ATOMIC_RELAXED);
+
+	do {
+		if (budget_bytes != 0 && used + bytes > budget_bytes)
+			return false;
+	} while (!__atomic_compare_exchange_n(&budget_used, &used, used + bytes, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	// Keeping track of the high-water mark - only ever raised.
+	unsigned long long high = __atomic_load_n(&budget_high, __ATOMIC_RELAXED);
+	while (used + bytes > high && !__atomic_compare_exchange_n(
+		&budget_high, &high, used + bytes, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED
+	));
+
+	return true;
+}
+
+/**
+ * Gives back bytes reserved using `budget_reserve`.
+ *
+ * @param bytes: Unsigned integer containing the bytes reserved.
+ */
+void budget_release(unsigned long long bytes) {
+	__atomic_sub_fetch(&budget_used, bytes, __ATOMIC_RELAXED);
+}
+
+/**
+ * Returns the most bytes that have been reserved at once.
+ *
+ * @return
+ * 		Unsigned integer containing the high-water mark, in bytes.
+ */
+unsigned long long budget_peak() {
+	return __atomic_load_n(&budget_high, __ATOMIC_RELAXED);
+}
+
+/**
+ * Parses a size - a number of bytes, optionally followed by a unit (`K`, `M` or `G`, in
+ * powers of 1024).
+ *
+ * @param text: Span containing the size (`512M`). Should have been validated beforehand.
+ *
+ * @return
+ * 		Unsigned integer containing the size, in bytes.
+ */
+unsigned long long parse_size(struct span text) {
+	unsigned long long size = 0;
+	unsigned int i = 0;
+
+	for (; i < text.length && text.data[i] >= '0' && text.data[i] <= '9'; i++)
+		size = size * 10 + (text.data[i] - '0');
+
+	if (i < text.length)
+		switch (text.data[i] | 0x20) {
+			case 'k':
+				return size << 10;
+
+			case 'm':
+				return size << 20;
+
+			case 'g':
+				return size << 30;
+		}
+
+	return size;
+}
@@ -0,0 +1,865 @@
+// Implementation of the bulk mode. Every regular file in the input directory is read in
+// full, ciphered, and written to a file of the same name in the output directory.
+//
+// Up to `QUEUE_DEPTH` files are in flight at once. Reads and writes are queued into an
+// `io_uring` submission ring and handed to the kernel in batches - a single system call
+// submits everything queued so far and waits for completions - so the run is bound by
+// how fast the disk answers rather than by one blocking call per file. Where the kernel
+// refuses to set up a ring, the same pipeline runs on blocking `pread`/`pwrite`.
+//
+// The I/O thread never ciphers - a file read in full is handed to a work-stealing pool
+// (see `thread_pool.h`), split into block-aligned parts like the lines of the batch mode.
+// The last part to finish hands the file back, and wakes the I/O thread (through an
+// `eventfd` it always has a read queued on) to queue the write.
+//
+// Every file in flight is held in memory (along with its result) - under a memory budget
+// (see `budget.h`), files wait for others to finish before being read, and a file too large
+// for the budget on its own is streamed through the cipher in chunks instead.
+
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "bulk.h"
+#include "budget.h"
+#include "thread_pool.h"
+
+#define true 1
+#define false 0
+
+// Number of files (and as such, operations) in flight at once.
+#define QUEUE_DEPTH 64
+
+// Files larger than this are split into parts of about this size, ciphered on different workers.
+#define BULK_GRAIN (64u << 10)
+
+// Largest read/write handed to the kernel in a single operation.
+#define IO_CHUNK (1u << 30)
+
+// Largest file that can be ciphered - the result has to fit in an unsigned integer.
+#define BULK_MAX_FILE (UINT_MAX - 1u)
+
+// Number of characters of a file read at a time while it is streamed - unless the memory
+// budget is smaller still.
+#define BULK_STREAM_CHUNK (1u << 20)
+
+enum io_kind {IO_READ, IO_WRITE};
+
+/**
+ * A single file moving through the pipeline - read, ciphered, then written.
+ */
+struct bulk_file {
+	// The job ciphering the file on the pool - should stay the first member.
+	struct pool_job job;
+
+	// The key, and the queue the file is handed back to once it has been ciphered.
+	const struct cipher_key *prepared;
+	bool encrypt;
+	struct io_queue *queue;
+
+	// Next file handed back to the queue (see `io_queue.ciphered`).
+	struct bulk_file *next;
+
+	// Name of the file - relative to both directories.
+	char name[NAME_MAX + 1];
+
+	int input_fd;
+	int output_fd;
+
+	// Contents of the input file, and the number of characters read so far.
+	string input;
+	unsigned int size;
+	unsigned int read;
+
+	// The result, and the number of characters written so far. Null until the file has
+	// been read in full.
+	string output;
+	unsigned int output_length;
+	unsigned int written;
+
+	// Number of bytes reserved from the memory budget for the buffers of the file.
+	unsigned long long reserved;
+
+	// Boolean indicating if something went wrong with the file - set from the workers if a
+	// part of it could not be ciphered.
+	bool failed;
+};
+
+/**
+ * A completed operation - used by the fallback, which completes operations as soon as
+ * they are queued.
+ */
+struct io_result {
+	struct bulk_file *file;
+	enum io_kind kind;
+	long result;
+};
+
+/**
+ * State of the I/O queue - an `io_uring` instance if available, otherwise the list of
+ * operations completed by the fallback.
+ */
+struct io_queue {
+	// Boolean indicating if `io_uring` is being used.
+	bool uring;
+
+	// File descriptor of the ring.
+	int fd;
+
+	// Pointers into the submission ring (shared with the kernel).
+	unsigned int *sq_tail;
+	unsigned int *sq_mask;
+	unsigned int *sq_array;
+	struct io_uring_sqe *sqes;
+
+	// Pointers into the completion ring (shared with the kernel).
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	struct io_uring_cqe *cqes;
+
+	// Number of operations queued, but not submitted to the kernel yet.
+	unsigned int to_submit;
+
+	// Operations completed by the fallback, waiting to be handled.
+	struct io_result completed[QUEUE_DEPTH];
+	unsigned int completed_count;
+
+	// The pool the files are ciphered on.
+	struct thread_pool *pool;
+
+	// Files ciphered by the pool, waiting for their writes to be queued - guarded by the lock.
+	pthread_mutex_t lock;
+	struct bulk_file *ciphered;
+
+	// Signalled (written to) by the pool every time a file is ciphered. With `io_uring`, a
+	// read of it is always queued, so that a wait for completions also ends there.
+	int wake_fd;
+	uint64_t wake_value;
+	bool wake_queued;
+};
+
+/**
+ * Internal method to set up an `io_uring` instance for the queue.
+ *
+ * @param queue: Pointer to the queue that is to be set up.
+ *
+ * @return
+ * 		Boolean indicating if the ring could be set up - false if the kernel does not
+ * 		support (or allow) it.
+ */
+bool io_setup(struct io_queue *queue) {
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	// A file has at most one operation queued at a time - along with the read of `wake_fd`.
+	int fd = (int) syscall(__NR_io_uring_setup, QUEUE_DEPTH + 1, &params);
+	if (fd < 0)
+		return false;
+
+	size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+	// Newer kernels map both the rings in one go.
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (cq_size > sq_size)
+			sq_size = cq_size;
+		cq_size = sq_size;
+	}
+
+	char *sq = mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	char *cq = (params.features & IORING_FEAT_SINGLE_MMAP) ? sq : mmap(
+		NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING
+	);
+	struct io_uring_sqe *sqes = mmap(
+		NULL, params.sq_entries * sizeof(struct io_uring_sqe),
+		PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES
+	);
+
+	if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+
+	queue->uring = true;
+	queue->fd = fd;
+
+	queue->sq_tail = (unsigned int *) (sq + params.sq_off.tail);
+	queue->sq_mask = (unsigned int *) (sq + params.sq_off.ring_mask);
+	queue->sq_array = (unsigned int *) (sq + params.sq_off.array);
+	queue->sqes = sqes;
+
+	queue->cq_head = (unsigned int *) (cq + params.cq_off.head);
+	queue->cq_tail = (unsigned int *) (cq + params.cq_off.tail);
+	queue->cq_mask = (unsigned int *) (cq + params.cq_off.ring_mask);
+	queue->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+
+	return true;
+}
+
+/**
+ * Internal method to queue a read/write operation for a file.
+ *
+ * @remarks
+ * 		With `io_uring`, the operation is only queued - it reaches the kernel with the
+ * 		next call to `io_wait`. The fallback performs the operation right away.
+ *
+ * @param queue: Pointer to the queue.
+ * @param file: Pointer to the file the operation is for.
+ * @param kind: Whether the operation reads from the input, or writes to the output.
+ */
+void io_queue_op(struct io_queue *queue, struct bulk_file *file, enum io_kind kind) {
+	int fd = (kind == IO_READ) ? file->input_fd : file->output_fd;
+	string buffer = (kind == IO_READ) ? file->input + file->read : file->output + file->written;
+	unsigned int offset = (kind == IO_READ) ? file->read : file->written;
+	unsigned int length = ((kind == IO_READ) ? file->size : file->output_length) - offset;
+
+	if (length > IO_CHUNK)
+		length = IO_CHUNK;
+
+	if (!queue->uring) {
+		long result = (kind == IO_READ) ? pread(fd, buffer, length, offset) : pwrite(fd, buffer, length, offset);
+
+		struct io_result *slot = &queue->completed[queue->completed_count++];
+		slot->file = file;
+		slot->kind = kind;
+		slot->result = (result < 0) ? -errno : result;
+		return;
+	}
+
+	unsigned int tail = *queue->sq_tail;
+	unsigned int index = tail & *queue->sq_mask;
+
+	struct io_uring_sqe *sqe = &queue->sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = (kind == IO_READ) ? IORING_OP_READ : IORING_OP_WRITE;
+	sqe->fd = fd;
+	sqe->addr = (unsigned long) buffer;
+	sqe->len = length;
+	sqe->off = offset;
+
+	// The lowest bit of the pointer (always aligned) is used to carry the kind.
+	sqe->user_data = (unsigned long) file | kind;
+
+	queue->sq_array[index] = index;
+	__atomic_store_n(queue->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	queue->to_submit++;
+}
+
+/**
+ * Internal method to queue the read of `wake_fd` into the ring - the completion of it (with
+ * no file) means files have been ciphered.
+ *
+ * @param queue: Pointer to the queue - using `io_uring`.
+ */
+void io_queue_wake(struct io_queue *queue) {
+	unsigned int tail = *queue->sq_tail;
+	unsigned int index = tail & *queue->sq_mask;
+
+	struct io_uring_sqe *sqe = &queue->sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = queue->wake_fd;
+	sqe->addr = (unsigned long) &queue->wake_value;
+	sqe->len = sizeof(queue->wake_value);
+	sqe->user_data = 0;
+
+	queue->sq_array[index] = index;
+	__atomic_store_n(queue->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	queue->to_submit++;
+	queue->wake_queued = true;
+}
+
+/**
+ * Internal method to run a part of a file - called on the workers.
+ */
+void bulk_cipher_part(struct pool_job *job, unsigned int begin, unsigned int end) {
+	struct bulk_file *file = (struct bulk_file *) job;
+	struct span message = make_span(file->input, file->size);
+
+	if (!engine_run_slice(file->prepared, file->encrypt, file->output, message, begin, end))
+		__atomic_store_n(&file->failed, true, __ATOMIC_RELAXED);
+}
+
+/**
+ * Internal method to hand a ciphered file back to the I/O thread, waking it - called on the
+ * worker running the last part of the file.
+ */
+void bulk_cipher_finish(struct pool_job *job) {
+	struct bulk_file *file = (struct bulk_file *) job;
+	struct io_queue *queue = file->queue;
+
+	pthread_mutex_lock(&queue->lock);
+	file->next = queue->ciphered;
+	queue->ciphered = file;
+	pthread_mutex_unlock(&queue->lock);
+
+	uint64_t one = 1;
+	while (write(queue->wake_fd, &one, sizeof(one)) < 0 && errno == EINTR);
+}
+
+/**
+ * Internal method to write a part of the result of a streamed file, with blocking calls.
+ *
+ * @param file: Pointer to the file.
+ * @param data: The characters to be written.
+ * @param length: Unsigned integer containing the number of characters.
+ * @param written: Pointer to the number of characters written to the output so far - moved along.
+ *
+ * @return
+ * 		Boolean indicating if everything could be written. Prints the reason otherwise.
+ */
+bool bulk_write_all(struct bulk_file *file, const char *data, unsigned int length, unsigned long long *written) {
+	unsigned int done = 0;
+
+	while (done < length) {
+		ssize_t count = pwrite(file->output_fd, data + done, length - done, *written);
+
+		if (count <= 0) {
+			if (count < 0 && errno == EINTR)
+				continue;
+
+			printf("\nError: Could not write `%s` - %s\n", file->name, count < 0 ? strerror(errno) : "no space left");
+			return false;
+		}
+
+		done += count;
+		*written += count;
+	}
+
+	return true;
+}
+
+/**
+ * Internal method to close a file that is done with, and release its buffers.
+ *
+ * @param file: Pointer to the file.
+ * @param output_dir: File descriptor of the output directory - used to remove the
+ * 		output if the file failed.
+ */
+void bulk_close(struct bulk_file *file, int output_dir) {
+	close(file->input_fd);
+	close(file->output_fd);
+
+	if (file->failed)
+		unlinkat(output_dir, file->name, 0);
+
+	free(file->input);
+	free(file->output);
+	budget_release(file->reserved);
+	free(file);
+}
+
+/**
+ * Internal method to reserve the memory a file needs from the budget, and create the buffer
+ * it is read into.
+ *
+ * @param file: Pointer to the file.
+ * @param prepared: Pointer to the prepared key - for the size of the result.
+ *
+ * @return
+ * 		Boolean indicating if the memory could be reserved - false if the files in flight
+ * 		leave too little of the budget.
+ */
+bool bulk_start(struct bulk_file *file, const struct cipher_key *prepared) {
+	unsigned long long needed = engine_footprint(prepared, file->size);
+	if (!budget_reserve(needed))
+		return false;
+
+	file->reserved = needed;
+	file->input = (string) malloc(file->size + 1);
+
+	return true;
+}
+
+/**
+ * Internal method to cipher a file too large for the memory budget - it is read, ciphered
+ * and written a chunk at a time (see `engine_stream_update`), with blocking calls.
+ *
+ * @remarks
+ * 		Meant to be called with nothing else in flight - the chunks are sized to fit in what
+ * 		is left of the budget then.
+ *
+ * @param file: Pointer to the file - marked as failed if it could not be ciphered.
+ * @param prepared: Pointer to the prepared key.
+ * @param encrypt: Boolean indicating if the file is to be encrypted (or decrypted).
+ */
+void bulk_stream(struct bulk_file *file, const struct cipher_key *prepared, bool encrypt) {
+	struct engine_stream stream;
+	if (!engine_stream_init(&stream, prepared, encrypt)) {
+		printf(
+			"\nError: `%s` does not fit in the memory budget, and this cipher needs it whole%s\n", file->name,
+			(prepared->cipher == RAILFENCE) ? " (see `--rf-block`)" : ""
+		);
+		file->failed = true;
+		return;
+	}
+
+	// The input chunk, and the result of a chunk - up to a block larger.
+	unsigned int block = engine_block_size(prepared);
+	unsigned long long chunk = BULK_STREAM_CHUNK, limit = budget_limit();
+
+	if (limit != 0 && 2 * chunk + block + 1 > limit)
+		chunk = (limit > 2ULL * block + 1) ? (limit - block - 1) / 2 : block;
+
+	if (budget_reserve(2 * chunk + block + 1))
+		file->reserved = 2 * chunk + block + 1;
+
+	string input = (string) malloc(chunk);
+	string output = (string) malloc(chunk + block + 1);
+
+	unsigned long long offset = 0, written = 0;
+
+	while (!file->failed) {
+		ssize_t length = pread(file->input_fd, input, chunk, offset);
+		if (length == 0)
+			break;
+
+		if (length < 0) {
+			printf("\nError: Could not read `%s` - %s\n", file->name, strerror(errno));
+			file->failed = true;
+			break;
+		}
+
+		offset += length;
+
+		unsigned int normalized = engine_normalize_into(prepared, input, make_span(input, (unsigned int) length));
+		unsigned int size = engine_stream_update(&stream, output, make_span(input, normalized));
+
+		if (size == CIPHER_INVALID) {
+			printf("\nError: `%s` cannot be ciphered with the key provided\n", file->name);
+			file->failed = true;
+			break;
+		}
+
+		file->failed = !bulk_write_all(file, output, size, &written);
+	}
+
+	// Ending the stream either way - the block held back is released along with it.
+	unsigned int size = engine_stream_finish(&stream, output);
+
+	if (!file->failed) {
+		if (size == CIPHER_INVALID) {
+			printf("\nError: The end of `%s` cannot be ciphered with the key provided\n", file->name);
+			file->failed = true;
+		} else {
+			file->failed = !bulk_write_all(file, output, size, &written);
+		}
+	}
+
+	free(input);
+	free(output);
+}
+
+/**
+ * Internal method to move a file on to its next step - reading more of it, handing it to the
+ * pool once it has been read in full, or writing more of the result.
+ *
+ * @param queue: Pointer to the queue.
+ * @param file: Pointer to the file.
+ * @param prepared: Pointer to the prepared key.
+ * @param encrypt: Boolean indicating if the files are to be encrypted (or decrypted).
+ *
+ * @return
+ * 		Boolean indicating if the file is done with - either fully written, or failed.
+ */
+bool bulk_advance(struct io_queue *queue, struct bulk_file *file, const struct cipher_key *prepared, bool encrypt) {
+	if (file->failed)
+		return true;
+
+	if (file->read < file->size) {
+		io_queue_op(queue, file, IO_READ);
+		return false;
+	}
+
+	if (file->output == NULL) {
+		// Read in full - the input is normalized in-place, and ciphered on the pool. The size
+		// of the input is the size of the message from then on.
+		struct span contents = make_span(file->input, file->size);
+		file->size = engine_normalize_into(prepared, file->input, contents);
+
+		unsigned int size = engine_run_into(prepared, encrypt, NULL, 0, make_span(file->input, file->size));
+		if (size == CIPHER_INVALID) {
+			printf("\nError: `%s` cannot be ciphered with the key provided\n", file->name);
+			file->failed = true;
+			return true;
+		}
+
+		file->output = (string) malloc(size + 1);
+		file->output_length = size;
+
+		if (size != 0) {
+			unsigned int block = engine_block_size(prepared);
+
+			file->prepared = prepared;
+			file->encrypt = encrypt;
+			file->queue = queue;
+
+			file->job.run = bulk_cipher_part;
+			file->job.finish = bulk_cipher_finish;
+			file->job.length = size;
+			file->job.align = block;
+			file->job.grain = (BULK_GRAIN / block) * block;
+
+			if ((prepared->cipher == AUTOKEY && !encrypt) || prepared->cipher == DOUBLE_COLUMNAR)
+				// Runs in one go - as with the lines of the batch mode.
+				file->job.grain = size;
+
+			// Handed back through `bulk_drain` once ciphered.
+			pool_submit(queue->pool, &file->job);
+			return false;
+		}
+	}
+
+	if (file->written < file->output_length) {
+		io_queue_op(queue, file, IO_WRITE);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Internal method to handle a completed operation.
+ *
+ * @return
+ * 		Boolean indicating if the file is done with.
+ */
+bool bulk_complete(
+	struct io_queue *queue, struct bulk_file *file, enum io_kind kind, long result,
+	const struct cipher_key *prepared, bool encrypt
+) {
+	if (result < 0) {
+		printf("\nError: Could not %s `%s` - %s\n", kind == IO_READ ? "read" : "write", file->name, strerror(-result));
+		file->failed = true;
+		return true;
+	}
+
+	if (kind == IO_READ) {
+		if (result == 0)
+			// The file shrank since it was opened - going ahead with what was read.
+			file->size = file->read;
+
+		file->read += result;
+	} else {
+		if (result == 0) {
+			printf("\nError: Could not write `%s`\n", file->name);
+			file->failed = true;
+			return true;
+		}
+
+		file->written += result;
+	}
+
+	return bulk_advance(queue, file, prepared, encrypt);
+}
+
+/**
+ * Internal method to move on the files the pool has ciphered - their writes are queued.
+ *
+ * @return
+ * 		Unsigned integer containing the number of files that are done with.
+ */
+unsigned int bulk_drain(
+	struct io_queue *queue, int output_dir, unsigned int *failures,
+	const struct cipher_key *prepared, bool encrypt
+) {
+	pthread_mutex_lock(&queue->lock);
+	struct bulk_file *file = queue->ciphered;
+	queue->ciphered = NULL;
+	pthread_mutex_unlock(&queue->lock);
+
+	unsigned int finished = 0;
+
+	while (file != NULL) {
+		struct bulk_file *next = file->next;
+
+		// Some messages only turn out to be invalid while being ciphered (`hill95`).
+		if (file->failed)
+			printf("\nError: `%s` cannot be ciphered with the key provided\n", file->name);
+
+		if (bulk_advance(queue, file, prepared, encrypt)) {
+			*failures += file->failed;
+			bulk_close(file, output_dir);
+			finished++;
+		}
+
+		file = next;
+	}
+
+	return finished;
+}
+
+/**
+ * Internal method to submit the queued operations, wait for at least one of them to
+ * complete (or for a file to be ciphered), and handle every completed operation.
+ *
+ * @return
+ * 		Unsigned integer containing the number of files that are done with.
+ */
+unsigned int io_wait(
+	struct io_queue *queue, int output_dir, unsigned int *failures,
+	const struct cipher_key *prepared, bool encrypt
+) {
+	unsigned int finished = 0;
+
+	if (!queue->uring) {
+		// Every file in flight without a completed operation is on the pool - waiting for
+		// one of them to be ciphered.
+		uint64_t value;
+		if (queue->completed_count == 0)
+			while (read(queue->wake_fd, &value, sizeof(value)) < 0 && errno == EINTR);
+
+		// Handling a snapshot - completions of operations queued while handling land in
+		// the (now empty) list for the next round.
+		struct io_result completed[QUEUE_DEPTH];
+		unsigned int count = queue->completed_count;
+		memcpy(completed, queue->completed, count * sizeof(struct io_result));
+		queue->completed_count = 0;
+
+		for (unsigned int i = 0; i < count; i++) {
+			struct bulk_file *file = completed[i].file;
+			if (bulk_complete(queue, file, completed[i].kind, completed[i].result, prepared, encrypt)) {
+				*failures += file->failed;
+				bulk_close(file, output_dir);
+				finished++;
+			}
+		}
+
+		return finished + bulk_drain(queue, output_dir, failures, prepared, encrypt);
+	}
+
+	if (!queue->wake_queued)
+		io_queue_wake(queue);
+
+	// A single system call to hand over everything queued, and wait for a completion.
+	int submitted = (int) syscall(
+		__NR_io_uring_enter, queue->fd, queue->to_submit, 1, IORING_ENTER_GETEVENTS, NULL, 0
+	);
+
+	if (submitted < 0 && errno != EINTR) {
+		printf("\nError: io_uring failed - %s\n", strerror(errno));
+		exit(-10);
+	} else if (submitted > 0) {
+		queue->to_submit -= submitted;
+	}
+
+	unsigned int head = *queue->cq_head;
+	unsigned int tail = __atomic_load_n(queue->cq_tail, __ATOMIC_ACQUIRE);
+
+	for (; head != tail; head++) {
+		struct io_uring_cqe *cqe = &queue->cqes[head & *queue->cq_mask];
+
+		if (cqe->user_data == 0) {
+			// Files have been ciphered - handled below, along with any ciphered meanwhile.
+			queue->wake_queued = false;
+			continue;
+		}
+
+		struct bulk_file *file = (struct bulk_file *) (unsigned long) (cqe->user_data & ~1ULL);
+		enum io_kind kind = (enum io_kind) (cqe->user_data & 1);
+
+		if (bulk_complete(queue, file, kind, cqe->res, prepared, encrypt)) {
+			*failures += file->failed;
+			bulk_close(file, output_dir);
+			finished++;
+		}
+	}
+
+	__atomic_store_n(queue->cq_head, head, __ATOMIC_RELEASE);
+	return finished + bulk_drain(queue, output_dir, failures, prepared, encrypt);
+}
+
+/**
+ * Internal method to open a file from the input directory, along with its output.
+ *
+ * @return
+ * 		Pointer to the file, or null if it is not a regular file or cannot be opened.
+ */
+struct bulk_file *bulk_open(int input_dir, int output_dir, const_str name) {
+	int input_fd = openat(input_dir, name, O_RDONLY | O_CLOEXEC);
+	if (input_fd < 0)
+		return NULL;
+
+	struct stat details;
+	if (fstat(input_fd, &details) < 0 || !S_ISREG(details.st_mode)) {
+		close(input_fd);
+		return NULL;
+	}
+
+	if (details.st_size > BULK_MAX_FILE) {
+		printf("\nError: `%s` is too large to be ciphered\n", name);
+		close(input_fd);
+		return NULL;
+	}
+
+	int output_fd = openat(output_dir, name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (output_fd < 0) {
+		printf("\nError: Could not create `%s` - %s\n", name, strerror(errno));
+		close(input_fd);
+		return NULL;
+	}
+
+	struct bulk_file *file = (struct bulk_file *) calloc(1, sizeof(struct bulk_file));
+	strncpy(file->name, name, NAME_MAX);
+	file->input_fd = input_fd;
+	file->output_fd = output_fd;
+	file->size = (unsigned int) details.st_size;
+
+	// The buffers are created once the memory can be reserved (see `bulk_start`).
+	return file;
+}
+
+/**
+ * Runs the program in bulk mode - ciphers every regular file in a directory, writing the
+ * results to files of the same names in another directory.
+ *
+ * @remarks
+ * 		The contents of each file are normalized (see `engine_normalize_into`) before being
+ * 		ciphered. The output directory is created if needed. Files that cannot be ciphered
+ * 		are reported and left out of the output directory.
+ *
+ * @param input_dir: Span containing the path of the directory to be read.
+ * @param output_dir: Span containing the path of the directory to be written.
+ * @param prepared: Pointer to the prepared key.
+ * @param encrypt: Boolean indicating if the files are to be encrypted (or decrypted).
+ * @param threads: Unsigned integer containing the number of workers ciphering the files -
+ * 		zero for one per processor.
+ *
+ * @return
+ * 		Integer containing the exit code for the program.
+ */
+int bulk_run(
+	struct span input_dir, struct span output_dir, const struct cipher_key *prepared, bool encrypt,
+	unsigned int threads
+) {
+	string input_path = gen_str(input_dir).data;
+	string output_path = gen_str(output_dir).data;
+
+	mkdir(output_path, 0755);
+
+	DIR *directory = opendir(input_path);
+	int output_fd = open(output_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+	if (directory == NULL || output_fd < 0) {
+		printf("\nError: Could not open `%s` - %s\n", directory == NULL ? input_path : output_path, strerror(errno));
+		return -10;
+	}
+
+	int input_fd = dirfd(directory);
+
+	// Writing into the directory being read would truncate the inputs.
+	struct stat input_details, output_details;
+	fstat(input_fd, &input_details);
+	fstat(output_fd, &output_details);
+
+	if (input_details.st_dev == output_details.st_dev && input_details.st_ino == output_details.st_ino) {
+		printf("\nError: The input and output directories should be different\n");
+		return -10;
+	}
+
+	struct io_queue *queue = (struct io_queue *) calloc(1, sizeof(struct io_queue));
+	queue->wake_fd = eventfd(0, EFD_CLOEXEC);
+
+	if (queue->wake_fd < 0) {
+		printf("\nError: Could not create an eventfd - %s\n", strerror(errno));
+		return -10;
+	}
+
+	io_setup(queue);
+
+	pthread_mutex_init(&queue->lock, NULL);
+	queue->pool = pool_create(threads);
+
+	unsigned int in_flight = 0, total = 0, failures = 0;
+	bool listed = false;
+
+	// A file opened, but waiting for the files in flight to leave room in the memory budget.
+	struct bulk_file *waiting = NULL;
+
+	while (true) {
+		// Keeping the pipeline full.
+		while (!listed && in_flight < QUEUE_DEPTH) {
+			struct bulk_file *file = waiting;
+			waiting = NULL;
+
+			if (file == NULL) {
+				struct dirent *entry = readdir(directory);
+				if (entry == NULL) {
+					listed = true;
+					break;
+				}
+
+				file = bulk_open(input_fd, output_fd, entry->d_name);
+				if (file == NULL)
+					continue;
+
+				total++;
+			}
+
+			if (!budget_fits(engine_footprint(prepared, file->size)) || !bulk_start(file, prepared)) {
+				if (in_flight > 0) {
+					waiting = file;
+					break;
+				}
+
+				// Too large for the budget even on its own - streamed in chunks instead.
+				bulk_stream(file, prepared, encrypt);
+				failures += file->failed;
+				bulk_close(file, output_fd);
+				continue;
+			}
+
+			if (bulk_advance(queue, file, prepared, encrypt)) {
+				// Empty files are done with right away.
+				failures += file->failed;
+				bulk_close(file, output_fd);
+			} else {
+				in_flight++;
+			}
+		}
+
+		if (in_flight == 0)
+			break;
+
+		in_flight -= io_wait(queue, output_fd, &failures, prepared, encrypt);
+	}
+
+	closedir(directory);
+	close(output_fd);
+
+	// Every file has been handed back by now - nothing is left on the pool.
+	pool_destroy(queue->pool);
+	pthread_mutex_destroy(&queue->lock);
+
+	if (queue->uring)
+		close(queue->fd);
+	close(queue->wake_fd);
+	free(queue);
+
+	printf("\nCiphered %u file(s) into `%s`", total - failures, output_path);
+	if (failures > 0)
+		printf(", %u failed", failures);
+	printf("\n\n");
+
+	free(input_path);
+	free(output_path);
+
+	return failures == 0 ? 0 : -10;
+}
@@ -0,0 +1,382 @@
+// Implementation of the result cache. A key is hashed, and looked for in the few slots of the
+// table starting at the one the hash points to - a slot only remembers the hash, and where
+// its record was written, as such the record is checked against the key in full before its
+// result is used. A hash shared by two keys costs a comparison, never a wrong result.
+//
+// Records are never freed one at a time - the arena is a ring, and a store writes over the
+// oldest records once it is full. A slot pointing to a record that has been written over is
+// simply treated as empty; when the slots of a key are all taken, the one pointing to the
+// oldest record is used.
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+
+#define true 1
+#define false 0
+
+// Bytes at the start of the file holding the header - the table starts after them.
+#define CACHE_TABLE 64
+
+// Bytes of the file for every slot of the table - the rest of the file is the arena.
+#define CACHE_BYTES_PER_SLOT 256
+
+// A record can take up at most this share of the arena - larger results are not cached, so
+// that a single run cannot flush out everything else.
+#define CACHE_RECORD_SHARE 8
+
+/**
+ * Internal method to round a size up to the alignment of the records.
+ */
+static inline unsigned long long _cache_align(unsigned long long size) {
+	return (size + 7) & ~7ULL;
+}
+
+/**
+ * Internal method to find the layout of a file of a given size.
+ *
+ * @param size: Unsigned integer containing the size of the file, in bytes.
+ * @param header: Pointer to the header in which the layout is to be written.
+ */
+void _cache_layout(unsigned long long size, struct cache_header *header) {
+	memset(header, 0, sizeof(struct cache_header));
+
+	header->magic = CACHE_MAGIC;
+	header->slots = (uint32_t) (size / CACHE_BYTES_PER_SLOT);
+	header->arena = (size - CACHE_TABLE - header->slots * sizeof(struct cache_slot)) & ~7ULL;
+}
+
+/**
+ * Internal method to find the size of the file holding a layout.
+ */
+static inline unsigned long long _cache_file_size(const struct cache_header *header) {
+	return CACHE_TABLE + (unsigned long long) header->slots * sizeof(struct cache_slot) + header->arena;
+}
+
+/**
+ * Internal method to find the slots of a cache.
+ */
+static inline struct cache_slot *_cache_slots(const struct result_cache *cache) {
+	return (struct cache_slot *) (cache->base + CACHE_TABLE);
+}
+
+/**
+ * Internal method to find the arena of a cache.
+ */
+static inline unsigned char *_cache_arena(const struct result_cache *cache) {
+	const struct cache_header *header = (const struct cache_header *) cache->base;
+	return cache->base + CACHE_TABLE + (unsigned long long) header->slots * sizeof(struct cache_slot);
+}
+
+/**
+ * Internal method to hash a key.
+ *
+ * @return
+ * 		Unsigned 64-bit integer containing the hash - never zero, which marks an unused slot.
+ */
+unsigned long long _cache_hash(const struct cache_key *key) {
+	unsigned char prefix[CHAIN_MAX + 10];
+	unsigned int length = 0;
+
+	prefix[length++] = (unsigned char) key->stages;
+	for (unsigned int i = 0; i < key->stages && i < CHAIN_MAX; i++)
+		prefix[length++] = (unsigned char) key->chain[i];
+
+	prefix[length++] = key->encrypt ? 1 : 0;
+	memcpy(prefix + length, &key->rf_block, sizeof(unsigned int));
+	length += sizeof(unsigned int);
+
+	// The length of the key, so that the key and the message cannot be split differently.
+	memcpy(prefix + length, &key->key.length, sizeof(unsigned int));
+	length += sizeof(unsigned int);
+
+	unsigned long long hash = hash_span(make_span((string) prefix, length), HASH_SEED);
+	hash = hash_span(key->message, hash_span(key->key, hash));
+
+	return (hash == 0) ? 1 : hash;
+}
+
+/**
+ * Internal method to check if the header at the start of a file describes a cache that
+ * fits it.
+ */
+bool _cache_valid(const struct cache_header *header, unsigned long long file_size) {
+	return header->magic == CACHE_MAGIC && header->slots >= CACHE_PROBE && header->arena != 0 &&
+		header->arena % 8 == 0 && _cache_file_size(header) == file_size;
+}
+
+/**
+ * Opens a cache - created (or rebuilt, if it was left half-created) if needed.
+ *
+ * @remarks
+ * 		The size is only used to create the cache - an existing cache keeps the size it was
+ * 		created with. A file that is not a cache is never written over.
+ *
+ * @param cache: Pointer to the cache that is to be populated.
+ * @param path: Span containing the path of the file.
+ * @param size: Unsigned integer containing the size of the file, in bytes - zero for
+ * 		`CACHE_DEFAULT_SIZE`.
+ *
+ * @return
+ * 		Boolean indicating if the cache could be opened.
+ */
+bool cache_open(struct result_cache *cache, struct span path, unsigned long long size) {
+	char name[PATH_MAX];
+	if (path.length == 0 || path.length >= PATH_MAX)
+		return false;
+
+	memcpy(name, path.data, path.length);
+	name[path.length] = '\0';
+
+	if (size == 0)
+		size = CACHE_DEFAULT_SIZE;
+
+	cache->fd = open(name, O_RDWR | O_CREAT, 0644);
+	if (cache->fd < 0)
+		return false;
+
+	// Creating the cache under the lock, so that processes opening it at once do not
+	// build it over each other.
+	if (flock(cache->fd, LOCK_EX) != 0) {
+		close(cache->fd);
+		return false;
+	}
+
+	struct stat info;
+	struct cache_header header;
+	bool ready = fstat(cache->fd, &info) == 0;
+
+	if (ready && info.st_size != 0) {
+		ready = pread(cache->fd, &header, sizeof(header), 0) == (ssize_t) sizeof(header) && header.magic == CACHE_MAGIC;
+
+		if (ready && !_cache_valid(&header, (unsigned long long) info.st_size)) {
+			// Left half-created - built again, with the size asked for.
+			_cache_layout(size, &header);
+			ready = ftruncate(cache->fd, 0) == 0 &&
+				pwrite(cache->fd, &header, sizeof(header), 0) == (ssize_t) sizeof(header) &&
+				ftruncate(cache->fd, (off_t) _cache_file_size(&header)) == 0;
+		}
+	} else if (ready) {
+		// The header is written before the file is grown - a file holding the header but
+		// not the table is rebuilt by the next process opening it.
+		_cache_layout(size, &header);
+		ready = pwrite(cache->fd, &header, sizeof(header), 0) == (ssize_t) sizeof(header) &&
+			ftruncate(cache->fd, (off_t) _cache_file_size(&header)) == 0;
+	}
+
+	flock(cache->fd, LOCK_UN);
+
+	if (ready) {
+		cache->size = _cache_file_size(&header);
+		cache->base = (unsigned char *) mmap(NULL, cache->size, PROT_READ | PROT_WRITE, MAP_SHARED, cache->fd, 0);
+		ready = cache->base != MAP_FAILED;
+	}
+
+	if (!ready) {
+		close(cache->fd);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Internal method to find a record that has not been written over yet.
+ *
+ * @note
+ * 		Should only be called while holding a lock on the cache.
+ *
+ * @param position: Position the record was written at.
+ *
+ * @return
+ * 		Pointer to the record - null if it has been written over, or was not written in full.
+ */
+const struct cache_record *_cache_record(const struct result_cache *cache, unsigned long long position) {
+	const struct cache_header *header = (const struct cache_header *) cache->base;
+
+	if (position >= header->head || header->head - position > header->arena)
+		return NULL;
+
+	unsigned long long offset = position % header->arena;
+	if (offset + sizeof(struct cache_record) > header->arena)
+		return NULL;
+
+	const struct cache_record *record = (const struct cache_record *) (_cache_arena(cache) + offset);
+	unsigned long long total = sizeof(struct cache_record) +
+		(unsigned long long) record->key_length + record->message_length + record->result_length;
+
+	if (record->magic != CACHE_MAGIC || offset + total > header->arena || position + total > header->head)
+		return NULL;
+
+	return record;
+}
+
+/**
+ * Internal method to check if a record was stored under a key.
+ */
+bool _cache_matches(const struct cache_record *record, const struct cache_key *key, unsigned long long hash) {
+	if (
+		record->hash != hash || record->key_length != key->key.length ||
+		record->message_length != key->message.length || record->rf_block != key->rf_block ||
+		record->encrypt != (key->encrypt ? 1 : 0) || record->stages != key->stages
+	)
+		return false;
+
+	for (unsigned int i = 0; i < key->stages && i < CHAIN_MAX; i++)
+		if (record->chain[i] != (uint8_t) key->chain[i])
+			return false;
+
+	const char *text = (const char *) (record + 1);
+
+	return memcmp(text, key->key.data, key->key.length) == 0 &&
+		memcmp(text + key->key.length, key->message.data, key->message.length) == 0;
+}
+
+/**
+ * Looks a result up in the cache.
+ *
+ * @param cache: Pointer to the cache opened using `cache_open`.
+ * @param key: Pointer to what the result depends on.
+ * @param result: Pointer to a span in which the result is to be returned - over a new string.
+ *
+ * @return
+ * 		Boolean indicating if the result was found.
+ */
+bool cache_lookup(struct result_cache *cache, const struct cache_key *key, struct span *result) {
+	const struct cache_header *header = (const struct cache_header *) cache->base;
+	const struct cache_slot *slots = _cache_slots(cache);
+
+	unsigned long long hash = _cache_hash(key);
+	bool found = false;
+
+	if (flock(cache->fd, LOCK_SH) != 0)
+		return false;
+
+	for (unsigned int i = 0; i < CACHE_PROBE && !found; i++) {
+		const struct cache_slot *slot = &slots[(hash + i) % header->slots];
+		if (slot->hash != hash)
+			continue;
+
+		const struct cache_record *record = _cache_record(cache, slot->position);
+		if (record == NULL || !_cache_matches(record, key, hash))
+			continue;
+
+		string copy = (string) malloc(record->result_length + 1);
+		memcpy(copy, (const char *) (record + 1) + record->key_length + record->message_length, record->result_length);
+		copy[record->result_length] = '\0';
+
+		*result = make_span(copy, record->result_length);
+		found = true;
+	}
+
+	flock(cache->fd, LOCK_UN);
+
+	return found;
+}
+
+/**
+ * Stores a result in the cache - over the oldest records, once the cache is full.
+ *
+ * @param cache: Pointer to the cache opened using `cache_open`.
+ * @param key: Pointer to what the result depends on.
+ * @param result: Span containing the result.
+ *
+ * @return
+ * 		Boolean indicating if the result was stored - false if it is too large to be cached.
+ */
+bool cache_store(struct result_cache *cache, const struct cache_key *key, struct span result) {
+	struct cache_header *header = (struct cache_header *) cache->base;
+	struct cache_slot *slots = _cache_slots(cache);
+
+	unsigned long long total = _cache_align(
+		sizeof(struct cache_record) + (unsigned long long) key->key.length + key->message.length + result.length
+	);
+
+	if (total > header->arena / CACHE_RECORD_SHARE || key->stages > CHAIN_MAX)
+		return false;
+
+	unsigned long long hash = _cache_hash(key);
+
+	if (flock(cache->fd, LOCK_EX) != 0)
+		return false;
+
+	// A record never wraps around the end of the arena - the rest of the arena is skipped.
+	unsigned long long offset = header->head % header->arena;
+	if (offset + total > header->arena) {
+		header->head += header->arena - offset;
+		offset = 0;
+	}
+
+	struct cache_record record;
+	memset(&record, 0, sizeof(record));
+	record.magic = CACHE_MAGIC;
+	record.key_length = key->key.length;
+	record.message_length = key->message.length;
+	record.result_length = result.length;
+	record.hash = hash;
+	record.rf_block = key->rf_block;
+	record.encrypt = key->encrypt ? 1 : 0;
+	record.stages = (uint8_t) key->stages;
+
+	for (unsigned int i = 0; i < key->stages; i++)
+		record.chain[i] = (uint8_t) key->chain[i];
+
+	unsigned char *cursor = _cache_arena(cache) + offset;
+	memcpy(cursor, &record, sizeof(record));
+	memcpy(cursor + sizeof(record), key->key.data, key->key.length);
+	memcpy(cursor + sizeof(record) + key->key.length, key->message.data, key->message.length);
+	memcpy(cursor + sizeof(record) + key->key.length + key->message.length, result.data, result.length);
+
+	unsigned long long position = header->head;
+	header->head += total;
+
+	// Picking the slot - the one already holding the key, else an empty one (or one whose
+	// record is gone), else the one holding the oldest record.
+	struct cache_slot *chosen = NULL;
+	unsigned long long oldest = ULLONG_MAX;
+
+	for (unsigned int i = 0; i < CACHE_PROBE; i++) {
+		struct cache_slot *slot = &slots[(hash + i) % header->slots];
+		const struct cache_record *held = (slot->hash == 0) ? NULL : _cache_record(cache, slot->position);
+
+		if (held != NULL && slot->hash == hash && _cache_matches(held, key, hash)) {
+			chosen = slot;
+			break;
+		}
+
+		// A slot without a record counts as older than any of them.
+		unsigned long long age = (held == NULL) ? 0 : slot->position + 1;
+		if (age < oldest) {
+			oldest = age;
+			chosen = slot;
+		}
+	}
+
+	chosen->hash = hash;
+	chosen->position = position;
+
+	flock(cache->fd, LOCK_UN);
+
+	return true;
+}
+
+/**
+ * Closes a cache.
+ *
+ * @param cache: Pointer to the cache opened using `cache_open`.
+ */
+void cache_close(struct result_cache *cache) {
+	munmap(cache->base, cache->size);
+	close(cache->fd);
+}
@@ -0,0 +1,203 @@
+/**
+ * Source file defining the columnar transpositions - columnar transposition, and double
+ * transposition. These ciphers support lower-case alphabets only. Space and/or any other
+ * character needs to be stripped out of the contents before-hand.
+ *
+ * The message is written row after row under the key, and read back column after column -
+ * in the (alphabetical) order of the letters of the key. Nothing is padded: when the message
+ * does not fill the last row, the columns on its left hold one more character than the rest.
+ * Double transposition runs the result through a second columnar transposition, with a key
+ * of its own.
+ *
+ * The characters are moved by the transposition shared with railfence (see `tp_permute`).
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "commons.h"
+#include "ciphers.h"
+
+/**
+ * Internal method to rank the columns of a key - by their letter, and by position between
+ * equal letters.
+ *
+ * @param order: Array in which the columns are to be written, in the order they are read.
+ * @param key: Span containing the key - should only hold letters (of either case).
+ *
+ * @return
+ * 		Boolean indicating if the key could be used - not empty, not longer than `CT_KEY_MAX`,
+ * 		and holding letters only.
+ */
+bool _ct_rank(unsigned char order[CT_KEY_MAX], struct span key) {
+	if (key.length == 0 || key.length > CT_KEY_MAX)
+		return false;
+
+	for (unsigned int i = 0; i < key.length; i++)
+		if (!isalpha((unsigned char) key.data[i]))
+			return false;
+
+	unsigned int count = 0;
+	for (char letter = 'a'; letter <= 'z'; letter++)
+		for (unsigned int i = 0; i < key.length; i++)
+			if (tolower((unsigned char) key.data[i]) == letter)
+				order[count++] = (unsigned char) i;
+
+	return true;
+}
+
+/**
+ * Prepares a key for one of the columnar transpositions.
+ *
+ * @param schedule: Pointer to the schedule that is to be populated.
+ * @param key: Span containing the key - normalized for columnar transposition, and as entered
+ * 		by the user for double transposition, which takes two words separated by spaces.
+ * @param cipher: The cipher the key is for - `COLUMNAR` or `DOUBLE_COLUMNAR`.
+ *
+ * @return
+ * 		Boolean indicating if the key could be prepared.
+ */
+bool ct_prepare(struct ct_schedule *schedule, struct span key, enum crypt cipher) {
+	memset(schedule, 0, sizeof(struct ct_schedule));
+
+	if (cipher == COLUMNAR) {
+		schedule->keys = 1;
+		schedule->width[0] = key.length;
+
+		return _ct_rank(schedule->order[0], key);
+	}
+
+	// Splitting the key into its two words.
+	unsigned int cursor = 0;
+
+	for (schedule->keys = 0; schedule->keys < 2; schedule->keys++) {
+		while (cursor < key.length && key.data[cursor] == ' ')
+			cursor++;
+
+		unsigned int start = cursor;
+		while (cursor < key.length && key.data[cursor] != ' ')
+			cursor++;
+
+		schedule->width[schedule->keys] = cursor - start;
+		if (!_ct_rank(schedule->order[schedule->keys], make_span(key.data + start, cursor - start)))
+			return false;
+	}
+
+	while (cursor < key.length && key.data[cursor] == ' ')
+		cursor++;
+
+	return cursor == key.length;
+}
+
+/**
+ * Internal method to map a lane to the column it reads (see `tp_layout`).
+ *
+ * @param context: Pointer to the order of the columns.
+ */
+void _ct_columns(const void *context, unsigned long long lane, unsigned long long *first, unsigned long long *second) {
+	*first = ((const unsigned char *) context)[lane];
+	*second = TP_NONE;
+}
+
+/**
+ * Internal method to run a single columnar transposition.
+ *
+ * @param key: Index of the key to be used.
+ */
+void _ct_permute(
+	const struct ct_schedule *schedule, unsigned int key, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+) {
+	struct tp_layout layout;
+	layout.width = schedule->width[key];
+	layout.lanes = schedule->width[key];
+	layout.columns = _ct_columns;
+	layout.context = schedule->order[key];
+
+	tp_permute(&layout, dest, message, message.length, encrypt, begin, end);
+}
+
+/**
+ * Runs a columnar transposition with a prepared key, writing the result into a buffer owned
+ * by the caller.
+ *
+ * @remarks
+ * 		Does not touch any global state - safe to call from multiple threads sharing the
+ * 		same schedule. A null (or small) destination is left untouched and the size needed
+ * 		is returned. Nothing is padded - the result is as long as the message.
+ *
+ * @note
+ * 		Like railfence, the destination cannot be the same buffer as the message.
+ *
+ * @param schedule: Pointer to the key prepared using `ct_prepare`.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer in which the result is to be written.
+ * @param dest_cap: Unsigned integer containing the capacity of the buffer, in characters.
+ * @param message: Span containing the message.
+ *
+ * @return
+ * 		Unsigned integer containing the length of the result.
+ */
+unsigned int ct_run_into(
+	const struct ct_schedule *schedule, bool encrypt, string dest, unsigned int dest_cap, struct span message
+) {
+	if (dest == NULL || dest_cap <= message.length)
+		return message.length;
+
+	ct_run_slice(schedule, encrypt, dest, message, 0, message.length);
+	dest[message.length] = '\0';
+
+	return message.length;
+}
+
+/**
+ * Runs a columnar transposition over a part of a message using a prepared key.
+ *
+ * @remarks
+ * 		With a single key, the characters at positions `[begin, end)` of the cipher (the
+ * 		result while encrypting, the message while decrypting) are moved to where
+ * 		`ct_run_into` would put them - like railfence (see `rf_run_slice`). Calls over disjoint
+ * 		ranges write to disjoint parts of the destination.
+ *
+ * 		The double transposition cannot be split - the second pass needs the complete result
+ * 		of the first one. The whole message is run through both of them, and the positions
+ * 		`[begin, end)` of the result are written out - a range short of the whole message costs
+ * 		as much as the whole message.
+ *
+ * @note
+ * 		Nothing is written outside of the range, not even a string terminator. The
+ * 		destination cannot overlap with the message.
+ *
+ * @param schedule: Pointer to the key prepared using `ct_prepare`.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer for the complete result - the range is written at its own offsets.
+ * @param message: Span containing the complete message.
+ * @param begin: Unsigned integer containing the start of the range.
+ * @param end: Unsigned integer containing the end of the range.
+ */
+void ct_run_slice(
+	const struct ct_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+) {
+	if (schedule->keys == 1) {
+		_ct_permute(schedule, 0, encrypt, dest, message, begin, end);
+		return;
+	}
+
+	bool whole = begin == 0 && end == message.length;
+
+	string middle = (string) malloc(message.length + 1);
+	string result = whole ? dest : (string) malloc(message.length + 1);
+
+	// Decrypting undoes the second pass first.
+	_ct_permute(schedule, encrypt ? 0 : 1, encrypt, middle, message, 0, message.length);
+	_ct_permute(schedule, encrypt ? 1 : 0, encrypt, result, make_span(middle, message.length), 0, message.length);
+
+	if (!whole) {
+		memcpy(dest + begin, result + begin, end - begin);
+		free(result);
+	}
+
+	free(middle);
+}
@@ -4,12 +4,52 @@
 #include <ctype.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "../headers/commons.h"
+#include "../headers/cpu.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 #define true 1
 #define false 0
 
+// Number of compiled regex patterns remembered by `regex_compile`.
+#define REGEX_CACHE_SIZE 32
+
+/**
+ * Convenience method to create a span over a run of characters.
+ *
+ * @param data: Pointer to the first character covered by the span.
+ * @param length: Unsigned integer containing the number of characters covered.
+ *
+ * @return
+ * 		A span covering `length` characters starting from `data`.
+ */
+inline struct span make_span(string data, unsigned int length) {
+	struct span result = {data, length};
+	return result;
+}
+
+/**
+ * Creates a span covering a null-terminated string.
+ *
+ * @remarks
+ * 		Meant to be used only at the boundaries of the program (arguments from the
+ * 		console, string literals) - the string is scanned once here, and the length
+ * 		is carried along with the span from here on.
+ *
+ * @param data: The null-terminated string. Can be null, resulting in an empty span.
+ *
+ * @return
+ * 		A span covering the string (excluding the string terminator).
+ */
+inline struct span span_of(string data) {
+	return make_span(data, (data == NULL) ? 0 : strlen(data));
+}
+
 /**
  * Compares two strings and returns their result as a boolean. Can be used for case-insensitive or sensitive
  * comparisons as needed.
@@ -22,15 +62,18 @@
  * @return
  * 		Boolean indicating if the two strings match or not. True indicates a match.
  */
-bool compare(char *string01, char *string02, const bool case_sensitive) {
+bool compare(struct span string01, struct span string02, const bool case_sensitive) {
+	if (string01.length != string02.length)
+		// Strings of different length can never match.
+		return false;
+
 	if (case_sensitive)
-		// Using an in-built method if a case-sensitive check is to be made - directly returning the value of the
-		// method call.
-		return strcmp(string01, string02);
+		// Using an in-built method if a case-sensitive check is to be made.
+		return memcmp(string01.data, string02.data, string01.length) == 0;
 
 	// If flow-of-control reaches here, assume that the check being made is case-insensitive.
-	for (unsigned int i = 0; string01[i] != '\0' && string02[i] != '\0'; i++)
-		if (tolower(string01[i]) != tolower(string02[i]))
+	for (unsigned int i = 0; i < string01.length; i++)
+		if (tolower(string01.data[i]) != tolower(string02.data[i]))
 			// Converting each character to lower case - returning false directly in case a match fails.
 			return false;
 
@@ -50,27 +93,23 @@ bool compare(char *string01, char *string02, const bool case_sensitive) {
  * 		Useful to compare a normal string to a string literal while ensuring
  * 		a case-insensitive comparison.
  *
- * @param val01: String containing text that is to be converted to lower-case before comparison.
+ * @param val01: Span containing text that is to be converted to lower-case before comparison.
  * @param val02: String that is to be directly compared - preferably a string literal.
  *
  * @return
  * 		Boolean indicating if the two strings are an exact match of each other or not.
  * 		The check performed is case-sensitive.
  */
-inline bool l_compare(string val01, string val02) {
-	unsigned int len01 = strlen(val01);
-	unsigned int len02 = strlen(val02);
-
-	if (len01 != len02)
-		return false;
-
-	for (unsigned int i = 0; i < len01; i++)
+inline bool l_compare(struct span val01, const_str val02) {
+	for (unsigned int i = 0; i < val01.length; i++)
 		// Comparing by simply converting characters from left string to lower-case
-		// while performing a check - return false if any check fails.
-		if (tolower(val01[i]) != val02[i])
+		// while performing a check - return false if any check fails (including the
+		// literal running out of characters).
+		if (val02[i] == '\0' || tolower(val01.data[i]) != val02[i])
 			return false;
 
-	return true;
+	// Both the strings should end at the same place.
+	return val02[val01.length] == '\0';
 }
 
 /**
@@ -82,12 +121,24 @@ inline bool l_compare(string val01, string val02) {
  * @remarks
  *		Will force-stop the execution of the program in-case the regex pattern fails to
  *		compile - known trigger being placed to reduce the possibility of a runtime bug.
-
+ *
+ * @remarks
+ * 		Compiled patterns are remembered (and never freed) - the same handful of patterns
+ * 		are used over and over, compiling them once keeps repeated validations cheap.
+ *
  * @return
  * 		A pointer to the compiled regex pattern. This compiled pattern can then be used
  * 		on a string as needed.
  */
-inline pcre *regex_compile(string regex_pattern) {
+inline pcre *regex_compile(const_str regex_pattern) {
+	static const_str patterns[REGEX_CACHE_SIZE];
+	static pcre *compiled[REGEX_CACHE_SIZE];
+	static unsigned int next_slot = 0;
+
+	for (unsigned int i = 0; i < REGEX_CACHE_SIZE && patterns[i] != NULL; i++)
+		if (patterns[i] == regex_pattern || strcmp(patterns[i], regex_pattern) == 0)
+			return compiled[i];
+
 	const char *error_message;
 	int error_offset;
 
@@ -114,28 +165,249 @@ inline pcre *regex_compile(string regex_pattern) {
 		exit(-10);
 	}
 
+	// Remembering the pattern - the oldest one is replaced once the cache is full. The
+	// pattern being replaced is not freed, pointers to it might still be in use.
+	patterns[next_slot] = regex_pattern;
+	compiled[next_slot] = compiled_pattern;
+	next_slot = (next_slot + 1) % REGEX_CACHE_SIZE;
+
 	return compiled_pattern;
 }
 
 /**
  * Method to convert a string to its lower-case equivalent.
  *
- * @param message: String containing the message that is to be converted to lowercase.
+ * @param message: Span containing the message that is to be converted to lowercase.
  *
  * @return
- * 		A string with the lowercase version of every character in the original message.
+ * 		The same span, with every character in the original message converted to lowercase.
  */
-string convert_lower(string message) {
-	for (int unsigned i = 0; message[i] != '\0'; i++)
-		message[i] = (char) tolower(message[i]);
+struct span convert_lower(struct span message) {
+	for (int unsigned i = 0; i < message.length; i++)
+		message.data[i] = (char) tolower(message.data[i]);
 
 	return message;
 }
 
 
 /**
- * Internal method to create a copy of a string while also specifying the
- * length of the new string.
+ * Internal method to normalize a single character - written to the destination whether it is
+ * kept or not, and counted only if it is, so that no branch depends on the text.
+ *
+ * @remarks
+ * 		Setting the `0x20` bit lowers an alphabet, and leaves the digits alone - what is left is
+ * 		an alphabet only if it is between `a` and `z`.
+ *
+ * @param dest: Buffer in which the character is to be written.
+ * @param counter: Unsigned integer containing the number of characters kept so far.
+ * @param character: The character.
+ * @param digits: Boolean indicating if digits are to be kept as well.
+ *
+ * @return
+ * 		Unsigned integer containing the number of characters kept - including this one.
+ */
+static inline __attribute__((always_inline)) unsigned int _normalize_step(
+	string dest, unsigned int counter, unsigned char character, bool digits
+) {
+	unsigned char lower = character | 0x20;
+	bool letter = (unsigned char) (lower - 'a') < 26;
+	bool digit = digits && (unsigned char) (character - '0') < 10;
+
+	dest[counter] = (char) (letter ? lower : character);
+	return counter + (letter | digit);
+}
+
+/**
+ * The kernels normalizing a run of characters - a character at a time (see `_normalize_step`),
+ * and vectors of characters at a time where the processor has them. A vector made up only of
+ * characters that are kept (plain text, or text normalized before) is written in one go, the
+ * others are left to `_normalize_step`.
+ *
+ * @note
+ * 		The destination can be the same buffer as the source - nothing is written past the
+ * 		characters already read.
+ */
+unsigned int _normalize_generic(string dest, const char *source, unsigned int length, bool digits) {
+	unsigned int counter = 0;
+
+	for (unsigned int i = 0; i < length; i++)
+		counter = _normalize_step(dest, counter, (unsigned char) source[i], digits);
+
+	return counter;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2"))) unsigned int _normalize_avx2(
+	string dest, const char *source, unsigned int length, bool digits
+) {
+	unsigned int counter = 0, i = 0;
+
+	for (; i + 32 <= length; i += 32) {
+		__m256i value = _mm256_loadu_si256((const __m256i *) (source + i));
+		__m256i lower = _mm256_or_si256(value, _mm256_set1_epi8(0x20));
+
+		// Unsigned comparisons - a lane is in range if the smaller of it and the bound is itself.
+		__m256i shifted = _mm256_sub_epi8(lower, _mm256_set1_epi8('a'));
+		__m256i letter = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(25)), shifted);
+		__m256i kept = letter;
+
+		if (digits) {
+			__m256i number = _mm256_sub_epi8(value, _mm256_set1_epi8('0'));
+			kept = _mm256_or_si256(kept, _mm256_cmpeq_epi8(_mm256_min_epu8(number, _mm256_set1_epi8(9)), number));
+		}
+
+		if (_mm256_movemask_epi8(kept) == -1) {
+			_mm256_storeu_si256((__m256i *) (dest + counter), _mm256_blendv_epi8(value, lower, letter));
+			counter += 32;
+		} else {
+			for (unsigned int j = i; j < i + 32; j++)
+				counter = _normalize_step(dest, counter, (unsigned char) source[j], digits);
+		}
+	}
+
+	for (; i < length; i++)
+		counter = _normalize_step(dest, counter, (unsigned char) source[i], digits);
+
+	return counter;
+}
+
+__attribute__((target("avx512bw"))) unsigned int _normalize_avx512(
+	string dest, const char *source, unsigned int length, bool digits
+) {
+	unsigned int counter = 0, i = 0;
+
+	for (; i + 64 <= length; i += 64) {
+		__m512i value = _mm512_loadu_si512((const void *) (source + i));
+		__m512i lower = _mm512_or_si512(value, _mm512_set1_epi8(0x20));
+
+		__mmask64 letter = _mm512_cmple_epu8_mask(_mm512_sub_epi8(lower, _mm512_set1_epi8('a')), _mm512_set1_epi8(25));
+		__mmask64 kept = letter;
+
+		if (digits)
+			kept |= _mm512_cmple_epu8_mask(_mm512_sub_epi8(value, _mm512_set1_epi8('0')), _mm512_set1_epi8(9));
+
+		if (kept == ~0ULL) {
+			_mm512_storeu_si512((void *) (dest + counter), _mm512_mask_blend_epi8(letter, value, lower));
+			counter += 64;
+		} else {
+			for (unsigned int j = i; j < i + 64; j++)
+				counter = _normalize_step(dest, counter, (unsigned char) source[j], digits);
+		}
+	}
+
+	for (; i < length; i++)
+		counter = _normalize_step(dest, counter, (unsigned char) source[i], digits);
+
+	return counter;
+}
+
+#endif
+
+/**
+ * The normalization kernel built for an instruction set.
+ */
+struct normalize_kernel {
+	enum isa isa;
+
+	unsigned int (*run)(string dest, const char *source, unsigned int length, bool digits);
+};
+
+// The kernels, best first - the last one runs anywhere.
+const struct normalize_kernel normalize_kernels[] = {
+#if defined(__x86_64__) || defined(__i386__)
+	{ ISA_AVX512, _normalize_avx512 },
+	{ ISA_AVX2, _normalize_avx2 },
+#endif
+	{ ISA_GENERIC, _normalize_generic }
+};
+
+// The kernel in use - see `normalize_select_kernel`.
+const struct normalize_kernel *normalize_kernel = &normalize_kernels[
+	sizeof(normalize_kernels) / sizeof(normalize_kernels[0]) - 1
+];
+
+/**
+ * Selects the normalization kernel - the best one needing at most the instruction set given.
+ *
+ * @note
+ * 		Not thread-safe - meant to be called at startup (see `cpu_dispatch`).
+ *
+ * @param isa: The instruction set that can be used.
+ *
+ * @return
+ * 		The instruction set of the kernel selected.
+ */
+enum isa normalize_select_kernel(enum isa isa) {
+	unsigned int i = 0;
+	while (normalize_kernels[i].isa > isa)
+		i++;
+
+	normalize_kernel = &normalize_kernels[i];
+	return normalize_kernel->isa;
+}
+
+/**
+ * Copies the alphabets from the source into the destination, converting them to
+ * lower-case - everything else (spaces, digits and more) is dropped.
+ *
+ * @remarks
+ * 		This is the normalization needed by the cipher algorithms before they can be
+ * 		used on a message entered by the user. Only the ASCII alphabets are kept, as
+ * 		`isalpha` does in the default locale.
+ *
+ * @note
+ * 		The destination should be able to hold `source.length` characters, and can be
+ * 		the same buffer as the source. It is not terminated by this method.
+ *
+ * @param dest: Buffer in which the normalized characters are to be written.
+ * @param source: Span containing the text that is to be normalized.
+ *
+ * @return
+ * 		Unsigned integer containing the number of characters written.
+ */
+unsigned int normalize_into(string dest, struct span source) {
+	return normalize_kernel->run(dest, source.data, source.length, false);
+}
+
+/**
+ * Similar to `normalize_into`, except that digits are kept as well - the normalization
+ * needed by the alphanumeric play-fair (`playfair6`).
+ *
+ * @param dest: Buffer in which the normalized characters are to be written. Can be the
+ * 		same buffer as the source.
+ * @param source: Span containing the text that is to be normalized.
+ *
+ * @return
+ * 		Unsigned integer containing the number of characters written.
+ */
+unsigned int normalize_alnum_into(string dest, struct span source) {
+	return normalize_kernel->run(dest, source.data, source.length, true);
+}
+
+/**
+ * Calculates a (non-cryptographic) hash of the characters covered by a span - uses
+ * the FNV-1a algorithm.
+ *
+ * @param data: Span containing the characters to be hashed.
+ * @param seed: Hash to continue from - `HASH_SEED` to start afresh. Can be used to hash
+ * 		multiple spans as if they were one.
+ *
+ * @return
+ * 		Unsigned 64-bit integer containing the hash.
+ */
+inline unsigned long long hash_span(struct span data, unsigned long long seed) {
+	for (unsigned int i = 0; i < data.length; i++) {
+		seed ^= (unsigned char) data.data[i];
+		seed *= 0x100000001b3ULL;
+	}
+
+	return seed;
+}
+
+/**
+ * Internal method to create a copy of a span while also specifying the
+ * capacity of the new string.
  *
  * @remarks
  * 		This method is a slight-modified version of `gen_str`, in case edge
@@ -144,48 +416,45 @@ string convert_lower(string message) {
  * 		used in such scenario(s).
  *
  * @note
- *		If the length required is less than the length of the original
- * 		string, only the first `len-1` characters from the original string will
+ *		If the capacity required is less than the length of the original
+ * 		span, only the first `capacity` characters from the original span will
  * 		be copied over.
  *
  * @note
- * 		A length of `0` indicates that this method will create a new string
- * 		with an exact copy of the original string - without leaving any
- * 		extra space(s).
+ * 		The new string always has space for one extra character after the
+ * 		capacity requested, and is terminated right after the characters copied
+ * 		- it can be passed to methods expecting a null-terminated string.
  *
  * @note
  * 		Caution: New string(s) are created by this method using `malloc`
  * 		internally - as such, they need to be manually destroyed in order to
  * 		avoid memory leaks (or overflows).
  *
- * @param message: String containing the message that is to be copied over.
- * @param len: Unsigned integer indicating the required length of the new string.
+ * @param message: Span containing the message that is to be copied over.
+ * @param capacity: Unsigned integer indicating the number of characters the new string
+ * 		should be able to hold.
  *
  * @return
- * 		String that is a copy of the original string and has the required length.
+ * 		Span over the new string, covering the characters copied from the original.
  */
-inline string raw_gen_str(string message, unsigned int len) {
-	if (len == 0)
-		// If a length of zero is supplied, modifying it to containing the length
-		// of the source string + 1 (extra space for string terminator)
-		len = strlen(message) + 1;
+inline struct span raw_gen_str(struct span message, unsigned int capacity) {
+	unsigned int length = (message.length < capacity) ? message.length : capacity;
 
-	// Creating a new string.
-	string temp = (string) malloc((len * sizeof(char)) - 1);
+	// Creating a new string - with an extra space for the string terminator.
+	string temp = (string) malloc((capacity + 1) * sizeof(char));
 
-	for (unsigned int i = 0; i < len - 1; i++)
-		temp[i] = message[i];
+	memcpy(temp, message.data, length);
 
 	// Adding the string terminator to the end of the string.
-	temp[len-1] = '\0';
-	return temp;
+	temp[length] = '\0';
+	return make_span(temp, length);
 }
 
 /**
- * Copies the content of the original string and returns a copy of them
+ * Copies the content of the original span and returns a copy of them
  * in a new string.
  *
- * @param message: Source string. Contents of this string will be copied.
+ * @param message: Source span. Contents of this span will be copied.
  *
  * @remarks
  * 		Since modifications made to hard-coded string are a part of undefined
@@ -194,7 +463,7 @@ inline string raw_gen_str(string message, unsigned int len) {
  *
  * @note
  * 		This method delegates to `raw_gen_str` method internally. The length
- * 		of the string created will be equal to the source string (+1 for
+ * 		of the string created will be equal to the source span (+1 for
  * 		string terminator).
  *
  * 	@note
@@ -203,14 +472,14 @@ inline string raw_gen_str(string message, unsigned int len) {
  * 		or it could lead to a potential memory leak.
  *
  * @return
- * 		A string containing a copy of the contents of the original string.
+ * 		A span over a copy of the contents of the original span.
  */
-inline string gen_str(string message) {
-	return raw_gen_str(message, 0);
+inline struct span gen_str(struct span message) {
+	return raw_gen_str(message, message.length);
 }
 
 /**
- * Internal method to create a copy of the source string with additional space to
+ * Internal method to create a copy of the source span with additional space to
  * concatenate extra text as needed.
  *
  * @remarks
@@ -222,19 +491,19 @@ inline string gen_str(string message) {
  * 		lead to a potential memory leak.
  *
  * @note
- * 		Strings created by this message will have a total length of `strlen(message)` +
+ * 		Strings created by this message will have a total capacity of `message.length` +
  * 		`pad_length` + 1 (for the string terminator).
  *
- * @param message: Source string that is to be copied over.
+ * @param message: Source span that is to be copied over.
  * @param pad_length: Unsigned integer containing the extra size required in the resultant
  * 		string.
  *
  * @return
- * 		String containing a copy of the contents of the original string, and the extra space
- * 		as required.
+ * 		Span over a copy of the contents of the original span - the string has the extra
+ * 		space as required after the characters covered.
  */
-inline string gen_str_pad(string message, unsigned int pad_length) {
-	return raw_gen_str(message, strlen(message) + pad_length);
+inline struct span gen_str_pad(struct span message, unsigned int pad_length) {
+	return raw_gen_str(message, message.length + pad_length);
 }
 
 
@@ -254,8 +523,8 @@ inline string gen_str_pad(string message, unsigned int pad_length) {
  * 		Boolean value containing true if the pattern compiles successfully and matches the input
  * 		string. False increase the string does not match with the pattern.
  */
-bool validate(string regex_pattern, string input) {
-	if (input == NULL || regex_pattern == NULL)
+bool validate(const_str regex_pattern, struct span input) {
+	if (input.data == NULL || regex_pattern == NULL)
 		// Prevent random errors
 		return false;
 
@@ -263,8 +532,8 @@ bool validate(string regex_pattern, string input) {
 	int result = pcre_exec(
 		regex_compile(regex_pattern),  // The compiled pattern against which string is to be checked.
 		NULL,                          // No associated structure required.
-		input,                         // The string which is to be matched to the compiled pattern.
-		(int) strlen(input),           // Basically, the length up to which the pattern is to be checked.
+		input.data,                    // The string which is to be matched to the compiled pattern.
+		(int) input.length,            // Basically, the length up to which the pattern is to be checked.
 		0,                             // Matching the pattern from the start of the string - no offset required.
 		0,                             // No special options needed
 		0,                             // No result offsets to be acquired - used if groups are to be extracted.
@@ -291,18 +560,18 @@ bool validate(string regex_pattern, string input) {
  * @param input_string: The input string against which the regex pattern is to be compiled and tested.
  *
  * @return
- * 		Value obtained by extracting the value of the regex pattern by matching it against the input
- * 		string.
+ * 		Span over the value obtained by extracting the value of the regex pattern by matching it
+ * 		against the input string - points into the input string, nothing is copied.
  */
-string extract_data(string regex_pattern, string input_string) {
+struct span extract_data(const_str regex_pattern, struct span input_string) {
 	int vector_size = 48;
 	int result_vector[vector_size];
 
 	int rc = pcre_exec(
 		regex_compile(regex_pattern),
 		0,
-		input_string,
-		(int) strlen(input_string),
+		input_string.data,
+		(int) input_string.length,
 		0,
 		0,
 		result_vector,
@@ -310,9 +579,9 @@ string extract_data(string regex_pattern, string input_string) {
 	);
 
 	if (rc >= 3)
-		return input_string + result_vector[2];
+		return make_span(input_string.data + result_vector[2], result_vector[3] - result_vector[2]);
 	else
-		return "";
+		return make_span("", 0);
 }
 
 /**
@@ -324,22 +593,68 @@ string extract_data(string regex_pattern, string input_string) {
  * 		by this tuple will be of the type `UNDEFINED`. And the calling method should
  * 		handle such a response appropriately.
  *
- * @param message: String text that is to be mapped to an enum value.
+ * @param message: Span containing the text that is to be mapped to an enum value.
  *
  * @return
  * 		A value of type `crypt` indicating the cipher type that the text maps to.
  */
-inline enum crypt map_cipher(string message) {
+inline enum crypt map_cipher(struct span message) {
 	if (l_compare(message, "playfair"))
 		return PLAYFAIR;
+	else if (l_compare(message, "playfair6"))
+		return PLAYFAIR6;
 	else if (l_compare(message, "hill"))
 		return HILL_CIPHER;
+	else if (l_compare(message, "hill256"))
+		return HILL256;
+	else if (l_compare(message, "hill95"))
+		return HILL95;
 	else if (l_compare(message, "railfence"))
 		return RAILFENCE;
+	else if (l_compare(message, "vigenere"))
+		return VIGENERE;
+	else if (l_compare(message, "beaufort"))
+		return BEAUFORT;
+	else if (l_compare(message, "variant-beaufort"))
+		return VARIANT_BEAUFORT;
+	else if (l_compare(message, "autokey"))
+		return AUTOKEY;
+	else if (l_compare(message, "caesar"))
+		return CAESAR;
+	else if (l_compare(message, "rot13"))
+		return ROT13;
+	else if (l_compare(message, "atbash"))
+		return ATBASH;
+	else if (l_compare(message, "affine"))
+		return AFFINE;
+	else if (l_compare(message, "keyword"))
+		return KEYWORD;
+	else if (l_compare(message, "columnar"))
+		return COLUMNAR;
+	else if (l_compare(message, "double-columnar"))
+		return DOUBLE_COLUMNAR;
 	else
 		return UNDEFINED;
 }
 
+/**
+ * Maps a cipher back to its name - the reverse of `map_cipher`.
+ *
+ * @param cipher: The cipher.
+ *
+ * @return
+ * 		Constant string containing the name of the cipher - `unknown` if it is not one.
+ */
+const_str cipher_name(enum crypt cipher) {
+	static const_str names[UNDEFINED] = {
+		"playfair", "hill", "railfence", "playfair6", "hill256", "hill95", "vigenere", "beaufort",
+		"variant-beaufort", "autokey", "caesar", "rot13", "atbash", "affine", "keyword", "columnar",
+		"double-columnar"
+	};
+
+	return ((unsigned int) cipher < UNDEFINED) ? names[cipher] : "unknown";
+}
+
 
 /**
  * Convenience method to emulate the behaviour of `fgets` method to read a string
@@ -360,32 +675,32 @@ inline enum crypt map_cipher(string message) {
  * 		that runtime of this method in low.
  *
  * @param dest: Pointer to the destination string where the output is to be stored.
- * @param string_len: Unsigned integer containing the length of the source string.
+ * @param capacity: Unsigned integer containing the number of characters the destination can hold.
  *
  * @return
- * 		The source string after all modifications have been made to it.
+ * 		Span over the destination string, covering the characters read. The string is
+ * 		also terminated.
  */
-extern inline string scan_str(string dest, unsigned int string_len) {
+extern inline struct span scan_str(string dest, unsigned int capacity) {
 	// Static variables, will be initialized as needed - declaring once to eliminate
 	// the time being wasted in creating/destroying them.
 
-	static char c;
+	static int c;
 	static unsigned int i;
 
-	for (i = 0; i < string_len - 1; i++) {
+	for (i = 0; i < capacity - 1; i++) {
 		// Reading one character at a time from stdin.
 		c = getchar();
 
-		// Breaking the loop if the character is a new line or string-terminator.
-		if (c == '\n' || c == '\0') {
-			dest[i] = '\0';
+		// Breaking the loop if the character is a new line or string-terminator (or if
+		// there is nothing left to read).
+		if (c == '\n' || c == '\0' || c == EOF)
 			break;
-		}
 
-		dest[i] = c;
+		dest[i] = (char) c;
 	}
 
 	// String-terminator at the end - space has already been reserved in the loop
-	dest[string_len] = '\0';
-	return dest;
+	dest[i] = '\0';
+	return make_span(dest, i);
 }
@@ -0,0 +1,115 @@
+// Implementation of the co-process mode. The same framing as the daemon mode (see
+// `server.c`) - over stdin and stdout instead of a socket, for a single client: the parent
+// process. Stdin is read in large chunks, every complete request in a chunk is handled at
+// once (see `handle_buffered`), and all their responses go out in a single write - a parent
+// with many requests in flight gets them answered with a couple of system calls.
+//
+// Stdout carries nothing but responses - errors are reported on stderr.
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "coproc.h"
+#include "server.h"
+
+#define true 1
+#define false 0
+
+// Number of characters read from stdin at a time.
+#define COPROC_CHUNK (1u << 20)
+
+/**
+ * Internal method to write every response in a buffer to stdout - emptying the buffer.
+ *
+ * @param output: Pointer to the buffer holding the responses.
+ *
+ * @return
+ * 		Boolean indicating if the responses could be written - false once the parent has
+ * 		stopped reading.
+ */
+bool _coproc_flush(struct frame_buffer *output) {
+	unsigned int sent = 0;
+
+	while (sent < output->length) {
+		ssize_t count = write(STDOUT_FILENO, output->data + sent, output->length - sent);
+
+		if (count < 0) {
+			if (errno == EINTR)
+				continue;
+
+			return false;
+		}
+
+		sent += count;
+	}
+
+	output->length = 0;
+	return true;
+}
+
+/**
+ * Runs the program in co-process mode - answers requests from stdin until it is closed.
+ *
+ * @remarks
+ * 		Requests are answered in the order they arrive, as soon as the chunk they arrived in
+ * 		is handled - the parent does not need to close stdin to get its responses.
+ *
+ * @return
+ * 		Integer containing the exit code for the program - non-zero if the input is not a
+ * 		valid stream of requests, or the responses could not be written.
+ */
+int coproc_run() {
+	// A parent going away mid-write is reported through `write` instead.
+	signal(SIGPIPE, SIG_IGN);
+
+	struct frame_buffer input = {NULL, 0, 0};
+	struct frame_buffer output = {NULL, 0, 0};
+	int status = 0;
+
+	while (true) {
+		frame_reserve(&input, COPROC_CHUNK);
+
+		ssize_t count = read(STDIN_FILENO, input.data + input.length, input.capacity - input.length);
+		if (count < 0 && errno == EINTR)
+			continue;
+
+		if (count < 0) {
+			fprintf(stderr, "\nError: Could not read the requests - %s\n", strerror(errno));
+			status = -10;
+			break;
+		} else if (count == 0) {
+			// The parent is done sending requests.
+			if (input.length > 0) {
+				fprintf(stderr, "\nError: The input ended in the middle of a request\n");
+				status = -10;
+			}
+
+			break;
+		}
+
+		input.length += count;
+
+		bool trusted = handle_buffered(&input, &output);
+
+		if (!_coproc_flush(&output)) {
+			fprintf(stderr, "\nError: Could not write the responses - %s\n", strerror(errno));
+			status = -10;
+			break;
+		}
+
+		if (!trusted) {
+			fprintf(stderr, "\nError: Received a request larger than %u characters\n", FRAME_MAX_LENGTH);
+			status = -10;
+			break;
+		}
+	}
+
+	free(input.data);
+	free(output.data);
+
+	return status;
+}
@@ -0,0 +1,129 @@
+// Implementation of the selection of cipher kernels. The processor is asked (through
+// `cpuid`) which instruction sets it supports, and every cipher with a table of kernels
+// picks the best one at or below that - a single binary runs everywhere from SSE2-only
+// processors to AVX-512 ones, using whatever each of them has.
+//
+// The selection can be forced down to a lower instruction set (`--force-isa`), to compare
+// the kernels against each other on the same machine.
+
+#include <stdio.h>
+
+#include "cpu.h"
+#include "ciphers.h"
+#include "crack.h"
+
+#define true 1
+#define false 0
+
+// The instruction set the kernels were selected for - the generic kernels are used until
+// `cpu_dispatch` is called.
+enum isa cpu_selected = ISA_GENERIC;
+
+/**
+ * Finds the best instruction set supported by the processor (and the operating system).
+ *
+ * @return
+ * 		The best instruction set with kernels that the processor can run.
+ */
+enum isa cpu_detect() {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+
+	// The byte kernels need the byte and word instructions - without them, every byte of a
+	// 64-byte vector is handled in two halves. The hill kernels only need the foundation.
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+		return ISA_AVX512;
+
+	if (__builtin_cpu_supports("avx2"))
+		return ISA_AVX2;
+#endif
+
+	return ISA_GENERIC;
+}
+
+/**
+ * Maps the name of an instruction set (as accepted by `--force-isa`) to its enum.
+ *
+ * @param name: Span containing the name.
+ *
+ * @return
+ * 		The instruction set - `ISA_UNDEFINED` if the name is unknown.
+ */
+enum isa map_isa(struct span name) {
+	for (enum isa isa = ISA_GENERIC; isa < ISA_UNDEFINED; isa++)
+		if (l_compare(name, isa_name(isa)))
+			return isa;
+
+	return ISA_UNDEFINED;
+}
+
+/**
+ * Returns the name of an instruction set.
+ *
+ * @param isa: The instruction set.
+ *
+ * @return
+ * 		Constant string containing the name - the same one `map_isa` takes.
+ */
+const_str isa_name(enum isa isa) {
+	switch (isa) {
+		case ISA_GENERIC:
+			return "generic";
+
+		case ISA_AVX2:
+			return "avx2";
+
+		case ISA_AVX512:
+			return "avx512";
+
+		default:
+			return "unknown";
+	}
+}
+
+/**
+ * Selects the kernels of every cipher for an instruction set - to be called once at startup,
+ * before any thread is started.
+ *
+ * @param isa: The instruction set to be used - `ISA_UNDEFINED` to use the best one the
+ * 		processor supports.
+ *
+ * @return
+ * 		Boolean indicating if the kernels could be selected - false if the processor does
+ * 		not support the instruction set asked for.
+ */
+bool cpu_dispatch(enum isa isa) {
+	enum isa supported = cpu_detect();
+
+	if (isa == ISA_UNDEFINED)
+		isa = supported;
+	else if (isa > supported)
+		return false;
+
+	cpu_selected = isa;
+	hc_select_kernel(isa);
+	vg_select_kernel(isa);
+	sb_select_kernel(isa);
+	normalize_select_kernel(isa);
+	hc_crack_select_kernel(isa);
+
+	return true;
+}
+
+/**
+ * Prints the instruction set in use, and the kernel picked for each cipher.
+ */
+void cpu_report() {
+	printf("\nProcessor supports: %s\nSelected: %s\n", isa_name(cpu_detect()), isa_name(cpu_selected));
+
+	printf("\nKernels:\n");
+	printf("\thill/hill256/hill95: %s\n", isa_name(hc_select_kernel(cpu_selected)));
+	printf("\tvigenere/beaufort/variant-beaufort/autokey: %s\n", isa_name(vg_select_kernel(cpu_selected)));
+	printf("\tcaesar/rot13/atbash/affine/keyword: %s\n", isa_name(sb_select_kernel(cpu_selected)));
+
+	printf("\tnormalization: %s\n", isa_name(normalize_select_kernel(cpu_selected)));
+	printf("\thill crack scoring: %s\n", isa_name(hc_crack_select_kernel(cpu_selected)));
+
+	// Everything else has a single (scalar) kernel so far.
+	printf("\tplayfair/playfair6/railfence/columnar/double-columnar: %s\n", isa_name(ISA_GENERIC));
+}
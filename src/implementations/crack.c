@@ -0,0 +1,283 @@
+// Implementation of the parts shared by the crack modes - the ranking of candidates and
+// the loading of n-gram statistics - along with the railfence crack.
+//
+// Railfence has very few keys (one per rail count), as such every rail count is tried.
+// Candidates are compared on a sample from the start of the plaintext, decrypted directly
+// (see `rf_decrypt_range`) - the cost of trying a key does not depend on the length of
+// the message, and the rail counts are spread over the thread pool.
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "crack.h"
+#include "ciphers.h"
+#include "thread_pool.h"
+
+#define true 1
+#define false 0
+
+// Number of characters of each candidate plaintext that are scored.
+#define CRACK_SAMPLE 2048
+
+// Candidates are decrypted and scored this many characters at a time - and dropped as soon
+// as they cannot make it into the ranking anymore.
+#define CRACK_CHUNK 64
+
+// Largest rail count tried by default (unless `--max-rails` says otherwise).
+#define CRACK_DEFAULT_RAILS 10000
+
+// Length of the n-grams used to score railfence candidates.
+#define RF_CRACK_NGRAM 3
+
+/**
+ * Initializes an empty ranking.
+ *
+ * @param ranking: Pointer to the ranking - to be released using `ranking_free`.
+ * @param capacity: Unsigned integer containing the number of candidates to be kept.
+ */
+void ranking_init(struct crack_ranking *ranking, unsigned int capacity) {
+	pthread_mutex_init(&ranking->lock, NULL);
+
+	ranking->capacity = (capacity == 0) ? 1 : capacity;
+	ranking->items = (struct crack_candidate *) malloc(sizeof(struct crack_candidate) * ranking->capacity);
+	ranking->count = 0;
+	ranking->threshold = -(1LL << 62);
+}
+
+/**
+ * Offers a candidate to the ranking - kept only if it is among the best seen so far.
+ *
+ * @remarks
+ * 		Safe to call from any number of threads at once.
+ *
+ * @param ranking: Pointer to the ranking.
+ * @param key: The candidate key.
+ * @param score: Score of the plaintext given by the key.
+ */
+void ranking_offer(struct crack_ranking *ranking, unsigned long long key, long long score) {
+	if (score <= __atomic_load_n(&ranking->threshold, __ATOMIC_RELAXED))
+		return;
+
+	pthread_mutex_lock(&ranking->lock);
+
+	if (ranking->count < ranking->capacity || score > ranking->items[ranking->count - 1].score) {
+		// Insertion sort - the ranking is short.
+		unsigned int position = (ranking->count < ranking->capacity) ? ranking->count++ : ranking->count - 1;
+
+		while (position > 0 && ranking->items[position - 1].score < score) {
+			ranking->items[position] = ranking->items[position - 1];
+			position--;
+		}
+
+		ranking->items[position].key = key;
+		ranking->items[position].score = score;
+
+		if (ranking->count == ranking->capacity)
+			__atomic_store_n(&ranking->threshold, ranking->items[ranking->count - 1].score, __ATOMIC_RELAXED);
+	}
+
+	pthread_mutex_unlock(&ranking->lock);
+}
+
+/**
+ * Releases the memory held by a ranking.
+ *
+ * @param ranking: Pointer to the ranking.
+ */
+void ranking_free(struct crack_ranking *ranking) {
+	pthread_mutex_destroy(&ranking->lock);
+	free(ranking->items);
+}
+
+/**
+ * Builds the n-gram table to be used by a crack run - mapped from the file of tables in
+ * the options, built from the corpus in the options, or from the built-in sample.
+ *
+ * @param table: Pointer to the table that is to be populated.
+ * @param n: Unsigned integer containing the length of the n-grams.
+ * @param options: Pointer to the options of the run.
+ *
+ * @return
+ * 		Boolean indicating if the table could be built. Prints the reason otherwise.
+ */
+bool crack_table(struct ngram_table *table, unsigned int n, const struct crack_options *options) {
+	if (options->ngrams.data != NULL) {
+		string path = gen_str(options->ngrams).data;
+		bool loaded = ngram_load(table, n, path);
+
+		if (!loaded)
+			printf("\nError: Could not load the %u-gram table from `%s`\n", n, path);
+
+		free(path);
+		return loaded;
+	}
+
+	if (options->corpus.data == NULL)
+		return ngram_build(table, n, scoring_sample());
+
+	string path = gen_str(options->corpus).data;
+	FILE *file = fopen(path, "rb");
+
+	if (file == NULL) {
+		printf("\nError: Could not open the corpus `%s`\n", path);
+		free(path);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	string contents = (string) malloc(size > 0 ? size : 1);
+	size_t length = fread(contents, sizeof(char), size > 0 ? size : 0, file);
+	fclose(file);
+
+	bool built = ngram_build(table, n, make_span(contents, (unsigned int) length));
+	if (!built)
+		printf("\nError: The corpus `%s` does not contain enough text\n", path);
+
+	free(contents);
+	free(path);
+
+	return built;
+}
+
+/**
+ * A railfence crack - the range of the job covers the rail counts to be tried, starting
+ * from two rails.
+ */
+struct rf_crack_job {
+	// The job run on the pool - should stay the first member.
+	struct pool_job job;
+
+	struct span cipher;
+	const struct ngram_table *table;
+	struct crack_ranking *ranking;
+};
+
+/**
+ * Internal method to try a range of rail counts - called on the workers.
+ *
+ * @remarks
+ * 		Scores only go down as more of the plaintext is scored, as such a candidate whose
+ * 		partial score is already below the worst one in the (full) ranking is dropped.
+ */
+void rf_crack_part(struct pool_job *job, unsigned int begin, unsigned int end) {
+	struct rf_crack_job *crack = (struct rf_crack_job *) job;
+
+	unsigned int sample = (crack->cipher.length < CRACK_SAMPLE) ? crack->cipher.length : CRACK_SAMPLE;
+	unsigned int overlap = crack->table->n - 1;
+	char buffer[CRACK_SAMPLE];
+
+	for (unsigned int i = begin; i < end; i++) {
+		unsigned int rows = i + 2;
+		long long score = 0;
+		unsigned int done = 0;
+
+		while (done < sample) {
+			unsigned int next = (done + CRACK_CHUNK < sample) ? done + CRACK_CHUNK : sample;
+			rf_decrypt_range(rows, buffer, crack->cipher, done, next);
+
+			// Scoring the n-grams ending in this chunk - starting a little before it.
+			unsigned int from = (done > overlap) ? done - overlap : 0;
+			score += ngram_score(crack->table, make_span(buffer + from, next - from));
+
+			done = next;
+			if (score <= __atomic_load_n(&crack->ranking->threshold, __ATOMIC_RELAXED))
+				break;
+		}
+
+		if (done == sample)
+			ranking_offer(crack->ranking, rows, score);
+	}
+}
+
+/**
+ * Cracks a railfence cipher - tries every rail count, and prints the best candidates
+ * along with their plaintexts.
+ *
+ * @remarks
+ * 		The cipher does not need to be padded to fit the diagonal - text ciphered by tools
+ * 		that do not pad is read as well.
+ *
+ * @param cipher: Span containing the (normalized) cipher.
+ * @param options: Pointer to the options of the run.
+ *
+ * @return
+ * 		Integer containing the exit code for the program.
+ */
+int crack_railfence(struct span cipher, const struct crack_options *options) {
+	struct timespec started, stopped;
+	clock_gettime(CLOCK_MONOTONIC, &started);
+
+	if (cipher.length < 3) {
+		printf("\nError: The message is too short to be cracked\n");
+		return -10;
+	}
+
+	// Anything from `length` rails on leaves the message as-is.
+	unsigned int limit = (options->max_rails != 0) ? options->max_rails : CRACK_DEFAULT_RAILS;
+	if (limit > cipher.length - 1)
+		limit = cipher.length - 1;
+
+	if (limit < 2) {
+		printf("\nError: At least two rails should be tried\n");
+		return -10;
+	}
+
+	struct ngram_table table;
+	if (!crack_table(&table, RF_CRACK_NGRAM, options))
+		return -10;
+
+	struct crack_ranking ranking;
+	ranking_init(&ranking, options->top);
+
+	struct rf_crack_job crack;
+	memset(&crack, 0, sizeof(crack));
+
+	crack.cipher = cipher;
+	crack.table = &table;
+	crack.ranking = &ranking;
+
+	crack.job.run = rf_crack_part;
+	crack.job.length = limit - 1;
+	crack.job.align = 1;
+	crack.job.grain = 16;
+
+	struct thread_pool *pool = pool_create(options->threads);
+	pool_submit(pool, &crack.job);
+	pool_destroy(pool);
+
+	clock_gettime(CLOCK_MONOTONIC, &stopped);
+	double elapsed = (stopped.tv_sec - started.tv_sec) * 1e3 + (stopped.tv_nsec - started.tv_nsec) / 1e6;
+
+	printf("\nTried %u rail counts in %.2f ms\n", limit - 1, elapsed);
+
+	// Scores are reported per n-gram, so that they read the same for any length.
+	unsigned int sample = (cipher.length < CRACK_SAMPLE) ? cipher.length : CRACK_SAMPLE;
+	double ngrams = (sample >= RF_CRACK_NGRAM) ? sample - RF_CRACK_NGRAM + 1 : 1;
+
+	string plaintext = (string) malloc(cipher.length);
+
+	for (unsigned int i = 0; i < ranking.count; i++) {
+		unsigned int rows = (unsigned int) ranking.items[i].key;
+		rf_run_unpadded(rows, false, plaintext, cipher);
+
+		printf(
+			"\n#%u - Rails: %u, Fitness: %.3f\n\t%.*s\n",
+			i + 1, rows, ranking.items[i].score / (double) NGRAM_SCALE / ngrams, cipher.length, plaintext
+		);
+	}
+
+	printf("\n");
+
+	free(plaintext);
+	ranking_free(&ranking);
+	ngram_free(&table);
+
+	return 0;
+}
@@ -1,6 +1,9 @@
 
 #include "data_input.h"
 #include "ciphers.h"
+#include "budget.h"
+#include "cache.h"
+#include "keyring.h"
 
 
 /**
@@ -30,7 +33,7 @@ void fetch_cli_args(struct user_data *this, unsigned int count, string *args) {
 
 	// Ignoring the first arguments - this would be the path to the main script.
 	for (unsigned int i = 1; i < count; i++) {
-		string arg = args[i];
+		struct span arg = span_of(args[i]);
 		// Iterating through each argument and validating them based on regex pattern.
 		if (validate("^--verbose$", arg)) {
 			// Flipping the verbose flag.
@@ -39,13 +42,18 @@ void fetch_cli_args(struct user_data *this, unsigned int count, string *args) {
 			this->encrypt = true;
 		} else if (validate("--(?i)decrypt$", arg)) {
 			this->encrypt = false;
-		} else if (validate("^--message=(([a-zA-Z ]+))$", arg)) {
-			// Extracting the contents of the message.
-			this->cipher_message = extract_data("^--message=(([A-Za-z ]+))$", arg);
-		} else if (validate("^--key=(([A-Za-z ]+|\\d+))$", arg)) {
+		} else if (validate("^--message=(([a-zA-Z0-9 ]+))$", arg)) {
+			// Extracting the contents of the message - digits are checked against the cipher
+			// once everything has been read.
+			this->cipher_message = extract_data("^--message=(([A-Za-z0-9 ]+))$", arg);
+		} else if (validate("^--key=(([A-Za-z0-9 ]+))$", arg)) {
 			// Extracting the key used with the cipher.
-			this->cipher_key = extract_data("^--key=(([A-Za-z ]+|\\d+))$", arg);
-		} else if (validate("^--cipher=((playfair|hill|railfence))$", arg)) {
+			this->cipher_key = extract_data("^--key=(([A-Za-z0-9 ]+))$", arg);
+		} else if (validate("^--key=((([A-Za-z ]*|[\\d ]+)(,([A-Za-z ]*|[\\d ]+))+))$", arg)) {
+			// One key for every cipher in a chain - separated by commas. Numeric keys can hold
+			// more than one number (affine), and ROT13 and Atbash take an empty one.
+			this->cipher_key = extract_data("^--key=((.+))$", arg);
+		} else if (validate("^--cipher=((playfair|playfair6|hill|hill256|hill95|railfence|vigenere|beaufort|variant-beaufort|autokey|caesar|rot13|atbash|affine|keyword|columnar|double-columnar))$", arg)) {
 			this->cipher = map_cipher(extract_data("^--cipher=((.*))$", arg));
 
 			if (this->cipher == UNDEFINED) {
@@ -53,15 +61,175 @@ void fetch_cli_args(struct user_data *this, unsigned int count, string *args) {
 				printf("\nError: Undefined cipher type detected.\n");
 				exit(-10);
 			}
+
+			this->chain[0] = this->cipher;
+			this->stages = 1;
+		} else if (validate("^--cipher=(((playfair|hill|railfence|vigenere|beaufort|variant-beaufort|caesar|rot13|atbash|affine|keyword|columnar|double-columnar)(,(playfair|hill|railfence|vigenere|beaufort|variant-beaufort|caesar|rot13|atbash|affine|keyword|columnar|double-columnar))+))$", arg)) {
+			// A chain of ciphers - split on the commas. The text of a chain is normalized
+			// once, to lowercase letters, and every stage hands letters to the next one. The
+			// byte-oriented hill ciphers (`hill256`, `hill95`) are left out - their result holds
+			// any byte (or printable character), which the letter ciphers after them cannot
+			// take, and they would be handed text stripped of everything but letters. The
+			// alphanumeric play-fair needs the digits the chain drops, and autokey cannot run
+			// as a stage (see `engine_prepare_chain`).
+			struct span names = extract_data("^--cipher=((.+))$", arg);
+			this->stages = 0;
+
+			for (unsigned int start = 0, end = 0; end <= names.length; end++) {
+				if (end < names.length && names.data[end] != ',')
+					continue;
+
+				if (this->stages == CHAIN_MAX) {
+					printf("\nError: At most %d ciphers can be chained.\n", CHAIN_MAX);
+					exit(-10);
+				}
+
+				this->chain[this->stages] = map_cipher(make_span(names.data + start, end - start));
+
+				// Play-fair folds `j` into `i` - a stage before it could not be undone.
+				if (this->stages != 0 && this->chain[this->stages] == PLAYFAIR) {
+					printf("\nError: Play-fair can only be the first cipher of a chain.\n");
+					exit(-10);
+				}
+
+				this->stages++;
+				start = end + 1;
+			}
+
+			this->cipher = this->chain[0];
+		} else if (validate("^--serve=((.+))$", arg)) {
+			// Running as a daemon - listening on the socket at the path given.
+			this->serve_path = extract_data("^--serve=((.+))$", arg);
+		} else if (validate("^--coproc$", arg)) {
+			// Answering requests on stdin/stdout - for a parent process driving the program.
+			this->coproc = true;
+		} else if (validate("^--dir=((.+))$", arg)) {
+			// Ciphering every file in a directory.
+			this->bulk_input = extract_data("^--dir=((.+))$", arg);
+		} else if (validate("^--out=((.+))$", arg)) {
+			this->bulk_output = extract_data("^--out=((.+))$", arg);
+		} else if (validate("^--batch$", arg)) {
+			// Ciphering every line read from stdin.
+			this->batch = true;
+		} else if (validate("^--stream$", arg)) {
+			// Ciphering stdin as a single message, as it arrives.
+			this->stream = true;
+		} else if (validate("^--pipeline$", arg)) {
+			// Overlapping the steps of the stream mode.
+			this->pipeline = true;
+		} else if (validate("^--rf-block=(([1-9]\\d{0,8}))$", arg)) {
+			// Running railfence over blocks of this size.
+			this->rf_block = (unsigned int) strtoul(extract_data("^--rf-block=((\\d+))$", arg).data, NULL, 10);
+		} else if (validate("^--force-isa=((generic|avx2|avx512))$", arg)) {
+			// Selecting the kernels for this instruction set, instead of the best one available.
+			this->force_isa = extract_data("^--force-isa=((.+))$", arg);
+		} else if (validate("^--kernels$", arg)) {
+			// Only reporting the kernels that would be used.
+			this->kernels = true;
+		} else if (validate("^--history$", arg)) {
+			// Printing every run logged so far.
+			this->history = true;
+		} else if (validate("^--history=((\\d{4}-\\d{2}-\\d{2}(\\.\\.\\d{4}-\\d{2}-\\d{2})?))$", arg)) {
+			// Printing the runs logged on a day, or a range of days.
+			this->history = true;
+			this->history_days = extract_data("^--history=((.+))$", arg);
+		} else if (validate("^--max-memory=(([1-9]\\d{0,11}[KkMmGg]?))$", arg)) {
+			// Keeping the buffers that grow with the messages within this many bytes.
+			this->max_memory = parse_size(extract_data("^--max-memory=((.+))$", arg));
+		} else if (validate("^--cache=((.+))$", arg)) {
+			// Keeping the results in (and answering repeated messages from) this file.
+			this->cache_path = extract_data("^--cache=((.+))$", arg);
+		} else if (validate("^--cache-size=(([1-9]\\d{0,11}[KkMmGg]?))$", arg)) {
+			// Size of the cache, if it is to be created.
+			this->cache_size = parse_size(extract_data("^--cache-size=((.+))$", arg));
+
+			if (this->cache_size < CACHE_MIN_SIZE) {
+				printf("\nError: The cache should be at least %u bytes large.\n", CACHE_MIN_SIZE);
+				exit(-10);
+			}
+		} else if (validate("^--keyring=((.+))$", arg)) {
+			// Taking keys prepared ahead of time from this file.
+			this->keyring_path = extract_data("^--keyring=((.+))$", arg);
+		} else if (validate("^--key-id=((\\d{1,9}))$", arg)) {
+			this->key_id = (unsigned int) strtoul(extract_data("^--key-id=((\\d+))$", arg).data, NULL, 10);
+		} else if (validate("^--threads=((\\d{1,4}))$", arg)) {
+			this->threads = (unsigned int) strtoul(extract_data("^--threads=((\\d{1,4}))$", arg).data, NULL, 10);
+		} else if (validate("^--crack$", arg)) {
+			// Searching for the key instead.
+			this->crack = true;
+		} else if (validate("^--top=(([1-9]\\d{0,3}))$", arg)) {
+			this->top = (unsigned int) strtoul(extract_data("^--top=((\\d+))$", arg).data, NULL, 10);
+		} else if (validate("^--max-rails=(([1-9]\\d{0,8}))$", arg)) {
+			this->max_rails = (unsigned int) strtoul(extract_data("^--max-rails=((\\d+))$", arg).data, NULL, 10);
+		} else if (validate("^--rounds=(([1-9]\\d{0,5}))$", arg)) {
+			this->rounds = (unsigned int) strtoul(extract_data("^--rounds=((\\d+))$", arg).data, NULL, 10);
+		} else if (validate("^--seed=(([1-9]\\d{0,18}))$", arg)) {
+			this->seed = strtoull(extract_data("^--seed=((\\d+))$", arg).data, NULL, 10);
+		} else if (validate("^--corpus=((.+))$", arg)) {
+			this->corpus = extract_data("^--corpus=((.+))$", arg);
+		} else if (validate("^--ngrams=((.+))$", arg)) {
+			this->ngrams = extract_data("^--ngrams=((.+))$", arg);
+		} else if (validate("^--known=((.+))$", arg)) {
+			this->known = extract_data("^--known=((.+))$", arg);
 		} else {
 			// Direct exit with an error if the parameter passed cannot be recognized.
-			printf("\n\nError: Unexpected argument detected `%s`\n", arg);
+			printf("\n\nError: Unexpected argument detected `%.*s`\n", arg.length, arg.data);
 
 			exit(-10);
 		}
 	}
 }
 
+/**
+ * Internal method to load the keyring, and to take the cipher from the key picked by its id
+ * (if any).
+ *
+ * @remarks
+ * 		In case the keyring cannot be loaded, or the key cannot be used, this method will
+ * 		directly kill the program while printing the error.
+ *
+ * @param this: Pointer to the original object that is to be populated.
+ */
+void load_keyring(struct user_data *this) {
+	string path = gen_str(this->keyring_path).data;
+
+	if (!keyring_load(path)) {
+		printf("\n\nError: Could not load the keyring `%s` - was it built by this version?\n", path);
+		exit(-10);
+	}
+
+	free(path);
+
+	if (this->key_id == KEYRING_NONE)
+		return;
+
+	// Only the modes that prepare the key once, before reading the messages, take it from
+	// the keyring.
+	if (this->bulk_input.data == NULL && !this->batch && !this->stream) {
+		printf("\n\nError: Keys can only be picked by id in bulk, batch and stream mode\n");
+		exit(-10);
+	}
+
+	const struct cipher_key *prepared = keyring_find(this->key_id);
+	if (prepared == NULL) {
+		printf("\n\nError: The keyring holds no key with id %u (%u keys)\n", this->key_id, keyring_count());
+		exit(-10);
+	}
+
+	if (this->cipher_key.data != NULL || (this->cipher != CIPHER_UNSET && this->cipher != prepared->cipher)) {
+		printf(
+			"\n\nError: Key %u is for `%s` - `--key` and `--cipher` are not needed with `--key-id`\n",
+			this->key_id, cipher_name(prepared->cipher)
+		);
+		exit(-10);
+	}
+
+	this->cipher = prepared->cipher;
+	this->chain[0] = this->cipher;
+	this->stages = 1;
+	this->cipher_key = span_of("");
+}
+
 /**
  * Populates all the internal fields of the structure with their initial values as needed.
  *
@@ -80,16 +248,48 @@ void fetch_cli_args(struct user_data *this, unsigned int count, string *args) {
  */
 void initialize(struct user_data *this) {
 	// Start by setting all parameters to be null.
-	this->cipher_message = NULL;
-	this->cipher_key = NULL;
+	this->cipher_message = make_span(NULL, 0);
+	this->cipher_key = make_span(NULL, 0);
 
 	// Random values for specific types.
 	this->encrypt = -1;
-	this->cipher = -2;
+	this->cipher = CIPHER_UNSET;
 	this->verbose = -1;
 
-	this->processed_key = NULL;
-	this->processed_message = NULL;
+	this->processed_key = make_span(NULL, 0);
+	this->processed_message = make_span(NULL, 0);
+
+	this->serve_path = make_span(NULL, 0);
+	this->coproc = false;
+
+	this->bulk_input = make_span(NULL, 0);
+	this->bulk_output = make_span(NULL, 0);
+
+	this->batch = false;
+	this->stream = false;
+	this->pipeline = false;
+	this->rf_block = 0;
+	this->force_isa = make_span(NULL, 0);
+	this->kernels = false;
+	this->history = false;
+	this->history_days = make_span(NULL, 0);
+	this->max_memory = 0;
+	this->cache_path = make_span(NULL, 0);
+	this->cache_size = 0;
+	this->keyring_path = make_span(NULL, 0);
+	this->key_id = KEYRING_NONE;
+	this->threads = 0;
+
+	this->stages = 0;
+
+	this->crack = false;
+	this->top = 5;
+	this->max_rails = 0;
+	this->rounds = 0;
+	this->seed = 0;
+	this->corpus = make_span(NULL, 0);
+	this->ngrams = make_span(NULL, 0);
+	this->known = make_span(NULL, 0);
 }
 
 /**
@@ -113,21 +313,22 @@ void interactive(struct user_data *this, bool cli_used) {
 	// same as initialization - having the user enter the value in interactive mode.
 	// Should be separate `if` blocks instead of an if-else ladder.
 
-	if (!cli_used || this->cipher == -2) {
+	if (!cli_used || this->cipher == CIPHER_UNSET) {
 		// Creating a new string to take input from the user.
-		string temp_str = new_str(STRING_SMALL);
+		string temp_buffer = new_str(STRING_SMALL);
+		struct span temp_str;
 
 		// An infinite loop - break out only when correct input is detected. Can be emulated
 		// with a goto statement too - avoiding to prevent cluttering the global namespace.
 		while (true) {
-			printf("\n\nCipher technique to be used (playfair/hill/railfence)");
+			printf("\n\nCipher technique to be used (playfair/playfair6/hill/hill256/hill95/railfence/vigenere/beaufort/variant-beaufort/autokey/caesar/rot13/atbash/affine/keyword/columnar/double-columnar)");
 			printf("\ncipher> ");
 
 			// Scanning the string.
-			scan_str(temp_str, STRING_SMALL);
+			temp_str = scan_str(temp_buffer, STRING_SMALL);
 
 			// Validating the value of the string - using regex for readability.
-			if (validate("^((playfair|hill|railfence))$", temp_str)) {
+			if (validate("^((playfair|playfair6|hill|hill256|hill95|railfence|vigenere|beaufort|variant-beaufort|autokey|caesar|rot13|atbash|affine|keyword|columnar|double-columnar))$", temp_str)) {
 				// The flow-of-control reaches here only when the user picks up a valid cipher type.
 				// Mapping the cipher type to an enum to store it.
 				this->cipher = map_cipher(temp_str);
@@ -137,6 +338,9 @@ void interactive(struct user_data *this, bool cli_used) {
 					// printing an error message and continuing with next iteration of the loop.
 					goto cipher_map_error;
 
+				this->chain[0] = this->cipher;
+				this->stages = 1;
+
 				// Breaking out of the infinite loop if the string matches.
 				break;
 			} else {
@@ -145,27 +349,35 @@ void interactive(struct user_data *this, bool cli_used) {
 				cipher_map_error:
 
 				// Printing an error message if the match fails.
-				printf("Error: Unknown value `%s`\n", temp_str);
+				printf("Error: Unknown value `%.*s`\n", temp_str.length, temp_str.data);
 			}
 		}
 
 		// Clearing temporary string - good practice.
-		free(temp_str);
+		free(temp_buffer);
 	}
 
-	if (!cli_used || this->cipher_key == NULL) {
+	// ROT13 and Atbash take no key - an empty one is used, unless one was passed anyway.
+	bool keyless = this->cipher == ROT13 || this->cipher == ATBASH;
+
+	if (keyless && this->cipher_key.data == NULL)
+		this->cipher_key = span_of("");
+
+	// While cracking, the key is what is being looked for - skipping asking for one.
+	if ((!cli_used || this->cipher_key.data == NULL) && !this->crack && !keyless) {
 		// Creating a new string - the variable was initialized as null
-		this->cipher_key = new_str(STRING_MEDIUM);
+		string key_buffer = new_str(STRING_MEDIUM);
 
 		// Infinite loop to reject invalid input.
 		while (true) {
 			printf("\n\nKey to be used in the cipher (%d alphabets at max)", STRING_MEDIUM);
 			printf("\nkey> ");
 
-			scan_str(this->cipher_key, STRING_MEDIUM);
+			this->cipher_key = scan_str(key_buffer, STRING_MEDIUM);
 
-			if (validate("^(([a-zA-Z ]+|\\d+))$", this->cipher_key))
-				// Break out of the infinite loop - pure numeric key used in Railfence.
+			if (validate("^(([a-zA-Z0-9 ]+))$", this->cipher_key))
+				// Break out of the infinite loop - pure numeric key used in Railfence (and
+				// Caesar/affine), and alphanumeric keys in the 6x6 play-fair.
 				break;
 			else
 				// Print an error message - continue with the next iteration of the (infinite) loop.
@@ -174,23 +386,29 @@ void interactive(struct user_data *this, bool cli_used) {
 	}
 
 	// Handling an edge-case check! In case of railfence cipher, the is supposed to be numeric.
-	if (this->cipher == RAILFENCE)
+	// The keys of a chain are checked as the chain is prepared (see `engine_prepare_chain`).
+	if (this->cipher == RAILFENCE && !this->crack && this->stages == 1 && this->key_id == KEYRING_NONE)
 		// Attempting to validate the key - if validation fails, the method-call will internally
 		// terminate the program. If the flow-of-control returns back, assume that the key
 		// is valid.
 		validate_key_railfence(this->cipher_key);
 
-	if (!cli_used || this->cipher_message == NULL) {
+	// In bulk, batch and stream mode, the messages are read from files/stdin - skipping asking
+	// for one. While cracking, a message missing from the command-line is read from stdin instead.
+	if (
+		(!cli_used || this->cipher_message.data == NULL) &&
+		this->bulk_input.data == NULL && !this->batch && !this->stream && !this->crack
+	) {
 		// Creating a string - was initialized as null.
-		this->cipher_message = new_str(STRING_LARGE);
+		string message_buffer = new_str(STRING_LARGE);
 
 		// Infinite loop to reject invalid input.
 		while (true) {
-			printf("\n\nMessage that is to be ciphered (alphabets only)");
+			printf("\n\nMessage that is to be ciphered (alphabets only - and digits with playfair6)");
 			printf("\nmessage> ");
 
-			scan_str(this->cipher_message, STRING_LARGE);
-			if (validate("^[A-Za-z ]+$", this->cipher_message))
+			this->cipher_message = scan_str(message_buffer, STRING_LARGE);
+			if (validate("^[A-Za-z0-9 ]+$", this->cipher_message))
 				// Break out of the loop if the input is valid.
 				break;
 			else
@@ -202,13 +420,14 @@ void interactive(struct user_data *this, bool cli_used) {
 	// A special case. The verbose flag is optional, and shall default to false. If the user
 	// does not provide verbose flag through console, defaulting its value to false.
 	if (!cli_used && this->verbose == -1) {
-		string temp_input = new_str(STRING_SMALL);
+		string input_buffer = new_str(STRING_SMALL);
+		struct span temp_input;
 
 		while (true) {
 			printf("\n\nUse verbose mode (yes/no)?");
 			printf("\nverbose> ");
 
-			scan_str(temp_input, STRING_SMALL);
+			temp_input = scan_str(input_buffer, STRING_SMALL);
 
 			// Validating the string input - case independent.
 			if (validate("^(?i)((yes|no|true|false|y|n))$", temp_input)) {
@@ -222,24 +441,25 @@ void interactive(struct user_data *this, bool cli_used) {
 				// Breaking out of the infinite loop.
 				break;
 			} else {
-				printf("Error: Unexpected answer `%s`", temp_input);
+				printf("Error: Unexpected answer `%.*s`", temp_input.length, temp_input.data);
 			}
 		}
 
 		// Deleting the temporary string.
-		free(temp_input);
+		free(input_buffer);
 	} else if (!cli_used || this->verbose == -1) {
 		this->verbose = false;
 	}
 
-	if (!cli_used || this->encrypt == -1) {
-		string cipher_val = new_str(STRING_SMALL);
+	if ((!cli_used || this->encrypt == -1) && !this->crack) {
+		string value_buffer = new_str(STRING_SMALL);
+		struct span cipher_val;
 
 		while (true) {
 			printf("\n\nEncrypt the message (yes/no)?");
 			printf("\nencrypt/decrypt> ");
 
-			scan_str(cipher_val, STRING_SMALL);
+			cipher_val = scan_str(value_buffer, STRING_SMALL);
 			if (validate("^(?i)((yes|no|true|false|y|n))$", cipher_val)) {
 				// Mapping the value to a boolean.
 				this->encrypt = (
@@ -251,50 +471,96 @@ void interactive(struct user_data *this, bool cli_used) {
 				// Break out of the infinite loop
 				break;
 			} else {
-				printf("Error: Invalid input: `%s`\n", cipher_val);
+				printf("Error: Invalid input: `%.*s`\n", cipher_val.length, cipher_val.data);
 			}
 		}
 
-		free(cipher_val);
+		free(value_buffer);
 	}
 }
 
 /**
- * Creates a modified copy of the first string in the second string.
+ * Internal method to check if a span contains any digits.
  *
- * @remarks
- * 		The second string *should* be null - or this method will raise an error.
+ * @param source: Span to be checked - can be null.
+ *
+ * @return
+ * 		Boolean indicating if a digit was found.
+ */
+bool has_digits(struct span source) {
+	for (unsigned int i = 0; i < source.length; i++)
+		if (isdigit((unsigned char) source.data[i]))
+			return true;
+
+	return false;
+}
+
+/**
+ * Creates a modified copy of the source span in a new string.
  *
  * @remarks
  * 		Designed to modify the input arguments to suit the needs of the cipher
  * 		techniques - performs background chores such as removing spaces, changing
  * 		case and more to the result string. Doesn't modify the source string.
  *
- * @param source: Source string. Should not be null.
+ * @note
+ * 		The string created is terminated, and should be destroyed once it is used.
+ *
+ * @param source: Source span. Should not be empty.
+ * @param digits: Boolean indicating if digits are to be kept (see `normalize_alnum_into`).
  *
  * @return
- * 		The destination string after modification that is a mutated version of the
- * 		source string.
+ * 		Span over the destination string after modification that is a mutated version
+ * 		of the source.
  */
-extern inline string mutate(string source) {
+extern inline struct span mutate(struct span source, bool digits) {
 
 	// Raise an error if any
-	if (source == NULL || strlen(source) == 0) {
+	if (source.data == NULL || source.length == 0) {
 		printf("\n\n\tERROR: Null source detected during mutation in data-input\n");
 		exit(-10);
 	}
 
-	unsigned int counter = 0;
-	unsigned int source_len = strlen(source);
+	// Creating a destination string of required length - with space for the terminator.
+	string dest = new_str(source.length + 1);
 
-	// Creating a destination string of required length.
-	string dest = new_str(source_len * sizeof(char));
+	unsigned int counter = digits ? normalize_alnum_into(dest, source) : normalize_into(dest, source);
 
-	for (unsigned int i = 0; i < source_len; i++)
-		if (isalpha(source[i]))
-			dest[counter++] = tolower(source[i]);
+	dest[counter] = '\0';
+	return make_span(dest, counter);
+}
 
-	return dest;
+/**
+ * Internal method to read everything from a stream, until its end.
+ *
+ * @remarks
+ * 		Will force-stop the program if the memory cannot be allocated.
+ *
+ * @param stream: The stream to be read.
+ *
+ * @return
+ * 		Span over a new string containing everything read - should be destroyed once it is used.
+ */
+struct span read_stream(FILE *stream) {
+	unsigned int capacity = 4096, length = 0;
+	string contents = new_str(capacity);
+
+	size_t count;
+	while ((count = fread(contents + length, sizeof(char), capacity - length, stream)) > 0) {
+		length += count;
+
+		if (length == capacity) {
+			capacity *= 2;
+			contents = (string) realloc(contents, capacity);
+		}
+
+		if (contents == NULL) {
+			printf("\n\nError: Ran out of memory while reading the input\n");
+			exit(-10);
+		}
+	}
+
+	return make_span(contents, length);
 }
 
 /**
@@ -329,25 +595,116 @@ void populate_data(struct user_data *this, int arg_count, string *argv) {
 		fetch_cli_args(this, arg_count, argv);
 	}
 
+	// Keys prepared ahead of time are loaded before anything is asked for - a key picked by
+	// its id decides the cipher as well.
+	if (this->keyring_path.data != NULL) {
+		load_keyring(this);
+	} else if (this->key_id != KEYRING_NONE) {
+		printf("\n\nError: `--key-id` should be used along with `--keyring`\n");
+		exit(-10);
+	}
+
+	// In daemon (and co-process) mode, everything else arrives with each request - nothing to
+	// ask for. Neither is anything needed to report the kernels, or to query the history.
+	if (this->serve_path.data != NULL || this->coproc || this->kernels || this->history)
+		return;
+
 	// Running the interactive session regardless of whether console line provided arguments
 	// This method will ask for the missing values in-case console arguments have been provided
 	// or, other, ask the user for each value iteratively.
+	if ((this->bulk_input.data == NULL) != (this->bulk_output.data == NULL)) {
+		// Bulk mode needs both the directories.
+		printf("\n\nError: `--dir` and `--out` should be used together\n");
+		exit(-10);
+	}
+
 	interactive(this, cli_used);
 
+	if (this->stages > 1 && (this->crack || this->batch || this->stream || this->bulk_input.data != NULL)) {
+		printf("\n\nError: Cipher chains can only be used on a single message\n");
+		exit(-10);
+	}
+
+	if (this->pipeline && !this->stream) {
+		printf("\n\nError: `--pipeline` can only be used along with `--stream`\n");
+		exit(-10);
+	}
+
+	if (this->rf_block != 0 && (this->cipher != RAILFENCE || this->stages > 1 || this->crack)) {
+		printf("\n\nError: Blocks (`--rf-block`) can only be used to cipher with `railfence`\n");
+		exit(-10);
+	}
+
+	// Only the alphanumeric play-fair and the byte-oriented hill ciphers take digits - anywhere
+	// else, they are only allowed in the (numeric) keys of railfence, Caesar and affine (and
+	// dropped from a cipher being cracked).
+	bool bytes = this->cipher == HILL256 || this->cipher == HILL95;
+	bool numeric_key = this->cipher == RAILFENCE || this->cipher == CAESAR || this->cipher == AFFINE;
+
+	if (this->cipher != PLAYFAIR6 && !bytes && !this->crack) {
+		bool digit_key = !numeric_key && this->stages == 1 && has_digits(this->cipher_key);
+
+		if (digit_key || has_digits(this->cipher_message)) {
+			printf("\n\nError: Digits can only be ciphered with `playfair6`, `hill256` or `hill95`\n");
+			exit(-10);
+		}
+	}
+
+	if (this->crack) {
+		// Cracking always decrypts - the message is the cipher, read in full from stdin if it
+		// was not passed through the command-line.
+		this->encrypt = false;
+
+		if (this->cipher_message.data == NULL)
+			this->cipher_message = read_stream(stdin);
+
+		this->processed_message = make_span(new_str(this->cipher_message.length + 1), 0);
+		this->processed_message.length = normalize_into(this->processed_message.data, this->cipher_message);
+		return;
+	}
+
+	// In bulk, batch and stream mode, the key is prepared along with the cipher (see
+	// `engine_prepare`) and the messages are read later on - nothing left to process.
+	if (this->bulk_input.data != NULL || this->batch || this->stream)
+		return;
+
 	// Once all the argument(s) have their required values, modifying them to suit conditions
 	// includes converting characters to lower-case, and stripping off spaces and more.
 
-	if (this->cipher == PLAYFAIR || this->cipher == HILL_CIPHER) {
+	if (this->stages > 1) {
+		// Every stage of a chain processes its own key as it is prepared.
+		this->processed_message = mutate(this->cipher_message, false);
+		this->processed_key = gen_str(this->cipher_key);
+		return;
+	}
+
+	if (bytes) {
+		// The byte-oriented hill ciphers take the message and the key as they are.
+		this->processed_message = gen_str(this->cipher_message);
+		this->processed_key = gen_str(this->cipher_key);
+	} else if (
+		this->cipher == PLAYFAIR || this->cipher == HILL_CIPHER || this->cipher == KEYWORD ||
+		this->cipher == COLUMNAR || (this->cipher >= VIGENERE && this->cipher <= AUTOKEY)
+	) {
 		// Creating mutated copies of the original values - devoid of non-alphabetical
 		// characters as well as spaces and numbers - this is what will be used in case
-		// of playfair and hill cipher - they cannot work with different cases and/or
-		// spaces being involved in the source(s).
-		this->processed_message = mutate(this->cipher_message);
-		this->processed_key = mutate(this->cipher_key);
-	} else if (this->cipher == RAILFENCE) {
+		// of playfair, hill cipher, the Vigenère family, keyword and columnar transposition -
+		// they cannot work with different cases and/or spaces being involved in the source(s).
+		this->processed_message = mutate(this->cipher_message, false);
+		this->processed_key = mutate(this->cipher_key, false);
+	} else if (this->cipher == PLAYFAIR6) {
+		// Same as above, except that the 6x6 matrix holds the digits as well.
+		this->processed_message = mutate(this->cipher_message, true);
+		this->processed_key = mutate(this->cipher_key, true);
+	} else if (
+		this->cipher == RAILFENCE || this->cipher == CAESAR || this->cipher == ROT13 || this->cipher == ATBASH ||
+		this->cipher == AFFINE || this->cipher == DOUBLE_COLUMNAR
+	) {
 		// RailFence can work with capitalization and/or spaces in between source(s),
-		// creating a copy of the original strings in this case.
-		this->processed_message = mutate(this->cipher_message);
+		// creating a copy of the original strings in this case. The same goes for the keys
+		// of Caesar and affine - numbers, separated by a space - and the two words of the
+		// double transposition.
+		this->processed_message = mutate(this->cipher_message, false);
 		this->processed_key = gen_str(this->cipher_key);
 	}
 }
@@ -0,0 +1,811 @@
+// Implementation of the cipher engine - maps a cipher type to the methods used to
+// prepare its key, and to run it. Any new cipher needs to be added here as well.
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+
+#define true 1
+#define false 0
+
+// Number of prepared keys remembered by `engine_cached_key`.
+#define KEY_CACHE_SIZE 64
+
+// Keys longer than this are prepared afresh each time instead of being remembered.
+#define KEY_CACHE_MAX_KEY 64
+
+// Keys up to this length are normalized on the stack - longer keys need `malloc`.
+#define KEY_STACK_LENGTH 256
+
+// Size of the tiles a chain runs its fused stages over (and formatted text is ciphered in,
+// see `engine_run_restored`) - small enough to stay in the cache between stages, and a
+// multiple of every block size (see `engine_block_size`) other than the period of the
+// Vigenère family.
+#define CHAIN_TILE (6 * 682)
+
+/**
+ * A single entry in the key cache - the key as received, and its prepared form.
+ */
+struct key_cache_entry {
+	bool used;
+	unsigned int key_length;
+	char key[KEY_CACHE_MAX_KEY];
+	struct cipher_key prepared;
+};
+
+// The cache of prepared keys. Direct-mapped - a key can only live in the slot its hash
+// maps to, and replaces whatever was there before.
+struct key_cache_entry engine_key_cache[KEY_CACHE_SIZE];
+
+/**
+ * Normalizes text for a cipher - lowers the alphabets and drops everything else (see
+ * `normalize_into`), keeping the digits as well for the alphanumeric play-fair. The
+ * byte-oriented hill ciphers take the text as-is, as such it is only copied.
+ *
+ * @param prepared: Pointer to the key - only its cipher needs to be set.
+ * @param dest: Buffer in which the normalized characters are to be written. Can be the
+ * 		same buffer as the source.
+ * @param source: Span containing the text that is to be normalized.
+ *
+ * @return
+ * 		Unsigned integer containing the number of characters written.
+ */
+unsigned int engine_normalize_into(const struct cipher_key *prepared, string dest, struct span source) {
+	if (prepared->cipher == PLAYFAIR6)
+		return normalize_alnum_into(dest, source);
+
+	if (prepared->cipher == HILL256 || prepared->cipher == HILL95) {
+		// The byte-oriented ciphers take the text as-is.
+		if (dest != source.data)
+			memmove(dest, source.data, source.length);
+
+		return source.length;
+	}
+
+	return normalize_into(dest, source);
+}
+
+/**
+ * Internal method to check if a key belongs to one of the periodic ciphers of the Vigenère
+ * family - ciphers repeating their key every `period` characters.
+ */
+static inline bool engine_is_periodic(const struct cipher_key *prepared) {
+	return prepared->cipher == VIGENERE || prepared->cipher == BEAUFORT || prepared->cipher == VARIANT_BEAUFORT;
+}
+
+/**
+ * Prepares a key for a cipher.
+ *
+ * @remarks
+ * 		The key is expected as entered by the user - for play-fair, hill cipher, the Vigenère
+ * 		family, keyword and columnar transposition, it is normalized (see `engine_normalize_into`)
+ * 		before being prepared. The key for railfence should be a positive number, and the keys
+ * 		of Caesar and affine one and two numbers (see `sb_prepare`) - ROT13 and Atbash take no
+ * 		key. Double transposition takes two words (see `ct_prepare`). The byte-oriented hill
+ * 		ciphers use the key as-is, and only take keys that can be inverted.
+ *
+ * @param prepared: Pointer to the structure that is to be populated.
+ * @param cipher: The cipher the key is to be prepared for.
+ * @param key: Span containing the key.
+ *
+ * @return
+ * 		Boolean indicating if the key could be prepared - false if the key is invalid for
+ * 		the cipher, or the cipher is unknown.
+ */
+bool engine_prepare(struct cipher_key *prepared, enum crypt cipher, struct span key) {
+	prepared->cipher = cipher;
+
+	if (cipher == RAILFENCE)
+		return rf_prepare(&prepared->schedule.railfence, key);
+
+	if (cipher == HILL256 || cipher == HILL95)
+		// The key is used as-is - and should have an inverse, since nothing ciphered with it
+		// could be read back otherwise.
+		return hc_prepare_bytes(&prepared->schedule.hill, key, (cipher == HILL256) ? HC_BYTES : HC_PRINTABLE);
+
+	if (cipher == CAESAR || cipher == ROT13 || cipher == ATBASH || cipher == AFFINE)
+		// The keys are numbers (or not used at all) - taken as-is.
+		return sb_prepare(&prepared->schedule.substitution, key, cipher);
+
+	if (cipher == DOUBLE_COLUMNAR)
+		// Two words - the spaces between them are kept.
+		return ct_prepare(&prepared->schedule.columnar, key, cipher);
+
+	if (cipher >= UNDEFINED)
+		return false;
+
+	// Normalizing the key - on the stack unless the key is really long.
+	char buffer[KEY_STACK_LENGTH];
+	string normalized = (key.length <= KEY_STACK_LENGTH) ? buffer : (string) malloc(key.length);
+	struct span processed = make_span(normalized, engine_normalize_into(prepared, normalized, key));
+	bool valid = true;
+
+	if (cipher == PLAYFAIR)
+		pf_prepare(&prepared->schedule.playfair, processed);
+	else if (cipher == PLAYFAIR6)
+		pf6_prepare(&prepared->schedule.playfair, processed);
+	else if (cipher == HILL_CIPHER)
+		hc_prepare(&prepared->schedule.hill, processed);
+	else if (cipher == KEYWORD)
+		valid = sb_prepare(&prepared->schedule.substitution, processed, cipher);
+	else if (cipher == COLUMNAR)
+		valid = ct_prepare(&prepared->schedule.columnar, processed, cipher);
+	else
+		valid = vg_prepare(&prepared->schedule.vigenere, processed, cipher);
+
+	if (normalized != buffer)
+		free(normalized);
+
+	return valid && processed.length != 0;
+}
+
+/**
+ * Returns a prepared key for a cipher - the key is prepared only if it is not present in
+ * the cache already.
+ *
+ * @note
+ * 		The cache is not thread-safe, and the pointer returned is only valid until the next
+ * 		call to this method. Keys that should outlive that are to be copied, or prepared
+ * 		using `engine_prepare` directly.
+ *
+ * @param cipher: The cipher the key is to be prepared for.
+ * @param key: Span containing the key - as entered by the user.
+ *
+ * @return
+ * 		Pointer to the prepared key, or null if the key is invalid for the cipher.
+ */
+const struct cipher_key *engine_cached_key(enum crypt cipher, struct span key) {
+	static struct cipher_key uncached;
+
+	if (key.length > KEY_CACHE_MAX_KEY)
+		return engine_prepare(&uncached, cipher, key) ? &uncached : NULL;
+
+	unsigned char cipher_byte = (unsigned char) cipher;
+	unsigned long long hash = hash_span(key, hash_span(make_span((string) &cipher_byte, 1), HASH_SEED));
+
+	struct key_cache_entry *entry = &engine_key_cache[hash % KEY_CACHE_SIZE];
+	if (
+		entry->used && entry->prepared.cipher == cipher && entry->key_length == key.length &&
+		memcmp(entry->key, key.data, key.length) == 0
+	)
+		return &entry->prepared;
+
+	// Not found - preparing the key, and remembering it only if it is valid.
+	entry->used = false;
+	if (!engine_prepare(&entry->prepared, cipher, key))
+		return NULL;
+
+	memcpy(entry->key, key.data, key.length);
+	entry->key_length = key.length;
+	entry->used = true;
+
+	return &entry->prepared;
+}
+
+/**
+ * Runs a cipher using a prepared key, writing the result into a buffer owned by the caller.
+ *
+ * @remarks
+ * 		A null (or small) destination is left untouched and the size needed is returned.
+ *
+ * @note
+ * 		The message should have been normalized before-hand. The destination should not
+ * 		overlap with the message.
+ *
+ * @param prepared: Pointer to the prepared key - the cipher is picked from the key.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer in which the result is to be written.
+ * @param dest_cap: Unsigned integer containing the capacity of the buffer, in characters.
+ * @param message: Span containing the message.
+ *
+ * @return
+ * 		Unsigned integer containing the length of the result, or `CIPHER_INVALID` if the
+ * 		message cannot be ciphered.
+ */
+unsigned int engine_run_into(
+	const struct cipher_key *prepared, bool encrypt, string dest, unsigned int dest_cap, struct span message
+) {
+	switch (prepared->cipher) {
+		case PLAYFAIR:
+		case PLAYFAIR6:
+			return pf_run_into(&prepared->schedule.playfair, encrypt, dest, dest_cap, message);
+
+		case HILL_CIPHER:
+		case HILL256:
+		case HILL95:
+			return hc_run_into(&prepared->schedule.hill, encrypt, dest, dest_cap, message);
+
+		case RAILFENCE:
+			return rf_run_into(&prepared->schedule.railfence, encrypt, dest, dest_cap, message);
+
+		case VIGENERE:
+		case BEAUFORT:
+		case VARIANT_BEAUFORT:
+		case AUTOKEY:
+			return vg_run_into(&prepared->schedule.vigenere, encrypt, dest, dest_cap, message);
+
+		case CAESAR:
+		case ROT13:
+		case ATBASH:
+		case AFFINE:
+		case KEYWORD:
+			return sb_run_into(&prepared->schedule.substitution, encrypt, dest, dest_cap, message);
+
+		case COLUMNAR:
+		case DOUBLE_COLUMNAR:
+			return ct_run_into(&prepared->schedule.columnar, encrypt, dest, dest_cap, message);
+
+		default:
+			return CIPHER_INVALID;
+	}
+}
+
+/**
+ * Returns the size of the blocks a cipher works on - a message can be split anywhere on
+ * a multiple of this size, and each part ciphered on its own (see `engine_run_slice`).
+ *
+ * @param prepared: Pointer to the prepared key.
+ *
+ * @return
+ * 		Unsigned integer containing the size of a block, in characters.
+ */
+unsigned int engine_block_size(const struct cipher_key *prepared) {
+	switch (prepared->cipher) {
+		case PLAYFAIR:
+		case PLAYFAIR6:
+			return 2;
+
+		case HILL_CIPHER:
+		case HILL256:
+		case HILL95:
+			return HC_MATRIX_SIZE;
+
+		case RAILFENCE:
+			// Blocked railfence moves characters within its blocks, and otherwise one at a time.
+			return (prepared->schedule.railfence.block != 0) ? prepared->schedule.railfence.block : 1;
+
+		case VIGENERE:
+		case BEAUFORT:
+		case VARIANT_BEAUFORT:
+			// Each part picks up the key from its start - a part starting on the period does so
+			// without knowing where it came from.
+			return prepared->schedule.vigenere.period;
+
+		default:
+			return 1;
+	}
+}
+
+/**
+ * Calculates the memory needed to cipher a message as a whole - the message, and a buffer
+ * for the result (see `engine_run_into`). Used to account for the buffers against the memory
+ * budget (see `budget.h`).
+ *
+ * @param prepared: Pointer to the prepared key.
+ * @param length: Unsigned integer containing the length of the message.
+ *
+ * @return
+ * 		Unsigned integer containing the number of bytes needed.
+ */
+unsigned long long engine_footprint(const struct cipher_key *prepared, unsigned int length) {
+	// The result grows by the padding of the last block, at most.
+	unsigned long long padding = engine_block_size(prepared);
+
+	if (prepared->cipher == RAILFENCE && prepared->schedule.railfence.block == 0)
+		// Padded to fit the diagonal - by less than a full cycle of the rails.
+		padding = 2ULL * prepared->schedule.railfence.rows;
+
+	if (prepared->cipher == DOUBLE_COLUMNAR)
+		// The result of the first pass is held on to for the second one.
+		padding += length + 1ULL;
+
+	// Both strings are terminated.
+	return 2ULL * length + padding + 2;
+}
+
+/**
+ * Runs a cipher over a part of a message using a prepared key - the range `[begin, end)`
+ * is in the same terms as the `*_run_slice` method of the cipher.
+ *
+ * @note
+ * 		The range should start on a multiple of `engine_block_size`, and the size of the
+ * 		result should have been checked using `engine_run_into` beforehand.
+ *
+ * @param prepared: Pointer to the prepared key - the cipher is picked from the key.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer for the complete result - the range is written at its own offsets.
+ * @param message: Span containing the complete message.
+ * @param begin: Unsigned integer containing the start of the range.
+ * @param end: Unsigned integer containing the end of the range.
+ *
+ * @return
+ * 		Boolean indicating if the range could be ciphered.
+ */
+bool engine_run_slice(
+	const struct cipher_key *prepared, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+) {
+	switch (prepared->cipher) {
+		case PLAYFAIR:
+		case PLAYFAIR6:
+			pf_run_slice(&prepared->schedule.playfair, encrypt, dest, message, begin, end);
+			return true;
+
+		case HILL_CIPHER:
+		case HILL256:
+		case HILL95:
+			return hc_run_slice(&prepared->schedule.hill, encrypt, dest, message, begin, end);
+
+		case RAILFENCE:
+			rf_run_slice(&prepared->schedule.railfence, encrypt, dest, message, begin, end);
+			return true;
+
+		case VIGENERE:
+		case BEAUFORT:
+		case VARIANT_BEAUFORT:
+		case AUTOKEY:
+			return vg_run_slice(&prepared->schedule.vigenere, encrypt, dest, message, begin, end);
+
+		case CAESAR:
+		case ROT13:
+		case ATBASH:
+		case AFFINE:
+		case KEYWORD:
+			return sb_run_slice(&prepared->schedule.substitution, encrypt, dest, message, begin, end);
+
+		case COLUMNAR:
+		case DOUBLE_COLUMNAR:
+			ct_run_slice(&prepared->schedule.columnar, encrypt, dest, message, begin, end);
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+/**
+ * Runs a cipher over a number of independent messages at once - each with its own prepared
+ * key, and its own direction.
+ *
+ * @remarks
+ * 		The hill ciphers interleave the messages over the lanes of their vectors (see
+ * 		`hc_run_many`), which keeps the vectors full with messages too short to do so on
+ * 		their own. Play-fair runs the messages straight through its kernels (see
+ * 		`pf_run_many`), and everything else one after the other.
+ *
+ * @note
+ * 		Every key should be prepared for the same cipher (play-fair keys can mix both sizes
+ * 		of the matrix). The messages should have been normalized before-hand, and the
+ * 		destination of each lane sized using `engine_run_into`.
+ *
+ * @param prepared: Array containing the prepared key of each message.
+ * @param lanes: Array containing the messages - their results are written into the lanes.
+ * @param count: Unsigned integer containing the number of messages.
+ */
+void engine_run_many(const struct cipher_key *const *prepared, struct cipher_lane *lanes, unsigned int count) {
+	if (count == 0)
+		return;
+
+	for (unsigned int i = 0; i < count; i++)
+		lanes[i].schedule = &prepared[i]->schedule;
+
+	switch (prepared[0]->cipher) {
+		case PLAYFAIR:
+		case PLAYFAIR6:
+			pf_run_many(lanes, count);
+			return;
+
+		case HILL_CIPHER:
+		case HILL256:
+		case HILL95:
+			hc_run_many(lanes, count);
+			return;
+
+		default:
+			for (unsigned int i = 0; i < count; i++) {
+				unsigned int size = engine_run_into(prepared[i], lanes[i].encrypt, NULL, 0, lanes[i].message);
+
+				lanes[i].length = (size == CIPHER_INVALID) ? CIPHER_INVALID : engine_run_into(
+					prepared[i], lanes[i].encrypt, lanes[i].dest, size + 1, lanes[i].message
+				);
+			}
+	}
+}
+
+/**
+ * Prepares a chain of ciphers - the keys are separated by commas, one for every cipher.
+ *
+ * @param chain: Pointer to the chain that is to be populated.
+ * @param ciphers: Array containing the ciphers, in the order they encrypt the message.
+ * @param count: Unsigned integer containing the number of ciphers - up to `CHAIN_MAX`.
+ * @param keys: Span containing the keys, separated by commas (`monarchy,3`).
+ *
+ * @return
+ * 		Boolean indicating if the chain could be prepared - false if the number of keys does
+ * 		not match, or any key is invalid for its cipher.
+ */
+bool engine_prepare_chain(struct cipher_chain *chain, const enum crypt *ciphers, unsigned int count, struct span keys) {
+	if (count == 0 || count > CHAIN_MAX)
+		return false;
+
+	chain->length = count;
+
+	unsigned int start = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		unsigned int end = start;
+		while (end < keys.length && keys.data[end] != ',')
+			end++;
+
+		// Running out of keys early, or having keys left over, both mean a mismatch.
+		if (start > keys.length || (i + 1 == count) != (end == keys.length))
+			return false;
+
+		if (!engine_prepare(&chain->stages[i], ciphers[i], make_span(keys.data + start, end - start)))
+			return false;
+
+		// Autokey reads the plaintext as its key - it can neither be fused with other stages,
+		// nor run like the transpositions.
+		if (ciphers[i] == AUTOKEY)
+			return false;
+
+		// Play-fair folds `j` into `i` - any stage before it could have written a `j`, which
+		// would never be read back, and the stage could not be undone.
+		if (i != 0 && (ciphers[i] == PLAYFAIR || ciphers[i] == PLAYFAIR6))
+			return false;
+
+		start = end + 1;
+	}
+
+	return true;
+}
+
+/**
+ * Internal method to check if a stage only works within its own blocks - each block of
+ * the result only depends on the same block of the message.
+ */
+static inline bool engine_is_local(const struct cipher_key *prepared) {
+	if (prepared->cipher == AUTOKEY || prepared->cipher == COLUMNAR || prepared->cipher == DOUBLE_COLUMNAR)
+		return false;
+
+	return prepared->cipher != RAILFENCE || prepared->schedule.railfence.block != 0;
+}
+
+/**
+ * Runs a cipher over formatted text - the text is normalized, ciphered and its formatting
+ * restored in one go, writing the result into a buffer owned by the caller.
+ *
+ * @remarks
+ * 		The text is ciphered as if normalized by `engine_normalize_into`. In the result,
+ * 		each letter keeps the case of the one it replaces, everything else stays where it
+ * 		was, and any padding added by the cipher comes last - characters after the last
+ * 		letter are only kept if padding follows them.
+ *
+ * 		The text is handled a tile at a time - each tile is normalized into a buffer on the
+ * 		stack, ciphered in-place and restored into the destination while it is still in the
+ * 		cache, without any copy of the complete message being made.
+ *
+ * @note
+ * 		Only for ciphers that work within their own blocks, in-place (play-fair, hill cipher,
+ * 		the periodic ciphers of the Vigenère family). A null
+ * 		(or small) destination is left untouched and the capacity needed is returned - the
+ * 		result itself can be shorter.
+ *
+ * @param prepared: Pointer to the prepared key - the cipher is picked from the key.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer in which the result is to be written.
+ * @param dest_cap: Unsigned integer containing the capacity of the buffer, in characters.
+ * @param text: Span containing the text, as entered by the user.
+ *
+ * @return
+ * 		Unsigned integer containing the length of the result, or `CIPHER_INVALID` if the
+ * 		text cannot be ciphered.
+ */
+unsigned int engine_run_restored(
+	const struct cipher_key *prepared, bool encrypt, string dest, unsigned int dest_cap, struct span text
+) {
+	if (!engine_is_local(prepared) || prepared->cipher == RAILFENCE)
+		return CIPHER_INVALID;
+
+	if (prepared->cipher == HILL256 || prepared->cipher == HILL95)
+		// Nothing is normalized for the byte-oriented ciphers - nothing to restore either.
+		return engine_run_into(prepared, encrypt, dest, dest_cap, text);
+
+	// Padding never takes up a complete block.
+	unsigned int capacity = text.length + engine_block_size(prepared);
+	if (dest == NULL || dest_cap <= capacity)
+		return capacity;
+
+	// Characters that are ciphered - as normalized by `engine_normalize_into`.
+	bool digits = prepared->cipher == PLAYFAIR6;
+
+	// With room for the padding of the last tile. Every tile is a multiple of the block size,
+	// as such each one starts on a block - and, with the periodic ciphers, the key all over.
+	char tile[CHAIN_TILE + HC_MATRIX_SIZE];
+	unsigned int tile_size = CHAIN_TILE - CHAIN_TILE % engine_block_size(prepared);
+	unsigned int cursor = 0, length = 0;
+	bool last = false;
+
+	while (!last) {
+		// Normalizing the letters of the next tile.
+		unsigned int start = cursor, count = 0;
+		while (cursor < text.length && count < tile_size) {
+			unsigned char character = (unsigned char) text.data[cursor++];
+			if (isalpha(character) || (digits && isdigit(character)))
+				tile[count++] = (char) tolower(character);
+		}
+
+		// Only the last tile is padded - every other one is a multiple of the block size.
+		last = cursor == text.length;
+		unsigned int size = count;
+
+		if (last) {
+			size = engine_run_into(prepared, encrypt, NULL, 0, make_span(NULL, count));
+			if (size == CIPHER_INVALID)
+				return CIPHER_INVALID;
+		}
+
+		if (size != 0 && !engine_run_slice(prepared, encrypt, tile, make_span(tile, count), 0, size))
+			return CIPHER_INVALID;
+
+		// Putting the formatting back - a tile that is not the last ends on a letter.
+		unsigned int index = 0;
+		for (unsigned int i = start; i < cursor; i++) {
+			unsigned char character = (unsigned char) text.data[i];
+
+			if (isalpha(character) || (digits && isdigit(character)))
+				dest[length++] = isupper(character) ? (char) toupper((unsigned char) tile[index++]) : tile[index++];
+			else if (index < size)
+				dest[length++] = (char) character;
+		}
+
+		memcpy(dest + length, tile + index, size - index);
+		length += size - index;
+	}
+
+	dest[length] = '\0';
+	return length;
+}
+
+/**
+ * Runs a chain of ciphers over a message, writing the result into a buffer owned by the
+ * caller.
+ *
+ * @remarks
+ * 		Stages that only work within their own blocks (play-fair, hill cipher) are fused -
+ * 		the message is run through all of them a tile at a time, in-place in the destination,
+ * 		so it passes through the cache once. Stages that move characters across the whole
+ * 		message (the transpositions) run on their own; only when one of them has to read from
+ * 		the destination is a second buffer needed, allocated once for the whole run.
+ *
+ * 		The message is padded once, up-front, to fit the blocks of every stage - and railfence
+ * 		runs without padding (see `rf_run_unpadded`). No stage changes the length of the text,
+ * 		as such a ciphered message can always be run back through the chain.
+ *
+ * @note
+ * 		The message should have been normalized before-hand. A null (or small) destination
+ * 		is left untouched and the size needed is returned. The destination should not
+ * 		overlap with the message.
+ *
+ * @param chain: Pointer to the prepared chain.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer in which the result is to be written.
+ * @param dest_cap: Unsigned integer containing the capacity of the buffer, in characters.
+ * @param message: Span containing the message.
+ *
+ * @return
+ * 		Unsigned integer containing the length of the result, or `CIPHER_INVALID` if the
+ * 		message cannot be ciphered by any of the stages.
+ */
+unsigned int engine_chain_into(
+	const struct cipher_chain *chain, bool encrypt, string dest, unsigned int dest_cap, struct span message
+) {
+	// The stages in the order they run, and the size of a block fitting all of them - the
+	// least common multiple of their block sizes.
+	const struct cipher_key *stages[CHAIN_MAX];
+	unsigned int block = 1;
+
+	for (unsigned int i = 0; i < chain->length; i++) {
+		stages[i] = &chain->stages[encrypt ? i : chain->length - 1 - i];
+
+		// The periodic ciphers pick up their key anywhere (see `vg_run_slice`) - and do not pad.
+		unsigned int size = engine_is_periodic(stages[i]) ? 1 : engine_block_size(stages[i]);
+
+		unsigned int a = block, b = size;
+		while (b != 0) {
+			unsigned int rest = a % b;
+			a = b;
+			b = rest;
+		}
+
+		block = block / a * size;
+	}
+
+	// A ciphered message already fits the blocks - only plaintext is padded.
+	unsigned int length = message.length;
+	if (length % block != 0) {
+		if (!encrypt)
+			return CIPHER_INVALID;
+
+		length += block - length % block;
+	}
+
+	// The transpositions take any length - railfence once it does not pad.
+	for (unsigned int i = 0; i < chain->length; i++)
+		if (engine_is_local(stages[i]) && engine_run_into(stages[i], encrypt, NULL, 0, make_span(NULL, length)) == CIPHER_INVALID)
+			return CIPHER_INVALID;
+
+	if (dest == NULL || dest_cap <= length)
+		return length;
+
+	// Every transposition reading from one of the buffers moves the text to the other one -
+	// starting out in whichever buffer leaves the result in the destination.
+	bool padded = length != message.length;
+	unsigned int moves = 0;
+
+	for (unsigned int i = 0; i < chain->length; i++)
+		if (!engine_is_local(stages[i]) && (i > 0 || padded))
+			moves++;
+
+	string buffers[2] = {dest, (moves != 0) ? (string) malloc(length + 1) : NULL};
+	unsigned int current = moves % 2;
+
+	struct span source = message;
+	if (padded) {
+		memcpy(buffers[current], message.data, message.length);
+		memset(buffers[current] + message.length, 'x', length - message.length);
+
+		source = make_span(buffers[current], length);
+	}
+
+	bool valid = true;
+
+	for (unsigned int i = 0; i < chain->length && valid;) {
+		if (!engine_is_local(stages[i])) {
+			if (source.data != message.data)
+				current = 1 - current;
+
+			if (stages[i]->cipher == RAILFENCE)
+				rf_run_unpadded(stages[i]->schedule.railfence.rows, encrypt, buffers[current], source);
+			else
+				engine_run_slice(stages[i], encrypt, buffers[current], source, 0, length);
+
+			source = make_span(buffers[current], length);
+
+			i++;
+			continue;
+		}
+
+		// Finding the run of stages that can be fused with this one.
+		unsigned int last = i;
+		while (last + 1 < chain->length && engine_is_local(stages[last + 1]))
+			last++;
+
+		string target = buffers[current];
+
+		for (unsigned int begin = 0; begin < length && valid; begin += CHAIN_TILE) {
+			unsigned int end = (begin + CHAIN_TILE < length) ? begin + CHAIN_TILE : length;
+
+			for (unsigned int k = i; k <= last && valid; k++) {
+				struct span input = (k == i) ? source : make_span(target, length);
+				valid = engine_run_slice(stages[k], encrypt, target, input, begin, end);
+			}
+		}
+
+		source = make_span(target, length);
+		i = last + 1;
+	}
+
+	free(buffers[1]);
+
+	if (!valid)
+		return CIPHER_INVALID;
+
+	dest[length] = '\0';
+	return length;
+}
+
+/**
+ * Starts running a cipher over a stream - a message arriving in chunks of any size.
+ *
+ * @param stream: Pointer to the stream that is to be initialized.
+ * @param prepared: Pointer to the prepared key - should outlive the stream.
+ * @param encrypt: Boolean indicating if the stream is to be encrypted (or decrypted).
+ *
+ * @note
+ * 		A stream that could be started should be ended using `engine_stream_finish` - even
+ * 		if a chunk could not be ciphered.
+ *
+ * @return
+ * 		Boolean indicating if the cipher can be streamed - only ciphers working within their
+ * 		own blocks can.
+ */
+bool engine_stream_init(struct engine_stream *stream, const struct cipher_key *prepared, bool encrypt) {
+	stream->prepared = prepared;
+	stream->encrypt = encrypt;
+	stream->pending = NULL;
+	stream->pending_length = 0;
+
+	if (!engine_is_local(prepared))
+		return false;
+
+	// Room for one block - the most ever held back.
+	stream->pending = (string) malloc(engine_block_size(prepared));
+	return true;
+}
+
+/**
+ * Runs the cipher over the next chunk of a stream - every complete block is ciphered right
+ * away, and what is left of an incomplete block is held back for the next chunk.
+ *
+ * @note
+ * 		The chunk should be normalized (see `engine_normalize_into`). The destination should
+ * 		be able to hold `chunk.length + engine_block_size` characters, and is not terminated.
+ *
+ * @param stream: Pointer to the stream.
+ * @param dest: Buffer in which the result is to be written.
+ * @param chunk: Span containing the next part of the message.
+ *
+ * @return
+ * 		Unsigned integer containing the number of characters written, or `CIPHER_INVALID`
+ * 		if the chunk cannot be ciphered.
+ */
+unsigned int engine_stream_update(struct engine_stream *stream, string dest, struct span chunk) {
+	unsigned int block = engine_block_size(stream->prepared);
+	unsigned int used = 0, length = 0;
+
+	// Completing the block held back from the previous chunk first.
+	if (stream->pending_length != 0) {
+		while (stream->pending_length < block && used < chunk.length)
+			stream->pending[stream->pending_length++] = chunk.data[used++];
+
+		if (stream->pending_length < block)
+			return 0;
+
+		struct span pending = make_span(stream->pending, block);
+		if (!engine_run_slice(stream->prepared, stream->encrypt, dest, pending, 0, block))
+			return CIPHER_INVALID;
+
+		stream->pending_length = 0;
+		length = block;
+	}
+
+	unsigned int whole = (chunk.length - used) / block * block;
+	struct span blocks = make_span(chunk.data + used, whole);
+
+	if (whole != 0 && !engine_run_slice(stream->prepared, stream->encrypt, dest + length, blocks, 0, whole))
+		return CIPHER_INVALID;
+
+	for (used += whole; used < chunk.length; used++)
+		stream->pending[stream->pending_length++] = chunk.data[used];
+
+	return length + whole;
+}
+
+/**
+ * Ends a stream - the block held back (if any) is padded and ciphered, and the memory held
+ * by the stream is released.
+ *
+ * @param stream: Pointer to the stream.
+ * @param dest: Buffer in which the result is to be written - should be able to hold
+ * 		`engine_block_size + 1` characters. Terminated.
+ *
+ * @return
+ * 		Unsigned integer containing the number of characters written, or `CIPHER_INVALID`
+ * 		if the rest of the stream cannot be ciphered.
+ */
+unsigned int engine_stream_finish(struct engine_stream *stream, string dest) {
+	struct span pending = make_span(stream->pending, stream->pending_length);
+	unsigned int length = 0;
+
+	dest[0] = '\0';
+	if (pending.length != 0)
+		length = engine_run_into(stream->prepared, stream->encrypt, dest, engine_block_size(stream->prepared) + 1, pending);
+
+	free(stream->pending);
+	stream->pending = NULL;
+	stream->pending_length = 0;
+
+	return length;
+}
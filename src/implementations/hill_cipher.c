@@ -3,6 +3,9 @@
  * supports lower-case alphabets only. Space and/or any other character
  * needs to be stripped out of the contents before-hand.
  *
+ * The byte-oriented variants (`hill256` and `hill95`) work over every byte,
+ * or every printable character, as-is - nothing needs to be stripped.
+ *
  * Notes:
  *  Regarding the stupid naming scheme used in this source file, since
  *  the implementations of the various ciphers are linked to a single
@@ -14,6 +17,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "commons.h"
 #include "ciphers.h"
@@ -22,7 +26,7 @@
 // to use.
 //
 // Example; A size of three, will form a `trigraph` and use 3x3 matrix.
-#define MATRIX_SIZE 3
+#define MATRIX_SIZE HC_MATRIX_SIZE
 
 // The base number that is used to calculate the modulo while formulating
 // the final result in the matrix.
@@ -32,14 +36,107 @@
 // string is shorter that expected.
 #define PAD_NULL 'x'
 
-// Defining the key matrix that is to be used by this cipher algorithm.
-// Global because doesn't matter since the program can only run a single
-// cipher during its lifetime.
-char hc_key_matrix[MATRIX_SIZE][MATRIX_SIZE];
+// Number of blocks the vector kernels cipher at once - one per lane of the
+// vectors below. Sized for AVX-512 - narrower instruction sets take a few instructions
+// per operation.
+#define HC_LANES 16
+
+// Reduction modulo `HC_PRINTABLE` without a division - for any `v` below 2^15, the
+// quotient `v / 95` is `(v * HC_95_MAGIC) >> HC_95_SHIFT`.
+#define HC_95_MAGIC 22076u
+#define HC_95_SHIFT 21
+
+// The same, modulo `BASE_MOD` - for any `v` below 2^11.
+#define HC_26_MAGIC 2521u
+#define HC_26_SHIFT 16
+
+// A vector holding one character from each of `HC_LANES` blocks - the arithmetic over
+// these is done with SIMD instructions, where the processor has them.
+typedef unsigned int hc_lanes __attribute__((vector_size(HC_LANES * sizeof(unsigned int))));
+
+// The key schedule used by the string-key methods (`crypt_hill_cipher` and friends).
+// Global because doesn't matter since those methods can only run a single cipher at a
+// time - prepared schedules should be used wherever more than one key is in flight.
+struct hc_schedule hc_key_schedule;
+
+int mod(int a, int b) {
+	int r = a % b;
+	return r < 0 ? r + b : r;
+}
+
+/**
+ * Calculates the inverse of a matrix, modulo the given modulus.
+ *
+ * @remarks
+ * 		The inverse is calculated as the adjoint of the matrix (transpose of the co-factor
+ * 		matrix) multiplied by the multiplicative inverse of the determinant. A matrix only
+ * 		has an inverse if its determinant shares no factor with the modulus - modulo 256,
+ * 		if the determinant is odd.
+ *
+ * @param matrix: The matrix that is to be inverted - values in the range `[0, modulus)`.
+ * @param inverse: The matrix in which the inverse is to be stored. Left untouched if the
+ * 		matrix cannot be inverted.
+ * @param modulus: Unsigned integer containing the modulus - up to `HC_BYTES`.
+ *
+ * @return
+ * 		Boolean indicating if the matrix could be inverted.
+ */
+bool hc_invert_mod(
+	const unsigned char matrix[MATRIX_SIZE][MATRIX_SIZE], unsigned char inverse[MATRIX_SIZE][MATRIX_SIZE],
+	unsigned int modulus
+) {
+	// Populating the co-factor matrix - for a 3x3 matrix, picking the rows/columns cyclically
+	// takes care of the alternating signs.
+	int cofactor[MATRIX_SIZE][MATRIX_SIZE];
+	for (unsigned int row = 0; row < MATRIX_SIZE; row++)
+		for (unsigned int column = 0; column < MATRIX_SIZE; column++)
+			cofactor[row][column] =
+				matrix[(row + 1) % 3][(column + 1) % 3] * matrix[(row + 2) % 3][(column + 2) % 3] -
+				matrix[(row + 1) % 3][(column + 2) % 3] * matrix[(row + 2) % 3][(column + 1) % 3];
+
+	// Expanding the determinant along the first row.
+	int determinant = 0;
+	for (unsigned int i = 0; i < MATRIX_SIZE; i++)
+		determinant += matrix[0][i] * cofactor[0][i];
+
+	determinant = mod(determinant, (int) modulus);
+
+	// Getting the multiplicative inverse of the determinant - does not exist if the two
+	// share a factor.
+	int multi_inverse = 0;
+	for (int i = 1; i < (int) modulus && multi_inverse == 0; i++)
+		if ((determinant * i) % (int) modulus == 1)
+			multi_inverse = i;
+
+	if (multi_inverse == 0)
+		return false;
+
+	// Transposing the co-factor matrix to get the adjoint, and multiplying by the
+	// multiplicative inverse.
+	for (unsigned int i = 0; i < MATRIX_SIZE; i++)
+		for (unsigned int j = 0; j < MATRIX_SIZE; j++)
+			inverse[i][j] = (unsigned char) mod(cofactor[j][i] * multi_inverse, (int) modulus);
+
+	return true;
+}
 
 /**
- * Populates the key matrix being used in this cipher algorithm. The string
- * key supplied will be used to populate the key matrix.
+ * Calculates the inverse of a matrix, modulo `BASE_MOD` - see `hc_invert_mod`.
+ *
+ * @param matrix: The matrix that is to be inverted - values in the range `[0, BASE_MOD)`.
+ * @param inverse: The matrix in which the inverse is to be stored. Left untouched if the
+ * 		matrix cannot be inverted.
+ *
+ * @return
+ * 		Boolean indicating if the matrix could be inverted.
+ */
+bool hc_invert(const unsigned char matrix[MATRIX_SIZE][MATRIX_SIZE], unsigned char inverse[MATRIX_SIZE][MATRIX_SIZE]) {
+	return hc_invert_mod(matrix, inverse, BASE_MOD);
+}
+
+/**
+ * Populates a key schedule - the key matrix being used in this cipher algorithm,
+ * and its inverse. The string key supplied will be used to populate the key matrix.
  *
  * @remarks
  * 	If the key string contains more alphabets than needed in the matrix, only
@@ -48,110 +145,80 @@ char hc_key_matrix[MATRIX_SIZE][MATRIX_SIZE];
  * 	If the key string is not long enough to populate the key matrix by itself,
  * 	normal alphabets will be used after the key string to populate the matrix.
  *
- * @param key: String containing the key used to populate the matrix with value.
+ * @param schedule: Pointer to the schedule that is to be populated.
+ * @param key: Span containing the key used to populate the matrix with value.
  */
-void hc_populate_key(string key) {
+void hc_prepare(struct hc_schedule *schedule, struct span key) {
 	// Using the original key if it is long enough to populate the key matrix,
 	// if not, filling the rest of the space with alphabetical characters.
-	unsigned int string_length = strlen(key);
 	unsigned int counter = 0;
-	for (int i = 0; i < MATRIX_SIZE * MATRIX_SIZE; i++)
-		hc_key_matrix[i / MATRIX_SIZE][i % MATRIX_SIZE] =
-			(i < string_length) ? key[i] : (char) counter++ + 97;
-}
+	for (unsigned int i = 0; i < MATRIX_SIZE * MATRIX_SIZE; i++)
+		schedule->forward[i / MATRIX_SIZE][i % MATRIX_SIZE] = (unsigned char) (
+			(i < key.length) ? (unsigned int) mod(key.data[i] - 97, BASE_MOD) : counter++
+		);
 
-int mod(int a, int b) {
-	int r = a % b;
-	return r < 0 ? r + b : r;
+	// The inverse is only needed to decrypt - a key without one can still encrypt.
+	schedule->modulus = BASE_MOD;
+	schedule->invertible = hc_invert(schedule->forward, schedule->inverse);
 }
 
 /**
+ * Populates a key schedule for a byte-oriented hill cipher - the key is used as-is, every
+ * byte (or printable character) of it being a value in the matrix.
  *
+ * @remarks
+ * 		Similar to `hc_prepare`, a key too short to fill the matrix is followed by the
+ * 		numbers counting up from zero.
  *
- * @param key
+ * @param schedule: Pointer to the schedule that is to be populated.
+ * @param key: Span containing the key - printable characters only for `HC_PRINTABLE`.
+ * @param modulus: Unsigned integer containing the modulus - `HC_BYTES` or `HC_PRINTABLE`.
+ *
+ * @return
+ * 		Boolean indicating if the key matrix can be inverted - the message could not be
+ * 		recovered otherwise, as such the key should not be used.
  */
-void hc_populate_inverse(string key) {
-	// Generating the key matrix for the algorithm - this matrix will then
-	// be inverted for the inverse matrix.
-	hc_populate_key(key);
+bool hc_prepare_bytes(struct hc_schedule *schedule, struct span key, unsigned int modulus) {
+	// Printable characters are counted from the space.
+	int offset = (modulus == HC_PRINTABLE) ? ' ' : 0;
 
-	// Creating a temporary matrix as the augmented matrix.
-	int augmented_matrix[MATRIX_SIZE][MATRIX_SIZE];
-
-	float determinant = 0;
-	for (int i = 0; i < 3; i++)
-		determinant = determinant + (
-			(hc_key_matrix[0][i] - 97) * (
-				(hc_key_matrix[1][(i + 1) % 3] - 97) *
-				(hc_key_matrix[2][(i + 2) % 3] - 97) -
-				(hc_key_matrix[1][(i + 2) % 3] - 97) *
-				(hc_key_matrix[2][(i + 1) % 3] - 97)
-			)
+	unsigned int counter = 0;
+	for (unsigned int i = 0; i < MATRIX_SIZE * MATRIX_SIZE; i++)
+		schedule->forward[i / MATRIX_SIZE][i % MATRIX_SIZE] = (unsigned char) (
+			(i < key.length) ? (unsigned int) mod((unsigned char) key.data[i] - offset, (int) modulus) : counter++
 		);
 
-	// Getting the result and the multiplicative inverse at once.
-	int result = (int) determinant % 26;
-	int multi_inverse = 0;
-	while ((multi_inverse * result) % 26 != 1)
-		multi_inverse++;
-
-	// Populating augmented matrix with initial set of values - will contain
-	// the co-factor matrix by the end of this step.
-	bool negative = false;
-	for (unsigned int row = 0; row < MATRIX_SIZE; row++) {
-		for (unsigned int column = 0; column < MATRIX_SIZE; column++) {
-			int first = 1;
-			int second = 1;
-
-			unsigned int first_row = 0;
-			for (unsigned int i = 0; i < MATRIX_SIZE; i++)
-				for (unsigned int j = 0; j < MATRIX_SIZE; j++)
-					if (i != row && j != column) {
-						if (first_row == 0 || first_row == 3)
-							first *= hc_key_matrix[i][j] - 97;
-						else
-							second *= hc_key_matrix[i][j] - 97;
-
-						first_row++;
-					}
-
-			augmented_matrix[row][column] = ((negative) ? -1 : 1) * (first - second);
-			negative = !negative;
-		}
-	}
-
-	// Converting the co-factor matrix into transpose - to get adjoint matrix.
-	for (unsigned int i = 0; i < MATRIX_SIZE; i++)
-		for (unsigned int j = 0; j < MATRIX_SIZE; j++)
-			if (i <= j) {
-				int temp = mod(augmented_matrix[i][j], 26);
+	schedule->modulus = modulus;
+	schedule->invertible = hc_invert_mod(schedule->forward, schedule->inverse, modulus);
 
-				augmented_matrix[i][j] = mod(augmented_matrix[j][i], 26);
-				augmented_matrix[j][i] = temp;
-			}
+	return schedule->invertible;
+}
 
-	// Multiplying by the multiplicative inverse, and storing the result in the
-	// original matrix, from where it will be used to get the result.
-	for (unsigned int i = 0; i < MATRIX_SIZE; i++)
-		for (unsigned int j = 0; j < MATRIX_SIZE; j++)
-			hc_key_matrix[i][j] = mod(augmented_matrix[i][j] * multi_inverse, 26) + 97;
+/**
+ * Populates the key schedule being used by the string-key methods.
+ *
+ * @param key: Span containing the key used to populate the matrix with value.
+ */
+void hc_populate_key(struct span key) {
+	hc_prepare(&hc_key_schedule, key);
 }
 
 /**
  * Internal function to print the matrix. Defined as an inner-level API,
  * that can either be accessed directly, or using the friendly-function.
  *
+ * @param matrix: The matrix that is to be printed.
  * @param pad_char: String containing characters that are to be used as a padding.
  * @param end_line: String to be printed after the final line of the matrix.
  * 		Ideally, will be one or more new-line characters.
  */
-void _hc_print_key(string pad_char, string end_line) {
+void _hc_print_key(const unsigned char matrix[MATRIX_SIZE][MATRIX_SIZE], string pad_char, string end_line) {
 	for (unsigned int i = 0; i < MATRIX_SIZE; i++) {
 		// Avoiding printing a new line before the start of the matrix. While
 		// ensuring that the first line is actually padded with the character.
 		printf("%c%s", (i != 0) ? '\n' : '\0', pad_char);
 		for (unsigned int j = 0; j < MATRIX_SIZE; j++)
-			printf("%c  ", hc_key_matrix[i][j]);
+			printf("%c  ", matrix[i][j] + 97);
 	}
 
 	// Printing the end-line character.
@@ -169,7 +236,7 @@ void _hc_print_key(string pad_char, string end_line) {
  * 		padding/end-line character is needed.
  */
 extern inline void hc_print_key() {
-	_hc_print_key("", "\n");
+	_hc_print_key(hc_key_schedule.forward, "", "\n");
 }
 
 /**
@@ -179,17 +246,11 @@ extern inline void hc_print_key() {
  * @param c: The character that is to be mapped.
  *
  * @return
- * 		Unsigned integer character indicating the mapped value of the character.
+ * 		Unsigned integer character indicating the mapped value of the character. Characters
+ * 		that cannot be used with this cipher map to `BASE_MOD` (or above).
  */
 extern inline unsigned int map(char c) {
-	if ((int) c < 97) {
-		// Raise an error if an invalid mapping is attempted - reduces the possibility
-		// of logical bugs, instead converts them into runtime errors.
-		printf("Error: Attempt to map character `%c` in Hill Cipher.\n", c);
-		exit(-10);
-	}
-
-	return (int) c - 97;
+	return (unsigned int) (unsigned char) c - 97;
 }
 
 /**
@@ -218,6 +279,7 @@ extern inline char rev_map(int i) {
  * generated by this method in an intermediate step, and the result of matrix
  * multiplication.
  *
+ * @param matrix: The key matrix (or its inverse) being used.
  * @param multiplier: String containing the key map, i.e. the matrix being multiplied
  * 		to the key matrix.
  * @param result: String containing the result, i.e. result of the multiplication
@@ -227,7 +289,10 @@ extern inline char rev_map(int i) {
  * @param end_line: String printed at the end of the matrix. Warning: If set to null,
  * 		the cursor will be present at the end of matrix (won't be moved to next line).
  */
-void hc_current_mapping(string multiplier, string result, const_str padding, const_str end_line) {
+void hc_current_mapping(
+	const unsigned char matrix[MATRIX_SIZE][MATRIX_SIZE], string multiplier, string result,
+	const_str padding, const_str end_line
+) {
 	bool mid_line_found = false;
 	for (unsigned int i = 0; i < MATRIX_SIZE; i++) {
 		// Printing on a new line if this isn't the first row of the matrix.
@@ -237,7 +302,7 @@ void hc_current_mapping(string multiplier, string result, const_str padding, con
 				// The first character will be the alphabet being multiplied, and the string following it
 				// will be the padding as needed (removed in case of last column).
 				"%c%s",
-				hc_key_matrix[i][j],
+				matrix[i][j] + 97,
 				(j + 1 == MATRIX_SIZE) ? "" : "  "
 			);
 
@@ -255,47 +320,48 @@ void hc_current_mapping(string multiplier, string result, const_str padding, con
 }
 
 /**
- * Public method to implement the Hill Cipher algorithm to encrypt text.
+ * Internal method to multiply each block of `MATRIX_SIZE` characters with the key
+ * matrix. The message is copied into the destination before being modified, as such
+ * the destination can be the same buffer as the message.
  *
- * @param message: String containing the message to be encrypted.
- * @param key: String containing the message to be used as a key.
+ * @remarks
+ * 		Used by the string-key methods, which can print every step - prepared keys go
+ * 		through the vector kernels (see `_hc_transform_lanes`).
+ *
+ * @note
+ * 		Writes exactly `result_length` characters - the caller terminates the result if needed.
+ *
+ * @param matrix: The key matrix (or its inverse) to multiply the message with.
+ * @param dest: Buffer in which the result is to be written.
+ * @param message: Span containing the message.
+ * @param result_length: Unsigned integer containing the length of the message after padding.
  * @param verbose: Boolean indicating if verbose mode is to be used.
  *
  * @return
- * 		A string containing the encrypted version of the original text message.
- * 		Will be devoid of all spaces, can be mapped to the input string to
- * 		be able to add back spaces as needed.
+ * 		Boolean indicating if the message could be ciphered - false if the message
+ * 		contains a character that cannot be mapped.
  */
-string crypt_hill_cipher(string message, string key, bool verbose) {
-	// Generating the key matrix.
-	hc_populate_key(key);
-
-	if (verbose) {
-		printf("\nKey Matrix:\n");
-		_hc_print_key("\t", "\n\n");
-		printf("Original Message: \n\t`%s`\n", message);
-	}
-
+bool _hc_transform(
+	const unsigned char matrix[MATRIX_SIZE][MATRIX_SIZE], string dest, struct span message,
+	unsigned int result_length, bool verbose
+) {
 	// Temporary string(s) to hold `n` characters in the string at the time.
-	string temp = (string) malloc(MATRIX_SIZE * sizeof(char));
-	string temp_result = (string) malloc(MATRIX_SIZE * sizeof(char));
-
-	// Calculating the length of the original message, and of the result - they might
-	// not always match. If the message length is not a multiple of `MATRIX_SIZE`, it
-	// will be padded with extra characters to make it fit.
-	unsigned int message_length = strlen(message);
-	unsigned int result_length = message_length + (message_length % MATRIX_SIZE);
-
-	// The result string - will be used to contain the result as it is being generated.
-	string result = (string) malloc(result_length * sizeof(char));
+	char temp[MATRIX_SIZE];
+	char temp_result[MATRIX_SIZE];
+	unsigned int mapped[MATRIX_SIZE];
 
 	// Starting a loop to iterate between every `MATRIX_SIZE` elements. If a
 	// tri-graph is selected for example, iterating between every three elements.
 	for (unsigned int i = 0; i < result_length; i += MATRIX_SIZE) {
-		for (unsigned int counter = 0; counter < MATRIX_SIZE; counter++)
+		for (unsigned int counter = 0; counter < MATRIX_SIZE; counter++) {
 			// Picking up the first `n` characters from the current position - if the
 			// message has ran out of characters, padding with null character.
-			temp[counter] = (i + counter < message_length) ? message[i + counter] : PAD_NULL;
+			temp[counter] = (i + counter < message.length) ? message.data[i + counter] : PAD_NULL;
+			mapped[counter] = map(temp[counter]);
+
+			if (mapped[counter] >= BASE_MOD)
+				return false;
+		}
 
 		// Matrix multiplication - treat the contents of the temp string as a matrix, and perform
 		// multiplication with the key matrix.
@@ -303,97 +369,573 @@ string crypt_hill_cipher(string message, string key, bool verbose) {
 			unsigned int val = 0;
 
 			for (unsigned int k = 0; k < MATRIX_SIZE; k++)
-				val += map(hc_key_matrix[j][k]) * map(temp[k]);
+				val += matrix[j][k] * mapped[k];
 
 			// Adding the results to the temp result string - to make sure that the contents of this
 			// multiplication can be printed in verbose mode. Calculating the modulus using the macro.
 			temp_result[j] = rev_map(val % BASE_MOD);
 		}
 
-		strcat(result, temp_result);
+		// The block has been read completely, safe to overwrite it even if working in-place.
+		memcpy(dest + i, temp_result, MATRIX_SIZE);
 
 		if (verbose) {
 			printf("\n\nIteration %d:\n", (i / 3) + 1);
 
 			hc_current_mapping(
+				matrix,
 				temp,
 				temp_result,
 				"\t",
 				"\n\n"
 			);
 
-			printf("Current Result: \n\t`%s`\n", result);
+			printf("Current Result: \n\t`%.*s`\n", i + MATRIX_SIZE, dest);
 		}
 	}
 
-	// Freeing up space from the temporary string - just a good practice.
-	free(temp);
+	return true;
+}
 
-	return gen_str(result);
+/**
+ * Calculates the length of the result - the message is padded to be a multiple of
+ * `MATRIX_SIZE` in length.
+ *
+ * @param length: Unsigned integer containing the length of the message.
+ *
+ * @return
+ * 		Unsigned integer containing the length of the result.
+ */
+extern inline unsigned int hc_result_length(unsigned int length) {
+	return length + (MATRIX_SIZE - length % MATRIX_SIZE) % MATRIX_SIZE;
 }
 
-string decrypt_hill_cipher(string message, string key, bool verbose) {
-	// Generating the key matrix.
-	hc_populate_inverse(key);
+/**
+ * Internal method to reduce the sums of a row of the key matrix (multiplied with a block)
+ * without a division - see `HC_95_MAGIC` and `HC_26_MAGIC`.
+ *
+ * @param value: Pointer to the vector holding the sum of every lane - each below
+ * 		`3 * (modulus - 1)^2`. Reduced in-place.
+ * @param modulus: Unsigned integer containing the modulus of the cipher.
+ */
+static inline __attribute__((always_inline)) void _hc_reduce(hc_lanes *value, unsigned int modulus) {
+	if (modulus == HC_BYTES)
+		*value &= 0xFF;
+	else if (modulus == HC_PRINTABLE)
+		*value -= ((*value * HC_95_MAGIC) >> HC_95_SHIFT) * HC_PRINTABLE;
+	else
+		*value -= ((*value * HC_26_MAGIC) >> HC_26_SHIFT) * BASE_MOD;
+}
 
-	if (verbose) {
-		printf("\nKey Matrix:\n");
-		_hc_print_key("\t", "\n\n");
-		printf("Original Message: \n\t`%s`\n", message);
+/**
+ * Internal method to multiply each block of a message with the key matrix - similar to
+ * `_hc_transform`, without the verbose output.
+ *
+ * @remarks
+ * 		The blocks are ciphered `HC_LANES` at a time. Their characters are spread over one
+ * 		vector per position in the block (the first characters of every block, the second
+ * 		ones...), multiplied with the key matrix a row at a time, reduced (see `_hc_reduce`)
+ * 		and merged back.
+ *
+ * @note
+ * 		Writes exactly `result_length` characters. The destination can be the same buffer as
+ * 		the message - each group of blocks is read completely before being written.
+ *
+ * @param schedule: Pointer to the prepared key - for its modulus.
+ * @param matrix: The key matrix (or its inverse) to multiply the message with.
+ * @param dest: Buffer in which the result is to be written.
+ * @param message: Span containing the message.
+ * @param result_length: Unsigned integer containing the length of the message after padding.
+ *
+ * @return
+ * 		Boolean indicating if the message could be ciphered - false if the message contains
+ * 		anything other than lower-case alphabets modulo 26, or printable characters modulo 95.
+ */
+static inline __attribute__((always_inline)) bool _hc_transform_lanes(
+	const struct hc_schedule *schedule, const unsigned char matrix[MATRIX_SIZE][MATRIX_SIZE], string dest,
+	struct span message, unsigned int result_length
+) {
+	unsigned int modulus = schedule->modulus;
+	unsigned int offset = (modulus == BASE_MOD) ? 'a' : (modulus == HC_PRINTABLE) ? ' ' : 0;
+
+	for (unsigned int i = 0; i < result_length; i += MATRIX_SIZE * HC_LANES) {
+		unsigned int blocks = (result_length - i) / MATRIX_SIZE;
+		if (blocks > HC_LANES)
+			blocks = HC_LANES;
+
+		// Spreading the characters over the vectors - unused lanes stay at zero.
+		hc_lanes mapped[MATRIX_SIZE] = {{0}};
+		for (unsigned int block = 0; block < blocks; block++)
+			for (unsigned int k = 0; k < MATRIX_SIZE; k++) {
+				unsigned int position = i + block * MATRIX_SIZE + k;
+				unsigned int value = (unsigned int) (
+					(position < message.length) ? (unsigned char) message.data[position] : PAD_NULL
+				) - offset;
+
+				if (value >= modulus)
+					return false;
+
+				mapped[k][block] = value;
+			}
+
+		for (unsigned int j = 0; j < MATRIX_SIZE; j++) {
+			hc_lanes value = matrix[j][0] * mapped[0] + matrix[j][1] * mapped[1] + matrix[j][2] * mapped[2];
+			_hc_reduce(&value, modulus);
+
+			for (unsigned int block = 0; block < blocks; block++)
+				dest[i + block * MATRIX_SIZE + j] = (char) (value[block] + offset);
+		}
 	}
 
-	// Temporary string(s) to hold `n` characters in the string at the time.
-	string temp = (string) malloc(MATRIX_SIZE * sizeof(char));
-	string temp_result = (string) malloc(MATRIX_SIZE * sizeof(char));
+	return true;
+}
 
-	// Calculating the length of the original message, and of the result - they might
-	// not always match. If the message length is not a multiple of `MATRIX_SIZE`, it
-	// will be padded with extra characters to make it fit.
-	unsigned int message_length = strlen(message);
-	unsigned int result_length = message_length + (message_length % MATRIX_SIZE);
+/**
+ * Internal method to cipher a number of independent messages, interleaved over the lanes of
+ * the vectors - see `hc_run_many`.
+ *
+ * @remarks
+ * 		Every lane runs a message a block at a time, with the key matrix of that message
+ * 		spread over the lanes of a vector per entry. A lane taking up a new message as soon as
+ * 		its own is done keeps the vectors full even if the messages are only a few blocks long.
+ * 		Messages of `HC_LANES` blocks or more fill the vectors by themselves, and are run
+ * 		through `_hc_transform_lanes` instead.
+ */
+static inline __attribute__((always_inline)) void _hc_run_many(struct cipher_lane *lanes, unsigned int count) {
+	if (count == 0)
+		return;
 
-	// The result string - will be used to contain the result as it is being generated.
-	string result = (string) malloc(result_length * sizeof(char));
+	unsigned int modulus = ((const struct hc_schedule *) lanes[0].schedule)->modulus;
+	unsigned int offset = (modulus == BASE_MOD) ? 'a' : (modulus == HC_PRINTABLE) ? ' ' : 0;
 
-	// Starting a loop to iterate between every `MATRIX_SIZE` elements. If a
-	// tri-graph is selected for example, iterating between every three elements.
-	for (unsigned int i = 0; i < result_length; i += MATRIX_SIZE) {
-		for (unsigned int counter = 0; counter < MATRIX_SIZE; counter++)
-			// Picking up the first `n` characters from the current position - if the
-			// message has ran out of characters, padding with null character.
-			temp[counter] = (i + counter < message_length) ? message[i + counter] : PAD_NULL;
+	// The message in each lane, how far along it the lane is, and the length of its result.
+	struct cipher_lane *active[HC_LANES] = {NULL};
+	unsigned int position[HC_LANES], total[HC_LANES];
 
-		// Matrix multiplication - treat the contents of the temp string as a matrix, and perform
-		// multiplication with the key matrix.
-		for (unsigned int j = 0; j < MATRIX_SIZE; j++) {
-			unsigned int val = 0;
+	// The key matrices of the lanes - one vector per entry, staged as plain arrays (writing
+	// single lanes of a vector is slow) and loaded once a lane changes hands.
+	unsigned int staged[MATRIX_SIZE][MATRIX_SIZE][HC_LANES] __attribute__((aligned(64))) = {{{0}}};
+	hc_lanes matrix[MATRIX_SIZE][MATRIX_SIZE];
+	bool reload = true;
 
-			for (unsigned int k = 0; k < MATRIX_SIZE; k++)
-				val += map(hc_key_matrix[j][k]) * map(temp[k]);
+	unsigned int next = 0;
 
-			// Adding the results to the temp result string - to make sure that the contents of this
-			// multiplication can be printed in verbose mode. Calculating the modulus using the macro.
-			temp_result[j] = rev_map(val % BASE_MOD);
+	while (true) {
+		unsigned int running = 0;
+
+		// Handing the next messages to the lanes that are free.
+		for (unsigned int l = 0; l < HC_LANES; l++) {
+			while (active[l] == NULL && next < count) {
+				struct cipher_lane *lane = &lanes[next++];
+				const struct hc_schedule *schedule = (const struct hc_schedule *) lane->schedule;
+
+				lane->length = hc_result_length(lane->message.length);
+				if (!lane->encrypt && !schedule->invertible) {
+					lane->length = CIPHER_INVALID;
+					continue;
+				}
+
+				const unsigned char (*key)[MATRIX_SIZE] = lane->encrypt ? schedule->forward : schedule->inverse;
+
+				// A message long enough to fill the vectors on its own is ciphered on its own.
+				if (lane->length >= MATRIX_SIZE * HC_LANES || lane->length == 0) {
+					if (!_hc_transform_lanes(schedule, key, lane->dest, lane->message, lane->length))
+						lane->length = CIPHER_INVALID;
+					else
+						lane->dest[lane->length] = '\0';
+
+					continue;
+				}
+
+				for (unsigned int j = 0; j < MATRIX_SIZE; j++)
+					for (unsigned int k = 0; k < MATRIX_SIZE; k++)
+						staged[j][k][l] = key[j][k];
+
+				reload = true;
+
+				active[l] = lane;
+				position[l] = 0;
+				total[l] = lane->length;
+			}
+
+			running += active[l] != NULL;
 		}
 
-		strcat(result, temp_result);
+		if (running == 0)
+			break;
 
-		if (verbose) {
-			printf("\n\nIteration %d:\n", (i / 3) + 1);
+		if (reload) {
+			memcpy(matrix, staged, sizeof(matrix));
+			reload = false;
+		}
 
-			hc_current_mapping(
-				temp,
-				temp_result,
-				"\t",
-				"\n\n"
-			);
+		// Spreading the next block of every lane over the vectors.
+		unsigned int characters[MATRIX_SIZE][HC_LANES] __attribute__((aligned(64))) = {{0}};
+		for (unsigned int l = 0; l < HC_LANES; l++) {
+			if (active[l] == NULL)
+				continue;
+
+			struct span message = active[l]->message;
+			for (unsigned int k = 0; k < MATRIX_SIZE; k++) {
+				unsigned int at = position[l] + k;
+				unsigned int value = (unsigned int) (
+					(at < message.length) ? (unsigned char) message.data[at] : PAD_NULL
+				) - offset;
+
+				if (value >= modulus) {
+					// Dropping the message - the lane is free again.
+					active[l]->length = CIPHER_INVALID;
+					active[l] = NULL;
+					break;
+				}
+
+				characters[k][l] = value;
+			}
+		}
+
+		hc_lanes mapped[MATRIX_SIZE];
+		memcpy(mapped, characters, sizeof(mapped));
+
+		for (unsigned int j = 0; j < MATRIX_SIZE; j++) {
+			hc_lanes value = matrix[j][0] * mapped[0] + matrix[j][1] * mapped[1] + matrix[j][2] * mapped[2];
+			_hc_reduce(&value, modulus);
 
-			printf("Current Result: \n\t`%s`\n", result);
+			unsigned int results[HC_LANES] __attribute__((aligned(64)));
+			memcpy(results, &value, sizeof(results));
+
+			for (unsigned int l = 0; l < HC_LANES; l++)
+				if (active[l] != NULL)
+					active[l]->dest[position[l] + j] = (char) (results[l] + offset);
+		}
+
+		// Moving every lane along - and terminating the results that are complete.
+		for (unsigned int l = 0; l < HC_LANES; l++) {
+			if (active[l] == NULL)
+				continue;
+
+			position[l] += MATRIX_SIZE;
+			if (position[l] == total[l]) {
+				active[l]->dest[total[l]] = '\0';
+				active[l] = NULL;
+			}
 		}
 	}
+}
+
+/**
+ * The kernels of `_hc_transform_lanes` and `_hc_run_many` - the same code, built for each
+ * instruction set.
+ */
+bool _hc_transform_lanes_generic(
+	const struct hc_schedule *schedule, const unsigned char matrix[MATRIX_SIZE][MATRIX_SIZE], string dest,
+	struct span message, unsigned int result_length
+) {
+	return _hc_transform_lanes(schedule, matrix, dest, message, result_length);
+}
+
+void _hc_run_many_generic(struct cipher_lane *lanes, unsigned int count) {
+	_hc_run_many(lanes, count);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2"))) bool _hc_transform_lanes_avx2(
+	const struct hc_schedule *schedule, const unsigned char matrix[MATRIX_SIZE][MATRIX_SIZE], string dest,
+	struct span message, unsigned int result_length
+) {
+	return _hc_transform_lanes(schedule, matrix, dest, message, result_length);
+}
+
+__attribute__((target("avx2"))) void _hc_run_many_avx2(struct cipher_lane *lanes, unsigned int count) {
+	_hc_run_many(lanes, count);
+}
+
+__attribute__((target("avx512f"))) bool _hc_transform_lanes_avx512(
+	const struct hc_schedule *schedule, const unsigned char matrix[MATRIX_SIZE][MATRIX_SIZE], string dest,
+	struct span message, unsigned int result_length
+) {
+	return _hc_transform_lanes(schedule, matrix, dest, message, result_length);
+}
+
+__attribute__((target("avx512f"))) void _hc_run_many_avx512(struct cipher_lane *lanes, unsigned int count) {
+	_hc_run_many(lanes, count);
+}
+
+#endif
+
+/**
+ * The vector kernels built for an instruction set.
+ */
+struct hc_kernel {
+	enum isa isa;
+
+	bool (*transform_lanes)(
+		const struct hc_schedule *schedule, const unsigned char matrix[MATRIX_SIZE][MATRIX_SIZE], string dest,
+		struct span message, unsigned int result_length
+	);
+
+	void (*run_many)(struct cipher_lane *lanes, unsigned int count);
+};
+
+// The kernels, best first - the last one runs anywhere.
+const struct hc_kernel hc_kernels[] = {
+#if defined(__x86_64__) || defined(__i386__)
+	{ ISA_AVX512, _hc_transform_lanes_avx512, _hc_run_many_avx512 },
+	{ ISA_AVX2, _hc_transform_lanes_avx2, _hc_run_many_avx2 },
+#endif
+	{ ISA_GENERIC, _hc_transform_lanes_generic, _hc_run_many_generic }
+};
+
+// The kernel in use - see `hc_select_kernel`.
+const struct hc_kernel *hc_kernel = &hc_kernels[sizeof(hc_kernels) / sizeof(hc_kernels[0]) - 1];
+
+/**
+ * Selects the vector kernels (used by the byte-oriented variants, and to run many messages
+ * at once) - the best ones needing at most the instruction set given.
+ *
+ * @note
+ * 		Not thread-safe - meant to be called at startup (see `cpu_dispatch`).
+ *
+ * @param isa: The instruction set that can be used.
+ *
+ * @return
+ * 		The instruction set of the kernel selected.
+ */
+enum isa hc_select_kernel(enum isa isa) {
+	unsigned int i = 0;
+	while (hc_kernels[i].isa > isa)
+		i++;
+
+	hc_kernel = &hc_kernels[i];
+	return hc_kernel->isa;
+}
+
+/**
+ * Runs the hill cipher with a prepared key, writing the result into a buffer owned by
+ * the caller.
+ *
+ * @remarks
+ * 		Does not touch any global state - safe to call from multiple threads sharing the
+ * 		same schedule. A null (or small) destination is left untouched and the size needed
+ * 		is returned.
+ *
+ * @param schedule: Pointer to the key prepared using `hc_prepare`.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer in which the result is to be written. Can be the same as the message.
+ * @param dest_cap: Unsigned integer containing the capacity of the buffer, in characters.
+ * @param message: Span containing the message.
+ *
+ * @return
+ * 		Unsigned integer containing the length of the result, or `CIPHER_INVALID` if the key
+ * 		has no inverse (while decrypting) or the message contains anything other than
+ * 		lower-case alphabets (printable characters for `HC_PRINTABLE`, and anything at all
+ * 		for `HC_BYTES`).
+ */
+unsigned int hc_run_into(
+	const struct hc_schedule *schedule, bool encrypt, string dest, unsigned int dest_cap, struct span message
+) {
+	unsigned int result_length = hc_result_length(message.length);
+
+	if (!encrypt && !schedule->invertible)
+		return CIPHER_INVALID;
+
+	if (dest == NULL || dest_cap <= result_length)
+		return result_length;
+
+	const unsigned char (*matrix)[MATRIX_SIZE] = encrypt ? schedule->forward : schedule->inverse;
+
+	if (!hc_kernel->transform_lanes(schedule, matrix, dest, message, result_length))
+		return CIPHER_INVALID;
+
+	dest[result_length] = '\0';
+	return result_length;
+}
+
+/**
+ * Runs the hill cipher over a part of a message using a prepared key - writes the characters
+ * at positions `[begin, end)` of the result that `hc_run_into` would produce.
+ *
+ * @remarks
+ * 		Used to split a large message across threads - calls over disjoint ranges write to
+ * 		disjoint parts of the destination. Nothing is written outside of the range, not even
+ * 		a string terminator.
+ *
+ * @note
+ * 		The range should start on a trigraph (a multiple of `HC_MATRIX_SIZE`). The size of the
+ * 		result should have been checked using `hc_run_into` beforehand.
+ *
+ * @param schedule: Pointer to the key prepared using `hc_prepare`.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer for the complete result - the range is written at its own offsets.
+ * @param message: Span containing the complete message.
+ * @param begin: Unsigned integer containing the first position of the result to be written.
+ * @param end: Unsigned integer containing the position of the result to stop at.
+ *
+ * @return
+ * 		Boolean indicating if the range could be ciphered - false if it contains anything
+ * 		that cannot be ciphered (see `hc_run_into`), or the key has no inverse while decrypting.
+ */
+bool hc_run_slice(
+	const struct hc_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+) {
+	if (!encrypt && !schedule->invertible)
+		return false;
+
+	unsigned int available = (end < message.length) ? end : message.length;
+
+	const unsigned char (*matrix)[MATRIX_SIZE] = encrypt ? schedule->forward : schedule->inverse;
+	struct span part = make_span(message.data + begin, available - begin);
+
+	return hc_kernel->transform_lanes(schedule, matrix, dest + begin, part, end - begin);
+}
+
+/**
+ * Runs the hill cipher over a number of independent messages at once, each with its own
+ * prepared key - the messages are interleaved over the lanes of the vectors (see
+ * `_hc_run_many`), as such even short messages are ciphered at the speed of long ones.
+ *
+ * @note
+ * 		Every lane should use the same modulus - only the variant of the cipher has to match,
+ * 		not the key. The results are the same as those of `hc_run_into`.
+ *
+ * @param lanes: Array containing the messages - their results are written into the lanes.
+ * @param count: Unsigned integer containing the number of messages.
+ */
+void hc_run_many(struct cipher_lane *lanes, unsigned int count) {
+	hc_kernel->run_many(lanes, count);
+}
+
+/**
+ * Internal method shared by the string-key methods - prepares the global schedule, and
+ * runs the cipher while printing the steps in verbose mode.
+ *
+ * @remarks
+ * 		Will force-stop the execution of the program if the message cannot be ciphered.
+ */
+unsigned int _hc_run_into(
+	bool encrypt, string dest, unsigned int dest_cap, struct span message, struct span key, bool verbose
+) {
+	unsigned int result_length = hc_result_length(message.length);
+	if (dest == NULL || dest_cap <= result_length)
+		return result_length;
+
+	// Generating the key matrix, and its inverse.
+	hc_populate_key(key);
+
+	if (!encrypt && !hc_key_schedule.invertible) {
+		// Decrypting is impossible if the key matrix cannot be inverted - converting this
+		// into a runtime error.
+		printf("\nError: The key `%.*s` cannot be inverted (Hill Cipher).\n", key.length, key.data);
+		exit(-10);
+	}
+
+	const unsigned char (*matrix)[MATRIX_SIZE] = encrypt ? hc_key_schedule.forward : hc_key_schedule.inverse;
+
+	if (verbose) {
+		printf("\nKey Matrix:\n");
+		_hc_print_key(matrix, "\t", "\n\n");
+		printf("Original Message: \n\t`%.*s`\n", message.length, message.data);
+	}
+
+	if (!_hc_transform(matrix, dest, message, result_length, verbose)) {
+		// Raise an error if an invalid mapping is attempted - reduces the possibility
+		// of logical bugs, instead converts them into runtime errors.
+		printf("Error: Attempt to map a non-alphabetical character in Hill Cipher.\n");
+		exit(-10);
+	}
+
+	dest[result_length] = '\0';
+	return result_length;
+}
+
+/**
+ * Public method to implement the Hill Cipher algorithm to encrypt text, writing the
+ * result into a buffer owned by the caller.
+ *
+ * @remarks
+ * 		Calling this method with a null destination (or a destination that is too
+ * 		small) does not modify anything and simply returns the size needed.
+ *
+ * @param dest: Buffer in which the result is to be written. Can be the same as the message.
+ * @param dest_cap: Unsigned integer containing the capacity of the buffer, in characters.
+ * @param message: Span containing the message to be encrypted.
+ * @param key: Span containing the message to be used as a key.
+ * @param verbose: Boolean indicating if verbose mode is to be used.
+ *
+ * @return
+ * 		Unsigned integer containing the length of the result. The buffer should be able
+ * 		to hold one more character than this (for the string terminator).
+ */
+unsigned int crypt_hill_cipher_into(
+	string dest, unsigned int dest_cap, struct span message, struct span key, bool verbose
+) {
+	return _hc_run_into(true, dest, dest_cap, message, key, verbose);
+}
+
+/**
+ * Public method to decrypt text ciphered using the Hill Cipher algorithm, writing the
+ * result into a buffer owned by the caller.
+ *
+ * @remarks
+ * 		Similar to `crypt_hill_cipher_into`, a null (or small) destination is left untouched
+ * 		and the size needed is returned.
+ *
+ * @param dest: Buffer in which the result is to be written. Can be the same as the message.
+ * @param dest_cap: Unsigned integer containing the capacity of the buffer, in characters.
+ * @param message: Span containing the ciphered text.
+ * @param key: Span containing the key used to cipher the text.
+ * @param verbose: Boolean indicating if verbose mode is to be used.
+ *
+ * @return
+ * 		Unsigned integer containing the length of the result.
+ */
+unsigned int decrypt_hill_cipher_into(
+	string dest, unsigned int dest_cap, struct span message, struct span key, bool verbose
+) {
+	return _hc_run_into(false, dest, dest_cap, message, key, verbose);
+}
 
-	// Freeing up space from the temporary string - just a good practice.
-	free(temp);
+/**
+ * Public method to implement the Hill Cipher algorithm to encrypt text.
+ *
+ * @note
+ * 		Delegates to `crypt_hill_cipher_into` - the string returned is created using
+ * 		`malloc` and should be destroyed once it has been used.
+ *
+ * @param message: Span containing the message to be encrypted.
+ * @param key: Span containing the message to be used as a key.
+ * @param verbose: Boolean indicating if verbose mode is to be used.
+ *
+ * @return
+ * 		A span over a new string containing the encrypted version of the original text
+ * 		message. Will be devoid of all spaces, can be mapped to the input string to
+ * 		be able to add back spaces as needed.
+ */
+struct span crypt_hill_cipher(struct span message, struct span key, bool verbose) {
+	unsigned int size = hc_result_length(message.length) + 1;
+
+	string result = (string) malloc(size * sizeof(char));
+	return make_span(result, crypt_hill_cipher_into(result, size, message, key, verbose));
+}
+
+/**
+ * Public method to decrypt text ciphered using the Hill Cipher algorithm.
+ *
+ * @note
+ * 		Delegates to `decrypt_hill_cipher_into` - the string returned is created using
+ * 		`malloc` and should be destroyed once it has been used.
+ *
+ * @param message: Span containing the ciphered text.
+ * @param key: Span containing the key used to cipher the text.
+ * @param verbose: Boolean indicating if verbose mode is to be used.
+ *
+ * @return
+ * 		A span over a new string containing the deciphered message.
+ */
+struct span decrypt_hill_cipher(struct span message, struct span key, bool verbose) {
+	unsigned int size = hc_result_length(message.length) + 1;
 
-	return gen_str(result);
+	string result = (string) malloc(size * sizeof(char));
+	return make_span(result, decrypt_hill_cipher_into(result, size, message, key, verbose));
 }
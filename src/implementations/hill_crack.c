@@ -0,0 +1,586 @@
+// Implementation of the hill cipher crack. With enough known plaintext the key is solved
+// for directly - three trigraphs of plaintext whose matrix can be inverted pin down the
+// key matrix, as `C = K * P` gives `K = C * P^-1` (modulo 26).
+//
+// Otherwise, the rows of the inverse matrix are searched for one at a time. Each row of
+// the inverse gives one character of every plaintext trigraph, as such the 26^3 candidates
+// for a row can be ranked on their own - by how English their characters are, and by the
+// known plaintext (if any) they agree with. The best rows are then put together, and the
+// resulting keys ranked on the plaintext they give.
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "crack.h"
+#include "ciphers.h"
+#include "thread_pool.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#define true 1
+#define false 0
+
+#define MATRIX_SIZE HC_MATRIX_SIZE
+
+// Number of candidates for a single row of the matrix - `26^MATRIX_SIZE`.
+#define HC_CRACK_ROWS (26 * 26 * 26)
+
+// Largest value of the product of a row with a trigraph, before it is reduced modulo 26.
+#define HC_CRACK_DOT (MATRIX_SIZE * 25 * 25 + 1)
+
+// Number of trigraphs of the cipher used to rank candidates.
+#define HC_CRACK_BLOCKS 683
+
+// Number of candidates kept for each row of the matrix - every combination of them is tried.
+#define HC_CRACK_ROW_TOP 16
+
+// Number of candidates scored in one go, before they are offered to the rankings.
+#define HC_CRACK_CHUNK 64
+
+// Number of known trigraphs searched for an invertible set.
+#define HC_CRACK_KNOWN_BLOCKS 64
+
+// Length of the n-grams used to rank complete keys.
+#define HC_CRACK_NGRAM 3
+
+/**
+ * Internal method to multiply two matrices, modulo 26.
+ */
+void hc_crack_multiply(
+	const unsigned char left[MATRIX_SIZE][MATRIX_SIZE], const unsigned char right[MATRIX_SIZE][MATRIX_SIZE],
+	unsigned char result[MATRIX_SIZE][MATRIX_SIZE]
+) {
+	for (unsigned int i = 0; i < MATRIX_SIZE; i++)
+		for (unsigned int j = 0; j < MATRIX_SIZE; j++) {
+			unsigned int value = 0;
+
+			for (unsigned int k = 0; k < MATRIX_SIZE; k++)
+				value += left[i][k] * right[k][j];
+
+			result[i][j] = (unsigned char) (value % 26);
+		}
+}
+
+/**
+ * Internal method to pack a key matrix into an integer (a number in base 26, read row by
+ * row) - the form in which candidates are ranked.
+ */
+unsigned long long hc_crack_pack(const unsigned char matrix[MATRIX_SIZE][MATRIX_SIZE]) {
+	unsigned long long key = 0;
+
+	for (unsigned int i = 0; i < MATRIX_SIZE * MATRIX_SIZE; i++)
+		key = key * 26 + matrix[i / MATRIX_SIZE][i % MATRIX_SIZE];
+
+	return key;
+}
+
+/**
+ * Internal method to unpack a key matrix into its string form - the key that would be
+ * passed to the cipher.
+ */
+void hc_crack_unpack(unsigned long long key, char dest[MATRIX_SIZE * MATRIX_SIZE]) {
+	for (int i = MATRIX_SIZE * MATRIX_SIZE - 1; i >= 0; i--) {
+		dest[i] = (char) ('a' + key % 26);
+		key /= 26;
+	}
+}
+
+/**
+ * Internal method to solve for the key using the known plaintext - looks for three known
+ * trigraphs that can be inverted, and checks the key they give against the rest.
+ *
+ * @return
+ * 		Boolean indicating if the key could be solved for.
+ */
+bool hc_solve_known(struct span cipher, struct span known, unsigned char key[MATRIX_SIZE][MATRIX_SIZE]) {
+	unsigned int blocks = known.length / MATRIX_SIZE;
+	unsigned int searched = (blocks < HC_CRACK_KNOWN_BLOCKS) ? blocks : HC_CRACK_KNOWN_BLOCKS;
+
+	unsigned char plain[MATRIX_SIZE][MATRIX_SIZE], coded[MATRIX_SIZE][MATRIX_SIZE];
+	unsigned char inverse[MATRIX_SIZE][MATRIX_SIZE];
+
+	for (unsigned int a = 0; a < searched; a++)
+		for (unsigned int b = a + 1; b < searched; b++)
+			for (unsigned int c = b + 1; c < searched; c++) {
+				// The trigraphs are the columns of the matrices.
+				unsigned int picked[MATRIX_SIZE] = {a, b, c};
+
+				for (unsigned int column = 0; column < MATRIX_SIZE; column++)
+					for (unsigned int row = 0; row < MATRIX_SIZE; row++) {
+						plain[row][column] = known.data[picked[column] * MATRIX_SIZE + row] - 'a';
+						coded[row][column] = cipher.data[picked[column] * MATRIX_SIZE + row] - 'a';
+					}
+
+				if (!hc_invert((const unsigned char (*)[MATRIX_SIZE]) plain, inverse))
+					continue;
+
+				hc_crack_multiply(
+					(const unsigned char (*)[MATRIX_SIZE]) coded, (const unsigned char (*)[MATRIX_SIZE]) inverse, key
+				);
+
+				// Any invertible set gives the same key if the plaintext is right - checking it
+				// against every known trigraph to catch plaintext that is not.
+				for (unsigned int i = 0; i < blocks * MATRIX_SIZE; i++) {
+					unsigned int block = i - i % MATRIX_SIZE, value = 0;
+
+					for (unsigned int k = 0; k < MATRIX_SIZE; k++)
+						value += key[i % MATRIX_SIZE][k] * (known.data[block + k] - 'a');
+
+					if ((char) ('a' + value % 26) != cipher.data[i])
+						return false;
+				}
+
+				return true;
+			}
+
+	return false;
+}
+
+/**
+ * A search over the candidates for the rows of the inverse matrix - the range of the job
+ * covers every candidate, read as a number in base 26.
+ */
+struct hc_crack_job {
+	// The job run on the pool - should stay the first member.
+	struct pool_job job;
+
+	// The sampled trigraphs of the cipher, split by position - the first character of
+	// every trigraph, then the second, and so on.
+	unsigned char *columns[MATRIX_SIZE];
+	unsigned int blocks;
+
+	// The cipher, and the known plaintext at its start (normalized, possibly empty).
+	struct span cipher;
+	struct span known;
+
+	// Score of a character, indexed by the product of a row with a trigraph - before it
+	// is reduced, so that the modulo is never calculated while scoring. The vector kernels
+	// gather 32 bits at a time, as such read (and drop) the entry past the last one.
+	short scores[HC_CRACK_DOT + 1];
+
+	// The best candidates for every row.
+	struct crack_ranking rankings[MATRIX_SIZE];
+};
+
+/**
+ * Internal method to check a candidate row against the known plaintext.
+ *
+ * @return
+ * 		Boolean indicating if the row gives the known characters at its position.
+ */
+bool hc_crack_agrees(const struct hc_crack_job *crack, const unsigned int row[MATRIX_SIZE], unsigned int position) {
+	for (unsigned int i = position; i < crack->known.length; i += MATRIX_SIZE) {
+		const_str block = crack->cipher.data + (i - position);
+		unsigned int value = 0;
+
+		for (unsigned int k = 0; k < MATRIX_SIZE; k++)
+			value += row[k] * (unsigned int) (block[k] - 'a');
+
+		if (value % 26 != (unsigned int) (crack->known.data[i] - 'a'))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * The kernels scoring a run of candidate rows - by how English the characters they give for
+ * the sampled trigraphs are. A candidate at a time, and 8 (AVX2) or 16 (AVX-512) candidates
+ * at a time with a lane for each, gathering the score of every character from the table.
+ *
+ * @param crack: Pointer to the search.
+ * @param begin: Unsigned integer containing the first candidate.
+ * @param count: Unsigned integer containing the number of candidates - at most `HC_CRACK_CHUNK`.
+ * @param scores: Array in which the score of every candidate is to be written.
+ */
+void _hc_crack_score_generic(const struct hc_crack_job *crack, unsigned int begin, unsigned int count, long long *scores) {
+	const unsigned char *first = crack->columns[0], *second = crack->columns[1], *third = crack->columns[2];
+
+	for (unsigned int j = 0; j < count; j++) {
+		unsigned int candidate = begin + j;
+		unsigned int row[MATRIX_SIZE] = {candidate / 676, candidate / 26 % 26, candidate % 26};
+
+		// Kept free of branches and modulo, over plain arrays - the hot loop of the search.
+		long long score = 0;
+		for (unsigned int i = 0; i < crack->blocks; i++)
+			score += crack->scores[row[0] * first[i] + row[1] * second[i] + row[2] * third[i]];
+
+		scores[j] = score;
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2"))) void _hc_crack_score_avx2(
+	const struct hc_crack_job *crack, unsigned int begin, unsigned int count, long long *scores
+) {
+	const unsigned char *first = crack->columns[0], *second = crack->columns[1], *third = crack->columns[2];
+
+	unsigned int j = 0;
+	for (; j + 8 <= count; j += 8) {
+		int digits[MATRIX_SIZE][8];
+		for (unsigned int lane = 0; lane < 8; lane++) {
+			unsigned int candidate = begin + j + lane;
+
+			digits[0][lane] = (int) (candidate / 676);
+			digits[1][lane] = (int) (candidate / 26 % 26);
+			digits[2][lane] = (int) (candidate % 26);
+		}
+
+		__m256i row0 = _mm256_loadu_si256((const __m256i *) digits[0]);
+		__m256i row1 = _mm256_loadu_si256((const __m256i *) digits[1]);
+		__m256i row2 = _mm256_loadu_si256((const __m256i *) digits[2]);
+		__m256i total = _mm256_setzero_si256();
+
+		for (unsigned int i = 0; i < crack->blocks; i++) {
+			__m256i index = _mm256_add_epi32(
+				_mm256_add_epi32(
+					_mm256_mullo_epi32(row0, _mm256_set1_epi32(first[i])),
+					_mm256_mullo_epi32(row1, _mm256_set1_epi32(second[i]))
+				),
+				_mm256_mullo_epi32(row2, _mm256_set1_epi32(third[i]))
+			);
+
+			// The score is the lower half of the 32 bits gathered - sign-extended in place.
+			__m256i value = _mm256_i32gather_epi32((const int *) crack->scores, index, sizeof(short));
+			total = _mm256_add_epi32(total, _mm256_srai_epi32(_mm256_slli_epi32(value, 16), 16));
+		}
+
+		int lanes[8];
+		_mm256_storeu_si256((__m256i *) lanes, total);
+
+		for (unsigned int lane = 0; lane < 8; lane++)
+			scores[j + lane] = lanes[lane];
+	}
+
+	_hc_crack_score_generic(crack, begin + j, count - j, scores + j);
+}
+
+__attribute__((target("avx512f"))) void _hc_crack_score_avx512(
+	const struct hc_crack_job *crack, unsigned int begin, unsigned int count, long long *scores
+) {
+	const unsigned char *first = crack->columns[0], *second = crack->columns[1], *third = crack->columns[2];
+
+	unsigned int j = 0;
+	for (; j + 16 <= count; j += 16) {
+		int digits[MATRIX_SIZE][16];
+		for (unsigned int lane = 0; lane < 16; lane++) {
+			unsigned int candidate = begin + j + lane;
+
+			digits[0][lane] = (int) (candidate / 676);
+			digits[1][lane] = (int) (candidate / 26 % 26);
+			digits[2][lane] = (int) (candidate % 26);
+		}
+
+		__m512i row0 = _mm512_loadu_si512((const void *) digits[0]);
+		__m512i row1 = _mm512_loadu_si512((const void *) digits[1]);
+		__m512i row2 = _mm512_loadu_si512((const void *) digits[2]);
+		__m512i total = _mm512_setzero_si512();
+
+		for (unsigned int i = 0; i < crack->blocks; i++) {
+			__m512i index = _mm512_add_epi32(
+				_mm512_add_epi32(
+					_mm512_mullo_epi32(row0, _mm512_set1_epi32(first[i])),
+					_mm512_mullo_epi32(row1, _mm512_set1_epi32(second[i]))
+				),
+				_mm512_mullo_epi32(row2, _mm512_set1_epi32(third[i]))
+			);
+
+			__m512i value = _mm512_i32gather_epi32(index, (const void *) crack->scores, sizeof(short));
+			total = _mm512_add_epi32(total, _mm512_srai_epi32(_mm512_slli_epi32(value, 16), 16));
+		}
+
+		int lanes[16];
+		_mm512_storeu_si512((void *) lanes, total);
+
+		for (unsigned int lane = 0; lane < 16; lane++)
+			scores[j + lane] = lanes[lane];
+	}
+
+	_hc_crack_score_generic(crack, begin + j, count - j, scores + j);
+}
+
+#endif
+
+/**
+ * The scoring kernel built for an instruction set.
+ */
+struct hc_crack_kernel {
+	enum isa isa;
+
+	void (*score)(const struct hc_crack_job *crack, unsigned int begin, unsigned int count, long long *scores);
+};
+
+// The kernels, best first - the last one runs anywhere.
+const struct hc_crack_kernel hc_crack_kernels[] = {
+#if defined(__x86_64__) || defined(__i386__)
+	{ ISA_AVX512, _hc_crack_score_avx512 },
+	{ ISA_AVX2, _hc_crack_score_avx2 },
+#endif
+	{ ISA_GENERIC, _hc_crack_score_generic }
+};
+
+// The kernel in use - see `hc_crack_select_kernel`.
+const struct hc_crack_kernel *hc_crack_kernel = &hc_crack_kernels[
+	sizeof(hc_crack_kernels) / sizeof(hc_crack_kernels[0]) - 1
+];
+
+/**
+ * Selects the scoring kernel of the hill cipher crack - the best one needing at most the
+ * instruction set given.
+ *
+ * @note
+ * 		Not thread-safe - meant to be called at startup (see `cpu_dispatch`).
+ *
+ * @param isa: The instruction set that can be used.
+ *
+ * @return
+ * 		The instruction set of the kernel selected.
+ */
+enum isa hc_crack_select_kernel(enum isa isa) {
+	unsigned int i = 0;
+	while (hc_crack_kernels[i].isa > isa)
+		i++;
+
+	hc_crack_kernel = &hc_crack_kernels[i];
+	return hc_crack_kernel->isa;
+}
+
+/**
+ * Internal method to rank a range of candidate rows - called on the workers.
+ *
+ * @remarks
+ * 		The score of a row does not depend on the position it is used at, as such every
+ * 		candidate is scored once (a chunk at a time, see `hc_crack_kernels`) and offered to
+ * 		each position it agrees with.
+ */
+void hc_crack_part(struct pool_job *job, unsigned int begin, unsigned int end) {
+	struct hc_crack_job *crack = (struct hc_crack_job *) job;
+	long long scores[HC_CRACK_CHUNK];
+
+	for (unsigned int start = begin; start < end; start += HC_CRACK_CHUNK) {
+		unsigned int count = (end - start < HC_CRACK_CHUNK) ? end - start : HC_CRACK_CHUNK;
+		hc_crack_kernel->score(crack, start, count, scores);
+
+		for (unsigned int j = 0; j < count; j++) {
+			unsigned int candidate = start + j;
+			unsigned int row[MATRIX_SIZE] = {candidate / 676, candidate / 26 % 26, candidate % 26};
+
+			for (unsigned int position = 0; position < MATRIX_SIZE; position++)
+				if (hc_crack_agrees(crack, row, position))
+					ranking_offer(&crack->rankings[position], candidate, scores[j]);
+		}
+	}
+}
+
+/**
+ * Internal method to put together every combination of the best rows, and rank the keys
+ * they give on the plaintext of the sample.
+ */
+void hc_crack_combine(struct hc_crack_job *crack, const struct ngram_table *table, struct crack_ranking *ranking) {
+	unsigned int sample = crack->blocks * MATRIX_SIZE;
+	string plaintext = (string) malloc(sample);
+
+	unsigned char inverse[MATRIX_SIZE][MATRIX_SIZE], key[MATRIX_SIZE][MATRIX_SIZE];
+	unsigned int picked[MATRIX_SIZE] = {0};
+
+	while (true) {
+		for (unsigned int position = 0; position < MATRIX_SIZE; position++) {
+			unsigned long long candidate = crack->rankings[position].items[picked[position]].key;
+
+			inverse[position][0] = (unsigned char) (candidate / 676);
+			inverse[position][1] = (unsigned char) (candidate / 26 % 26);
+			inverse[position][2] = (unsigned char) (candidate % 26);
+		}
+
+		// Only rows that form an invertible matrix can come from a key.
+		if (hc_invert((const unsigned char (*)[MATRIX_SIZE]) inverse, key)) {
+			for (unsigned int i = 0; i < sample; i++) {
+				unsigned int value = 0;
+
+				for (unsigned int k = 0; k < MATRIX_SIZE; k++)
+					value += inverse[i % MATRIX_SIZE][k] * crack->columns[k][i / MATRIX_SIZE];
+
+				plaintext[i] = (char) ('a' + value % 26);
+			}
+
+			ranking_offer(
+				ranking, hc_crack_pack((const unsigned char (*)[MATRIX_SIZE]) key),
+				ngram_score(table, make_span(plaintext, sample))
+			);
+		}
+
+		// Moving on to the next combination - counting through the rankings like digits.
+		unsigned int position = 0;
+		while (position < MATRIX_SIZE && ++picked[position] == crack->rankings[position].count)
+			picked[position++] = 0;
+
+		if (position == MATRIX_SIZE)
+			break;
+	}
+
+	free(plaintext);
+}
+
+/**
+ * Internal method to print a candidate key along with the plaintext it gives - and its
+ * fitness, if it was ranked.
+ */
+void hc_crack_report(unsigned int rank, unsigned long long packed, bool ranked, double fitness, struct span cipher) {
+	char key[MATRIX_SIZE * MATRIX_SIZE];
+	hc_crack_unpack(packed, key);
+
+	struct hc_schedule schedule;
+	hc_prepare(&schedule, make_span(key, MATRIX_SIZE * MATRIX_SIZE));
+
+	printf("\n#%u - Key: %.*s", rank, MATRIX_SIZE * MATRIX_SIZE, key);
+	if (ranked)
+		printf(", Fitness: %.3f", fitness);
+
+	string plaintext = (string) malloc(cipher.length + 1);
+
+	if (hc_run_into(&schedule, false, plaintext, cipher.length + 1, cipher) == CIPHER_INVALID)
+		printf("\n\tThe key cannot be inverted - the plaintext cannot be recovered\n");
+	else
+		printf("\n\t%.*s\n", cipher.length, plaintext);
+
+	free(plaintext);
+}
+
+/**
+ * Cracks a hill cipher - solves for the key using known plaintext where it is enough to,
+ * and searches for it otherwise. Prints the best candidates along with their plaintexts.
+ *
+ * @remarks
+ * 		The known plaintext (optional) should be the start of the message, and is normalized
+ * 		the same way the cipher is. Three trigraphs of it are usually enough to solve for
+ * 		the key - any amount narrows the search down.
+ *
+ * @param cipher: Span containing the (normalized) cipher.
+ * @param options: Pointer to the options of the run.
+ *
+ * @return
+ * 		Integer containing the exit code for the program.
+ */
+int crack_hill(struct span cipher, const struct crack_options *options) {
+	struct timespec started, stopped;
+	clock_gettime(CLOCK_MONOTONIC, &started);
+
+	if (cipher.length < MATRIX_SIZE || cipher.length % MATRIX_SIZE != 0) {
+		printf("\nError: The cipher should be made of complete trigraphs\n");
+		return -10;
+	}
+
+	string known = (string) malloc(options->known.length + 1);
+	unsigned int known_length = normalize_into(known, options->known);
+	if (known_length > cipher.length)
+		known_length = cipher.length;
+
+	unsigned char key[MATRIX_SIZE][MATRIX_SIZE];
+
+	if (hc_solve_known(cipher, make_span(known, known_length), key)) {
+		clock_gettime(CLOCK_MONOTONIC, &stopped);
+		double elapsed = (stopped.tv_sec - started.tv_sec) * 1e3 + (stopped.tv_nsec - started.tv_nsec) / 1e6;
+
+		printf("\nSolved for the key using %u known trigraphs in %.2f ms\n", known_length / MATRIX_SIZE, elapsed);
+		hc_crack_report(1, hc_crack_pack((const unsigned char (*)[MATRIX_SIZE]) key), false, 0, cipher);
+		printf("\n");
+
+		free(known);
+		return 0;
+	}
+
+	struct ngram_table letters, table;
+	if (!crack_table(&letters, 1, options)) {
+		free(known);
+		return -10;
+	}
+
+	if (!crack_table(&table, HC_CRACK_NGRAM, options)) {
+		ngram_free(&letters);
+		free(known);
+		return -10;
+	}
+
+	struct hc_crack_job *crack = (struct hc_crack_job *) calloc(1, sizeof(struct hc_crack_job));
+	crack->cipher = cipher;
+	crack->known = make_span(known, known_length);
+
+	crack->blocks = cipher.length / MATRIX_SIZE;
+	if (crack->blocks > HC_CRACK_BLOCKS)
+		crack->blocks = HC_CRACK_BLOCKS;
+
+	for (unsigned int k = 0; k < MATRIX_SIZE; k++) {
+		crack->columns[k] = (unsigned char *) malloc(crack->blocks);
+
+		for (unsigned int i = 0; i < crack->blocks; i++)
+			crack->columns[k][i] = (unsigned char) (cipher.data[i * MATRIX_SIZE + k] - 'a');
+	}
+
+	for (unsigned int i = 0; i < HC_CRACK_DOT; i++)
+		crack->scores[i] = letters.scores[i % 26];
+
+	for (unsigned int position = 0; position < MATRIX_SIZE; position++)
+		ranking_init(&crack->rankings[position], HC_CRACK_ROW_TOP);
+
+	crack->job.run = hc_crack_part;
+	crack->job.length = HC_CRACK_ROWS;
+	crack->job.align = 1;
+	crack->job.grain = 256;
+
+	struct thread_pool *pool = pool_create(options->threads);
+	pool_submit(pool, &crack->job);
+	pool_destroy(pool);
+
+	struct crack_ranking ranking;
+	ranking_init(&ranking, options->top);
+
+	bool agreed = true;
+	for (unsigned int position = 0; position < MATRIX_SIZE; position++)
+		agreed &= crack->rankings[position].count != 0;
+
+	if (agreed)
+		hc_crack_combine(crack, &table, &ranking);
+
+	clock_gettime(CLOCK_MONOTONIC, &stopped);
+	double elapsed = (stopped.tv_sec - started.tv_sec) * 1e3 + (stopped.tv_nsec - started.tv_nsec) / 1e6;
+
+	int result = 0;
+
+	if (ranking.count == 0) {
+		printf("\nError: No key agrees with the known plaintext\n");
+		result = -10;
+	} else {
+		printf("\nSearched %u candidates for each row in %.2f ms\n", HC_CRACK_ROWS, elapsed);
+
+		// Scores are reported per n-gram, so that they read the same for any length.
+		double ngrams = crack->blocks * MATRIX_SIZE - HC_CRACK_NGRAM + 1;
+
+		for (unsigned int i = 0; i < ranking.count; i++)
+			hc_crack_report(i + 1, ranking.items[i].key, true, ranking.items[i].score / (double) NGRAM_SCALE / ngrams, cipher);
+
+		printf("\n");
+	}
+
+	ranking_free(&ranking);
+
+	for (unsigned int position = 0; position < MATRIX_SIZE; position++)
+		ranking_free(&crack->rankings[position]);
+
+	for (unsigned int k = 0; k < MATRIX_SIZE; k++)
+		free(crack->columns[k]);
+
+	free(crack);
+	free(known);
+
+	ngram_free(&table);
+	ngram_free(&letters);
+
+	return result;
+}
@@ -0,0 +1,423 @@
+// Implementation of the usage history. A run is appended to the records, and an entry for
+// it to the index of every run and to the index of each cipher it used - all under an
+// exclusive lock on the records, so that runs logging at the same time never interleave.
+//
+// The indexes are mapped into memory when queried - the first entry of the range asked for
+// is found by halving, and the records are read straight from their offsets. A query only
+// touches the pages of the index on its way down, and the records it prints - regardless
+// of how many runs have been logged.
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "history.h"
+
+#define true 1
+#define false 0
+
+// Longest path of a file of the history.
+#define HISTORY_PATH_MAX 64
+
+/**
+ * Internal method to find the path of an index.
+ *
+ * @param path: Buffer of `HISTORY_PATH_MAX` characters in which the path is to be written.
+ * @param cipher: The cipher of the index - `UNDEFINED` for the index of every run.
+ */
+void _history_index_path(string path, enum crypt cipher) {
+	if (cipher == UNDEFINED)
+		snprintf(path, HISTORY_PATH_MAX, "%s/index", HISTORY_DIR);
+	else
+		snprintf(path, HISTORY_PATH_MAX, "%s/index.%s", HISTORY_DIR, cipher_name(cipher));
+}
+
+/**
+ * Internal method to write the whole of a buffer at a position in a file.
+ *
+ * @return
+ * 		Boolean indicating if everything could be written.
+ */
+bool _history_write_at(int fd, const void *data, size_t size, off_t offset) {
+	const char *cursor = (const char *) data;
+
+	while (size > 0) {
+		ssize_t written = pwrite(fd, cursor, size, offset);
+		if (written < 0 && errno == EINTR)
+			continue;
+
+		if (written <= 0)
+			return false;
+
+		cursor += written;
+		size -= (size_t) written;
+		offset += written;
+	}
+
+	return true;
+}
+
+/**
+ * Internal method to read the whole of a buffer from a position in a file.
+ *
+ * @return
+ * 		Boolean indicating if everything could be read - false past the end of the file.
+ */
+bool _history_read_at(int fd, void *data, size_t size, off_t offset) {
+	char *cursor = (char *) data;
+
+	while (size > 0) {
+		ssize_t count = pread(fd, cursor, size, offset);
+		if (count < 0 && errno == EINTR)
+			continue;
+
+		if (count <= 0)
+			return false;
+
+		cursor += count;
+		size -= (size_t) count;
+		offset += count;
+	}
+
+	return true;
+}
+
+/**
+ * Internal method to append an entry to an index.
+ *
+ * @remarks
+ * 		An entry left half-written (by a run that was stopped while logging) is written
+ * 		over. The entry is filed under the time of the last one if the clock went back -
+ * 		the index stays sorted.
+ *
+ * @note
+ * 		Should only be called while holding the lock on the records.
+ *
+ * @return
+ * 		Boolean indicating if the entry could be written.
+ */
+bool _history_index_append(enum crypt cipher, struct history_entry entry) {
+	char path[HISTORY_PATH_MAX];
+	_history_index_path(path, cipher);
+
+	int fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+		return false;
+
+	off_t size = lseek(fd, 0, SEEK_END);
+	size -= size % (off_t) sizeof(struct history_entry);
+
+	struct history_entry last;
+	if (size > 0 && _history_read_at(fd, &last, sizeof(last), size - (off_t) sizeof(last)) && last.time > entry.time)
+		entry.time = last.time;
+
+	bool written = _history_write_at(fd, &entry, sizeof(entry), size);
+	close(fd);
+
+	return written;
+}
+
+/**
+ * Appends a run to the usage history.
+ *
+ * @param chain: Array containing the ciphers the message was run through.
+ * @param stages: Unsigned integer containing the number of ciphers - up to `CHAIN_MAX`.
+ * @param encrypt: Boolean indicating if the message was encrypted (or decrypted).
+ * @param message: Span containing the message, as entered by the user.
+ * @param result: Span containing the result.
+ *
+ * @return
+ * 		Boolean indicating if the run could be logged.
+ */
+bool history_append(const enum crypt *chain, unsigned int stages, bool encrypt, struct span message, struct span result) {
+	if (mkdir(HISTORY_DIR, 0755) != 0 && errno != EEXIST)
+		return false;
+
+	char path[HISTORY_PATH_MAX];
+	snprintf(path, HISTORY_PATH_MAX, "%s/records", HISTORY_DIR);
+
+	int fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+		return false;
+
+	if (flock(fd, LOCK_EX) != 0) {
+		close(fd);
+		return false;
+	}
+
+	struct history_record record;
+	memset(&record, 0, sizeof(record));
+	record.magic = HISTORY_MAGIC;
+	record.message_length = message.length;
+	record.result_length = result.length;
+	record.encrypt = encrypt ? 1 : 0;
+	record.stages = (uint8_t) stages;
+	record.time = (int64_t) time(NULL);
+
+	for (unsigned int i = 0; i < stages && i < CHAIN_MAX; i++)
+		record.chain[i] = (uint8_t) chain[i];
+
+	off_t offset = lseek(fd, 0, SEEK_END);
+
+	bool logged = _history_write_at(fd, &record, sizeof(record), offset) &&
+		_history_write_at(fd, message.data, message.length, offset + (off_t) sizeof(record)) &&
+		_history_write_at(fd, result.data, result.length, offset + (off_t) sizeof(record) + message.length);
+
+	// A record that was not written in full is never pointed to by an entry - the next run
+	// simply writes its own after it.
+	if (logged) {
+		struct history_entry entry = {record.time, (uint64_t) offset};
+		logged = _history_index_append(UNDEFINED, entry);
+
+		// Once under each cipher of a chain - even if it is used more than once.
+		for (unsigned int i = 0; i < stages && logged; i++) {
+			bool repeated = false;
+			for (unsigned int j = 0; j < i; j++)
+				repeated = repeated || chain[j] == chain[i];
+
+			if (!repeated)
+				logged = _history_index_append(chain[i], entry);
+		}
+	}
+
+	flock(fd, LOCK_UN);
+	close(fd);
+
+	return logged;
+}
+
+/**
+ * Internal method to find the start of a day, in local time.
+ *
+ * @param text: Span containing the day - `YYYY-MM-DD`.
+ * @param result: Pointer to the time the day starts at, in seconds since the epoch.
+ *
+ * @return
+ * 		Boolean indicating if the day exists.
+ */
+bool _history_parse_day(struct span text, int64_t *result) {
+	char buffer[16];
+	if (text.length != 10)
+		return false;
+
+	memcpy(buffer, text.data, text.length);
+	buffer[text.length] = '\0';
+
+	int year, month, day;
+	if (sscanf(buffer, "%4d-%2d-%2d", &year, &month, &day) != 3)
+		return false;
+
+	struct tm moment;
+	memset(&moment, 0, sizeof(moment));
+	moment.tm_year = year - 1900;
+	moment.tm_mon = month - 1;
+	moment.tm_mday = day;
+	moment.tm_isdst = -1;
+
+	time_t start = mktime(&moment);
+
+	// A day past the end of its month is moved over to the next one - and rejected.
+	if (start == (time_t) -1 || moment.tm_mday != day || moment.tm_mon != month - 1)
+		return false;
+
+	*result = (int64_t) start;
+	return true;
+}
+
+/**
+ * Parses the days a query covers - a single day (`YYYY-MM-DD`), or the first and the last
+ * day of a range (`YYYY-MM-DD..YYYY-MM-DD`).
+ *
+ * @param days: Span containing the days - empty to cover every run.
+ * @param from: Pointer to the time the first day starts at.
+ * @param to: Pointer to the time the last day ends at.
+ *
+ * @return
+ * 		Boolean indicating if the days exist.
+ */
+bool history_parse_days(struct span days, int64_t *from, int64_t *to) {
+	if (days.length == 0) {
+		*from = INT64_MIN;
+		*to = INT64_MAX;
+		return true;
+	}
+
+	struct span first = days, last = days;
+	for (unsigned int i = 0; i + 1 < days.length; i++) {
+		if (days.data[i] == '.' && days.data[i + 1] == '.') {
+			first = make_span(days.data, i);
+			last = make_span(days.data + i + 2, days.length - i - 2);
+			break;
+		}
+	}
+
+	if (!_history_parse_day(first, from) || !_history_parse_day(last, to))
+		return false;
+
+	// Up to the start of the day after the last one - a day is not always 24 hours long.
+	struct tm moment;
+	time_t end = (time_t) *to;
+	localtime_r(&end, &moment);
+
+	moment.tm_mday++;
+	moment.tm_hour = 0;
+	moment.tm_min = 0;
+	moment.tm_sec = 0;
+	moment.tm_isdst = -1;
+
+	*to = (int64_t) mktime(&moment);
+	return *from < *to;
+}
+
+/**
+ * Internal method to find the first entry of an index filed at (or after) a time.
+ *
+ * @param entries: The entries of the index - sorted by time.
+ * @param count: Number of entries.
+ * @param time: The time looked for.
+ *
+ * @return
+ * 		Index of the first entry filed at or after the time - `count` if there is none.
+ */
+unsigned long long _history_lower_bound(const struct history_entry *entries, unsigned long long count, int64_t time) {
+	unsigned long long low = 0, high = count;
+
+	while (low < high) {
+		unsigned long long middle = low + (high - low) / 2;
+
+		if (entries[middle].time < time)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return low;
+}
+
+/**
+ * Internal method to print a single record.
+ *
+ * @return
+ * 		Boolean indicating if the record could be read.
+ */
+bool _history_print(int fd, uint64_t offset) {
+	struct history_record record;
+	if (!_history_read_at(fd, &record, sizeof(record), (off_t) offset) || record.magic != HISTORY_MAGIC)
+		return false;
+
+	unsigned long long size = (unsigned long long) record.message_length + record.result_length;
+	string contents = (string) malloc(size + 1);
+
+	if (!_history_read_at(fd, contents, size, (off_t) (offset + sizeof(record)))) {
+		free(contents);
+		return false;
+	}
+
+	struct tm moment;
+	time_t when = (time_t) record.time;
+	localtime_r(&when, &moment);
+
+	char stamp[32];
+	strftime(stamp, sizeof(stamp), "%d/%m/%Y %H:%M:%S", &moment);
+
+	printf("%s ", stamp);
+	for (unsigned int i = 0; i < record.stages && i < CHAIN_MAX; i++)
+		printf("%s%s", (i == 0) ? "" : ",", cipher_name((enum crypt) record.chain[i]));
+
+	printf(" (%s)\nOriginal Message: ", record.encrypt ? "encrypt" : "decrypt");
+	fwrite(contents, sizeof(char), record.message_length, stdout);
+
+	printf("\nResult: ");
+	fwrite(contents + record.message_length, sizeof(char), record.result_length, stdout);
+	printf("\n\n");
+
+	free(contents);
+	return true;
+}
+
+/**
+ * Runs a query over the usage history (`--history`) - prints every run on the days asked
+ * for, in the order they were logged.
+ *
+ * @param days: Span containing the days (see `history_parse_days`) - empty for every run.
+ * @param cipher: The cipher the runs should have used - `UNDEFINED` for any cipher.
+ *
+ * @return
+ * 		Integer containing the exit code for the program.
+ */
+int history_query(struct span days, enum crypt cipher) {
+	int64_t from, to;
+	if (!history_parse_days(days, &from, &to)) {
+		printf("\nError: Invalid days `%.*s` - expected `YYYY-MM-DD` or `YYYY-MM-DD..YYYY-MM-DD`\n", days.length, days.data);
+		return -10;
+	}
+
+	char path[HISTORY_PATH_MAX];
+	_history_index_path(path, cipher);
+
+	int index_fd = open(path, O_RDONLY);
+	snprintf(path, HISTORY_PATH_MAX, "%s/records", HISTORY_DIR);
+	int records_fd = open(path, O_RDONLY);
+
+	struct stat status;
+	unsigned long long count = 0;
+
+	if (index_fd >= 0 && records_fd >= 0 && fstat(index_fd, &status) == 0)
+		count = (unsigned long long) status.st_size / sizeof(struct history_entry);
+
+	const struct history_entry *entries = NULL;
+	if (count != 0) {
+		entries = (const struct history_entry *) mmap(
+			NULL, count * sizeof(struct history_entry), PROT_READ, MAP_SHARED, index_fd, 0
+		);
+
+		if (entries == MAP_FAILED) {
+			printf("\nError: Could not read the usage history\n");
+			close(index_fd);
+			close(records_fd);
+			return -10;
+		}
+	}
+
+	unsigned long long first = (count != 0) ? _history_lower_bound(entries, count, from) : 0;
+	unsigned long long last = (count != 0) ? _history_lower_bound(entries, count, to) : 0;
+	unsigned long long printed = 0, damaged = 0;
+
+	// The records lie in the same order as the entries - letting the kernel read ahead.
+	if (first < last)
+		posix_fadvise(records_fd, (off_t) entries[first].offset, 0, POSIX_FADV_SEQUENTIAL);
+
+	printf("\n");
+	for (unsigned long long i = first; i < last; i++) {
+		if (_history_print(records_fd, entries[i].offset))
+			printed++;
+		else
+			damaged++;
+	}
+
+	printf("%llu run(s) found", printed);
+	if (damaged != 0)
+		printf(" - %llu could not be read", damaged);
+
+	printf("\n\n");
+
+	if (entries != NULL)
+		munmap((void *) entries, count * sizeof(struct history_entry));
+
+	if (index_fd >= 0)
+		close(index_fd);
+
+	if (records_fd >= 0)
+		close(records_fd);
+
+	return (damaged == 0) ? 0 : -10;
+}
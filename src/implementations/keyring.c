@@ -0,0 +1,124 @@
+// Implementation of the keyring. A single keyring is loaded for the whole program - mapped
+// read-only, as such shared by every process using the same file, and looked up by
+// position without anything being parsed.
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "keyring.h"
+
+#define true 1
+#define false 0
+
+// The keys of the keyring loaded, and their number - null until one is loaded.
+const struct cipher_key *keyring_keys = NULL;
+unsigned int keyring_size = 0;
+
+/**
+ * Loads a keyring written by `keyring_save` - used by `keyring_find` from then on.
+ *
+ * @note
+ * 		Not thread-safe - meant to be called at startup.
+ *
+ * @param path: String containing the path of the file.
+ *
+ * @return
+ * 		Boolean indicating if the keyring could be loaded - false if the file cannot be read,
+ * 		is not a keyring, or was written by a build laying out the keys differently.
+ */
+bool keyring_load(const_str path) {
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	struct stat details;
+	if (fstat(fd, &details) < 0 || (size_t) details.st_size < sizeof(struct keyring_file)) {
+		close(fd);
+		return false;
+	}
+
+	size_t length = (size_t) details.st_size;
+	void *mapping = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (mapping == MAP_FAILED)
+		return false;
+
+	const struct keyring_file *header = (const struct keyring_file *) mapping;
+
+	if (
+		memcmp(header->magic, KEYRING_MAGIC, sizeof(header->magic)) != 0 ||
+		header->key_size != sizeof(struct cipher_key) ||
+		length != sizeof(struct keyring_file) + (size_t) header->count * sizeof(struct cipher_key)
+	) {
+		munmap(mapping, length);
+		return false;
+	}
+
+	keyring_keys = (const struct cipher_key *) ((const char *) mapping + sizeof(struct keyring_file));
+	keyring_size = header->count;
+
+	return true;
+}
+
+/**
+ * Saves prepared keys to a keyring, to be loaded using `keyring_load`.
+ *
+ * @param keys: Array of keys prepared using `engine_prepare` - their ids are their positions.
+ * @param count: Unsigned integer containing the number of keys.
+ * @param path: String containing the path of the file - replaced if it exists.
+ *
+ * @return
+ * 		Boolean indicating if the file could be written.
+ */
+bool keyring_save(const struct cipher_key *keys, unsigned int count, const_str path) {
+	struct keyring_file header;
+	memset(&header, 0, sizeof(header));
+
+	memcpy(header.magic, KEYRING_MAGIC, sizeof(header.magic));
+	header.key_size = sizeof(struct cipher_key);
+	header.count = count;
+
+	FILE *file = fopen(path, "wb");
+	if (file == NULL)
+		return false;
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(keys, sizeof(struct cipher_key), count, file) == count;
+
+	return (fclose(file) == 0) && written;
+}
+
+/**
+ * Finds a key of the keyring loaded.
+ *
+ * @remarks
+ * 		The key is used straight from the file - safe to use from any number of threads.
+ *
+ * @param id: Unsigned integer containing the id of the key.
+ *
+ * @return
+ * 		Pointer to the key - null if there is no key with that id, or no keyring was loaded.
+ */
+const struct cipher_key *keyring_find(unsigned int id) {
+	if (id >= keyring_size || (unsigned int) keyring_keys[id].cipher >= UNDEFINED)
+		return NULL;
+
+	return &keyring_keys[id];
+}
+
+/**
+ * Returns the number of keys in the keyring loaded.
+ *
+ * @return
+ * 		Unsigned integer containing the number of keys - zero if no keyring was loaded.
+ */
+unsigned int keyring_count() {
+	return keyring_size;
+}
@@ -1,6 +1,7 @@
 // Source file defining the Play Fair Cipher strategy. This cipher supports
-// lowercase alphabets only. Spaces and/or anything else needs to be stripped
-// from the source string before being passed on to this algorithm.
+// lowercase alphabets only (and digits, with the 6x6 matrix). Spaces and/or
+// anything else needs to be stripped from the source string before being
+// passed on to this algorithm.
 
 
 #include "ciphers.h"
@@ -8,9 +9,10 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 // Additional character used to pad a string if the message has odd character count.
-#define PAD_CHAR "z"
+#define PAD_CHAR 'z'
 
 // The character that is to be ignored from the key matrix being formed.
 #define IGNORE_CHAR 'j'
@@ -18,91 +20,139 @@
 // If `IGNORE_CHAR` is present in the key, should be replaced by this character.
 #define REPLACE_CHAR 'i'
 
-// Length of edge of a single side in the key matrix.
-#define MATRIX_EDGE 5
+// Characters filling the 5x5 matrix after the key, in order - every alphabet except
+// `IGNORE_CHAR`.
+#define PF_ALPHABET "abcdefghiklmnopqrstuvwxyz"
+
+// Characters filling the 6x6 matrix after the key, in order.
+#define PF6_ALPHABET "abcdefghijklmnopqrstuvwxyz0123456789"
 
 // Placeholder string used to define the values being replaced at each iteration
 // over the matrix - will be used only in the verbose mode of the script.
 # define RULE_MESSAGE "  Replacement String:- \"%c%c\" %s\n"
 
-// The key matrix that shall be used to perform all the calculations. Keeping this
-// global since only one cipher can be performed by the program at a time anyways.
-char pf_key_matrix[MATRIX_EDGE][MATRIX_EDGE];
+// The key schedule used by the string-key methods (`crypt_play_fair` and friends). Keeping
+// this global since only one cipher can be performed by them at a time anyways - prepared
+// schedules should be used wherever more than one key is in flight.
+struct pf_schedule pf_key_schedule;
 
 /**
  * Returns the location of the character in the matrix.
  *
  * @remarks
  * 		The location returned by this method will be as a single integer that
- * 		can be mapped to a 2d matrix of edge `MATRIX_EDGE`.
+ * 		can be mapped to a 2d matrix of the edge of the schedule.
  *
+ * @param schedule: Pointer to the prepared key in which the character is to be found.
  * @param c: The character that is to be found in the matrix. Guaranteed to be unique.
  *
  * @return
- * 		An integer that can be mapped mapped to a 2d matrix.
+ * 		An integer that can be mapped mapped to a 2d matrix - negative if the character
+ * 		is not present in the matrix.
  */
-int pf_find_position(char c) {
-	if (c == IGNORE_CHAR)
-		// If the ignorable character is being searched for, replacing it.
-		c = REPLACE_CHAR;
-
-	for (int i = 0; i < MATRIX_EDGE * MATRIX_EDGE; i++)
-		if (pf_key_matrix[i / MATRIX_EDGE][i % MATRIX_EDGE] == c)
-			return i;
-
-
-	// Returning negative index to indicate not found.
-	return -1;
+extern inline int pf_find_position(const struct pf_schedule *schedule, char c) {
+	// The positions are recorded for every character while the matrix is populated - a
+	// lookup is enough (`IGNORE_CHAR` is recorded at the position of `REPLACE_CHAR`).
+	return schedule->position[(unsigned char) c];
 }
 
 /**
- * Convenience method to populate the key matrix using a given key.
+ * Internal method to populate a key schedule - the key matrix of the given edge, and the
+ * position of every character in it.
  *
  * @remarks
- * 		Note: This method will populate data inside the global matrix, which is why
- * 		it does not need to return anything by itself.
+ * 		Characters in the key that cannot be placed in the matrix are skipped - anything
+ * 		other than lower-case alphabets (and digits, for the 6x6 matrix).
  *
- * @param key: The key used to populate the key matrix.
+ * @param schedule: Pointer to the schedule that is to be populated.
+ * @param key: Span containing the key used to populate the key matrix.
+ * @param edge: Unsigned integer containing the edge of the matrix - `PF_MATRIX_EDGE`
+ * 		or `PF6_MATRIX_EDGE`.
  */
-void pf_populate_key(string key) {
-	// Boolean array - each value represents the alphabet at that index. Used to keep a track
-	// of alphabets included in the matrix - ensures no repetitions. Initializing all values as false.
-	bool chars[26] = {false};
+void _pf_fill(struct pf_schedule *schedule, struct span key, unsigned int edge) {
+	// The characters filling the matrix once the key has been placed.
+	const_str remaining = (edge == PF_MATRIX_EDGE) ? PF_ALPHABET : PF6_ALPHABET;
+	unsigned int total = key.length + (unsigned int) strlen(remaining);
 
 	// Using this variable to keep a track of the last cell filled in the matrix - will be used to
 	// determine the next cell that is to be filled as needed.
 	unsigned int matrix_counter = 0;
 
-	// Populating the matrix with the unique elements from the key.
-	for (unsigned int i = 0; key[i] != '\0'; i++) {
-		if (chars[key[i] - 97])
+	// Marking every character as missing to begin with - the positions double as the record
+	// of characters included in the matrix, ensuring no repetitions.
+	memset(schedule->position, -1, sizeof(schedule->position));
+	schedule->edge = edge;
+
+	// Populating the matrix with the unique elements from the key, followed by the remaining
+	// characters.
+	for (unsigned int i = 0; i < total; i++) {
+		unsigned char c = (unsigned char) ((i < key.length) ? key.data[i] : remaining[i - key.length]);
+
+		if (edge == PF_MATRIX_EDGE && c == IGNORE_CHAR)
+			// If the key contains the ignorable character, replacing.
+			c = REPLACE_CHAR;
+
+		if (!(c >= 'a' && c <= 'z') && !(edge == PF6_MATRIX_EDGE && c >= '0' && c <= '9'))
+			// Anything else cannot be placed in the matrix.
+			continue;
+
+		if (schedule->position[c] >= 0)
 			// Skip repetitions in the matrix if this character is already in it.
 			continue;
-		else if (key[i] == IGNORE_CHAR)
-			// If the key contains the ignorable character, replacing.
-			key[i] = REPLACE_CHAR;
 
-		// Add this key to the appropriate position in the matrix. Mark the character as
-		// taken.
-		pf_key_matrix[matrix_counter / MATRIX_EDGE][matrix_counter % MATRIX_EDGE] = key[i];
-		chars[key[i] - 97] = true;
+		// Add this key to the appropriate position in the matrix, and record its position.
+		schedule->matrix[matrix_counter / edge][matrix_counter % edge] = (char) c;
+		schedule->position[c] = (signed char) matrix_counter;
 
 		// Finally incrementing the counter to directly fill the next cell regardless of
 		// how many duplicates occur in the key.
 		matrix_counter++;
 	}
 
-	// Iterating over all remaining characters, and adding the unique ones to the matrix.
-	for (char c = 'a'; c <= (char) 'z'; c++) {
-		if (chars[c - 97] || c == IGNORE_CHAR)
-			// Skip iteration if the element already exists - or is a `j`.
-			continue;
+	if (edge == PF_MATRIX_EDGE)
+		// The ignorable character is ciphered as its replacement.
+		schedule->position[IGNORE_CHAR] = schedule->position[REPLACE_CHAR];
+}
 
-		// If the element doesn't exist, adding it to the matrix and marking this addition.
-		pf_key_matrix[matrix_counter / MATRIX_EDGE][matrix_counter % MATRIX_EDGE] = c;
-		chars[c - 97] = true;
-		matrix_counter++;
-	}
+/**
+ * Populates a key schedule using a given key - the 5x5 key matrix, and the position of
+ * every alphabet in it.
+ *
+ * @remarks
+ * 		Characters in the key that are not lower-case alphabets are skipped.
+ *
+ * @param schedule: Pointer to the schedule that is to be populated.
+ * @param key: Span containing the key used to populate the key matrix.
+ */
+void pf_prepare(struct pf_schedule *schedule, struct span key) {
+	_pf_fill(schedule, key, PF_MATRIX_EDGE);
+}
+
+/**
+ * Populates a key schedule for the alphanumeric play-fair (`playfair6`) - the 6x6 key
+ * matrix holds every alphabet and digit, as such nothing is replaced.
+ *
+ * @remarks
+ * 		Characters in the key that are not lower-case alphabets or digits are skipped.
+ *
+ * @param schedule: Pointer to the schedule that is to be populated.
+ * @param key: Span containing the key used to populate the key matrix.
+ */
+void pf6_prepare(struct pf_schedule *schedule, struct span key) {
+	_pf_fill(schedule, key, PF6_MATRIX_EDGE);
+}
+
+/**
+ * Convenience method to populate the key matrix using a given key.
+ *
+ * @remarks
+ * 		Note: This method will populate data inside the global schedule, which is why
+ * 		it does not need to return anything by itself.
+ *
+ * @param key: Span containing the key used to populate the key matrix.
+ */
+void pf_populate_key(struct span key) {
+	pf_prepare(&pf_key_schedule, key);
 }
 
 
@@ -115,12 +165,12 @@ void pf_populate_key(string key) {
  * 		Ideally, will be one or more new-line characters.
  */
 void _pf_print_key(string pad_char, string end_line) {
-	for (unsigned int i = 0; i < MATRIX_EDGE; i++) {
+	for (unsigned int i = 0; i < pf_key_schedule.edge; i++) {
 		// Avoiding printing a new line before the start of the matrix. While
 		// ensuring that the first line is actually padded with the character.
 		printf("%c%s", (i != 0) ? '\n' : '\0', pad_char);
-		for (unsigned int j = 0; j < MATRIX_EDGE; j++)
-			printf("%c  ", pf_key_matrix[i][j]);
+		for (unsigned int j = 0; j < pf_key_schedule.edge; j++)
+			printf("%c  ", pf_key_schedule.matrix[i][j]);
 	}
 
 	// Printing the end-line character.
@@ -144,37 +194,106 @@ extern inline void pf_print_key() {
 
 
 /**
- * Public method to implement the play-fair cipher algorithm.
+ * Internal method holding the play-fair rules for a matrix of a fixed edge - the same
+ * rules as `_pf_transform`, without the verbose output.
  *
- * @param message: String containing the original message that is to be ciphered.
- * 		Should contain only lower-cased alphabets - no other characters.
- * @param key: String containing the key that is to be ciphered.
- * @param is_noob: Boolean indicating if verbose output is needed.
+ * @remarks
+ * 		Always inlined into a wrapper passing the edge as a constant (`_pf_kernel_5` and
+ * 		`_pf_kernel_6`) - the compiler then turns the divisions by the edge into
+ * 		multiplications and unrolls the table of wrapped rows/columns. Characters are
+ * 		found with a single lookup into the table of positions.
  *
- * @return
- * 		String containing a cipher of the original text message.
+ * @param schedule: Pointer to the prepared key - with a matrix of the given edge.
+ * @param message: String containing the (padded) message, will be overwritten with the result.
+ * @param length: Unsigned integer containing the length of the message - should be even.
+ * @param shift: Offset to move along a row/column; `1` to encrypt, `edge - 1` to decrypt.
+ * @param edge: Unsigned integer containing the edge of the matrix - a constant.
  */
-string crypt_play_fair(string original_message, string key, bool is_noob) {
-	// Creating a copy of the original string with extra space to pad if needed.
-	string message = gen_str_pad(original_message, 1);
+static inline __attribute__((always_inline)) void _pf_kernel(
+	const struct pf_schedule *schedule, string message, unsigned int length, unsigned int shift,
+	const unsigned int edge
+) {
+	// The row/column reached from each row/column by moving along - wrapping around.
+	unsigned char next[PF6_MATRIX_EDGE];
+	for (unsigned int i = 0; i < edge; i++)
+		next[i] = (unsigned char) ((i + shift) % edge);
+
+	for (unsigned int i = 1; i < length; i += 2) {
+		int found_first = schedule->position[(unsigned char) message[i - 1]];
+		int found_second = schedule->position[(unsigned char) message[i]];
+
+		if (found_first < 0 || found_second < 0)
+			// Characters missing from the matrix cannot be ciphered - leaving the pair as-is.
+			continue;
 
-	// Pad message with an additional character - the result should have an even length.
-	message = (strlen(message) % 2 == 0) ? message : strcat(message, PAD_CHAR);
+		unsigned int row_first = (unsigned int) found_first / edge;
+		unsigned int row_second = (unsigned int) found_second / edge;
+		unsigned int col_first = (unsigned int) found_first % edge;
+		unsigned int col_second = (unsigned int) found_second % edge;
+
+		if (col_first == col_second) {
+			// Rule-01: same column, taking the characters from the adjacent row.
+			message[i - 1] = schedule->matrix[next[row_first]][col_first];
+			message[i] = schedule->matrix[next[row_second]][col_second];
+		} else if (row_first == row_second) {
+			// Rule-02: same row, taking the characters from the adjacent column.
+			message[i - 1] = schedule->matrix[row_first][next[col_first]];
+			message[i] = schedule->matrix[row_second][next[col_second]];
+		} else {
+			// Rule-03: the diagonally-opposite corners of the rectangle.
+			message[i - 1] = schedule->matrix[row_first][col_second];
+			message[i] = schedule->matrix[row_second][col_first];
+		}
+	}
+}
 
-	// Declaring a 2d char array to contain the key matrix, populating it with the key and
-	// remaining characters (except `IGNORE_CHAR`).
-	pf_populate_key(key);        // Will internally populate `pf_key_matrix`.
+/**
+ * Internal method running the play-fair rules over a 5x5 matrix - see `_pf_kernel`.
+ */
+void _pf_kernel_5(const struct pf_schedule *schedule, string message, unsigned int length, unsigned int shift) {
+	_pf_kernel(schedule, message, length, shift, PF_MATRIX_EDGE);
+}
 
-	if (is_noob) {
-		printf("Key Matrix: \n");
-		_pf_print_key("\t", "\n\n"); // Padding the matrix with space.
+/**
+ * Internal method running the play-fair rules over a 6x6 matrix - see `_pf_kernel`.
+ */
+void _pf_kernel_6(const struct pf_schedule *schedule, string message, unsigned int length, unsigned int shift) {
+	_pf_kernel(schedule, message, length, shift, PF6_MATRIX_EDGE);
+}
 
-		printf("Original Message: \n\t`%s`\n\n\n", message);
+/**
+ * Internal method to run the play-fair rules over a message that has already been
+ * padded to an even length. The message is modified in-place, two characters at a
+ * time.
+ *
+ * @remarks
+ * 		Encryption and decryption only differ in the direction in which the characters
+ * 		are shifted in rule-01 and rule-02 - the direction is passed as an offset that
+ * 		is added to the row/column of the character (modulo the edge of the matrix).
+ * 		Unless verbose output is needed, the kernel for the size of the matrix is used.
+ *
+ * @param schedule: Pointer to the prepared key.
+ * @param message: String containing the (padded) message, will be overwritten with the result.
+ * @param length: Unsigned integer containing the length of the message - should be even.
+ * @param shift: Offset to move along a row/column; `1` to encrypt, `edge - 1` to decrypt.
+ * @param is_noob: Boolean indicating if verbose output is needed.
+ */
+void _pf_transform(
+	const struct pf_schedule *schedule, string message, unsigned int length, unsigned int shift, bool is_noob
+) {
+	if (!is_noob) {
+		if (schedule->edge == PF6_MATRIX_EDGE)
+			_pf_kernel_6(schedule, message, length, shift);
+		else
+			_pf_kernel_5(schedule, message, length, shift);
+
+		return;
 	}
 
-	// Performing the actual cipher.
+	unsigned int edge = schedule->edge;
+
 	// Taking alphabets from the message, two characters at a time.
-	for (unsigned int i = 1; message[i] != '\0'; i += 2) {
+	for (unsigned int i = 1; i < length; i += 2) {
 		char first = message[i - 1];
 		char second = message[i];
 
@@ -184,52 +303,42 @@ string crypt_play_fair(string original_message, string key, bool is_noob) {
 		}
 
 		//Finding the location of the two characters in the matrix.
-		unsigned int pos_first = pf_find_position(first);
-		unsigned int pos_second = pf_find_position(second);
+		int found_first = pf_find_position(schedule, first);
+		int found_second = pf_find_position(schedule, second);
 
-		if ((pos_first % MATRIX_EDGE) == (pos_second % MATRIX_EDGE)) {
-			// If both letters are from the same column, taking the character from one row below them.
+		if (found_first < 0 || found_second < 0)
+			// Characters missing from the matrix cannot be ciphered - leaving the pair as-is.
+			continue;
+
+		unsigned int pos_first = found_first;
+		unsigned int pos_second = found_second;
 
-			if ((pos_first / MATRIX_EDGE) == MATRIX_EDGE - 1)
-				// If the element is present in the last row, using the element from the first one,
-				// otherwise taking the character from the next row.
-				first = pf_key_matrix[0][pos_first % MATRIX_EDGE];
-			else
-				first = pf_key_matrix[(pos_first / MATRIX_EDGE) + 1][pos_first % MATRIX_EDGE];
+		unsigned int row_first = pos_first / edge;
+		unsigned int row_second = pos_second / edge;
+		unsigned int col_first = pos_first % edge;
+		unsigned int col_second = pos_second % edge;
 
-			// Doing the same for the second character.
-			if ((pos_second / MATRIX_EDGE) == MATRIX_EDGE - 1)
-				second = pf_key_matrix[0][pos_second % MATRIX_EDGE];
-			else
-				second = pf_key_matrix[(pos_second / MATRIX_EDGE) + 1][pos_second % MATRIX_EDGE];
+		if (col_first == col_second) {
+			// If both letters are from the same column, taking the character from the adjacent
+			// row - wrapping around to the other end of the matrix if needed.
+			first = schedule->matrix[(row_first + shift) % edge][col_first];
+			second = schedule->matrix[(row_second + shift) % edge][col_second];
 
 			if (is_noob)
 				printf(RULE_MESSAGE, first, second, "(Rule-01)");
-
-		} else if ((pos_first / MATRIX_EDGE) == (pos_second / MATRIX_EDGE)) {
+		} else if (row_first == row_second) {
 			// If both the characters are in the same row, taking the character from the adjacent column.
-
-			if ((pos_first % MATRIX_EDGE) == MATRIX_EDGE - 1)
-				// If the element is at the last column, picking the element from the first column.
-				first = pf_key_matrix[pos_first / MATRIX_EDGE][0];
-			else
-				first = pf_key_matrix[pos_first / MATRIX_EDGE][(pos_first % MATRIX_EDGE) + 1];
-
-			if ((pos_second % MATRIX_EDGE) == MATRIX_EDGE - 1)
-				second = pf_key_matrix[pos_second / MATRIX_EDGE][0];
-			else
-				second = pf_key_matrix[pos_second / MATRIX_EDGE][(pos_second % MATRIX_EDGE) + 1];
+			first = schedule->matrix[row_first][(col_first + shift) % edge];
+			second = schedule->matrix[row_second][(col_second + shift) % edge];
 
 			if (is_noob)
 				printf(RULE_MESSAGE, first, second, "(Rule-02)");
 		} else {
 			// If both the above rules fail, forming a rectangle, and replacing the characters
-			// from the diagonally-opposite corner of the matrix.
-
-			// This means that the row for both entries needs to be modified without changing
-			// the column.
-			first = pf_key_matrix[pos_first / MATRIX_EDGE][pos_second % MATRIX_EDGE];
-			second = pf_key_matrix[pos_second / MATRIX_EDGE][pos_first % MATRIX_EDGE];
+			// from the diagonally-opposite corner of the matrix - the row for both entries
+			// needs to be modified without changing the column.
+			first = schedule->matrix[row_first][col_second];
+			second = schedule->matrix[row_second][col_first];
 
 			if (is_noob)
 				printf(RULE_MESSAGE, first, second, "(Rule-03)");
@@ -240,108 +349,242 @@ string crypt_play_fair(string original_message, string key, bool is_noob) {
 		message[i] = second;
 
 		if (is_noob)
-			printf("  Resultant String; \n\t`%s`\n\n", message);
+			printf("  Resultant String; \n\t`%.*s`\n\n", length, message);
 	}
-
-	return message;
 }
 
 /**
- * Public method to implement
+ * Internal method shared by the encryption and decryption routines - copies the
+ * message into the destination buffer, pads it and runs the cipher over it.
+ *
+ * @remarks
+ * 		The destination can be the same buffer as the message - the message is
+ * 		copied over before any character is modified.
  *
- * @param original_message
- * @param key
- * @param is_noob
  * @return
+ * 		Unsigned integer containing the length of the result (excluding the string
+ * 		terminator). Nothing is written if the destination is too small.
  */
-string decrypt_play_fair(string original_message, string key, bool is_noob) {
-	// Creating a copy of the source message with extra space to pad.
-	string message = gen_str_pad(original_message, 1);
+unsigned int _pf_run_into(
+	const struct pf_schedule *schedule, string dest, unsigned int dest_cap, struct span message,
+	unsigned int shift, bool is_noob
+) {
+	unsigned int length = message.length;
+
+	// Pad message with an additional character - the result should have an even length.
+	unsigned int result_length = length + (length % 2);
 
-	// Padding the message with extra character if needed.
-	message = (strlen(message) % 2 == 0) ? message : strcat(message, PAD_CHAR);
+	if (dest == NULL || dest_cap <= result_length)
+		// Not enough space for the result and its terminator, report the size needed.
+		return result_length;
 
-	// Populating the key matrix.
-	pf_populate_key(key);
+	memmove(dest, message.data, length);
+	if (result_length != length)
+		dest[length] = PAD_CHAR;
+
+	dest[result_length] = '\0';
 
 	if (is_noob) {
-		// Printing some additional info if the user needs verbose mode.
 		printf("Key Matrix: \n");
 		_pf_print_key("\t", "\n\n"); // Padding the matrix with space.
 
-		printf("Original Message: \n\t`%s`\n\n\n", message);
+		printf("Original Message: \n\t`%.*s`\n\n\n", result_length, dest);
 	}
 
-	// Deciphering the cipher text. Taking two characters at a time - having them
-	// undergo a process opposite to the process of ciphering the text.
-	for (unsigned int i = 1; message[i] != '\0'; i += 2) {
-		// Getting a pair of characters for this iteration
-		char first = message[i - 1];
-		char second = message[i];
+	_pf_transform(schedule, dest, result_length, shift, is_noob);
+	return result_length;
+}
 
-		// Finding the position of these characters within the matrix.
-		unsigned int pos_first = pf_find_position(first);
-		unsigned int pos_second = pf_find_position(second);
+/**
+ * Runs the play-fair cipher with a prepared key, writing the result into a buffer owned
+ * by the caller.
+ *
+ * @remarks
+ * 		Does not touch any global state - safe to call from multiple threads sharing the
+ * 		same schedule.
+ *
+ * @param schedule: Pointer to the key prepared using `pf_prepare`.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer in which the result is to be written. Can be the same as the message.
+ * @param dest_cap: Unsigned integer containing the capacity of the buffer, in characters.
+ * @param message: Span containing the message.
+ *
+ * @return
+ * 		Unsigned integer containing the length of the result.
+ */
+unsigned int pf_run_into(
+	const struct pf_schedule *schedule, bool encrypt, string dest, unsigned int dest_cap, struct span message
+) {
+	// Moving one step "back" along a row/column is the same as moving `edge - 1` steps forward.
+	return _pf_run_into(schedule, dest, dest_cap, message, encrypt ? 1 : schedule->edge - 1, false);
+}
 
-		if (is_noob) {
-			printf("\nPASS %d:\n", (i / 2) + 1);
-			printf("  Original Sub-string: \"%c%c\"\n", first, second);
-		}
+/**
+ * Runs play-fair over a part of a message using a prepared key - writes the characters at
+ * positions `[begin, end)` of the result that `pf_run_into` would produce.
+ *
+ * @remarks
+ * 		Used to split a large message across threads - calls over disjoint ranges write to
+ * 		disjoint parts of the destination. Nothing is written outside of the range, not even
+ * 		a string terminator.
+ *
+ * @note
+ * 		The range should start on a pair (an even position). The size of the result should
+ * 		have been checked using `pf_run_into` beforehand.
+ *
+ * @param schedule: Pointer to the key prepared using `pf_prepare`.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer for the complete result - the range is written at its own offsets.
+ * @param message: Span containing the complete message.
+ * @param begin: Unsigned integer containing the first position of the result to be written.
+ * @param end: Unsigned integer containing the position of the result to stop at.
+ */
+void pf_run_slice(
+	const struct pf_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+) {
+	unsigned int available = (end < message.length) ? end : message.length;
+
+	memmove(dest + begin, message.data + begin, available - begin);
+	if (available < end)
+		// Only the last range can run past the message - by the padding character.
+		dest[available] = PAD_CHAR;
+
+	_pf_transform(schedule, dest + begin, end - begin, encrypt ? 1 : schedule->edge - 1, false);
+}
 
-		// Depending on the rules in this cipher, altering the ciphered text to get back
-		// the original message.
-		if ((pos_first % MATRIX_EDGE) == (pos_second % MATRIX_EDGE)) {
-			// If both characters are from the same column, selecting the character from
-			// one column above them.
-
-			if (pos_first / MATRIX_EDGE == 0)
-				// If the element is in the top-most row, picking up an element from
-				// the bottom row.
-				first = pf_key_matrix[MATRIX_EDGE - 1][pos_first % MATRIX_EDGE];
-			else
-				first = pf_key_matrix[(pos_first / MATRIX_EDGE) - 1][pos_first % MATRIX_EDGE];
-
-			// Repeating the same for the second element.
-			if (pos_second / MATRIX_EDGE == 0)
-				second = pf_key_matrix[MATRIX_EDGE - 1][pos_second % MATRIX_EDGE];
-			else
-				second = pf_key_matrix[(pos_second / MATRIX_EDGE) - 1][pos_second % MATRIX_EDGE];
+/**
+ * Runs play-fair over a number of independent messages at once, each with its own prepared
+ * key - the messages are run one after the other, straight through the kernel for the size
+ * of their matrix.
+ *
+ * @remarks
+ * 		Unlike hill, the rules are table lookups that do not map onto vectors - interleaving
+ * 		messages brings nothing the processor does not already overlap between the (independent)
+ * 		pairs of a single message. What is saved is the sizing and dispatch of each message.
+ *
+ * @note
+ * 		Lanes can mix the 5x5 and 6x6 matrices. The results are the same as those of
+ * 		`pf_run_into`.
+ *
+ * @param lanes: Array containing the messages - their results are written into the lanes.
+ * @param count: Unsigned integer containing the number of messages.
+ */
+void pf_run_many(struct cipher_lane *lanes, unsigned int count) {
+	for (unsigned int i = 0; i < count; i++) {
+		struct cipher_lane *lane = &lanes[i];
+		const struct pf_schedule *schedule = (const struct pf_schedule *) lane->schedule;
 
-			if (is_noob)
-				printf(RULE_MESSAGE, first, second, "(Rule-01)");
-		} else if ((pos_first / MATRIX_EDGE) == (pos_second / MATRIX_EDGE)) {
-			// If both characters are from the same row, taking a character from adjacent column.
+		lane->length = lane->message.length + (lane->message.length % 2);
 
-			if ((pos_first % MATRIX_EDGE) == 0)
-				// If this is the first column, picking an element from the last column.
-				first = pf_key_matrix[pos_first / MATRIX_EDGE][MATRIX_EDGE - 1];
-			else
-				first = pf_key_matrix[pos_first / MATRIX_EDGE][(pos_first % MATRIX_EDGE) - 1];
+		memmove(lane->dest, lane->message.data, lane->message.length);
+		if (lane->length != lane->message.length)
+			lane->dest[lane->message.length] = PAD_CHAR;
 
-			if ((pos_second % MATRIX_EDGE) == 0)
-				second = pf_key_matrix[pos_second / MATRIX_EDGE][MATRIX_EDGE - 1];
-			else
-				second = pf_key_matrix[pos_second / MATRIX_EDGE][(pos_second / MATRIX_EDGE) - 1];
+		unsigned int shift = lane->encrypt ? 1 : schedule->edge - 1;
+		if (schedule->edge == PF6_MATRIX_EDGE)
+			_pf_kernel_6(schedule, lane->dest, lane->length, shift);
+		else
+			_pf_kernel_5(schedule, lane->dest, lane->length, shift);
 
-			if (is_noob)
-				printf(RULE_MESSAGE, first, second, "(Rule-02)");
-		} else {
-			// If both the conditions fail, making a rectangle, and replacing the characters from
-			// the diagonally opposite vertex of the rectangle.
+		lane->dest[lane->length] = '\0';
+	}
+}
 
-			first = pf_key_matrix[pos_first / MATRIX_EDGE][pos_second % MATRIX_EDGE];
-			second = pf_key_matrix[pos_second / MATRIX_EDGE][pos_first % MATRIX_EDGE];
+/**
+ * Public method to implement the play-fair cipher algorithm, writing the result
+ * into a buffer owned by the caller.
+ *
+ * @remarks
+ * 		Calling this method with a null destination (or a destination that is too
+ * 		small) does not modify anything and simply returns the size needed - can be
+ * 		used to size a buffer before-hand.
+ *
+ * @param dest: Buffer in which the result is to be written. Can be the same as the message.
+ * @param dest_cap: Unsigned integer containing the capacity of the buffer, in characters.
+ * @param message: Span containing the original message that is to be ciphered.
+ * 		Should contain only lower-cased alphabets - no other characters.
+ * @param key: Span containing the key that is to be ciphered.
+ * @param is_noob: Boolean indicating if verbose output is needed.
+ *
+ * @return
+ * 		Unsigned integer containing the length of the result. The buffer should be able
+ * 		to hold one more character than this (for the string terminator).
+ */
+unsigned int crypt_play_fair_into(
+	string dest, unsigned int dest_cap, struct span message, struct span key, bool is_noob
+) {
+	// Populating the key matrix with the key and remaining characters (except `IGNORE_CHAR`).
+	pf_populate_key(key);        // Will internally populate `pf_key_schedule`.
 
-			if (is_noob)
-				printf(RULE_MESSAGE, first, second, "(Rule-03)");
-		}
+	return _pf_run_into(&pf_key_schedule, dest, dest_cap, message, 1, is_noob);
+}
 
-		message[i - 1] = first;
-		message[i] = second;
-	}
+/**
+ * Public method to decrypt a message ciphered using the play-fair algorithm, writing
+ * the result into a buffer owned by the caller.
+ *
+ * @remarks
+ * 		Similar to `crypt_play_fair_into`, a null (or small) destination is left untouched
+ * 		and the size needed is returned.
+ *
+ * @param dest: Buffer in which the result is to be written. Can be the same as the message.
+ * @param dest_cap: Unsigned integer containing the capacity of the buffer, in characters.
+ * @param message: Span containing the ciphered text.
+ * @param key: Span containing the key used to cipher the text.
+ * @param is_noob: Boolean indicating if verbose output is needed.
+ *
+ * @return
+ * 		Unsigned integer containing the length of the result.
+ */
+unsigned int decrypt_play_fair_into(
+	string dest, unsigned int dest_cap, struct span message, struct span key, bool is_noob
+) {
+	pf_populate_key(key);
 
-	if (is_noob)
-		printf("  Resultant String; \n\t`%s`\n\n", message);
+	// Moving one step "back" along a row/column is the same as moving `edge - 1` steps forward.
+	return _pf_run_into(&pf_key_schedule, dest, dest_cap, message, pf_key_schedule.edge - 1, is_noob);
+}
 
-	return message;
-}
\ No newline at end of file
+/**
+ * Public method to implement the play-fair cipher algorithm.
+ *
+ * @note
+ * 		Delegates to `crypt_play_fair_into` - the string returned is created using `malloc`
+ * 		and should be destroyed once it has been used.
+ *
+ * @param original_message: Span containing the original message that is to be ciphered.
+ * 		Should contain only lower-cased alphabets - no other characters.
+ * @param key: Span containing the key that is to be ciphered.
+ * @param is_noob: Boolean indicating if verbose output is needed.
+ *
+ * @return
+ * 		Span over a new string containing a cipher of the original text message.
+ */
+struct span crypt_play_fair(struct span original_message, struct span key, bool is_noob) {
+	unsigned int size = crypt_play_fair_into(NULL, 0, original_message, key, false) + 1;
+
+	string message = (string) malloc(size * sizeof(char));
+	return make_span(message, crypt_play_fair_into(message, size, original_message, key, is_noob));
+}
+
+/**
+ * Public method to decrypt a message ciphered using the play-fair algorithm.
+ *
+ * @note
+ * 		Delegates to `decrypt_play_fair_into` - the string returned is created using
+ * 		`malloc` and should be destroyed once it has been used.
+ *
+ * @param original_message: Span containing the ciphered text.
+ * @param key: Span containing the key used to cipher the text.
+ * @param is_noob: Boolean indicating if verbose output is needed.
+ *
+ * @return
+ * 		Span over a new string containing the deciphered message.
+ */
+struct span decrypt_play_fair(struct span original_message, struct span key, bool is_noob) {
+	unsigned int size = decrypt_play_fair_into(NULL, 0, original_message, key, false) + 1;
+
+	string message = (string) malloc(size * sizeof(char));
+	return make_span(message, decrypt_play_fair_into(message, size, original_message, key, is_noob));
+}
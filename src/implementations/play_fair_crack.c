@@ -0,0 +1,483 @@
+// Implementation of the play-fair crack - a ciphertext-only attack using simulated annealing.
+// A candidate square is changed a little at a time (mostly by swapping two letters), and the
+// change is kept if the plaintext it gives scores better - or, now and then, even if it scores
+// worse, less and less often as the "temperature" goes down. This lets the search climb out
+// of the many squares that are only partly right.
+//
+// Independent chains run on the thread pool, each from a random square of its own - a chain
+// stuck on a square that is only partly right does not hold back the others. Every chain
+// draws from its own generator (seeded from `--seed` and the index of the chain), as such a
+// seeded run reports the same squares on any number of threads.
+
+#define _GNU_SOURCE
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "crack.h"
+#include "ciphers.h"
+#include "thread_pool.h"
+
+#define true 1
+#define false 0
+
+#define MATRIX_EDGE PF_MATRIX_EDGE
+
+// Number of cells in the square.
+#define PF_CRACK_CELLS (MATRIX_EDGE * MATRIX_EDGE)
+
+// Index of the letters merged in the square - `j` is read as `i`.
+#define PF_CRACK_IGNORED ('j' - 'a')
+#define PF_CRACK_REPLACED ('i' - 'a')
+
+// Number of characters of the cipher used to score candidates.
+#define PF_CRACK_SAMPLE 600
+
+// Number of chains run by default - or one per thread, if there are more threads.
+#define PF_CRACK_DEFAULT_ROUNDS 16
+
+// Number of times the temperature is lowered over a chain, and the number of candidates
+// tried at each temperature.
+#define PF_CRACK_STEPS 50
+#define PF_CRACK_ITERATIONS 10000
+
+// Share of the usual starting temperature the chains start at, see `crack_play_fair`.
+#define PF_CRACK_COOLING 0.33
+
+// Length of the n-grams used to score candidates.
+#define PF_CRACK_NGRAM 4
+
+// Returned in place of the score of a candidate that has been rejected part-way.
+#define PF_CRACK_REJECTED LLONG_MIN
+
+/**
+ * A candidate square - the letter in each cell (as numbers, `a` being 0), and the cell of
+ * each letter.
+ */
+struct pf_square {
+	unsigned char letter[PF_CRACK_CELLS];
+	unsigned char position[26];
+};
+
+/**
+ * A crack run - the range of the job covers the chains to be run.
+ */
+struct pf_crack_job {
+	// The job run on the pool - should stay the first member.
+	struct pool_job job;
+
+	// The sampled cipher, as numbers - `j` read as `i`.
+	const unsigned char *cipher;
+	unsigned int length;
+
+	const struct ngram_table *table;
+
+	// Temperature at the start of every chain, in units of the scores.
+	double temperature;
+
+	// The best square found by every chain, and its score - indexed by the chain.
+	struct pf_square *squares;
+	long long *scores;
+
+	unsigned long long seed;
+
+	// Number of candidates tried over all chains.
+	unsigned long long tried;
+};
+
+// The cells the two characters of a pair decrypt from, indexed by the cells of the pair
+// (`first * PF_CRACK_CELLS + second`) - the rules only depend on where the letters are,
+// not on which letters they are. Packed as `first << 8 | second`.
+unsigned short pf_crack_rules[PF_CRACK_CELLS * PF_CRACK_CELLS];
+
+/**
+ * Internal method to populate the table of rules, see `pf_crack_rules`. Mirrors the order
+ * in which `_pf_transform` checks the rules - a column, then a row, then a rectangle.
+ */
+void pf_crack_populate_rules() {
+	unsigned int back = MATRIX_EDGE - 1;
+
+	for (unsigned int first = 0; first < PF_CRACK_CELLS; first++)
+		for (unsigned int second = 0; second < PF_CRACK_CELLS; second++) {
+			unsigned int row_first = first / MATRIX_EDGE, col_first = first % MATRIX_EDGE;
+			unsigned int row_second = second / MATRIX_EDGE, col_second = second % MATRIX_EDGE;
+			unsigned int result_first, result_second;
+
+			if (col_first == col_second) {
+				result_first = ((row_first + back) % MATRIX_EDGE) * MATRIX_EDGE + col_first;
+				result_second = ((row_second + back) % MATRIX_EDGE) * MATRIX_EDGE + col_second;
+			} else if (row_first == row_second) {
+				result_first = row_first * MATRIX_EDGE + (col_first + back) % MATRIX_EDGE;
+				result_second = row_second * MATRIX_EDGE + (col_second + back) % MATRIX_EDGE;
+			} else {
+				result_first = row_first * MATRIX_EDGE + col_second;
+				result_second = row_second * MATRIX_EDGE + col_first;
+			}
+
+			pf_crack_rules[first * PF_CRACK_CELLS + second] = (unsigned short) (result_first << 8 | result_second);
+		}
+}
+
+/**
+ * Internal method to get the next number from a (xorshift) random number generator.
+ */
+unsigned long long pf_crack_random(unsigned long long *state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+
+	return *state;
+}
+
+/**
+ * Internal method to get a random number below a limit - scaled instead of divided down.
+ */
+unsigned int pf_crack_below(unsigned long long *state, unsigned int limit) {
+	return (unsigned int) (((pf_crack_random(state) >> 32) * limit) >> 32);
+}
+
+/**
+ * Internal method to record the cell of every letter, once the letters have been moved.
+ */
+void pf_crack_index(struct pf_square *square) {
+	for (unsigned int cell = 0; cell < PF_CRACK_CELLS; cell++)
+		square->position[square->letter[cell]] = (unsigned char) cell;
+
+	square->position[PF_CRACK_IGNORED] = square->position[PF_CRACK_REPLACED];
+}
+
+/**
+ * Internal method to fill a square with the letters in a random order.
+ */
+void pf_crack_shuffle(struct pf_square *square, unsigned long long *state) {
+	unsigned int cell = 0;
+	for (unsigned char letter = 0; letter < 26; letter++)
+		if (letter != PF_CRACK_IGNORED)
+			square->letter[cell++] = letter;
+
+	for (unsigned int i = PF_CRACK_CELLS - 1; i > 0; i--) {
+		unsigned int j = pf_crack_below(state, i + 1);
+
+		unsigned char temp = square->letter[i];
+		square->letter[i] = square->letter[j];
+		square->letter[j] = temp;
+	}
+
+	pf_crack_index(square);
+}
+
+/**
+ * Internal method to make a small change to a square. Mostly swaps two letters - and now
+ * and then swaps or flips whole rows/columns, which moves a square that is right up to
+ * its layout a long way in a single step.
+ */
+void pf_crack_mutate(struct pf_square *square, unsigned long long *state) {
+	unsigned int kind = pf_crack_below(state, 50);
+
+	if (kind >= 5) {
+		// Swapping two letters - the common case, only the two letters need to be re-indexed.
+		unsigned int first = pf_crack_below(state, PF_CRACK_CELLS);
+		unsigned int second = pf_crack_below(state, PF_CRACK_CELLS);
+
+		unsigned char temp = square->letter[first];
+		square->letter[first] = square->letter[second];
+		square->letter[second] = temp;
+
+		square->position[square->letter[first]] = (unsigned char) first;
+		square->position[square->letter[second]] = (unsigned char) second;
+		square->position[PF_CRACK_IGNORED] = square->position[PF_CRACK_REPLACED];
+
+		return;
+	}
+
+	unsigned int a = pf_crack_below(state, MATRIX_EDGE);
+	unsigned int b = pf_crack_below(state, MATRIX_EDGE);
+
+	unsigned char copy[PF_CRACK_CELLS];
+	memcpy(copy, square->letter, PF_CRACK_CELLS);
+
+	for (unsigned int cell = 0; cell < PF_CRACK_CELLS; cell++) {
+		unsigned int row = cell / MATRIX_EDGE, column = cell % MATRIX_EDGE;
+
+		switch (kind) {
+			case 0:
+				// Swapping two rows.
+				row = (row == a) ? b : (row == b) ? a : row;
+				break;
+
+			case 1:
+				// Swapping two columns.
+				column = (column == a) ? b : (column == b) ? a : column;
+				break;
+
+			case 2:
+				// Flipping the square top to bottom.
+				row = MATRIX_EDGE - 1 - row;
+				break;
+
+			case 3:
+				// Flipping the square left to right.
+				column = MATRIX_EDGE - 1 - column;
+				break;
+
+			default:
+				// Reversing the square.
+				row = MATRIX_EDGE - 1 - row;
+				column = MATRIX_EDGE - 1 - column;
+		}
+
+		square->letter[cell] = copy[row * MATRIX_EDGE + column];
+	}
+
+	pf_crack_index(square);
+}
+
+/**
+ * Internal method to get the index of a quadgram in the n-gram table.
+ */
+static inline unsigned int pf_crack_quadgram(const unsigned char *text) {
+	return ((text[0] * 26 + text[1]) * 26 + text[2]) * 26 + text[3];
+}
+
+/**
+ * Internal method to decrypt the sampled cipher with a square, and score the plaintext.
+ *
+ * @remarks
+ * 		Each pair is decrypted with three table lookups - the cells of the two letters,
+ * 		and the rule for that pair of cells - with no branches. Scores only go down as more
+ * 		of the plaintext is scored, as such the run is cut short once it drops below the
+ * 		floor - most candidates are rejected long before the end of the text.
+ *
+ * @param floor: The score below which the exact score does not matter.
+ *
+ * @return
+ * 		The score of the plaintext, or `PF_CRACK_REJECTED` if it is below the floor.
+ */
+long long pf_crack_score(
+	const struct pf_crack_job *crack, const struct pf_square *square, unsigned char *plaintext, long long floor
+) {
+	const unsigned char *cipher = crack->cipher;
+	const short *scores = crack->table->scores;
+
+	long long score = 0;
+
+	for (unsigned int i = 0; i < crack->length; i += 2) {
+		unsigned short rule = pf_crack_rules[square->position[cipher[i]] * PF_CRACK_CELLS + square->position[cipher[i + 1]]];
+
+		plaintext[i] = square->letter[rule >> 8];
+		plaintext[i + 1] = square->letter[rule & 0xff];
+
+		// Scoring the quadgrams ending in this pair - the pair itself, and the one before.
+		if (i >= 4)
+			score += scores[pf_crack_quadgram(plaintext + i - 3)];
+
+		if (i >= 2)
+			score += scores[pf_crack_quadgram(plaintext + i - 2)];
+
+		if (score < floor)
+			return PF_CRACK_REJECTED;
+	}
+
+	return score;
+}
+
+/**
+ * Internal method to run a range of annealing chains - called on the workers.
+ */
+void pf_crack_part(struct pool_job *job, unsigned int begin, unsigned int end) {
+	struct pf_crack_job *crack = (struct pf_crack_job *) job;
+	unsigned char *plaintext = (unsigned char *) malloc(crack->length);
+
+	for (unsigned int chain = begin; chain < end; chain++) {
+		unsigned long long state = crack->seed ^ ((chain + 1) * 0x9e3779b97f4a7c15ULL);
+		struct pf_square current, candidate, best;
+
+		pf_crack_shuffle(&current, &state);
+		double start = crack->temperature;
+
+		long long current_score = pf_crack_score(crack, &current, plaintext, PF_CRACK_REJECTED);
+		long long best_score = current_score;
+		best = current;
+
+		for (unsigned int step = 0; step < PF_CRACK_STEPS; step++) {
+			double temperature = start * (PF_CRACK_STEPS - step) / PF_CRACK_STEPS;
+
+			for (unsigned int i = 0; i < PF_CRACK_ITERATIONS; i++) {
+				candidate = current;
+				pf_crack_mutate(&candidate, &state);
+
+				// Better squares are always kept, worse ones with a chance that shrinks with
+				// the temperature - `exp(change / temperature)`. Drawing the chance up-front
+				// gives the lowest score that would still be kept.
+				double chance = ((pf_crack_random(&state) >> 11) + 1) * (1.0 / 9007199254740992.0);
+				long long floor = current_score + (long long) (temperature * log(chance));
+
+				long long score = pf_crack_score(crack, &candidate, plaintext, floor);
+				if (score == PF_CRACK_REJECTED)
+					continue;
+
+				current = candidate;
+				current_score = score;
+
+				if (current_score > best_score) {
+					best = current;
+					best_score = current_score;
+				}
+			}
+		}
+
+		crack->squares[chain] = best;
+		crack->scores[chain] = best_score;
+
+		__atomic_fetch_add(&crack->tried, (unsigned long long) PF_CRACK_STEPS * PF_CRACK_ITERATIONS, __ATOMIC_RELAXED);
+	}
+
+	free(plaintext);
+}
+
+/**
+ * Cracks a play-fair cipher - runs a number of annealing chains, and prints the best
+ * (distinct) squares found along with their plaintexts.
+ *
+ * @remarks
+ * 		Squares that differ only by rotating the rows/columns cipher the same way - only
+ * 		one of them is reported.
+ *
+ * @param cipher: Span containing the (normalized) cipher.
+ * @param options: Pointer to the options of the run.
+ *
+ * @return
+ * 		Integer containing the exit code for the program.
+ */
+int crack_play_fair(struct span cipher, const struct crack_options *options) {
+	struct timespec started, stopped;
+	clock_gettime(CLOCK_MONOTONIC, &started);
+
+	if (cipher.length < PF_CRACK_NGRAM || cipher.length % 2 != 0) {
+		printf("\nError: The cipher should be made of complete pairs\n");
+		return -10;
+	}
+
+	// Quadgrams counted from the built-in sample are mostly missing - the search would be
+	// led astray by chance more often than not.
+	if (options->ngrams.data == NULL && options->corpus.data == NULL) {
+		printf("\nError: Cracking play-fair needs quadgram statistics - use `--ngrams` or `--corpus`\n");
+		return -10;
+	}
+
+	struct ngram_table table;
+	if (!crack_table(&table, PF_CRACK_NGRAM, options))
+		return -10;
+
+	pf_crack_populate_rules();
+
+	unsigned int length = (cipher.length < PF_CRACK_SAMPLE) ? cipher.length : PF_CRACK_SAMPLE;
+	unsigned char *sample = (unsigned char *) malloc(length);
+
+	for (unsigned int i = 0; i < length; i++)
+		sample[i] = (unsigned char) (cipher.data[i] - 'a');
+
+	struct thread_pool *pool = pool_create(options->threads);
+
+	unsigned int rounds = options->rounds;
+	if (rounds == 0)
+		rounds = (pool_size(pool) > PF_CRACK_DEFAULT_ROUNDS) ? pool_size(pool) : PF_CRACK_DEFAULT_ROUNDS;
+
+	struct crack_ranking ranking;
+	ranking_init(&ranking, rounds);
+
+	struct pf_crack_job crack;
+	memset(&crack, 0, sizeof(crack));
+
+	crack.cipher = sample;
+	crack.length = length;
+	crack.table = &table;
+	crack.squares = (struct pf_square *) calloc(rounds, sizeof(struct pf_square));
+	crack.scores = (long long *) calloc(rounds, sizeof(long long));
+	crack.seed = options->seed;
+	if (crack.seed == 0)
+		crack.seed = ((unsigned long long) started.tv_nsec ^ ((unsigned long long) started.tv_sec << 32)) | 1;
+
+	// The usual starting temperature for quadgram scores, scaled with the length of the text
+	// - in units of `log10`, as such scaled up to the scores (see `NGRAM_SCALE`). That is
+	// tuned for tables counted from billions of characters, where missing quadgrams cost
+	// far more - with smaller tables, and shorter chains, a third of it finds the square
+	// most often.
+	double temperature = 10 + 0.087 * ((double) length - 84);
+	crack.temperature = ((temperature < 5) ? 5 : temperature) * PF_CRACK_COOLING * NGRAM_SCALE;
+
+	crack.job.run = pf_crack_part;
+	crack.job.length = rounds;
+	crack.job.align = 1;
+	crack.job.grain = 1;
+
+	pool_submit(pool, &crack.job);
+	pool_destroy(pool);
+
+	// Ranked in the order of the chains, once all of them are done - squares that score the
+	// same (rotations of each other) keep that order on any number of threads.
+	for (unsigned int chain = 0; chain < rounds; chain++)
+		ranking_offer(&ranking, chain, crack.scores[chain]);
+
+	clock_gettime(CLOCK_MONOTONIC, &stopped);
+	double elapsed = (stopped.tv_sec - started.tv_sec) * 1e3 + (stopped.tv_nsec - started.tv_nsec) / 1e6;
+
+	printf(
+		"\nRan %u annealing chains (%llu candidates, %.0f per second) in %.2f ms\n",
+		rounds, crack.tried, crack.tried / (elapsed / 1e3), elapsed
+	);
+
+	double ngrams = length - PF_CRACK_NGRAM + 1;
+
+	string *reported = (string *) malloc(sizeof(string) * ranking.count);
+	unsigned int count = 0;
+
+	for (unsigned int i = 0; i < ranking.count && count < options->top; i++) {
+		const struct pf_square *square = &crack.squares[ranking.items[i].key];
+
+		char key[PF_CRACK_CELLS];
+		for (unsigned int cell = 0; cell < PF_CRACK_CELLS; cell++)
+			key[cell] = (char) ('a' + square->letter[cell]);
+
+		struct pf_schedule schedule;
+		pf_prepare(&schedule, make_span(key, PF_CRACK_CELLS));
+
+		string plaintext = (string) malloc(cipher.length + 1);
+		pf_run_into(&schedule, false, plaintext, cipher.length + 1, cipher);
+
+		bool repeated = false;
+		for (unsigned int j = 0; j < count && !repeated; j++)
+			repeated = strcmp(reported[j], plaintext) == 0;
+
+		if (repeated) {
+			free(plaintext);
+			continue;
+		}
+
+		reported[count++] = plaintext;
+
+		printf(
+			"\n#%u - Key: %.*s, Fitness: %.3f\n\t%.*s\n",
+			count, PF_CRACK_CELLS, key, ranking.items[i].score / (double) NGRAM_SCALE / ngrams, cipher.length, plaintext
+		);
+	}
+
+	printf("\n");
+
+	for (unsigned int i = 0; i < count; i++)
+		free(reported[i]);
+
+	free(reported);
+	free(crack.squares);
+	free(crack.scores);
+	free(sample);
+
+	ranking_free(&ranking);
+	ngram_free(&table);
+
+	return 0;
+}
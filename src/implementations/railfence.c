@@ -9,7 +9,7 @@
 // does not require major structural changes for one cipher.
 
 #include <stdio.h>
-#include <math.h>
+#include <stdlib.h>
 
 #include "../headers/ciphers.h"
 #include "commons.h"
@@ -27,7 +27,7 @@ bool rf_key_validated = false;
  * Public interface to validate a key - designed to be used to validate the input while
  * accepting it from the user.
  *
- * @param key: String containing the key that is to be used.
+ * @param key: Span containing the key that is to be used.
  *
  * @remarks
  * 		To be used once while validating the key if the user chooses to use RailFence
@@ -44,7 +44,7 @@ bool rf_key_validated = false;
  * 		the rest of the codebase, revealing this method to validate a key before attempting to
  * 		encrypt/decrypt.
  */
-void validate_key_railfence(string key) {
+void validate_key_railfence(struct span key) {
 	// Marking the cipher as validated.
 	rf_key_validated = true;
 
@@ -55,9 +55,9 @@ void validate_key_railfence(string key) {
 		// If the validation fails, i.e. the key entered by the user cannot be used with
 		// railfence, rejecting the input force-stop the program.
 		printf(
-			"\n Error: Invalid key. The key entered `%s` cannot be used with RailFence cipher"
+			"\n Error: Invalid key. The key entered `%.*s` cannot be used with RailFence cipher"
 			"\n Please re-enter a valid key.\n",
-			key
+			key.length, key.data
 		);
 
 		exit(-10);
@@ -67,7 +67,7 @@ void validate_key_railfence(string key) {
 /**
  * Converts a string into a number.
  *
- * @param number: String containing the original number.
+ * @param number: Span containing the original number.
  *
  * @remarks
  * 		Can only be used with positive integers.
@@ -78,7 +78,7 @@ void validate_key_railfence(string key) {
  * @return
  * 		Unsigned integer containing the number from the string.
  */
-extern inline unsigned int convert(string number) {
+extern inline unsigned int convert(struct span number) {
 	// Validating to ensure the string contains a number - force stop if validation fails.
 	if (!validate("^\\d+$", number)) {
 		printf("\nError: Attempt to convert non-numeric string into a number (Railfence)\n");
@@ -88,10 +88,11 @@ extern inline unsigned int convert(string number) {
 	// Initializing with a value of zero.
 	unsigned int result = 0;
 
-	// Iterate from the end of the loop to the front.
-	for (unsigned int i = 0; number[i] != '\0'; i++)
-		// Converting the character into an integer and multiplying with a power of 10.
-		result = result * pow(10, i) + (number[i] - 48);
+	// Iterate from the front of the number to the end - every digit shifts the
+	// digits read so far one place to the left.
+	for (unsigned int i = 0; i < number.length; i++)
+		// Converting the character into an integer and adding it in the units place.
+		result = result * 10 + (number.data[i] - 48);
 
 	return result;
 }
@@ -99,6 +100,12 @@ extern inline unsigned int convert(string number) {
 /**
  * Calculates the length of the result string required in the matrix.
  *
+ * @remarks
+ * 		The message is padded until its last character falls on the bottom row of the
+ * 		matrix. The diagonal repeats itself every `2 * (rows - 1)` characters, and the
+ * 		character at index `rows - 1` of every such cycle is on the bottom row - the length
+ * 		can be calculated directly instead of walking over the diagonal.
+ *
  * @param str_len: Integer containing the length of the original string.
  * @param rows: Integer containing the number of rows required in the matrix.
  *
@@ -106,40 +113,168 @@ extern inline unsigned int convert(string number) {
  * 		Unsigned integer containing the length of the result string.
  */
 extern inline unsigned int get_length(unsigned int str_len, unsigned int rows) {
-	unsigned int row = 0;
-	unsigned int column = 0;
+	if (rows <= 1)
+		// A single rail never changes direction - the message fits as-is.
+		return str_len;
 
-	bool dir_down = false;
+	unsigned long long cycle = 2 * (rows - 1);
 
-	unsigned int new_len = 0;
+	// Index of the last character of the message (taking at least one character), and
+	// the number of characters needed to move from there to the bottom row.
+	unsigned long long last = (str_len == 0) ? 0 : str_len - 1;
+	unsigned long long extra = ((rows - 1) + cycle - (last % cycle)) % cycle;
 
-	for (unsigned int i = 0;; i++) {
-		if (row == 0 || row == rows - 1)
-			dir_down = !dir_down;
+	return (unsigned int) (last + extra + 1);
+}
+
+/**
+ * Internal method to count the characters on a single row of the matrix.
+ *
+ * @param row: Unsigned integer containing the row.
+ * @param rows: Unsigned integer containing the number of rows in the matrix - at least two.
+ * @param total_length: Unsigned integer containing the length after padding.
+ *
+ * @return
+ * 		Unsigned integer containing the number of characters on the row.
+ */
+extern inline unsigned long long rf_row_length(unsigned int row, unsigned int rows, unsigned int total_length) {
+	unsigned long long cycle = 2 * (rows - 1);
 
-		new_len++;
-		if (new_len >= str_len && row == rows - 1)
-			break;
+	// Number of cycles in which the character on the way down is a part of the message.
+	unsigned long long length = (row < total_length) ? (total_length - row - 1) / cycle + 1 : 0;
 
-		column++;
-		dir_down ? row++ : row--;
+	// Along with the character on the way back up - missing on the first and last row.
+	if (row != 0 && row != rows - 1 && cycle - row < total_length)
+		length += (total_length - (cycle - row) - 1) / cycle + 1;
+
+	return length;
+}
+
+/**
+ * Internal method to map a rail to the columns it reads (see `tp_layout`) - every cycle
+ * of the zigzag is a row of the matrix, and the characters of rail `r` are those in columns
+ * `r` (on the way down) and `cycle - r` (on the way back up, missing on the first and last
+ * rail).
+ *
+ * @param context: Pointer to the number of rails.
+ */
+void _rf_columns(const void *context, unsigned long long lane, unsigned long long *first, unsigned long long *second) {
+	unsigned long long rows = *(const unsigned int *) context;
+
+	*first = lane;
+	*second = (lane == 0 || lane == rows - 1) ? TP_NONE : 2 * (rows - 1) - lane;
+}
+
+/**
+ * Internal method to move characters of a message along the diagonal without building
+ * the matrix - the position of every character is calculated directly.
+ *
+ * @remarks
+ * 		The characters on row `r` of the matrix are at indices `r`, `cycle - r`, `cycle + r`,
+ * 		`2 * cycle - r`, and so on (every `cycle` characters for the first and last row). Reading
+ * 		the rows one after the other in this order gives the cipher - and writing them back in
+ * 		this order reverses it. The characters are moved by the transposition shared with the
+ * 		columnar ciphers (see `tp_permute`).
+ *
+ * @remarks
+ * 		Only the characters at positions `[begin, end)` of the cipher are moved - calls over
+ * 		disjoint ranges write to disjoint parts of the destination, as such can run at the
+ * 		same time. A range of `[0, total_length)` moves the whole message.
+ *
+ * @note
+ * 		The destination cannot overlap with the source.
+ *
+ * @param rows: Unsigned integer containing the number of rows in the matrix.
+ * @param dest: Buffer in which the result is to be written - should hold `total_length` characters.
+ * @param source: Span containing the message - padded with `X` characters up to `total_length`
+ * 		if it is shorter.
+ * @param total_length: Unsigned integer containing the length after padding.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param begin: Unsigned integer containing the first position (in the cipher) to be moved.
+ * @param end: Unsigned integer containing the position (in the cipher) to stop at.
+ */
+void _rf_permute(
+	unsigned int rows, string dest, struct span source, unsigned int total_length, bool encrypt,
+	unsigned int begin, unsigned int end
+) {
+	// A single rail never changes direction - the message is a single column.
+	struct tp_layout layout;
+	layout.width = (rows <= 1) ? 1 : 2 * (unsigned long long) (rows - 1);
+	layout.lanes = rows;
+	layout.columns = _rf_columns;
+	layout.context = &rows;
+
+	tp_permute(&layout, dest, source, total_length, encrypt, begin, end);
+}
+
+/**
+ * Internal method to print the matrix being used in verbose mode.
+ *
+ * @param rows: Integer containing the number of rows in the matrix.
+ * @param columns: Integer containing the number of columns in the matrix.
+ * @param matrix: The matrix that is to be printed.
+ */
+void _rf_print_matrix(unsigned int rows, unsigned int columns, char matrix[rows][columns]) {
+	printf("\n\nMatrix: \n\n");
+
+	for (unsigned int i = 0; i < rows; i++) {
+		printf("%c\t", (i == 0) ? '\0' : '\n');
+
+		for (unsigned int j = 0; j < columns; j++)
+			printf("%c\t", matrix[i][j]);
 	}
+}
 
-	return new_len;
+/**
+ * Internal method to create the matrix used in verbose mode.
+ *
+ * @note
+ * 		Force-stops the program if the memory cannot be allocated - the caller should have
+ * 		reserved the matrix from the memory budget beforehand.
+ *
+ * @param rows: Unsigned integer containing the number of rows in the matrix.
+ * @param columns: Unsigned integer containing the number of columns in the matrix.
+ *
+ * @return
+ * 		Pointer to the matrix, created using `malloc` - should be destroyed once it has been used.
+ */
+void *_rf_matrix_create(unsigned int rows, unsigned int columns) {
+	void *matrix = malloc((size_t) rows * columns);
+
+	if (matrix == NULL) {
+		printf("\nError: Could not allocate the rail matrix (%u rows, %u columns)\n", rows, columns);
+		exit(-10);
+	}
+
+	return matrix;
 }
 
 /**
- * Method to encrypt a message using the RailFence cipher algorithm.
+ * Method to encrypt a message using the RailFence cipher algorithm, writing the result
+ * into a buffer owned by the caller.
  *
- * @param key: String containing the key to be used. Should be validated beforehand.
- * @param message: String containing the message to be encrypted.
+ * @remarks
+ * 		Calling this method with a null destination (or a destination that is too
+ * 		small) does not modify anything and simply returns the size needed.
+ *
+ * @note
+ * 		The message is placed in the matrix before anything is written to the
+ * 		destination - the destination can be the same buffer as the message.
+ *
+ * @param dest: Buffer in which the result is to be written.
+ * @param dest_cap: Unsigned integer containing the capacity of the buffer, in characters.
+ * @param message: Span containing the message to be encrypted.
+ * @param key: Span containing the key to be used. Should be validated beforehand.
  * @param verbose: Boolean indicating if verbose output is to be printed.
  *
  * @return
- * 		String containing the encrypted result of the original message - encrypted using
- * 		the railfence cipher algorithm.
+ * 		Unsigned integer containing the length of the result - includes the characters
+ * 		used to pad the message. The buffer should be able to hold one more character
+ * 		than this (for the string terminator).
  */
-string crypt_railfence(string key, string message, bool verbose) {
+unsigned int crypt_railfence_into(
+	string dest, unsigned int dest_cap, struct span message, struct span key, bool verbose
+) {
 	// Checking if the key has been validate before. In case this fails, raising an error
 	// (Converting a logical bug into runtime error)
 	if (!rf_key_validated) {
@@ -149,47 +284,32 @@ string crypt_railfence(string key, string message, bool verbose) {
 
 	// Converting the string into an integer.
 	unsigned int row_count = convert(key);
+	unsigned int message_length = message.length;
 
-	// Calculating the current length of the string - and the extra length needed
-	// to pad the string such that it fits the diagonal.
-	unsigned int message_length = strlen(message);
+	// Calculating the length of the message after it is padded to fit the diagonal.
 	unsigned int total_length = get_length(message_length, row_count);
 
-	// Pad the existing string to ensure it contains enough characters.
-	if (message_length < total_length) {
-		unsigned int extra_len = total_length - message_length;
-
-		// Creating a temporary string of the required length.
-		string temp_str = gen_str_pad(message, extra_len);
+	if (dest == NULL || dest_cap <= total_length)
+		return total_length;
 
-		// Appending new characters at the end of the temporary string.
-		for (unsigned int i = 0; i < extra_len; i++)
-			// Padding with an `X` character.
-			temp_str[i + message_length] = 'X';
+	if (verbose) {
+		// Printing the padded version of the message - padded with `X` characters.
+		printf("\nPadded message:\n\t%.*s", message_length, message.data);
+		for (unsigned int i = message_length; i < total_length; i++)
+			printf("X");
 
-		// Using this temp string as the new message.
-		message = temp_str;
+		printf("\n\n");
 	}
 
-	if (verbose)
-		// Printing the padded version of the message.
-		printf("\nPadded message:\n\t%s\n\n", message);
-
-	// Create a new string to store the result into.
-	string result = (string) malloc(total_length * sizeof(char));
-
-	// Modifying each element of the result string to contain string terminator (hack-y approach)
-	for (unsigned int i = 0; i < total_length; i++)
-		result[i] = '\0';
-
-	// Creating a 2d matrix which will be populated using characters of the message
-	char matrix[row_count][total_length];
+	// Creating a 2d matrix which will be populated using characters of the message - on the
+	// heap, as it grows with both the number of rails and the message.
+	char (*matrix)[total_length] = _rf_matrix_create(row_count, total_length);
 
 	for (unsigned int i = 0; i < row_count; i++)
 		for (unsigned int j = 0; j < total_length; j++)
 			matrix[i][j] = ' ';
 
-	// Populating the 2d matrix.
+	// Populating the 2d matrix - padding the message with `X` characters on the fly.
 	bool dir_down = false;
 	unsigned int row = 0;
 	unsigned int column = 0;
@@ -198,38 +318,52 @@ string crypt_railfence(string key, string message, bool verbose) {
 		if (row == 0 || row == row_count - 1)
 			dir_down = !dir_down;
 
-		matrix[row][column++] = message[i];
-		dir_down ? row++ : row--;
+		matrix[row][column++] = (i < message_length) ? message.data[i] : 'X';
+
+		if (row_count > 1)
+			dir_down ? row++ : row--;
 	}
 
 	// Printing the matrix in verbose mode.
-	if (verbose) {
-		printf("\n\nMatrix: \n\n");
-
-		for (
-			unsigned int i = 0; i < row_count; i++) {
-			printf("%c\t", (i == 0) ? '\0' : '\n');
-
-			for (unsigned int j = 0; j < total_length; j++)
-				printf("%c\t", matrix[i][j]);
-		}
-	}
+	if (verbose)
+		_rf_print_matrix(row_count, total_length, matrix);
 
 	// Finally, fetching the result as needed.
 	unsigned int counter = 0;
 	for (unsigned int i = 0; i < row_count; i++)
-		for (int j = 0; j < total_length; j++)
+		for (unsigned int j = 0; j < total_length; j++)
 			if (matrix[i][j] != ' ')
-				result[counter++] = matrix[i][j];
+				dest[counter++] = matrix[i][j];
 
+	free(matrix);
+	dest[total_length] = '\0';
 
 	if (verbose)
 		printf("\n\n");
 
-	return result;
+	return total_length;
 }
 
-string decrypt_railfence(string key, string message, bool verbose) {
+/**
+ * Method to decrypt a message ciphered using the RailFence cipher algorithm, writing the
+ * result into a buffer owned by the caller.
+ *
+ * @remarks
+ * 		Similar to `crypt_railfence_into`, a null (or small) destination is left untouched
+ * 		and the size needed is returned.
+ *
+ * @param dest: Buffer in which the result is to be written.
+ * @param dest_cap: Unsigned integer containing the capacity of the buffer, in characters.
+ * @param message: Span containing the ciphered text.
+ * @param key: Span containing the key to be used. Should be validated beforehand.
+ * @param verbose: Boolean indicating if verbose output is to be printed.
+ *
+ * @return
+ * 		Unsigned integer containing the length of the result.
+ */
+unsigned int decrypt_railfence_into(
+	string dest, unsigned int dest_cap, struct span message, struct span key, bool verbose
+) {
 	// Checking if the key has been validate before. In case this fails, raising an error
 	// (Converting a logical bug into runtime error)
 	if (!rf_key_validated) {
@@ -239,10 +373,10 @@ string decrypt_railfence(string key, string message, bool verbose) {
 
 	// Converting the string into an integer.
 	unsigned int row_count = convert(key);
+	unsigned int message_length = message.length;
 
-	// Calculating the current length of the string - and the extra length needed
-	// to pad the string such that it fits the diagonal.
-	unsigned int message_length = strlen(message);
+	// Calculating the length the message should have - a ciphered message is always padded
+	// to fit the diagonal.
 	unsigned int total_length = get_length(message_length, row_count);
 
 	// If the message is not of the required length, rejecting the input
@@ -253,19 +387,16 @@ string decrypt_railfence(string key, string message, bool verbose) {
 		exit(-10);
 	}
 
+	if (dest == NULL || dest_cap <= total_length)
+		return total_length;
+
 	if (verbose)
 		// Printing the padded version of the message.
-		printf("\nPadded message:\n\t%s\n\n", message);
-
-	// Create a new string to store the result into.
-	string result = (string) malloc(total_length * sizeof(char));
+		printf("\nPadded message:\n\t%.*s\n\n", message_length, message.data);
 
-	// Modifying each element of the result string to contain string terminator (hack-y approach)
-	for (unsigned int i = 0; i < total_length; i++)
-		result[i] = '\0';
-
-	// Creating a 2d matrix which will be populated using characters of the message
-	char matrix[row_count][total_length];
+	// Creating a 2d matrix which will be populated using characters of the message - on the
+	// heap, as it grows with both the number of rails and the message.
+	char (*matrix)[total_length] = _rf_matrix_create(row_count, total_length);
 
 	for (unsigned int i = 0; i < row_count; i++)
 		for (unsigned int j = 0; j < total_length; j++)
@@ -276,59 +407,309 @@ string decrypt_railfence(string key, string message, bool verbose) {
 	unsigned int row = 0;
 	unsigned int column = 0;
 
-	int current_row = -1;
-
 	// First pass; marking the places with a star (*) symbol. These symbols will be
 	// replaced by characters in the next pass.
 	for (unsigned int i = 0; i < total_length; i++) {
 		if (row == 0 || row == row_count - 1)
 			dir_down = !dir_down;
 
-		if (row == 0)
-			current_row++;
-
 		matrix[row][column++] = '*';
-		dir_down ? row++ : row--;
+
+		if (row_count > 1)
+			dir_down ? row++ : row--;
 	}
 
 	// Second pass; replacing the star symbols from the first-pass with characters from
 	// the incoming message string.
 	unsigned int counter = 0;
-	for (unsigned int i = 0; i < row_count; i++) {
-		for (unsigned int j = 0; j < message_length; j++) {
+	for (unsigned int i = 0; i < row_count; i++)
+		for (unsigned int j = 0; j < total_length; j++)
 			if (matrix[i][j] == '*')
-				matrix[i][j] = message[counter++];
-		}
-	}
+				matrix[i][j] = message.data[counter++];
 
 	// Printing the matrix in verbose mode.
-	if (verbose) {
-		printf("\n\nMatrix: \n\n");
-
-		for (
-			unsigned int i = 0; i < row_count; i++) {
-			printf("%c\t", (i == 0) ? '\0' : '\n');
-
-			for (unsigned int j = 0; j < total_length; j++)
-				printf("%c\t", matrix[i][j]);
-		}
-	}
+	if (verbose)
+		_rf_print_matrix(row_count, total_length, matrix);
 
-	// Finally, fetching the result as needed.
+	// Finally, fetching the result by walking over the diagonal once more - the matrix holds
+	// a copy of the message, safe to write to the destination even if working in-place.
+	dir_down = false;
 	row = 0;
 	column = 0;
 	for (unsigned int i = 0; i < total_length; i++) {
 		if (row == 0 || row == row_count - 1)
 			dir_down = !dir_down;
 
-		// Using the character at the current position if not a space.
-		if (matrix[row][column] != ' ')
-			result[i] = matrix[row][column++];
-		dir_down ? row++ : row--;
+		dest[i] = matrix[row][column++];
+
+		if (row_count > 1)
+			dir_down ? row++ : row--;
 	}
 
+	free(matrix);
+	dest[total_length] = '\0';
+
 	if (verbose)
 		printf("\n\n");
 
-	return result;
-}
\ No newline at end of file
+	return total_length;
+}
+
+/**
+ * Prepares a railfence key - the key is validated and converted into a number.
+ *
+ * @remarks
+ * 		Unlike `validate_key_railfence`, this method never force-stops the program -
+ * 		an invalid key is reported through the return value.
+ *
+ * @param schedule: Pointer to the schedule that is to be populated.
+ * @param key: Span containing the key.
+ *
+ * @return
+ * 		Boolean indicating if the key is valid - should be a positive number.
+ */
+bool rf_prepare(struct rf_schedule *schedule, struct span key) {
+	if (!validate("^[1-9]\\d{0,8}$", key))
+		// Anything above nine digits would overflow - and no message is long enough
+		// to need that many rails anyways.
+		return false;
+
+	schedule->rows = convert(key);
+	schedule->block = 0;
+
+	return true;
+}
+
+/**
+ * Turns a prepared railfence key into a blocked one - the zigzag runs over each block of
+ * the message on its own, instead of over the complete message.
+ *
+ * @remarks
+ * 		Blocks are not padded - the last block is as long as what is left of the message,
+ * 		as such the result has the same length as the message and the length of the last
+ * 		block is where the message ends. Each block only depends on the same block of the
+ * 		message, which lets a blocked railfence run in parallel, and over streams in as much
+ * 		memory as a block takes.
+ *
+ * @param schedule: Pointer to the key prepared using `rf_prepare`.
+ * @param block: Unsigned integer containing the size of a block - zero to go back to
+ * 		running over the complete message.
+ */
+void rf_prepare_blocked(struct rf_schedule *schedule, unsigned int block) {
+	schedule->block = block;
+}
+
+/**
+ * Runs the railfence cipher with a prepared key, writing the result into a buffer owned
+ * by the caller.
+ *
+ * @remarks
+ * 		Does not build the matrix (see `_rf_permute`) - runs in linear time, and needs no
+ * 		memory apart from the destination regardless of the number of rails.
+ *
+ * @note
+ * 		Unlike the other ciphers, the destination cannot be the same buffer as the message.
+ *
+ * @param schedule: Pointer to the key prepared using `rf_prepare`.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer in which the result is to be written.
+ * @param dest_cap: Unsigned integer containing the capacity of the buffer, in characters.
+ * @param message: Span containing the message.
+ *
+ * @return
+ * 		Unsigned integer containing the length of the result, or `CIPHER_INVALID` if a
+ * 		message being decrypted does not have the padding it should (unless blocked).
+ */
+unsigned int rf_run_into(
+	const struct rf_schedule *schedule, bool encrypt, string dest, unsigned int dest_cap, struct span message
+) {
+	if (schedule->block != 0) {
+		// Blocks are not padded - any length can be read back.
+		if (dest == NULL || dest_cap <= message.length)
+			return message.length;
+
+		rf_run_slice(schedule, encrypt, dest, message, 0, message.length);
+		dest[message.length] = '\0';
+
+		return message.length;
+	}
+
+	unsigned int total_length = get_length(message.length, schedule->rows);
+
+	if (!encrypt && message.length != total_length)
+		// A ciphered message is always padded to fit the diagonal.
+		return CIPHER_INVALID;
+
+	if (dest == NULL || dest_cap <= total_length)
+		return total_length;
+
+	_rf_permute(schedule->rows, dest, message, total_length, encrypt, 0, total_length);
+	dest[total_length] = '\0';
+
+	return total_length;
+}
+
+/**
+ * Method to encrypt a message using the RailFence cipher algorithm.
+ *
+ * @note
+ * 		Delegates to `crypt_railfence_into` - the string returned is created using
+ * 		`malloc` and should be destroyed once it has been used.
+ *
+ * @param message: Span containing the message to be encrypted.
+ * @param key: Span containing the key to be used. Should be validated beforehand.
+ * @param verbose: Boolean indicating if verbose output is to be printed.
+ *
+ * @return
+ * 		Span over a new string containing the encrypted result of the original message -
+ * 		encrypted using the railfence cipher algorithm.
+ */
+struct span crypt_railfence(struct span message, struct span key, bool verbose) {
+	unsigned int size = crypt_railfence_into(NULL, 0, message, key, false) + 1;
+
+	string result = (string) malloc(size * sizeof(char));
+	return make_span(result, crypt_railfence_into(result, size, message, key, verbose));
+}
+
+/**
+ * Method to decrypt a message ciphered using the RailFence cipher algorithm.
+ *
+ * @note
+ * 		Delegates to `decrypt_railfence_into` - the string returned is created using
+ * 		`malloc` and should be destroyed once it has been used.
+ *
+ * @param message: Span containing the ciphered text.
+ * @param key: Span containing the key to be used. Should be validated beforehand.
+ * @param verbose: Boolean indicating if verbose output is to be printed.
+ *
+ * @return
+ * 		Span over a new string containing the deciphered message.
+ */
+struct span decrypt_railfence(struct span message, struct span key, bool verbose) {
+	unsigned int size = decrypt_railfence_into(NULL, 0, message, key, false) + 1;
+
+	string result = (string) malloc(size * sizeof(char));
+	return make_span(result, decrypt_railfence_into(result, size, message, key, verbose));
+}
+
+/**
+ * Runs the railfence cipher over a part of a message using a prepared key - moves the
+ * characters at positions `[begin, end)` of the cipher (the result while encrypting, the
+ * message while decrypting) to where `rf_run_into` would put them.
+ *
+ * @remarks
+ * 		Used to split a large message across threads - calls over disjoint ranges write to
+ * 		disjoint parts of the destination. Nothing else is written, not even a string
+ * 		terminator. With a blocked key, every block the range touches is run in full - the
+ * 		range should start on a block.
+ *
+ * @note
+ * 		The size of the result (and as such, the validity of the message) should have been
+ * 		checked using `rf_run_into` beforehand. The destination cannot overlap with the message.
+ *
+ * @param schedule: Pointer to the key prepared using `rf_prepare`.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer for the complete result - the range is written at its own offsets.
+ * @param message: Span containing the complete message.
+ * @param begin: Unsigned integer containing the first position (in the cipher) to be moved.
+ * @param end: Unsigned integer containing the position (in the cipher) to stop at.
+ */
+void rf_run_slice(
+	const struct rf_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+) {
+	if (schedule->block != 0) {
+		for (unsigned int start = begin; start < end && start < message.length; start += schedule->block) {
+			unsigned int size = (message.length - start < schedule->block) ? message.length - start : schedule->block;
+			rf_run_unpadded(schedule->rows, encrypt, dest + start, make_span(message.data + start, size));
+		}
+
+		return;
+	}
+
+	unsigned int total_length = get_length(message.length, schedule->rows);
+	_rf_permute(schedule->rows, dest, message, total_length, encrypt, begin, end);
+}
+
+/**
+ * Runs the railfence cipher over a message as-is, without padding it to fit the diagonal -
+ * the result has the same length as the message.
+ *
+ * @remarks
+ * 		Reads text ciphered by tools that do not pad the message, and is what the crack
+ * 		mode tries each rail count with. For messages that already fit the diagonal, the
+ * 		result is the same as `rf_run_into`.
+ *
+ * @note
+ * 		Writes exactly `message.length` characters - no string terminator. The destination
+ * 		cannot overlap with the message.
+ *
+ * @param rows: Unsigned integer containing the number of rails.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer in which the result is to be written.
+ * @param message: Span containing the message.
+ */
+void rf_run_unpadded(unsigned int rows, bool encrypt, string dest, struct span message) {
+	_rf_permute(rows, dest, message, message.length, encrypt, 0, message.length);
+}
+
+/**
+ * Decrypts only a part of an (unpadded) railfence cipher - the position of each character
+ * of the plaintext in the cipher is calculated directly, as such the cost does not depend
+ * on the length of the cipher.
+ *
+ * @remarks
+ * 		The position of the character at index `i` is the number of characters on the rows
+ * 		above its own, plus the number of characters before it on its own row. Both are
+ * 		counted per cycle of the diagonal, with the last (partial) cycle handled separately.
+ *
+ * @param rows: Unsigned integer containing the number of rails.
+ * @param dest: Buffer for the plaintext - the range is written at its own offsets, without
+ * 		a string terminator.
+ * @param cipher: Span containing the complete cipher.
+ * @param begin: Unsigned integer containing the first character of the plaintext to be decrypted.
+ * @param end: Unsigned integer containing the character of the plaintext to stop at.
+ */
+void rf_decrypt_range(unsigned int rows, string dest, struct span cipher, unsigned int begin, unsigned int end) {
+	unsigned long long total = cipher.length;
+	if (end > total)
+		end = total;
+
+	if (rows <= 1) {
+		if (begin < end)
+			memcpy(dest + begin, cipher.data + begin, end - begin);
+
+		return;
+	}
+
+	unsigned long long cycle = 2 * (unsigned long long) (rows - 1);
+	unsigned long long full = total / cycle;
+	unsigned long long partial = total % cycle;
+
+	// Position along the current cycle, and the number of cycles completed - tracked as the
+	// characters are walked over instead of being divided out for each one.
+	unsigned long long step = begin % cycle, cycles = begin / cycle;
+
+	for (unsigned int i = begin; i < end; i++) {
+		unsigned long long row = (step < rows) ? step : cycle - step;
+
+		// Characters on the rows above - one per cycle on the first row, two on the others.
+		unsigned long long before = 0;
+		if (row != 0) {
+			before = full * (2 * row - 1) + ((partial < row) ? partial : row);
+
+			if (partial > cycle - row + 1)
+				before += partial - (cycle - row + 1);
+		}
+
+		// Characters before this one on its own row.
+		unsigned long long within = (row == 0 || row == rows - 1) ? cycles : 2 * cycles + (step >= rows);
+
+		dest[i] = cipher.data[before + within];
+
+		if (++step == cycle) {
+			step = 0;
+			cycles++;
+		}
+	}
+}
@@ -0,0 +1,103 @@
+// Implementation of the single-producer, single-consumer ring. Each end is a counter written
+// by a single thread - the producer publishes an item by moving the tail past it (release),
+// the consumer frees its slot by moving the head past it. A thread finding the ring full
+// (or empty) spins for a while, and then yields the processor until the other thread has
+// caught up - the ring is the backpressure between the two.
+
+#define _GNU_SOURCE
+
+#include <sched.h>
+#include <stdlib.h>
+
+#include "ring.h"
+
+#define true 1
+#define false 0
+
+// Number of times a thread checks the ring again before yielding the processor.
+#define RING_SPINS 256
+
+/**
+ * Internal method to wait a little for the other end of a ring.
+ *
+ * @param spins: Pointer to the number of times the thread has waited so far.
+ */
+static inline void _ring_wait(unsigned int *spins) {
+	if (++(*spins) < RING_SPINS) {
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#endif
+		return;
+	}
+
+	sched_yield();
+}
+
+/**
+ * Creates a ring.
+ *
+ * @param ring: Pointer to the ring that is to be populated - to be released using `ring_free`.
+ * @param capacity: Unsigned integer containing the number of items the ring can hold -
+ * 		rounded up to a power of two.
+ */
+void ring_init(struct spsc_ring *ring, unsigned int capacity) {
+	ring->capacity = 1;
+	while (ring->capacity < capacity)
+		ring->capacity <<= 1;
+
+	ring->items = (void **) malloc(sizeof(void *) * ring->capacity);
+	ring->tail = 0;
+	ring->head = 0;
+}
+
+/**
+ * Pushes an item to a ring - waits while the ring is full.
+ *
+ * @note
+ * 		Should only be called from the producer.
+ *
+ * @param ring: Pointer to the ring.
+ * @param item: Pointer to the item.
+ */
+void ring_push(struct spsc_ring *ring, void *item) {
+	unsigned int tail = ring->tail, spins = 0;
+
+	while (tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == ring->capacity)
+		_ring_wait(&spins);
+
+	ring->items[tail & (ring->capacity - 1)] = item;
+	__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Pops the oldest item of a ring - waits while the ring is empty.
+ *
+ * @note
+ * 		Should only be called from the consumer.
+ *
+ * @param ring: Pointer to the ring.
+ *
+ * @return
+ * 		Pointer to the item.
+ */
+void *ring_pop(struct spsc_ring *ring) {
+	unsigned int head = ring->head, spins = 0;
+
+	while (__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == head)
+		_ring_wait(&spins);
+
+	void *item = ring->items[head & (ring->capacity - 1)];
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+	return item;
+}
+
+/**
+ * Releases the memory held by a ring.
+ *
+ * @param ring: Pointer to the ring.
+ */
+void ring_free(struct spsc_ring *ring) {
+	free(ring->items);
+	ring->items = NULL;
+}
@@ -0,0 +1,336 @@
+// Implementation of the n-gram scoring. Tables are built by counting every n-gram in a
+// corpus of English text - a short sample is built in, a larger corpus gives better
+// statistics and can be supplied instead. Tables built from a large corpus are best
+// saved to a file once (see `encryptor_ngrams`), and mapped from it afterwards.
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "scoring.h"
+
+#define true 1
+#define false 0
+
+// Added to the count of every n-gram, so that n-grams missing from the corpus are
+// unlikely rather than impossible.
+#define NGRAM_FLOOR 0.01
+
+// A sample of plain English prose, used when no corpus is supplied.
+const char SCORING_SAMPLE[] =
+	"The morning was cold and clear when the old keeper walked down to the harbour. "
+	"He had done the same thing every day for more than forty years, and there was very "
+	"little about the water that he did not know. He could tell from the colour of the "
+	"sky whether the boats would go out, and from the sound of the wind whether they would "
+	"come back before night. The younger men laughed at him for it, but they always asked "
+	"him before they left, and they always listened to what he said.\n"
+	"On that particular morning there was a letter waiting for him at the end of the pier. "
+	"It had been left under a stone so that it would not blow away, and the paper was "
+	"damp from the spray. The writing on the front was small and careful, and it was not "
+	"a hand that he recognised. He turned it over several times before he opened it, "
+	"because letters did not often come to him, and when they did they were rarely good "
+	"news. Inside there was a single sheet covered in rows of letters that made no sense "
+	"at all. There were no spaces between the words, if they were words, and no signature "
+	"at the bottom of the page.\n"
+	"He took the letter home and put it on the kitchen table next to the bread. For the "
+	"rest of the day he thought about it while he mended nets and cleaned the lamp. By the "
+	"evening he had decided that it must be some kind of puzzle, the sort of thing that "
+	"children send to each other when they want to keep a secret from their parents. His "
+	"own daughter had done the same when she was young, writing notes to her friends in a "
+	"code that she was very proud of and that anyone could have broken in a few minutes.\n"
+	"The difference was that this one did not break so easily. He tried moving every letter "
+	"one step along the alphabet, and then two steps, and then three, but nothing came out "
+	"that looked like language. He tried reading the rows backwards and reading them from "
+	"the bottom of the page to the top. He counted how often each letter appeared and "
+	"found that the common ones were the same as in ordinary writing, which told him that "
+	"the letters themselves had not been changed, only moved around. That was the first "
+	"real clue, and he sat with it for a long time before he saw what it meant.\n"
+	"If the letters had only been moved, then somewhere in the page was the whole of the "
+	"original message, waiting to be put back in the right order. The question was what "
+	"rule had been used to move them. He remembered an old method that sailors used to "
+	"pass the time, where a message was written in a zigzag across several lines and then "
+	"read off one line after another. The number of lines was the key, and without it the "
+	"message looked like nonsense. With it, the message could be read by anyone.\n"
+	"So he began to try different numbers of lines. Two lines gave him nothing useful. "
+	"Three lines gave him a few short words at the start, which made his heart beat faster, "
+	"but they soon fell apart into more nonsense. Four lines was worse. Five lines was "
+	"where it happened. As he wrote out the zigzag and read it back along the diagonal, "
+	"the first sentence appeared on the paper in front of him, clear and plain, as though "
+	"it had been waiting there the whole time for someone to find it.\n"
+	"It was a message from his daughter. She was coming home at the end of the month, and "
+	"she wanted to know if he still remembered the game they used to play. He laughed out "
+	"loud in the empty kitchen, and then he sat down to write a reply in the same way, "
+	"choosing a number of lines that he was sure she would never guess. When he had "
+	"finished, he read it over three times to make certain that every letter was in its "
+	"proper place, and then he folded the paper and put it in his coat.\n"
+	"The next morning he walked down to the harbour as usual. The weather had turned, and "
+	"the clouds were low and grey over the water. He told the men that the boats should "
+	"stay in, and for once nobody argued with him. Then he walked to the end of the pier "
+	"and left his letter under the same stone, where the wind could not take it, and went "
+	"back to his work with the feeling that something good was about to happen.\n"
+	"People often think that keeping a secret is about hiding it well, but the keeper had "
+	"learned that it is just as much about choosing who should be able to find it. A "
+	"message that nobody can read is no better than a message that was never sent. The "
+	"art is in making it easy for one person and hard for everybody else, and that is "
+	"a balance that has been argued about for as long as people have written things down.\n"
+	"There are many ways to strike that balance. Some methods change every letter into a "
+	"different letter according to a table that both sides share. Others leave the letters "
+	"alone and only change their order. The strongest methods of the past combined the two, "
+	"first swapping the letters and then shuffling them, so that neither the counting of "
+	"letters nor the search for patterns would give the answer away. Even those methods "
+	"could be broken with enough patience, and the story of how they were broken is one "
+	"of the most interesting chapters in the history of mathematics.\n"
+	"What makes these methods weak is that ordinary language is full of habits. Some pairs "
+	"of letters are very common and others almost never appear. Certain words turn up in "
+	"nearly every sentence. A careful reader can measure how much a piece of text looks "
+	"like real writing simply by counting these habits, and can then try thousands of "
+	"possible keys, keeping only the ones that produce text with the right shape. A "
+	"machine can do the same thing millions of times faster than any person, which is why "
+	"the old methods are now used only for games and for teaching.\n";
+
+/**
+ * Returns the built-in sample of English text - used to build n-gram tables when no
+ * corpus has been supplied.
+ *
+ * @return
+ * 		Span over the sample - should not be modified.
+ */
+struct span scoring_sample() {
+	return make_span((string) SCORING_SAMPLE, sizeof(SCORING_SAMPLE) - 1);
+}
+
+/**
+ * Builds an n-gram table by counting every n-gram in a corpus.
+ *
+ * @remarks
+ * 		Only alphabets are counted (in any case) - everything else in the corpus is skipped
+ * 		over, such that n-grams span across spaces and punctuation the same way they do in
+ * 		a normalized message.
+ *
+ * @param table: Pointer to the table that is to be populated - to be released using `ngram_free`.
+ * @param n: Unsigned integer containing the length of the n-grams - between 1 and `NGRAM_MAX`.
+ * @param corpus: Span containing the text to be counted.
+ *
+ * @return
+ * 		Boolean indicating if the table could be built - false if the length is not
+ * 		supported or the corpus has no n-grams.
+ */
+bool ngram_build(struct ngram_table *table, unsigned int n, struct span corpus) {
+	table->scores = NULL;
+	table->mapping = NULL;
+	table->mapped = 0;
+
+	if (n == 0 || n > NGRAM_MAX)
+		return false;
+
+	unsigned int size = 1;
+	for (unsigned int i = 0; i < n; i++)
+		size *= 26;
+
+	unsigned int *counts = (unsigned int *) calloc(size, sizeof(unsigned int));
+	unsigned long long total = 0;
+
+	unsigned int index = 0, filled = 0;
+	for (unsigned int i = 0; i < corpus.length; i++) {
+		unsigned char c = (unsigned char) corpus.data[i];
+		if (!isalpha(c))
+			continue;
+
+		index = (index * 26 + (tolower(c) - 'a')) % size;
+
+		if (++filled >= n) {
+			counts[index]++;
+			total++;
+		}
+	}
+
+	if (total == 0) {
+		free(counts);
+		return false;
+	}
+
+	short *scores = (short *) malloc(size * sizeof(short));
+
+	for (unsigned int i = 0; i < size; i++) {
+		double probability = (counts[i] + NGRAM_FLOOR) / (double) total;
+		double scaled = log10(probability) * NGRAM_SCALE;
+
+		scores[i] = (short) ((scaled < -32768) ? -32768 : lround(scaled));
+	}
+
+	table->n = n;
+	table->size = size;
+	table->scores = scores;
+
+	free(counts);
+	return true;
+}
+
+/**
+ * Loads an n-gram table from a file written by `ngram_save`.
+ *
+ * @remarks
+ * 		The file is mapped read-only - the scores are read straight from the page cache,
+ * 		shared by every thread (and every process) using the same file. Nothing is parsed
+ * 		or copied, as such loading takes the same time for any size of table.
+ *
+ * @param table: Pointer to the table that is to be populated - to be released using `ngram_free`.
+ * @param n: Unsigned integer containing the length of the n-grams.
+ * @param path: String containing the path of the file.
+ *
+ * @return
+ * 		Boolean indicating if the table could be loaded - false if the file cannot be read,
+ * 		is not a file of n-gram tables, or has no table of that length.
+ */
+bool ngram_load(struct ngram_table *table, unsigned int n, const_str path) {
+	table->scores = NULL;
+	table->mapping = NULL;
+	table->mapped = 0;
+
+	if (n == 0 || n > NGRAM_MAX)
+		return false;
+
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	struct stat details;
+	if (fstat(fd, &details) < 0 || (size_t) details.st_size < sizeof(struct ngram_file)) {
+		close(fd);
+		return false;
+	}
+
+	size_t length = (size_t) details.st_size;
+	void *mapping = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (mapping == MAP_FAILED)
+		return false;
+
+	const struct ngram_file *header = (const struct ngram_file *) mapping;
+
+	unsigned int size = 1;
+	for (unsigned int i = 0; i < n; i++)
+		size *= 26;
+
+	unsigned long long offset = header->offsets[n];
+
+	if (
+		memcmp(header->magic, NGRAM_MAGIC, sizeof(header->magic)) != 0 || header->scale != NGRAM_SCALE ||
+		offset == 0 || offset % NGRAM_ALIGN != 0 || offset > length || length - offset < size * sizeof(short)
+	) {
+		munmap(mapping, length);
+		return false;
+	}
+
+	// The whole table is about to be read at random - fetching it in one go.
+	madvise(mapping, length, MADV_WILLNEED);
+
+	table->n = n;
+	table->size = size;
+	table->scores = (const short *) ((const char *) mapping + offset);
+	table->mapping = mapping;
+	table->mapped = length;
+
+	return true;
+}
+
+/**
+ * Saves n-gram tables to a file, to be loaded using `ngram_load`.
+ *
+ * @param tables: Array of tables - of different lengths.
+ * @param count: Unsigned integer containing the number of tables.
+ * @param path: String containing the path of the file - replaced if it exists.
+ *
+ * @return
+ * 		Boolean indicating if the file could be written.
+ */
+bool ngram_save(const struct ngram_table *tables, unsigned int count, const_str path) {
+	struct ngram_file header;
+	memset(&header, 0, sizeof(header));
+
+	memcpy(header.magic, NGRAM_MAGIC, sizeof(header.magic));
+	header.scale = NGRAM_SCALE;
+
+	// Laying the tables out one after another, each on a cache line.
+	unsigned long long offset = sizeof(header);
+	for (unsigned int i = 0; i < count; i++) {
+		header.offsets[tables[i].n] = offset;
+
+		offset += tables[i].size * sizeof(short);
+		offset = (offset + NGRAM_ALIGN - 1) / NGRAM_ALIGN * NGRAM_ALIGN;
+	}
+
+	FILE *file = fopen(path, "wb");
+	if (file == NULL)
+		return false;
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+
+	for (unsigned int i = 0; i < count && written; i++) {
+		long padding = (long) header.offsets[tables[i].n] - ftell(file);
+		for (long j = 0; j < padding; j++)
+			fputc(0, file);
+
+		written = fwrite(tables[i].scores, sizeof(short), tables[i].size, file) == tables[i].size;
+	}
+
+	return (fclose(file) == 0) && written;
+}
+
+/**
+ * Releases the memory held by an n-gram table - or unmaps the file it was loaded from.
+ *
+ * @param table: Pointer to the table.
+ */
+void ngram_free(struct ngram_table *table) {
+	if (table->mapping != NULL)
+		munmap(table->mapping, table->mapped);
+	else
+		free((void *) table->scores);
+
+	table->scores = NULL;
+	table->mapping = NULL;
+	table->mapped = 0;
+}
+
+/**
+ * Scores a run of text - the sum of the scores of every n-gram in it. The higher (closer
+ * to zero) the score, the more the text looks like the corpus.
+ *
+ * @remarks
+ * 		Expects normalized text (lower-case alphabets) - any other character breaks the run
+ * 		of n-grams, and is skipped over. Scores are only comparable between texts with the
+ * 		same number of n-grams.
+ *
+ * @param table: Pointer to the table to be used.
+ * @param text: Span containing the text to be scored.
+ *
+ * @return
+ * 		Integer containing the score, see `NGRAM_SCALE`.
+ */
+long long ngram_score(const struct ngram_table *table, struct span text) {
+	long long score = 0;
+	unsigned int index = 0, filled = 0;
+
+	for (unsigned int i = 0; i < text.length; i++) {
+		unsigned int c = (unsigned char) text.data[i] - 'a';
+		if (c >= 26) {
+			filled = 0;
+			continue;
+		}
+
+		index = (index * 26 + c) % table->size;
+
+		if (++filled >= table->n)
+			score += table->scores[index];
+	}
+
+	return score;
+}
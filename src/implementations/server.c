@@ -0,0 +1,568 @@
+// Implementation of the daemon mode. The process binds to a unix domain socket and
+// answers framed requests (see `protocol.h`) for as long as it runs - keys are prepared
+// once and remembered (see `engine_cached_key`), or taken from a keyring prepared ahead of
+// time (see `keyring.h`), and any number of clients can be connected at once. A single
+// thread serves every connection using `epoll`.
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "server.h"
+#include "engine.h"
+#include "keyring.h"
+
+#define true 1
+#define false 0
+
+// Number of events fetched from `epoll` at a time.
+#define MAX_EVENTS 64
+
+// Number of characters read from a connection at a time.
+#define READ_CHUNK 65536
+
+// Largest number of requests handled at once (see `handle_frames`).
+#define SV_BATCH 256
+
+// Once this many characters of responses are waiting to be written to a connection, no
+// more requests are read from it until the client catches up.
+#define OUTPUT_HIGH_WATER (64u << 20)
+
+/**
+ * State of a single client connected to the server.
+ */
+struct connection {
+	// File descriptor of the connection.
+	int fd;
+
+	// Characters read from the connection that do not form a complete request yet.
+	struct frame_buffer input;
+
+	// Responses waiting to be written to the connection.
+	struct frame_buffer output;
+
+	// Number of characters at the start of `output` that have already been written.
+	unsigned int output_sent;
+
+	// Events the connection is currently registered for with `epoll`.
+	unsigned int events;
+
+	// Boolean indicating if the client has stopped sending requests - the connection is
+	// closed once the pending responses have been written.
+	bool closing;
+};
+
+// Flag raised by the signal handler to stop the server.
+volatile sig_atomic_t sv_stopping = false;
+
+/**
+ * Signal handler to stop the server gracefully.
+ *
+ * @param signal: The signal received - unused.
+ */
+void sv_stop(int signal) {
+	(void) signal;
+	sv_stopping = true;
+}
+
+/**
+ * Makes sure a frame buffer can hold a number of extra characters, growing it if needed.
+ *
+ * @remarks
+ * 		Will force-stop the program if the memory cannot be allocated.
+ *
+ * @param buffer: Pointer to the buffer that is to be grown.
+ * @param extra: Unsigned integer containing the number of characters to be added to the buffer.
+ */
+void frame_reserve(struct frame_buffer *buffer, unsigned int extra) {
+	if (buffer->length + extra <= buffer->capacity)
+		return;
+
+	unsigned int capacity = (buffer->capacity < 4096) ? 4096 : buffer->capacity * 2;
+	if (capacity < buffer->length + extra)
+		capacity = buffer->length + extra;
+
+	buffer->data = (string) realloc(buffer->data, capacity);
+	if (buffer->data == NULL) {
+		printf("\nError: Ran out of memory while buffering frames\n");
+		exit(-10);
+	}
+
+	buffer->capacity = capacity;
+}
+
+/**
+ * A request being handled along with others (see `handle_frames`).
+ */
+struct sv_slot {
+	struct frame_response response;
+
+	// Offset of the result in the output - the characters reserved for it.
+	unsigned int result;
+
+	// Boolean indicating if the request is to be ciphered - the request is valid so far.
+	bool pending;
+};
+
+/**
+ * Handles a number of requests at once - the responses (header and result) are appended to
+ * the output, in the same order as the requests.
+ *
+ * @remarks
+ * 		The messages are normalized before being ciphered, unless a request says it already
+ * 		has been. Once every request has been checked and its result sized, the messages are
+ * 		ciphered together - all the ones using the same cipher at once (see `engine_run_many`),
+ * 		which is what keeps short requests from being dominated by the cost of setting up
+ * 		a kernel for each of them. The results are written directly into the output buffer.
+ *
+ * @param requests: Array containing the headers of the requests - up to `SV_BATCH`.
+ * @param payloads: Array containing the payload of each request - the key followed by the message.
+ * @param count: Unsigned integer containing the number of requests.
+ * @param output: Pointer to the buffer to which the responses are to be appended.
+ */
+void handle_frames(
+	const struct frame_request *requests, const struct span *payloads, unsigned int count,
+	struct frame_buffer *output
+) {
+	// Buffer holding the normalized messages - reused across calls.
+	static struct frame_buffer scratch;
+
+	// Copies of the prepared keys - the cache only keeps the last one it returned valid.
+	static struct cipher_key keys[SV_BATCH];
+	static struct span messages[SV_BATCH];
+
+	struct sv_slot slots[SV_BATCH];
+
+	// Room for every message at once - the normalized messages stay where they are.
+	unsigned int total = 0;
+	for (unsigned int i = 0; i < count; i++)
+		total += payloads[i].length;
+
+	scratch.length = 0;
+	frame_reserve(&scratch, total);
+
+	unsigned int start = output->length;
+
+	for (unsigned int i = 0; i < count; i++) {
+		const struct frame_request *request = &requests[i];
+		struct sv_slot *slot = &slots[i];
+
+		slot->response = (struct frame_response) {0, FRAME_OK, {0}};
+		slot->pending = false;
+
+		// Reserving space for the header - it is written once the result is known.
+		frame_reserve(output, sizeof(slot->response));
+		output->length += sizeof(slot->response);
+
+		if (request->cipher >= UNDEFINED) {
+			slot->response.status = FRAME_BAD_CIPHER;
+			continue;
+		}
+
+		if (request->key_length > payloads[i].length) {
+			slot->response.status = FRAME_BAD_MESSAGE;
+			continue;
+		}
+
+		struct span key = make_span(payloads[i].data, request->key_length);
+		struct span message = make_span(payloads[i].data + key.length, payloads[i].length - key.length);
+
+		const struct cipher_key *prepared = NULL;
+
+		if (request->flags & FRAME_KEY_ID) {
+			// Prepared ahead of time - only the id is sent.
+			uint32_t id = KEYRING_NONE;
+			if (key.length == sizeof(id))
+				memcpy(&id, key.data, sizeof(id));
+
+			prepared = keyring_find(id);
+			if (prepared != NULL && prepared->cipher != (enum crypt) request->cipher)
+				prepared = NULL;
+		} else {
+			prepared = engine_cached_key((enum crypt) request->cipher, key);
+		}
+
+		bool encrypt = (request->flags & FRAME_ENCRYPT) != 0;
+
+		// A hill key without an inverse can encrypt, but cannot recover a message - the key
+		// is at fault, not the message.
+		bool hill = prepared != NULL &&
+			(prepared->cipher == HILL_CIPHER || prepared->cipher == HILL256 || prepared->cipher == HILL95);
+
+		if (prepared == NULL || (!encrypt && hill && !prepared->schedule.hill.invertible)) {
+			slot->response.status = FRAME_BAD_KEY;
+			continue;
+		}
+
+		keys[i] = *prepared;
+
+		if (!(request->flags & FRAME_NORMALIZED)) {
+			string normalized = scratch.data + scratch.length;
+			message = make_span(normalized, engine_normalize_into(&keys[i], normalized, message));
+			scratch.length += message.length;
+		}
+
+		messages[i] = message;
+
+		unsigned int size = engine_run_into(&keys[i], encrypt, NULL, 0, message);
+
+		if (size == CIPHER_INVALID) {
+			slot->response.status = FRAME_BAD_MESSAGE;
+			continue;
+		} else if (size >= FRAME_MAX_LENGTH) {
+			slot->response.status = FRAME_TOO_LARGE;
+			continue;
+		}
+
+		// Reserving the result right after the header - with space for the string terminator
+		// written by the cipher, which is not a part of the response.
+		frame_reserve(output, size + 1);
+		slot->result = output->length;
+		slot->response.length = size;
+		slot->pending = true;
+
+		output->length += size;
+	}
+
+	// Ciphering the requests - those using the same cipher together.
+	const struct cipher_key *prepared[SV_BATCH];
+	struct cipher_lane lanes[SV_BATCH];
+	unsigned int indices[SV_BATCH];
+
+	for (enum crypt cipher = 0; cipher < UNDEFINED; cipher++) {
+		unsigned int used = 0;
+
+		for (unsigned int i = 0; i < count; i++) {
+			if (!slots[i].pending || keys[i].cipher != cipher)
+				continue;
+
+			prepared[used] = &keys[i];
+			lanes[used].encrypt = (requests[i].flags & FRAME_ENCRYPT) != 0;
+			lanes[used].message = messages[i];
+			lanes[used].dest = output->data + slots[i].result;
+			indices[used++] = i;
+		}
+
+		engine_run_many(prepared, lanes, used);
+
+		for (unsigned int j = 0; j < used; j++) {
+			struct sv_slot *slot = &slots[indices[j]];
+
+			if (lanes[j].length == CIPHER_INVALID) {
+				slot->response.status = FRAME_BAD_MESSAGE;
+				slot->response.length = 0;
+				slot->pending = false;
+			}
+		}
+	}
+
+	// Writing the headers - and closing the gaps left by results that could not be ciphered.
+	unsigned int cursor = start;
+	for (unsigned int i = 0; i < count; i++) {
+		memcpy(output->data + cursor, &slots[i].response, sizeof(slots[i].response));
+		cursor += sizeof(slots[i].response);
+
+		if (!slots[i].pending)
+			continue;
+
+		if (cursor != slots[i].result)
+			memmove(output->data + cursor, output->data + slots[i].result, slots[i].response.length);
+
+		cursor += slots[i].response.length;
+	}
+
+	output->length = cursor;
+}
+
+/**
+ * Handles a single request - the response (header and result) is appended to the output.
+ *
+ * @param request: Pointer to the header of the request.
+ * @param payload: Span containing the key followed by the message.
+ * @param output: Pointer to the buffer to which the response is to be appended.
+ */
+void handle_frame(const struct frame_request *request, struct span payload, struct frame_buffer *output) {
+	handle_frames(request, &payload, 1, output);
+}
+
+/**
+ * Handles every complete request in a buffer of input - up to `SV_BATCH` at once (see
+ * `handle_frames`). The requests handled are removed from the input, leaving the incomplete
+ * request at the end (if any) at its front.
+ *
+ * @param input: Pointer to the buffer holding the characters read so far.
+ * @param output: Pointer to the buffer to which the responses are to be appended.
+ *
+ * @return
+ * 		Boolean indicating if the input can still be trusted - false if a request claims
+ * 		to be larger than `FRAME_MAX_LENGTH`. The requests before it are answered either way.
+ */
+bool handle_buffered(struct frame_buffer *input, struct frame_buffer *output) {
+	struct frame_request requests[SV_BATCH];
+	struct span payloads[SV_BATCH];
+	unsigned int offset = 0, ready = 0;
+	bool broken = false;
+
+	while (input->length - offset >= sizeof(struct frame_request)) {
+		struct frame_request *request = &requests[ready];
+		memcpy(request, input->data + offset, sizeof(*request));
+
+		if (request->length > FRAME_MAX_LENGTH) {
+			broken = true;
+			break;
+		}
+
+		if (input->length - offset - sizeof(*request) < request->length)
+			// Wait for the rest of the request.
+			break;
+
+		payloads[ready++] = make_span(input->data + offset + sizeof(*request), request->length);
+		offset += sizeof(*request) + request->length;
+
+		if (ready == SV_BATCH) {
+			handle_frames(requests, payloads, ready, output);
+			ready = 0;
+		}
+	}
+
+	handle_frames(requests, payloads, ready, output);
+
+	// Moving the incomplete request (if any) to the front of the buffer.
+	memmove(input->data, input->data + offset, input->length - offset);
+	input->length -= offset;
+
+	return !broken;
+}
+
+/**
+ * Internal method to register the events a connection is interested in - reading if it
+ * is not backlogged, and writing if there are responses waiting.
+ *
+ * @param epoll: File descriptor of the `epoll` instance.
+ * @param conn: Pointer to the connection.
+ */
+void sv_update_events(int epoll, struct connection *conn) {
+	unsigned int pending = conn->output.length - conn->output_sent;
+
+	unsigned int events = 0;
+	if (!conn->closing && pending < OUTPUT_HIGH_WATER)
+		events |= EPOLLIN;
+	if (pending > 0)
+		events |= EPOLLOUT;
+
+	if (events == conn->events)
+		return;
+
+	struct epoll_event event = {0};
+	event.events = events;
+	event.data.ptr = conn;
+
+	epoll_ctl(epoll, EPOLL_CTL_MOD, conn->fd, &event);
+	conn->events = events;
+}
+
+/**
+ * Internal method to read requests from a connection, and handle every complete request.
+ *
+ * @param conn: Pointer to the connection.
+ *
+ * @return
+ * 		Boolean indicating if the connection is still usable.
+ */
+bool sv_read(struct connection *conn) {
+	while (conn->output.length - conn->output_sent < OUTPUT_HIGH_WATER) {
+		frame_reserve(&conn->input, READ_CHUNK);
+
+		ssize_t count = read(
+			conn->fd, conn->input.data + conn->input.length, conn->input.capacity - conn->input.length
+		);
+
+		if (count == 0) {
+			// The client is done sending requests.
+			conn->closing = true;
+			return true;
+		} else if (count < 0) {
+			return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+		}
+
+		conn->input.length += count;
+
+		if (!handle_buffered(&conn->input, &conn->output))
+			// The stream cannot be trusted anymore - dropping the client.
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Internal method to write pending responses to a connection.
+ *
+ * @param conn: Pointer to the connection.
+ *
+ * @return
+ * 		Boolean indicating if the connection is still usable.
+ */
+bool sv_flush(struct connection *conn) {
+	while (conn->output_sent < conn->output.length) {
+		ssize_t count = write(
+			conn->fd, conn->output.data + conn->output_sent, conn->output.length - conn->output_sent
+		);
+
+		if (count < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			else if (errno == EINTR)
+				continue;
+
+			return false;
+		}
+
+		conn->output_sent += count;
+	}
+
+	if (conn->output_sent == conn->output.length) {
+		// Everything has been written - starting afresh.
+		conn->output.length = 0;
+		conn->output_sent = 0;
+	}
+
+	return !(conn->closing && conn->output.length == 0);
+}
+
+/**
+ * Internal method to close a connection and release everything it holds.
+ *
+ * @param epoll: File descriptor of the `epoll` instance.
+ * @param conn: Pointer to the connection.
+ */
+void sv_close(int epoll, struct connection *conn) {
+	epoll_ctl(epoll, EPOLL_CTL_DEL, conn->fd, NULL);
+	close(conn->fd);
+
+	free(conn->input.data);
+	free(conn->output.data);
+	free(conn);
+}
+
+/**
+ * Internal method to accept every pending connection on the socket.
+ *
+ * @param epoll: File descriptor of the `epoll` instance.
+ * @param listener: File descriptor of the socket.
+ */
+void sv_accept(int epoll, int listener) {
+	while (true) {
+		int fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0)
+			return;
+
+		struct connection *conn = (struct connection *) calloc(1, sizeof(struct connection));
+		conn->fd = fd;
+		conn->events = EPOLLIN;
+
+		struct epoll_event event = {0};
+		event.events = EPOLLIN;
+		event.data.ptr = conn;
+
+		if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+			close(fd);
+			free(conn);
+		}
+	}
+}
+
+/**
+ * Runs the program in daemon mode - listens for requests on a unix domain socket until
+ * the process is interrupted (SIGINT/SIGTERM).
+ *
+ * @remarks
+ * 		Any existing file at the path of the socket is replaced, and the socket is removed
+ * 		once the server stops.
+ *
+ * @param socket_path: Span containing the path at which the socket is to be created.
+ *
+ * @return
+ * 		Integer containing the exit code for the program.
+ */
+int serve(struct span socket_path) {
+	struct sockaddr_un address = {0};
+	address.sun_family = AF_UNIX;
+
+	if (socket_path.length == 0 || socket_path.length >= sizeof(address.sun_path)) {
+		printf("\nError: Invalid socket path `%.*s`\n", socket_path.length, socket_path.data);
+		return -10;
+	}
+
+	memcpy(address.sun_path, socket_path.data, socket_path.length);
+
+	int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	unlink(address.sun_path);
+
+	if (
+		listener < 0 ||
+		bind(listener, (struct sockaddr *) &address, sizeof(address)) < 0 ||
+		listen(listener, SOMAXCONN) < 0
+	) {
+		printf("\nError: Could not listen on `%s` - %s\n", address.sun_path, strerror(errno));
+		return -10;
+	}
+
+	int epoll = epoll_create1(EPOLL_CLOEXEC);
+
+	struct epoll_event event = {0};
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;        // A null pointer marks the listening socket.
+	epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+
+	// Stopping gracefully on an interrupt, and surviving clients that go away mid-write.
+	struct sigaction action = {0};
+	action.sa_handler = sv_stop;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	printf("\nListening on `%s`\n", address.sun_path);
+	fflush(stdout);
+
+	struct epoll_event events[MAX_EVENTS];
+	while (!sv_stopping) {
+		int count = epoll_wait(epoll, events, MAX_EVENTS, -1);
+
+		for (int i = 0; i < count; i++) {
+			struct connection *conn = (struct connection *) events[i].data.ptr;
+
+			if (conn == NULL) {
+				sv_accept(epoll, listener);
+				continue;
+			}
+
+			bool alive = true;
+			if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+				alive = sv_read(conn);
+
+			if (alive)
+				alive = sv_flush(conn);
+
+			if (alive)
+				sv_update_events(epoll, conn);
+			else
+				sv_close(epoll, conn);
+		}
+	}
+
+	close(epoll);
+	close(listener);
+	unlink(address.sun_path);
+
+	printf("\nStopped listening on `%s`\n", address.sun_path);
+	return 0;
+}
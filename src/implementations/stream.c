@@ -0,0 +1,321 @@
+// Implementation of the stream mode. Stdin is read a chunk at a time - each chunk is
+// normalized in-place and run through the cipher (see `engine_stream_update`), and the
+// result is written out before the next chunk is read. Memory use does not depend on the
+// size of the input, as such files of any size can be piped through.
+//
+// The byte-oriented ciphers (`hill256`, `hill95`) take the input as-is, as such binary
+// files come out the other end unchanged - other than the padding of the last block.
+//
+// Pipelined (`--pipeline`), every step runs on a thread of its own - reading, normalizing,
+// ciphering and writing - passing chunks along rings (see `ring.h`), so that a chunk is
+// ciphered while the next one is read and normalized, and the one before it is written.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "stream.h"
+#include "ring.h"
+
+#define true 1
+#define false 0
+
+// Number of characters read from stdin at once.
+#define STREAM_CHUNK (64u << 10)
+
+// Number of chunks making their way through the pipeline at once - a reader that has all of
+// them in flight waits for the writer to hand one back.
+#define STREAM_CHUNKS 8
+
+/**
+ * A chunk of the input on its way through the pipeline.
+ */
+struct stream_chunk {
+	// The characters read - normalized in-place - and their number, before and after being
+	// normalized.
+	string input;
+	unsigned int length;
+	unsigned int normalized;
+
+	// The result, and its length.
+	string output;
+	unsigned int written;
+
+	// Position of the chunk in the input.
+	unsigned long long offset;
+
+	// Boolean indicating if this is the end of the input - it holds nothing, and the rest of
+	// the result (see `engine_stream_finish`) is written along with it.
+	bool last;
+};
+
+/**
+ * State shared by the steps of the pipeline - each ring connects one step to the next, and
+ * `free` takes the chunks written back to the reader.
+ */
+struct stream_pipeline {
+	struct engine_stream stream;
+	const struct cipher_key *prepared;
+
+	struct spsc_ring free;
+	struct spsc_ring read;
+	struct spsc_ring normalized;
+	struct spsc_ring ciphered;
+
+	// Boolean indicating if the input could not be ciphered - set by the cipher, the reader
+	// stops reading once it sees it.
+	bool failed;
+};
+
+/**
+ * Internal method to start a stream - reports the ciphers that cannot be streamed.
+ *
+ * @return
+ * 		Boolean indicating if the stream could be started.
+ */
+bool _stream_start(struct engine_stream *stream, const struct cipher_key *prepared, bool encrypt) {
+	if (engine_stream_init(stream, prepared, encrypt))
+		return true;
+
+	// Only railfence can be blocked - autokey always needs the complete message.
+	fprintf(
+		stderr, "\nError: This cipher needs the complete message - it cannot be streamed%s\n",
+		(prepared->cipher == RAILFENCE) ? " (see `--rf-block`)" : ""
+	);
+
+	return false;
+}
+
+/**
+ * Runs the program in stream mode - ciphers stdin as a single message, writing the result
+ * to stdout.
+ *
+ * @remarks
+ * 		Only ciphers that work within their own blocks can be streamed - railfence needs the
+ * 		complete message, unless it is blocked. Errors are reported on stderr, stdout being
+ * 		the result.
+ *
+ * @param prepared: Pointer to the prepared key.
+ * @param encrypt: Boolean indicating if the input is to be encrypted (or decrypted).
+ *
+ * @return
+ * 		Integer containing the exit code for the program.
+ */
+int stream_run(const struct cipher_key *prepared, bool encrypt) {
+	struct engine_stream stream;
+	if (!_stream_start(&stream, prepared, encrypt))
+		return -10;
+
+	string input = (string) malloc(STREAM_CHUNK);
+	string output = (string) malloc(STREAM_CHUNK + engine_block_size(prepared) + 1);
+
+	unsigned long long offset = 0;
+	size_t length;
+	bool failed = false;
+
+	while (!failed && (length = fread(input, sizeof(char), STREAM_CHUNK, stdin)) > 0) {
+		// Normalizing in-place - the result never grows.
+		unsigned int normalized = engine_normalize_into(prepared, input, make_span(input, (unsigned int) length));
+		unsigned int written = engine_stream_update(&stream, output, make_span(input, normalized));
+
+		if (written == CIPHER_INVALID) {
+			fprintf(stderr, "\nError: The input cannot be ciphered with the key provided (near byte %llu)\n", offset);
+			failed = true;
+			break;
+		}
+
+		fwrite(output, sizeof(char), written, stdout);
+		offset += length;
+	}
+
+	// Ending the stream either way - the block held back is released along with it.
+	unsigned int written = engine_stream_finish(&stream, output);
+
+	if (!failed) {
+		if (written == CIPHER_INVALID) {
+			fprintf(stderr, "\nError: The end of the input cannot be ciphered with the key provided\n");
+			failed = true;
+		} else {
+			fwrite(output, sizeof(char), written, stdout);
+		}
+	}
+
+	fflush(stdout);
+
+	free(input);
+	free(output);
+
+	return failed ? -10 : 0;
+}
+
+/**
+ * Internal method running the normalizing step of the pipeline.
+ *
+ * @param argument: Pointer to the pipeline.
+ */
+void *_stream_normalize(void *argument) {
+	struct stream_pipeline *pipeline = (struct stream_pipeline *) argument;
+
+	while (true) {
+		struct stream_chunk *chunk = (struct stream_chunk *) ring_pop(&pipeline->read);
+
+		// Normalizing in-place - the result never grows.
+		if (!chunk->last)
+			chunk->normalized = engine_normalize_into(
+				pipeline->prepared, chunk->input, make_span(chunk->input, chunk->length)
+			);
+
+		ring_push(&pipeline->normalized, chunk);
+
+		if (chunk->last)
+			return NULL;
+	}
+}
+
+/**
+ * Internal method running the ciphering step of the pipeline - the only one touching the
+ * stream.
+ *
+ * @param argument: Pointer to the pipeline.
+ */
+void *_stream_cipher(void *argument) {
+	struct stream_pipeline *pipeline = (struct stream_pipeline *) argument;
+	bool failed = false;
+
+	while (true) {
+		struct stream_chunk *chunk = (struct stream_chunk *) ring_pop(&pipeline->normalized);
+
+		// Once the input cannot be ciphered, the chunks still on their way are handed back
+		// empty - the stream is ended either way, the block held back is released along with it.
+		if (chunk->last)
+			chunk->written = engine_stream_finish(&pipeline->stream, chunk->output);
+		else if (!failed)
+			chunk->written = engine_stream_update(&pipeline->stream, chunk->output, make_span(chunk->input, chunk->normalized));
+		else
+			chunk->written = 0;
+
+		if (chunk->written == CIPHER_INVALID && !failed) {
+			if (chunk->last)
+				fprintf(stderr, "\nError: The end of the input cannot be ciphered with the key provided\n");
+			else
+				fprintf(
+					stderr, "\nError: The input cannot be ciphered with the key provided (near byte %llu)\n",
+					chunk->offset
+				);
+
+			failed = true;
+			__atomic_store_n(&pipeline->failed, true, __ATOMIC_RELAXED);
+		}
+
+		if (failed)
+			chunk->written = 0;
+
+		ring_push(&pipeline->ciphered, chunk);
+
+		if (chunk->last)
+			return NULL;
+	}
+}
+
+/**
+ * Internal method running the writing step of the pipeline.
+ *
+ * @param argument: Pointer to the pipeline.
+ */
+void *_stream_write(void *argument) {
+	struct stream_pipeline *pipeline = (struct stream_pipeline *) argument;
+
+	while (true) {
+		struct stream_chunk *chunk = (struct stream_chunk *) ring_pop(&pipeline->ciphered);
+		fwrite(chunk->output, sizeof(char), chunk->written, stdout);
+
+		if (chunk->last) {
+			fflush(stdout);
+			return NULL;
+		}
+
+		// Handing the chunk back to the reader.
+		ring_push(&pipeline->free, chunk);
+	}
+}
+
+/**
+ * Runs the program in stream mode, with every step on a thread of its own - gives the same
+ * result as `stream_run`.
+ *
+ * @remarks
+ * 		The reader runs on the calling thread, the other steps on threads started here. At
+ * 		most `STREAM_CHUNKS` chunks are held at once - memory use does not depend on the size
+ * 		of the input either. Errors are reported on stderr, stdout being the result.
+ *
+ * @param prepared: Pointer to the prepared key.
+ * @param encrypt: Boolean indicating if the input is to be encrypted (or decrypted).
+ *
+ * @return
+ * 		Integer containing the exit code for the program.
+ */
+int stream_run_pipelined(const struct cipher_key *prepared, bool encrypt) {
+	struct stream_pipeline pipeline;
+	if (!_stream_start(&pipeline.stream, prepared, encrypt))
+		return -10;
+
+	pipeline.prepared = prepared;
+	pipeline.failed = false;
+
+	ring_init(&pipeline.free, STREAM_CHUNKS);
+	ring_init(&pipeline.read, STREAM_CHUNKS);
+	ring_init(&pipeline.normalized, STREAM_CHUNKS);
+	ring_init(&pipeline.ciphered, STREAM_CHUNKS);
+
+	struct stream_chunk chunks[STREAM_CHUNKS];
+
+	for (unsigned int i = 0; i < STREAM_CHUNKS; i++) {
+		chunks[i].input = (string) malloc(STREAM_CHUNK);
+		chunks[i].output = (string) malloc(STREAM_CHUNK + engine_block_size(prepared) + 1);
+		ring_push(&pipeline.free, &chunks[i]);
+	}
+
+	void *(*steps[])(void *) = { _stream_normalize, _stream_cipher, _stream_write };
+	pthread_t threads[sizeof(steps) / sizeof(steps[0])];
+
+	for (unsigned int i = 0; i < sizeof(steps) / sizeof(steps[0]); i++)
+		if (pthread_create(&threads[i], NULL, steps[i], &pipeline) != 0) {
+			fprintf(stderr, "\nError: Could not start the threads of the pipeline\n");
+			exit(-10);
+		}
+
+	unsigned long long offset = 0;
+
+	while (true) {
+		struct stream_chunk *chunk = (struct stream_chunk *) ring_pop(&pipeline.free);
+
+		size_t length = 0;
+		if (!__atomic_load_n(&pipeline.failed, __ATOMIC_RELAXED))
+			length = fread(chunk->input, sizeof(char), STREAM_CHUNK, stdin);
+
+		chunk->length = (unsigned int) length;
+		chunk->offset = offset;
+		chunk->last = length == 0;
+		offset += length;
+
+		ring_push(&pipeline.read, chunk);
+
+		if (chunk->last)
+			break;
+	}
+
+	for (unsigned int i = 0; i < sizeof(steps) / sizeof(steps[0]); i++)
+		pthread_join(threads[i], NULL);
+
+	for (unsigned int i = 0; i < STREAM_CHUNKS; i++) {
+		free(chunks[i].input);
+		free(chunks[i].output);
+	}
+
+	ring_free(&pipeline.free);
+	ring_free(&pipeline.read);
+	ring_free(&pipeline.normalized);
+	ring_free(&pipeline.ciphered);
+
+	return pipeline.failed ? -10 : 0;
+}
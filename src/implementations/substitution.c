@@ -0,0 +1,375 @@
+/**
+ * Source file defining the (monoalphabetic) substitution ciphers - Caesar, ROT13, Atbash,
+ * affine and keyword. These ciphers support lower-case alphabets only. Space and/or any
+ * other character needs to be stripped out of the contents before-hand.
+ *
+ * Each of them replaces every letter with another one, the same one everywhere in the
+ * message - they only differ in how the table of replacements is formed from the key:
+ *  Caesar shifts every letter by the key (a number, or the letter `a` is shifted to);
+ *  ROT13 is Caesar with a shift of 13, and Atbash runs the alphabet backwards - neither
+ *  takes a key;
+ *  affine maps `x` to `a * x + b` - the key holds both numbers, separated by a space;
+ *  keyword writes out the (unique) letters of the key, followed by the rest of the alphabet.
+ *
+ * Past the key, all of them run through the same kernel - a lookup in the table, 16 letters
+ * at a time with a byte-shuffle where the processor has one, and 32 (AVX2) or 64 (AVX-512)
+ * letters at a time with the wider shuffles.
+ */
+
+#include <ctype.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "commons.h"
+#include "ciphers.h"
+
+// The number of alphabets.
+#define BASE_MOD 26
+
+// Number of entries a single shuffle looks up from - the table is split into two halves of
+// this size.
+#define SB_HALF 16
+
+// A vector holding `SB_HALF` consecutive characters - signed, since the lanes are picked out
+// by their sign bits (see `_sb_step`).
+typedef signed char sb_lanes __attribute__((vector_size(SB_HALF)));
+
+/**
+ * Internal method to read a number off the start of a span.
+ *
+ * @param key: Span containing the key.
+ * @param cursor: Pointer to the position the number starts at - moved past the number, and
+ * 		the spaces after it.
+ * @param value: Pointer to the number read, modulo 26.
+ *
+ * @return
+ * 		Boolean indicating if a number could be read.
+ */
+bool _sb_read_number(struct span key, unsigned int *cursor, unsigned int *value) {
+	unsigned int start = *cursor;
+
+	*value = 0;
+	while (*cursor < key.length && key.data[*cursor] >= '0' && key.data[*cursor] <= '9')
+		*value = (*value * 10 + (unsigned int) (key.data[(*cursor)++] - '0')) % BASE_MOD;
+
+	if (*cursor == start)
+		return false;
+
+	while (*cursor < key.length && key.data[*cursor] == ' ')
+		(*cursor)++;
+
+	return true;
+}
+
+/**
+ * Prepares a key for one of the substitution ciphers.
+ *
+ * @remarks
+ * 		The table for encryption is formed from the key, and the one for decryption by
+ * 		inverting it - a table that does not use every letter (an affine key with a factor
+ * 		sharing a divisor with 26) cannot be inverted, and is rejected.
+ *
+ * @param schedule: Pointer to the schedule that is to be populated.
+ * @param key: Span containing the key - normalized for keyword, as entered by the user for
+ * 		the rest (unused with ROT13 and Atbash).
+ * @param cipher: The cipher the key is for - `CAESAR`, `ROT13`, `ATBASH`, `AFFINE` or `KEYWORD`.
+ *
+ * @return
+ * 		Boolean indicating if the key could be prepared.
+ */
+bool sb_prepare(struct sb_schedule *schedule, struct span key, enum crypt cipher) {
+	unsigned int factor = 1, shift = 0, cursor = 0;
+
+	memset(schedule->forward, 'a', SB_TABLE);
+	memset(schedule->inverse, 'a', SB_TABLE);
+
+	if (cipher == CAESAR) {
+		if (key.length == 1 && isalpha((unsigned char) key.data[0]))
+			shift = (unsigned int) (tolower((unsigned char) key.data[0]) - 'a');
+		else if (!_sb_read_number(key, &cursor, &shift) || cursor != key.length)
+			return false;
+	} else if (cipher == ROT13) {
+		shift = BASE_MOD / 2;
+	} else if (cipher == ATBASH) {
+		factor = BASE_MOD - 1;
+		shift = BASE_MOD - 1;
+	} else if (cipher == AFFINE) {
+		if (!_sb_read_number(key, &cursor, &factor) || !_sb_read_number(key, &cursor, &shift) || cursor != key.length)
+			return false;
+	}
+
+	if (cipher == KEYWORD) {
+		// The letters of the key (each one the first time it is seen), then the rest.
+		bool used[BASE_MOD] = {false};
+		unsigned int count = 0;
+
+		for (unsigned int i = 0; i < key.length + BASE_MOD; i++) {
+			unsigned int letter = (i < key.length) ? (unsigned int) (unsigned char) key.data[i] - 'a' : i - key.length;
+			if (letter >= BASE_MOD)
+				return false;
+
+			if (!used[letter]) {
+				used[letter] = true;
+				schedule->forward[count++] = (char) ('a' + letter);
+			}
+		}
+	} else {
+		for (unsigned int x = 0; x < BASE_MOD; x++)
+			schedule->forward[x] = (char) ('a' + (factor * x + shift) % BASE_MOD);
+	}
+
+	// Inverting the table - every letter should be used exactly once.
+	bool seen[BASE_MOD] = {false};
+
+	for (unsigned int x = 0; x < BASE_MOD; x++) {
+		unsigned int letter = (unsigned int) (schedule->forward[x] - 'a');
+		if (seen[letter])
+			return false;
+
+		seen[letter] = true;
+		schedule->inverse[letter] = (char) ('a' + x);
+	}
+
+	return true;
+}
+
+/**
+ * Internal method to look up a vector of letters in a table.
+ *
+ * @remarks
+ * 		A shuffle looks up 16 entries, with the low bits of each lane - both halves of the
+ * 		table are looked up, and the lanes holding letters past `p` (picked out by the sign of
+ * 		`15 - x`) take the result from the second one.
+ *
+ * @param text: Pointer to the vector holding the letters - replaced in-place.
+ * @param low: Pointer to the vector holding the first half of the table.
+ * @param high: Pointer to the vector holding the second half of the table.
+ * @param invalid: Pointer to a vector collecting the lanes holding anything other than a
+ * 		lower-case alphabet - in their sign bits.
+ */
+static inline __attribute__((always_inline)) void _sb_step(
+	sb_lanes *text, const sb_lanes *low, const sb_lanes *high, sb_lanes *invalid
+) {
+	sb_lanes letter = *text - 'a';
+	*invalid |= letter | ((BASE_MOD - 1) - letter);
+
+	sb_lanes upper = ((SB_HALF - 1) - letter) >> 7;
+	*text = (__builtin_shuffle(*low, letter) & ~upper) | (__builtin_shuffle(*high, letter) & upper);
+}
+
+/**
+ * Internal method to run a table over a run of letters - with byte-shuffles, for processors
+ * that have them.
+ *
+ * @note
+ * 		The destination can be the same buffer as the text.
+ *
+ * @return
+ * 		Boolean indicating if the text could be ciphered - false if it contains anything
+ * 		other than lower-case alphabets.
+ */
+static inline __attribute__((always_inline)) bool _sb_run_shuffle(
+	const char *table, string dest, const char *text, unsigned int length
+) {
+	sb_lanes low, high, value, invalid = {0};
+	memcpy(&low, table, SB_HALF);
+	memcpy(&high, table + SB_HALF, SB_HALF);
+
+	unsigned int i = 0;
+	for (; i + SB_HALF <= length; i += SB_HALF) {
+		memcpy(&value, text + i, SB_HALF);
+
+		_sb_step(&value, &low, &high, &invalid);
+		memcpy(dest + i, &value, SB_HALF);
+	}
+
+	if (i < length) {
+		char buffer[SB_HALF];
+		memset(buffer, 'a', SB_HALF);
+		memcpy(buffer, text + i, length - i);
+
+		memcpy(&value, buffer, SB_HALF);
+		_sb_step(&value, &low, &high, &invalid);
+		memcpy(dest + i, &value, length - i);
+	}
+
+	unsigned long long words[SB_HALF / sizeof(unsigned long long)];
+	memcpy(words, &invalid, SB_HALF);
+
+	return ((words[0] | words[1]) & 0x8080808080808080ULL) == 0;
+}
+
+/**
+ * The kernels running a table over a run of letters - a lookup a letter at a time for
+ * processors without a byte-shuffle (SSE2 has none), and wider shuffles for the processors
+ * that have them.
+ */
+bool _sb_run_generic(const char *table, string dest, const char *text, unsigned int length) {
+	unsigned int invalid = 0;
+
+	for (unsigned int i = 0; i < length; i++) {
+		unsigned int letter = (unsigned int) (unsigned char) text[i] - 'a';
+
+		invalid |= letter >= BASE_MOD;
+		dest[i] = table[letter % SB_TABLE];
+	}
+
+	return invalid == 0;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * The AVX2 kernel - 32 letters at a time. The wide shuffles only look up within each 128-bit
+ * lane, as such each half of the table is repeated in both lanes. What is left past the last
+ * full vector runs through `_sb_run_shuffle`.
+ */
+__attribute__((target("avx2"))) bool _sb_run_avx2(const char *table, string dest, const char *text, unsigned int length) {
+	__m256i low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) table));
+	__m256i high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) (table + SB_HALF)));
+	__m256i invalid = _mm256_setzero_si256();
+
+	unsigned int i = 0;
+	for (; i + 2 * SB_HALF <= length; i += 2 * SB_HALF) {
+		__m256i letter = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i *) (text + i)), _mm256_set1_epi8('a'));
+		invalid = _mm256_or_si256(invalid, _mm256_or_si256(letter, _mm256_sub_epi8(_mm256_set1_epi8(BASE_MOD - 1), letter)));
+
+		// Letters past `p` take the result from the second half.
+		__m256i upper = _mm256_cmpgt_epi8(letter, _mm256_set1_epi8(SB_HALF - 1));
+		__m256i value = _mm256_blendv_epi8(_mm256_shuffle_epi8(low, letter), _mm256_shuffle_epi8(high, letter), upper);
+
+		_mm256_storeu_si256((__m256i *) (dest + i), value);
+	}
+
+	return _mm256_movemask_epi8(invalid) == 0 && _sb_run_shuffle(table, dest + i, text + i, length - i);
+}
+
+/**
+ * The AVX-512 kernel - 64 letters at a time, with the halves of the table repeated in all four
+ * lanes. Byte shuffles and masks need the byte and word instructions (AVX512BW).
+ */
+__attribute__((target("avx512bw"))) bool _sb_run_avx512(const char *table, string dest, const char *text, unsigned int length) {
+	__m512i low = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *) table));
+	__m512i high = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *) (table + SB_HALF)));
+	__mmask64 invalid = 0;
+
+	unsigned int i = 0;
+	for (; i + 4 * SB_HALF <= length; i += 4 * SB_HALF) {
+		__m512i letter = _mm512_sub_epi8(_mm512_loadu_si512((const void *) (text + i)), _mm512_set1_epi8('a'));
+		invalid |= _mm512_cmpgt_epu8_mask(letter, _mm512_set1_epi8(BASE_MOD - 1));
+
+		__mmask64 upper = _mm512_cmpgt_epu8_mask(letter, _mm512_set1_epi8(SB_HALF - 1));
+		__m512i value = _mm512_mask_blend_epi8(upper, _mm512_shuffle_epi8(low, letter), _mm512_shuffle_epi8(high, letter));
+
+		_mm512_storeu_si512((void *) (dest + i), value);
+	}
+
+	return invalid == 0 && _sb_run_shuffle(table, dest + i, text + i, length - i);
+}
+
+#endif
+
+/**
+ * The kernel built for an instruction set.
+ */
+struct sb_kernel {
+	enum isa isa;
+
+	bool (*run)(const char *table, string dest, const char *text, unsigned int length);
+};
+
+// The kernels, best first - the last one runs anywhere.
+const struct sb_kernel sb_kernels[] = {
+#if defined(__x86_64__) || defined(__i386__)
+	{ ISA_AVX512, _sb_run_avx512 },
+	{ ISA_AVX2, _sb_run_avx2 },
+#endif
+	{ ISA_GENERIC, _sb_run_generic }
+};
+
+// The kernel in use - see `sb_select_kernel`.
+const struct sb_kernel *sb_kernel = &sb_kernels[sizeof(sb_kernels) / sizeof(sb_kernels[0]) - 1];
+
+/**
+ * Selects the kernel - the best one needing at most the instruction set given.
+ *
+ * @note
+ * 		Not thread-safe - meant to be called at startup (see `cpu_dispatch`).
+ *
+ * @param isa: The instruction set that can be used.
+ *
+ * @return
+ * 		The instruction set of the kernel selected.
+ */
+enum isa sb_select_kernel(enum isa isa) {
+	unsigned int i = 0;
+	while (sb_kernels[i].isa > isa)
+		i++;
+
+	sb_kernel = &sb_kernels[i];
+	return sb_kernel->isa;
+}
+
+/**
+ * Runs a substitution cipher with a prepared key, writing the result into a buffer owned
+ * by the caller.
+ *
+ * @remarks
+ * 		Does not touch any global state - safe to call from multiple threads sharing the
+ * 		same schedule. A null (or small) destination is left untouched and the size needed
+ * 		is returned. Nothing is padded - the result is as long as the message.
+ *
+ * @param schedule: Pointer to the key prepared using `sb_prepare`.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer in which the result is to be written. Can be the same as the message.
+ * @param dest_cap: Unsigned integer containing the capacity of the buffer, in characters.
+ * @param message: Span containing the message.
+ *
+ * @return
+ * 		Unsigned integer containing the length of the result, or `CIPHER_INVALID` if the
+ * 		message contains anything other than lower-case alphabets.
+ */
+unsigned int sb_run_into(
+	const struct sb_schedule *schedule, bool encrypt, string dest, unsigned int dest_cap, struct span message
+) {
+	if (dest == NULL || dest_cap <= message.length)
+		return message.length;
+
+	const char *table = encrypt ? schedule->forward : schedule->inverse;
+	if (!sb_kernel->run(table, dest, message.data, message.length))
+		return CIPHER_INVALID;
+
+	dest[message.length] = '\0';
+	return message.length;
+}
+
+/**
+ * Runs a substitution cipher over a part of a message using a prepared key - writes the
+ * characters at positions `[begin, end)` of the result that `sb_run_into` would produce.
+ *
+ * @remarks
+ * 		Used to split a large message across threads - calls over disjoint ranges write to
+ * 		disjoint parts of the destination. Nothing is written outside of the range, not even
+ * 		a string terminator. The range can start anywhere.
+ *
+ * @param schedule: Pointer to the key prepared using `sb_prepare`.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer for the complete result - the range is written at its own offsets.
+ * @param message: Span containing the complete message.
+ * @param begin: Unsigned integer containing the first position of the result to be written.
+ * @param end: Unsigned integer containing the position of the result to stop at.
+ *
+ * @return
+ * 		Boolean indicating if the range could be ciphered - false if it contains anything
+ * 		other than lower-case alphabets.
+ */
+bool sb_run_slice(
+	const struct sb_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+) {
+	const char *table = encrypt ? schedule->forward : schedule->inverse;
+	return sb_kernel->run(table, dest + begin, message.data + begin, end - begin);
+}
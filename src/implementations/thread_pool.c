@@ -0,0 +1,350 @@
+// Implementation of the work-stealing thread pool. Each worker owns a double-ended queue
+// (guarded by its own lock - contention is limited to a thief and the owner meeting on
+// the same queue). The owner pushes and pops at the bottom, thieves take from the top -
+// the oldest, and as such largest, parts of the work.
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "thread_pool.h"
+
+#define true 1
+#define false 0
+
+// Initial number of parts a queue can hold - grown as needed.
+#define DEQUE_INITIAL 64
+
+/**
+ * A part of a job, waiting in a queue.
+ */
+struct pool_item {
+	struct pool_job *job;
+	unsigned int begin;
+	unsigned int end;
+};
+
+/**
+ * A queue of parts owned by a single worker - a ring buffer with the top at `head` and the
+ * bottom at `tail`.
+ */
+struct pool_deque {
+	pthread_mutex_t lock;
+
+	struct pool_item *items;
+
+	// Capacity of the ring - always a power of two.
+	unsigned int capacity;
+
+	unsigned long long head;
+	unsigned long long tail;
+};
+
+struct thread_pool {
+	// Number of workers.
+	unsigned int size;
+
+	pthread_t *threads;
+
+	// The queue of each worker.
+	struct pool_deque *deques;
+
+	// Guards the fields below - and is used to put idle workers to sleep.
+	pthread_mutex_t lock;
+
+	// Signalled when new parts are queued.
+	pthread_cond_t wake;
+
+	// Signalled when every job submitted has finished.
+	pthread_cond_t idle;
+
+	// Number of parts waiting in the queues - read without the lock to avoid sleeping
+	// while there is work left.
+	unsigned int queued;
+
+	// Number of jobs submitted but not finished yet.
+	unsigned int outstanding;
+
+	// Queue that the next job submitted from outside the pool is placed in.
+	unsigned int next;
+
+	bool stopping;
+};
+
+/**
+ * Arguments for a worker thread.
+ */
+struct pool_worker {
+	struct thread_pool *pool;
+	unsigned int index;
+};
+
+/**
+ * Internal method to push a part to the bottom of a queue, and wake a sleeping worker.
+ */
+void pool_push(struct thread_pool *pool, struct pool_deque *deque, struct pool_item item) {
+	pthread_mutex_lock(&deque->lock);
+
+	if (deque->tail - deque->head == deque->capacity) {
+		// Full - doubling the ring, and moving the items to the start of the new one.
+		struct pool_item *items = (struct pool_item *) malloc(sizeof(struct pool_item) * deque->capacity * 2);
+
+		for (unsigned long long i = deque->head; i < deque->tail; i++)
+			items[i - deque->head] = deque->items[i & (deque->capacity - 1)];
+
+		free(deque->items);
+		deque->items = items;
+		deque->tail -= deque->head;
+		deque->head = 0;
+		deque->capacity *= 2;
+	}
+
+	deque->items[deque->tail++ & (deque->capacity - 1)] = item;
+	pthread_mutex_unlock(&deque->lock);
+
+	__atomic_add_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+
+	pthread_mutex_lock(&pool->lock);
+	pthread_cond_signal(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Internal method to take a part from a queue - from the bottom for the owner, from the
+ * top for a thief.
+ *
+ * @return
+ * 		Boolean indicating if a part was taken.
+ */
+bool pool_take(struct thread_pool *pool, struct pool_deque *deque, bool owner, struct pool_item *item) {
+	pthread_mutex_lock(&deque->lock);
+
+	bool found = deque->head != deque->tail;
+	if (found) {
+		unsigned long long index = owner ? --deque->tail : deque->head++;
+		*item = deque->items[index & (deque->capacity - 1)];
+	}
+
+	pthread_mutex_unlock(&deque->lock);
+
+	if (found)
+		__atomic_sub_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+
+	return found;
+}
+
+/**
+ * Internal method to run a part of a job - splitting it first if it is too large, and
+ * finishing the job if this was the last of its parts.
+ *
+ * @param pool: Pointer to the pool.
+ * @param index: Unsigned integer containing the index of the worker running the part.
+ * @param item: The part to be run.
+ */
+void pool_run(struct thread_pool *pool, unsigned int index, struct pool_item item) {
+	struct pool_job *job = item.job;
+
+	// Splitting off the second half while the part is too large - the halves are left in
+	// the queue of this worker, for it (or a thief) to pick up.
+	while (item.end - item.begin > job->grain) {
+		unsigned int half = ((item.end - item.begin) / 2 / job->align) * job->align;
+		if (half == 0)
+			break;
+
+		__atomic_add_fetch(&job->pending, 1, __ATOMIC_RELAXED);
+
+		struct pool_item rest = {job, item.begin + half, item.end};
+		pool_push(pool, &pool->deques[index], rest);
+
+		item.end = item.begin + half;
+	}
+
+	job->run(job, item.begin, item.end);
+
+	if (__atomic_sub_fetch(&job->pending, 1, __ATOMIC_ACQ_REL) != 0)
+		return;
+
+	// The last part of the job - the job is not to be touched past this point.
+	if (job->finish != NULL)
+		job->finish(job);
+
+	pthread_mutex_lock(&pool->lock);
+	if (--pool->outstanding == 0)
+		pthread_cond_broadcast(&pool->idle);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Internal method to steal a part from the queue of another worker.
+ *
+ * @return
+ * 		Boolean indicating if a part was stolen.
+ */
+bool pool_steal(struct thread_pool *pool, unsigned int index, struct pool_item *item) {
+	for (unsigned int i = 1; i < pool->size; i++)
+		if (pool_take(pool, &pool->deques[(index + i) % pool->size], false, item))
+			return true;
+
+	return false;
+}
+
+/**
+ * Internal method containing the loop run by every worker.
+ *
+ * @param argument: Pointer to the `pool_worker` structure of the worker.
+ */
+void *pool_loop(void *argument) {
+	struct pool_worker *worker = (struct pool_worker *) argument;
+	struct thread_pool *pool = worker->pool;
+	unsigned int index = worker->index;
+
+	free(worker);
+
+	struct pool_item item;
+	while (true) {
+		if (pool_take(pool, &pool->deques[index], true, &item) || pool_steal(pool, index, &item)) {
+			pool_run(pool, index, item);
+			continue;
+		}
+
+		// Nothing left anywhere - sleeping until something is queued.
+		pthread_mutex_lock(&pool->lock);
+
+		while (__atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST) == 0 && !pool->stopping)
+			pthread_cond_wait(&pool->wake, &pool->lock);
+
+		bool stop = pool->stopping && __atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST) == 0;
+		pthread_mutex_unlock(&pool->lock);
+
+		if (stop)
+			return NULL;
+	}
+}
+
+/**
+ * Creates a thread pool.
+ *
+ * @remarks
+ * 		Will force-stop the program if the threads cannot be created.
+ *
+ * @param threads: Unsigned integer containing the number of workers - zero to use one
+ * 		worker for every processor online.
+ *
+ * @return
+ * 		Pointer to the pool - to be destroyed using `pool_destroy`.
+ */
+struct thread_pool *pool_create(unsigned int threads) {
+	if (threads == 0) {
+		long online = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = (online > 0) ? (unsigned int) online : 1;
+	}
+
+	struct thread_pool *pool = (struct thread_pool *) calloc(1, sizeof(struct thread_pool));
+	pool->size = threads;
+	pool->threads = (pthread_t *) malloc(sizeof(pthread_t) * threads);
+	pool->deques = (struct pool_deque *) calloc(threads, sizeof(struct pool_deque));
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	pthread_cond_init(&pool->idle, NULL);
+
+	for (unsigned int i = 0; i < threads; i++) {
+		pthread_mutex_init(&pool->deques[i].lock, NULL);
+		pool->deques[i].capacity = DEQUE_INITIAL;
+		pool->deques[i].items = (struct pool_item *) malloc(sizeof(struct pool_item) * DEQUE_INITIAL);
+	}
+
+	for (unsigned int i = 0; i < threads; i++) {
+		struct pool_worker *worker = (struct pool_worker *) malloc(sizeof(struct pool_worker));
+		worker->pool = pool;
+		worker->index = i;
+
+		if (pthread_create(&pool->threads[i], NULL, pool_loop, worker) != 0) {
+			printf("\nError: Could not start worker threads\n");
+			exit(-10);
+		}
+	}
+
+	return pool;
+}
+
+/**
+ * Returns the number of workers in a pool.
+ */
+unsigned int pool_size(const struct thread_pool *pool) {
+	return pool->size;
+}
+
+/**
+ * Submits a job to the pool - the job runs in the background, and its `finish` callback
+ * is called once it is done.
+ *
+ * @note
+ * 		The job should stay valid until it has finished.
+ *
+ * @param pool: Pointer to the pool.
+ * @param job: Pointer to the job.
+ */
+void pool_submit(struct thread_pool *pool, struct pool_job *job) {
+	if (job->align == 0)
+		job->align = 1;
+	if (job->grain < job->align)
+		job->grain = job->align;
+
+	job->pending = 1;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->outstanding++;
+	unsigned int index = pool->next++ % pool->size;
+	pthread_mutex_unlock(&pool->lock);
+
+	struct pool_item item = {job, 0, job->length};
+	pool_push(pool, &pool->deques[index], item);
+}
+
+/**
+ * Waits until every job submitted to the pool has finished.
+ *
+ * @param pool: Pointer to the pool.
+ */
+void pool_wait(struct thread_pool *pool) {
+	pthread_mutex_lock(&pool->lock);
+
+	while (pool->outstanding != 0)
+		pthread_cond_wait(&pool->idle, &pool->lock);
+
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Stops the workers once every job submitted has finished, and destroys the pool.
+ *
+ * @param pool: Pointer to the pool.
+ */
+void pool_destroy(struct thread_pool *pool) {
+	pool_wait(pool);
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stopping = true;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (unsigned int i = 0; i < pool->size; i++) {
+		pthread_join(pool->threads[i], NULL);
+
+		pthread_mutex_destroy(&pool->deques[i].lock);
+		free(pool->deques[i].items);
+	}
+
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->wake);
+	pthread_cond_destroy(&pool->idle);
+
+	free(pool->deques);
+	free(pool->threads);
+	free(pool);
+}
@@ -0,0 +1,236 @@
+/**
+ * Source file defining the permutation shared by the transposition ciphers - railfence,
+ * columnar and double transposition. Each of them writes the message row after row into a
+ * matrix, and reads it back lane after lane in an order of its own (see `tp_layout`).
+ *
+ * Walking down a column of a large matrix touches a new cache line for every character,
+ * and every column walks over the whole message once more - instead, the matrix is moved a
+ * tile of rows at a time, small enough to stay in the cache while every lane takes its
+ * part of it.
+ */
+
+#include "commons.h"
+#include "ciphers.h"
+
+// Number of characters of the matrix in a tile - small enough to stay in the (L1) cache
+// along with what the lanes write.
+#define TP_TILE 16384
+
+// Most lanes moved a tile at a time - a range over more lanes is walked one lane after
+// the other.
+#define TP_TILE_LANES 256
+
+/**
+ * A lane taking part in a tiled move - its columns, and the position of its first
+ * character in the cipher.
+ */
+struct tp_lane {
+	unsigned long long first;
+	unsigned long long second;
+	unsigned long long offset;
+};
+
+/**
+ * Internal method to count the characters of a lane.
+ *
+ * @param first: The first column of the lane.
+ * @param second: The second column of the lane - `TP_NONE` if it has one column.
+ * @param full: Number of complete rows of the matrix.
+ * @param rest: Number of characters on the last (short) row of the matrix.
+ *
+ * @return
+ * 		Unsigned integer containing the number of characters on the lane.
+ */
+static inline unsigned long long _tp_lane_length(
+	unsigned long long first, unsigned long long second, unsigned long long full, unsigned long long rest
+) {
+	unsigned long long length = full + (first < rest);
+	if (second != TP_NONE)
+		length += full + (second < rest);
+
+	return length;
+}
+
+/**
+ * Internal method to move a single character - from the message to the cipher while
+ * encrypting, and back while decrypting.
+ *
+ * @param position: Position of the character in the cipher.
+ * @param index: Position of the character in the message - past the end of a message being
+ * 		encrypted, an `X` is used as padding.
+ */
+static inline void _tp_move(
+	string dest, struct span source, bool encrypt, unsigned long long position, unsigned long long index
+) {
+	if (encrypt)
+		dest[position] = (index < source.length) ? source.data[index] : 'X';
+	else
+		dest[index] = source.data[position];
+}
+
+/**
+ * Internal method to move the part of a lane on a tile of rows.
+ *
+ * @remarks
+ * 		The rows before the tile are all complete - the lane has `(first row) * (columns)`
+ * 		characters before the tile. Only the characters at positions `[begin, end)` of the
+ * 		cipher are moved.
+ */
+static inline void _tp_move_tile(
+	const struct tp_lane *lane, unsigned long long width, string dest, struct span source,
+	unsigned long long total_length, bool encrypt, unsigned long long row_begin, unsigned long long row_end,
+	unsigned long long begin, unsigned long long end
+) {
+	unsigned long long columns = (lane->second == TP_NONE) ? 1 : 2;
+	unsigned long long position = lane->offset + row_begin * columns;
+
+	// Complete rows inside the range (and, while encrypting, inside the message) - moved
+	// without checking each character.
+	bool inside = row_end * width <= total_length && position >= begin && position + (row_end - row_begin) * columns <= end;
+	if (encrypt && row_end * width > source.length)
+		inside = false;
+
+	if (inside && columns == 1) {
+		const char *from = source.data + row_begin * width + lane->first;
+
+		if (encrypt)
+			for (unsigned long long row = row_begin; row < row_end; row++, from += width)
+				dest[position++] = *from;
+		else
+			for (unsigned long long row = row_begin; row < row_end; row++)
+				dest[row * width + lane->first] = source.data[position++];
+
+		return;
+	}
+
+	if (inside) {
+		for (unsigned long long row = row_begin; row < row_end; row++, position += 2) {
+			_tp_move(dest, source, encrypt, position, row * width + lane->first);
+			_tp_move(dest, source, encrypt, position + 1, row * width + lane->second);
+		}
+
+		return;
+	}
+
+	for (unsigned long long row = row_begin; row < row_end && position < end; row++) {
+		for (unsigned long long k = 0; k < columns; k++) {
+			unsigned long long index = row * width + ((k == 0) ? lane->first : lane->second);
+			if (index >= total_length)
+				continue;
+
+			if (position >= begin && position < end)
+				_tp_move(dest, source, encrypt, position, index);
+
+			position++;
+		}
+	}
+}
+
+/**
+ * Moves the characters of a message along a transposition - the position of every character
+ * is calculated from the layout, without building the matrix.
+ *
+ * @remarks
+ * 		Only the characters at positions `[begin, end)` of the cipher are moved - calls over
+ * 		disjoint ranges write to disjoint parts of the destination, as such can run at the
+ * 		same time. A range of `[0, total_length)` moves the whole message.
+ *
+ * 		Unless the matrix is too wide for it, the range is moved a tile of rows at a time -
+ * 		each lane takes its part of the tile while it is in the cache, instead of walking
+ * 		down its columns over the whole message.
+ *
+ * @note
+ * 		The destination cannot overlap with the source.
+ *
+ * @param layout: Pointer to the layout of the transposition.
+ * @param dest: Buffer in which the result is to be written - should hold `total_length` characters.
+ * @param source: Span containing the message - padded with `X` characters up to `total_length`
+ * 		if it is shorter.
+ * @param total_length: Unsigned integer containing the length after padding.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param begin: Unsigned integer containing the first position (in the cipher) to be moved.
+ * @param end: Unsigned integer containing the position (in the cipher) to stop at.
+ */
+void tp_permute(
+	const struct tp_layout *layout, string dest, struct span source, unsigned int total_length, bool encrypt,
+	unsigned int begin, unsigned int end
+) {
+	if (begin >= end)
+		return;
+
+	unsigned long long width = layout->width;
+	unsigned long long full = total_length / width, rest = total_length % width;
+	unsigned long long rows = full + (rest != 0);
+
+	// Finding the lane holding the first character of the range, and where it starts.
+	unsigned long long lane = 0, counter = 0, first = 0, second = TP_NONE;
+
+	for (; lane < layout->lanes; lane++) {
+		layout->columns(layout->context, lane, &first, &second);
+
+		unsigned long long length = _tp_lane_length(first, second, full, rest);
+		if (counter + length > begin)
+			break;
+
+		counter += length;
+	}
+
+	// Collecting the lanes of the range - if there are few enough of them to be tiled.
+	struct tp_lane lanes[TP_TILE_LANES];
+	unsigned int count = 0;
+	unsigned long long offset = counter;
+
+	for (unsigned long long next = lane; next < layout->lanes && offset < end && count < TP_TILE_LANES; next++) {
+		layout->columns(layout->context, next, &lanes[count].first, &lanes[count].second);
+		lanes[count].offset = offset;
+
+		offset += _tp_lane_length(lanes[count].first, lanes[count].second, full, rest);
+		count++;
+	}
+
+	unsigned long long tile = TP_TILE / width;
+
+	if (offset >= end && tile > 1) {
+		// Rows holding the range - all of them, unless the range is within a single lane.
+		unsigned long long row_begin = 0, row_end = rows;
+
+		if (count == 1) {
+			unsigned long long columns = (lanes[0].second == TP_NONE) ? 1 : 2;
+
+			row_begin = (begin - lanes[0].offset) / columns;
+			row_end = (end - lanes[0].offset + columns - 1) / columns;
+			if (row_end > rows)
+				row_end = rows;
+		}
+
+		for (unsigned long long row = row_begin; row < row_end; row += tile) {
+			unsigned long long last = (row + tile < row_end) ? row + tile : row_end;
+
+			for (unsigned int i = 0; i < count; i++)
+				_tp_move_tile(&lanes[i], width, dest, source, total_length, encrypt, row, last, begin, end);
+		}
+
+		return;
+	}
+
+	// Too many lanes (or too wide a matrix) for a tile - walking one lane after the other,
+	// from the character the range starts with.
+	unsigned long long position = begin, skip = begin - counter;
+
+	for (; lane < layout->lanes && position < end; lane++, skip = 0) {
+		layout->columns(layout->context, lane, &first, &second);
+
+		unsigned long long columns = (second == TP_NONE) ? 1 : 2;
+		unsigned long long k = skip % columns;
+
+		for (unsigned long long row = skip / columns; row < rows && position < end; row++, k = 0) {
+			for (; k < columns && position < end; k++) {
+				unsigned long long index = row * width + ((k == 0) ? first : second);
+				if (index >= total_length)
+					continue;
+
+				_tp_move(dest, source, encrypt, position++, index);
+			}
+		}
+	}
+}
@@ -0,0 +1,467 @@
+/**
+ * Source file defining the Vigenère family of ciphers - Vigenère, Beaufort, variant
+ * Beaufort and autokey. These ciphers support lower-case alphabets only. Space and/or
+ * any other character needs to be stripped out of the contents before-hand.
+ *
+ * Every letter of the message is shifted by the letter of the key at the same position:
+ *  Vigenère adds the key, and variant Beaufort subtracts it (each one decrypts the other);
+ *  Beaufort subtracts the message from the key, and is its own inverse;
+ *  autokey adds the key like Vigenère, and once the key runs out, the plaintext itself.
+ *
+ * The periodic ciphers repeat their key every `period` characters - a position of the
+ * message only depends on the same position of the key, as such any part of a message can
+ * be ciphered on its own, given where it starts.
+ */
+
+#include <string.h>
+
+#include "commons.h"
+#include "ciphers.h"
+
+// The number of alphabets - the modulus the shifts work in.
+#define BASE_MOD 26
+
+// A vector holding `VG_LANES` consecutive characters - the arithmetic over these is done
+// with SIMD instructions, where the processor has them. Signed, and without any comparison
+// (see `_vg_step`) - a comparison of vectors wider than the processor has gets split up
+// into single characters by the compiler.
+typedef signed char vg_lanes __attribute__((vector_size(VG_LANES)));
+
+/**
+ * Prepares a key for one of the ciphers of the family.
+ *
+ * @remarks
+ * 		The shifts of the key are stored ready to be added to a letter - decrypting adds the
+ * 		complement of the key (`26 - k`, never zero, which the correction in `_vg_step` takes
+ * 		care of) instead of subtracting it.
+ *
+ * @param schedule: Pointer to the schedule that is to be populated.
+ * @param key: Span containing the (normalized) key - lower-case alphabets only.
+ * @param cipher: The cipher the key is for - `VIGENERE`, `BEAUFORT`, `VARIANT_BEAUFORT` or
+ * 		`AUTOKEY`.
+ *
+ * @return
+ * 		Boolean indicating if the key could be prepared - false if the key is empty, longer
+ * 		than `VG_KEY_MAX`, or contains anything other than lower-case alphabets.
+ */
+bool vg_prepare(struct vg_schedule *schedule, struct span key, enum crypt cipher) {
+	if (key.length == 0 || key.length > VG_KEY_MAX)
+		return false;
+
+	schedule->period = key.length;
+	schedule->autokey = cipher == AUTOKEY;
+	schedule->reflect = (cipher == BEAUFORT) ? 0xFF : 0;
+
+	for (unsigned int i = 0; i < VG_KEY_MAX + VG_LANES; i++) {
+		unsigned int shift = (unsigned char) key.data[i % key.length] - 'a';
+		if (shift >= BASE_MOD)
+			return false;
+
+		if (cipher == BEAUFORT) {
+			// The reflected letter is shifted forward by one more than the key (see `_vg_step`)
+			// - the same both ways.
+			schedule->forward[i] = schedule->inverse[i] = (unsigned char) ((shift + 1) % BASE_MOD);
+		} else {
+			unsigned char add = (unsigned char) shift, subtract = (unsigned char) (BASE_MOD - shift);
+
+			schedule->forward[i] = (cipher == VARIANT_BEAUFORT) ? subtract : add;
+			schedule->inverse[i] = (cipher == VARIANT_BEAUFORT) ? add : subtract;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Internal method to load a vector from memory - any alignment.
+ */
+static inline __attribute__((always_inline)) void _vg_load(vg_lanes *value, const void *source) {
+	memcpy(value, source, VG_LANES);
+}
+
+/**
+ * Internal method to load the first `count` lanes of a vector from memory - the rest of the
+ * lanes are filled with `fill`.
+ */
+static inline __attribute__((always_inline)) void _vg_load_partial(
+	vg_lanes *value, const void *source, unsigned int count, unsigned char fill
+) {
+	unsigned char buffer[VG_LANES] __attribute__((aligned(VG_LANES)));
+	memset(buffer, fill, VG_LANES);
+	memcpy(buffer, source, count);
+
+	_vg_load(value, buffer);
+}
+
+/**
+ * Internal method to shift a vector of letters.
+ *
+ * @remarks
+ * 		The letters are mapped to `[0, 26)` first. Beaufort runs the alphabet backwards - `a`
+ * 		becomes `z` and so on (`25 - x`, computed as `~x + 26` under the mask), after which
+ * 		every cipher is a plain shift forward. The sum is below 52, as such a single correction
+ * 		brings it back into the alphabet, without a division - the lanes past 25 are picked
+ * 		out by the sign of `25 - sum`.
+ *
+ * @param text: Pointer to the vector holding the letters - shifted in-place.
+ * @param shift: Pointer to the vector holding the shift of each lane - in the range `[0, 26]`.
+ * @param reflect: Pointer to the vector holding the mask of the schedule (see `vg_schedule`)
+ * 		in every lane.
+ * @param invalid: Pointer to a vector collecting the lanes holding anything other than a
+ * 		lower-case alphabet - in their sign bits.
+ */
+static inline __attribute__((always_inline)) void _vg_step(
+	vg_lanes *text, const vg_lanes *shift, const vg_lanes *reflect, vg_lanes *invalid
+) {
+	vg_lanes letter = *text - 'a';
+	*invalid |= letter | ((BASE_MOD - 1) - letter);
+
+	vg_lanes value = (letter ^ *reflect) + (*reflect & BASE_MOD) + *shift;
+	*text = value - ((((BASE_MOD - 1) - value) >> 7) & BASE_MOD) + 'a';
+}
+
+/**
+ * Internal method to check if the sign bit of any lane of a vector collected by `_vg_step`
+ * is set.
+ */
+static inline __attribute__((always_inline)) bool _vg_any(const vg_lanes *invalid) {
+	unsigned long long words[VG_LANES / sizeof(unsigned long long)];
+	memcpy(words, invalid, VG_LANES);
+
+	unsigned long long any = 0;
+	for (unsigned int i = 0; i < VG_LANES / sizeof(unsigned long long); i++)
+		any |= words[i];
+
+	return (any & 0x8080808080808080ULL) != 0;
+}
+
+/**
+ * Internal method to shift a run of letters by a run of shifts - both laid out in memory.
+ *
+ * @note
+ * 		`shifts` should have at least `length` entries. The destination can be the same
+ * 		buffer as the text.
+ */
+static inline __attribute__((always_inline)) void _vg_apply(
+	string dest, const char *text, const unsigned char *shifts, unsigned int length, const vg_lanes *reflect,
+	vg_lanes *invalid
+) {
+	vg_lanes value, shift;
+
+	unsigned int i = 0;
+	for (; i + VG_LANES <= length; i += VG_LANES) {
+		_vg_load(&value, text + i);
+		_vg_load(&shift, shifts + i);
+
+		_vg_step(&value, &shift, reflect, invalid);
+		memcpy(dest + i, &value, VG_LANES);
+	}
+
+	if (i < length) {
+		unsigned int count = length - i;
+		_vg_load_partial(&value, text + i, count, 'a');
+		_vg_load_partial(&shift, shifts + i, count, 0);
+
+		_vg_step(&value, &shift, reflect, invalid);
+		memcpy(dest + i, &value, count);
+	}
+}
+
+/**
+ * Internal method to run a periodic cipher over a run of letters.
+ *
+ * @remarks
+ * 		The key is broadcast over the lanes straight from the schedule - its shifts are
+ * 		repeated past the end of the key, as such a full vector of them can be read at any
+ * 		phase. Each vector moves the phase on by `VG_LANES` (modulo the period).
+ *
+ * @param shifts: The shifts of the key (see `vg_schedule`).
+ * @param period: Unsigned integer containing the length of the key.
+ * @param phase: Unsigned integer containing the position of the key the first letter is
+ * 		shifted by - below the period.
+ */
+static inline __attribute__((always_inline)) void _vg_periodic(
+	string dest, const char *text, const unsigned char *shifts, unsigned int period, unsigned int phase,
+	unsigned int length, const vg_lanes *reflect, vg_lanes *invalid
+) {
+	unsigned int step = VG_LANES % period;
+	vg_lanes value, shift;
+
+	unsigned int i = 0;
+	for (; i + VG_LANES <= length; i += VG_LANES) {
+		_vg_load(&value, text + i);
+		_vg_load(&shift, shifts + phase);
+
+		_vg_step(&value, &shift, reflect, invalid);
+		memcpy(dest + i, &value, VG_LANES);
+
+		phase += step;
+		if (phase >= period)
+			phase -= period;
+	}
+
+	if (i < length)
+		_vg_apply(dest + i, text + i, shifts + phase, length - i, reflect, invalid);
+}
+
+/**
+ * Internal method to run the cipher over the range `[begin, end)` of a message - see
+ * `vg_run_slice`.
+ *
+ * @remarks
+ * 		Autokey encrypts every letter past the primer with the letter of the plaintext `period`
+ * 		positions before it - read straight from the message, as such the letters are as
+ * 		independent as with the periodic ciphers. Decrypting needs that letter of the plaintext
+ * 		recovered first - the message is run a key's length (or a vector, if shorter) at a
+ * 		time, each part reading the shifts from the part of the result before it.
+ *
+ * 		A range decrypted with autokey that does not start at the beginning of the message
+ * 		needs the plaintext before it - recovered letter by letter, from the start.
+ *
+ * @note
+ * 		The destination should not overlap with the message for autokey - periodic ciphers
+ * 		can run in-place.
+ */
+static inline __attribute__((always_inline)) bool _vg_run(
+	const struct vg_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+) {
+	const unsigned char *shifts = encrypt ? schedule->forward : schedule->inverse;
+	unsigned int period = schedule->period;
+
+	vg_lanes reflect = (vg_lanes) {0} + (signed char) schedule->reflect;
+	vg_lanes invalid = {0};
+	vg_lanes value, shift;
+
+	if (!schedule->autokey) {
+		_vg_periodic(dest + begin, message.data + begin, shifts, period, begin % period, end - begin, &reflect, &invalid);
+		return !_vg_any(&invalid);
+	}
+
+	if (encrypt) {
+		// The primer, then the plaintext.
+		unsigned int split = (end < period) ? end : period;
+		if (begin < split)
+			_vg_apply(dest + begin, message.data + begin, shifts + begin, split - begin, &reflect, &invalid);
+
+		unsigned int i = (begin > period) ? begin : period;
+		for (; i + VG_LANES <= end; i += VG_LANES) {
+			_vg_load(&value, message.data + i);
+			_vg_load(&shift, message.data + i - period);
+			shift -= 'a';
+
+			_vg_step(&value, &shift, &reflect, &invalid);
+			memcpy(dest + i, &value, VG_LANES);
+		}
+
+		if (i < end) {
+			unsigned int count = end - i;
+			_vg_load_partial(&value, message.data + i, count, 'a');
+			_vg_load_partial(&shift, message.data + i - period, count, 'a');
+			shift -= 'a';
+
+			_vg_step(&value, &shift, &reflect, &invalid);
+			memcpy(dest + i, &value, count);
+		}
+
+		return !_vg_any(&invalid);
+	}
+
+	// The shifts of the first `period` letters of the range - from the primer, or the plaintext
+	// before the range.
+	unsigned char lead[VG_KEY_MAX];
+	const unsigned char *first = shifts + begin;
+
+	if (begin != 0) {
+		// Recovering the plaintext before the range - the last `period` letters of it are kept,
+		// each one at its position modulo the period.
+		unsigned char window[VG_KEY_MAX];
+		for (unsigned int j = 0; j < begin; j++) {
+			unsigned char step = (j < period) ? shifts[j] : (unsigned char) ('a' + BASE_MOD - window[j % period]);
+			unsigned char letter = (unsigned char) message.data[j] + step;
+
+			window[j % period] = (letter > 'z') ? (unsigned char) (letter - BASE_MOD) : letter;
+		}
+
+		for (unsigned int t = 0; t < period; t++)
+			lead[t] = (begin + t < period) ? shifts[begin + t] : (unsigned char) ('a' + BASE_MOD - window[(begin + t) % period]);
+
+		first = lead;
+	}
+
+	unsigned int split = (end - begin < period) ? end : begin + period;
+	_vg_apply(dest + begin, message.data + begin, first, split - begin, &reflect, &invalid);
+
+	// Every part only reads from the plaintext before it. A key shorter than a vector has its
+	// part of the plaintext kept in the lanes of a vector from one part to the next - reading it
+	// back from the result would wait on the store of the part just written.
+	unsigned int width = (period < VG_LANES) ? period : VG_LANES;
+
+	vg_lanes window = {0};
+	if (period < VG_LANES && split < end)
+		_vg_load_partial(&window, dest + split - period, period, 'a');
+
+	for (unsigned int i = split; i < end; i += width) {
+		unsigned int count = (end - i < width) ? end - i : width;
+		bool full = i + VG_LANES <= end;
+
+		if (full)
+			_vg_load(&value, message.data + i);
+		else
+			_vg_load_partial(&value, message.data + i, count, 'a');
+
+		if (period < VG_LANES)
+			shift = window;
+		else if (full)
+			_vg_load(&shift, dest + i - period);
+		else
+			_vg_load_partial(&shift, dest + i - period, count, 'a');
+
+		shift = ('a' + BASE_MOD) - shift;
+
+		_vg_step(&value, &shift, &reflect, &invalid);
+		window = value;
+
+		// Lanes past the part are written over by the parts after it.
+		memcpy(dest + i, &value, full ? VG_LANES : count);
+	}
+
+	return !_vg_any(&invalid);
+}
+
+/**
+ * The kernel of `_vg_run` - the same code, built for each instruction set.
+ */
+bool _vg_run_generic(
+	const struct vg_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+) {
+	return _vg_run(schedule, encrypt, dest, message, begin, end);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2"))) bool _vg_run_avx2(
+	const struct vg_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+) {
+	return _vg_run(schedule, encrypt, dest, message, begin, end);
+}
+
+__attribute__((target("avx512bw"))) bool _vg_run_avx512(
+	const struct vg_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+) {
+	return _vg_run(schedule, encrypt, dest, message, begin, end);
+}
+
+#endif
+
+/**
+ * The vector kernel built for an instruction set.
+ */
+struct vg_kernel {
+	enum isa isa;
+
+	bool (*run)(
+		const struct vg_schedule *schedule, bool encrypt, string dest, struct span message,
+		unsigned int begin, unsigned int end
+	);
+};
+
+// The kernels, best first - the last one runs anywhere.
+const struct vg_kernel vg_kernels[] = {
+#if defined(__x86_64__) || defined(__i386__)
+	{ ISA_AVX512, _vg_run_avx512 },
+	{ ISA_AVX2, _vg_run_avx2 },
+#endif
+	{ ISA_GENERIC, _vg_run_generic }
+};
+
+// The kernel in use - see `vg_select_kernel`.
+const struct vg_kernel *vg_kernel = &vg_kernels[sizeof(vg_kernels) / sizeof(vg_kernels[0]) - 1];
+
+/**
+ * Selects the vector kernel - the best one needing at most the instruction set given.
+ *
+ * @note
+ * 		Not thread-safe - meant to be called at startup (see `cpu_dispatch`).
+ *
+ * @param isa: The instruction set that can be used.
+ *
+ * @return
+ * 		The instruction set of the kernel selected.
+ */
+enum isa vg_select_kernel(enum isa isa) {
+	unsigned int i = 0;
+	while (vg_kernels[i].isa > isa)
+		i++;
+
+	vg_kernel = &vg_kernels[i];
+	return vg_kernel->isa;
+}
+
+/**
+ * Runs a cipher of the family with a prepared key, writing the result into a buffer owned
+ * by the caller.
+ *
+ * @remarks
+ * 		Does not touch any global state - safe to call from multiple threads sharing the
+ * 		same schedule. A null (or small) destination is left untouched and the size needed
+ * 		is returned. Nothing is padded - the result is as long as the message.
+ *
+ * @param schedule: Pointer to the key prepared using `vg_prepare`.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer in which the result is to be written. Can be the same as the message,
+ * 		except with autokey.
+ * @param dest_cap: Unsigned integer containing the capacity of the buffer, in characters.
+ * @param message: Span containing the message.
+ *
+ * @return
+ * 		Unsigned integer containing the length of the result, or `CIPHER_INVALID` if the
+ * 		message contains anything other than lower-case alphabets.
+ */
+unsigned int vg_run_into(
+	const struct vg_schedule *schedule, bool encrypt, string dest, unsigned int dest_cap, struct span message
+) {
+	if (dest == NULL || dest_cap <= message.length)
+		return message.length;
+
+	if (!vg_kernel->run(schedule, encrypt, dest, message, 0, message.length))
+		return CIPHER_INVALID;
+
+	dest[message.length] = '\0';
+	return message.length;
+}
+
+/**
+ * Runs a cipher of the family over a part of a message using a prepared key - writes the
+ * characters at positions `[begin, end)` of the result that `vg_run_into` would produce.
+ *
+ * @remarks
+ * 		Used to split a large message across threads - calls over disjoint ranges write to
+ * 		disjoint parts of the destination. Nothing is written outside of the range, not even
+ * 		a string terminator. The range can start anywhere - the key picks up at the right
+ * 		position. Decrypting autokey is the exception, where a range not starting at the
+ * 		beginning recovers all of the plaintext before it first (see `_vg_run`).
+ *
+ * @param schedule: Pointer to the key prepared using `vg_prepare`.
+ * @param encrypt: Boolean indicating if the message is to be encrypted (or decrypted).
+ * @param dest: Buffer for the complete result - the range is written at its own offsets.
+ * @param message: Span containing the complete message.
+ * @param begin: Unsigned integer containing the first position of the result to be written.
+ * @param end: Unsigned integer containing the position of the result to stop at.
+ *
+ * @return
+ * 		Boolean indicating if the range could be ciphered - false if it contains anything
+ * 		other than lower-case alphabets.
+ */
+bool vg_run_slice(
+	const struct vg_schedule *schedule, bool encrypt, string dest, struct span message,
+	unsigned int begin, unsigned int end
+) {
+	if (begin >= end)
+		return true;
+
+	return vg_kernel->run(schedule, encrypt, dest, message, begin, end);
+}
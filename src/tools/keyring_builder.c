@@ -0,0 +1,123 @@
+// Builds a keyring (see `keyring.h`) - prepares every key of a list once, and saves the
+// prepared keys (play-fair squares, hill matrices and their inverses, substitution tables,
+// columnar orders and so on) to a single file that the program maps instead of preparing
+// them on every run.
+//
+// The list holds one key per line, as `cipher:key` - `playfair:monarchy`, `affine:5 8`,
+// `rot13:`. Blank lines, and lines starting with `#`, are skipped. The id of a key is its
+// position in the list, counting from zero.
+//
+// Usage:
+// 	encryptor_keyring --keys=FILE --out=FILE
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "commons.h"
+#include "engine.h"
+#include "keyring.h"
+
+#define true 1
+#define false 0
+
+typedef short bool;
+typedef char *string;
+
+int main(int argc, string *argv) {
+	struct span keys_path = make_span(NULL, 0);
+	struct span output_path = make_span(NULL, 0);
+
+	for (int i = 1; i < argc; i++) {
+		struct span arg = span_of(argv[i]);
+
+		if (validate("^--keys=((.+))$", arg))
+			keys_path = extract_data("^--keys=((.+))$", arg);
+		else if (validate("^--out=((.+))$", arg))
+			output_path = extract_data("^--out=((.+))$", arg);
+		else {
+			printf("\nError: Unexpected argument detected `%.*s`\n", arg.length, arg.data);
+			exit(-10);
+		}
+	}
+
+	if (keys_path.data == NULL || output_path.data == NULL) {
+		printf("\nError: Both `--keys=FILE` and `--out=FILE` are needed\n");
+		exit(-10);
+	}
+
+	string path = gen_str(keys_path).data;
+	FILE *file = fopen(path, "rb");
+
+	if (file == NULL) {
+		printf("\nError: Could not open the list of keys `%s`\n", path);
+		exit(-10);
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	string contents = (string) malloc(size > 0 ? size : 1);
+	struct span list = make_span(contents, (unsigned int) fread(contents, sizeof(char), size > 0 ? size : 0, file));
+	fclose(file);
+
+	unsigned int count = 0, capacity = 64;
+	struct cipher_key *keys = (struct cipher_key *) malloc(capacity * sizeof(struct cipher_key));
+
+	for (unsigned int start = 0, end = 0, line = 1; start < list.length; start = end + 1, line++) {
+		for (end = start; end < list.length && list.data[end] != '\n'; end++);
+
+		struct span entry = make_span(list.data + start, end - start);
+		if (entry.length != 0 && entry.data[entry.length - 1] == '\r')
+			entry.length--;
+
+		if (entry.length == 0 || entry.data[0] == '#')
+			continue;
+
+		unsigned int colon = 0;
+		while (colon < entry.length && entry.data[colon] != ':')
+			colon++;
+
+		enum crypt cipher = (colon < entry.length) ? map_cipher(make_span(entry.data, colon)) : UNDEFINED;
+		if (cipher == UNDEFINED) {
+			printf("\nError: Line %u of `%s` should be `cipher:key`\n", line, path);
+			exit(-10);
+		}
+
+		if (count == capacity) {
+			capacity *= 2;
+			keys = (struct cipher_key *) realloc(keys, capacity * sizeof(struct cipher_key));
+		}
+
+		// Zeroed, so that the parts of the schedule a cipher does not use are the same in
+		// every keyring built from the same list.
+		memset(&keys[count], 0, sizeof(struct cipher_key));
+
+		struct span key = make_span(entry.data + colon + 1, entry.length - colon - 1);
+		if (!engine_prepare(&keys[count], cipher, key)) {
+			printf("\nError: Invalid key `%.*s` on line %u of `%s`\n", key.length, key.data, line, path);
+			exit(-10);
+		}
+
+		count++;
+	}
+
+	string output = gen_str(output_path).data;
+
+	if (!keyring_save(keys, count, output)) {
+		printf("\nError: Could not write the keyring to `%s`\n", output);
+		exit(-10);
+	}
+
+	printf("Prepared %u keys of `%s`, keyring written to `%s`\n", count, path, output);
+
+	free(keys);
+	free(contents);
+	free(output);
+	free(path);
+
+	return 0;
+}
@@ -0,0 +1,226 @@
+// A load generator for the daemon mode - sends the same request over and over to a
+// running `encryptor --serve=PATH`, keeping a number of requests in flight, and reports
+// the throughput along with the latency of the requests.
+//
+// Usage:
+// 	encryptor_load --socket=PATH [--requests=N] [--depth=D] [--cipher=NAME]
+// 		[--key=KEY | --key-id=N] [--message=TEXT] [--decrypt]
+//
+// With `--key-id`, the key is picked from the keyring the server was started with
+// (`--keyring`) - the cipher should match the one the key was prepared for.
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "commons.h"
+#include "protocol.h"
+
+#define true 1
+#define false 0
+
+typedef short bool;
+typedef char *string;
+
+/**
+ * Internal method to fetch a monotonic timestamp.
+ *
+ * @return
+ * 		Unsigned integer containing the current time, in nanoseconds.
+ */
+unsigned long long now_ns() {
+	struct timespec moment;
+	clock_gettime(CLOCK_MONOTONIC, &moment);
+	return (unsigned long long) moment.tv_sec * 1000000000ULL + moment.tv_nsec;
+}
+
+/**
+ * Internal method to read an exact number of characters from the socket.
+ *
+ * @param fd: File descriptor of the socket.
+ * @param dest: Buffer the characters are to be read into.
+ * @param length: Number of characters to be read.
+ */
+void read_exact(int fd, string dest, unsigned int length) {
+	while (length > 0) {
+		ssize_t count = read(fd, dest, length);
+		if (count <= 0) {
+			printf("\nError: The server closed the connection\n");
+			exit(-10);
+		}
+
+		dest += count;
+		length -= count;
+	}
+}
+
+/**
+ * Internal method to write an exact number of characters to the socket.
+ *
+ * @param fd: File descriptor of the socket.
+ * @param source: Buffer containing the characters.
+ * @param length: Number of characters to be written.
+ */
+void write_exact(int fd, const char *source, unsigned int length) {
+	while (length > 0) {
+		ssize_t count = write(fd, source, length);
+		if (count <= 0) {
+			printf("\nError: Could not write to the server\n");
+			exit(-10);
+		}
+
+		source += count;
+		length -= count;
+	}
+}
+
+/**
+ * Comparator to sort latencies in ascending order.
+ */
+int compare_latency(const void *first, const void *second) {
+	unsigned long long a = *(const unsigned long long *) first;
+	unsigned long long b = *(const unsigned long long *) second;
+	return (a > b) - (a < b);
+}
+
+int main(int argc, string *argv) {
+	struct span socket_path = make_span(NULL, 0);
+	struct span key = span_of("monarchy");
+	struct span message = span_of("instruments");
+	enum crypt cipher = PLAYFAIR;
+	unsigned int requests = 100000;
+	unsigned int depth = 16;
+	bool encrypt = true;
+
+	// Id of the key in the keyring of the server - sent instead of the key, if given.
+	bool by_id = false;
+	uint32_t key_id = 0;
+
+	for (int i = 1; i < argc; i++) {
+		struct span arg = span_of(argv[i]);
+
+		if (validate("^--socket=((.+))$", arg)) {
+			socket_path = extract_data("^--socket=((.+))$", arg);
+		} else if (validate("^--requests=(([1-9]\\d*))$", arg)) {
+			requests = strtoul(argv[i] + strlen("--requests="), NULL, 10);
+		} else if (validate("^--depth=(([1-9]\\d*))$", arg)) {
+			depth = strtoul(argv[i] + strlen("--depth="), NULL, 10);
+		} else if (validate("^--cipher=((.+))$", arg)) {
+			// Any cipher the server knows - see `map_cipher`.
+			cipher = map_cipher(extract_data("^--cipher=((.*))$", arg));
+
+			if (cipher == UNDEFINED) {
+				printf("\nError: Undefined cipher type detected `%.*s`\n", arg.length, arg.data);
+				exit(-10);
+			}
+		} else if (validate("^--key-id=((\\d{1,9}))$", arg)) {
+			by_id = true;
+			key_id = (uint32_t) strtoul(argv[i] + strlen("--key-id="), NULL, 10);
+		} else if (validate("^--key=$", arg)) {
+			// ROT13 and Atbash take no key.
+			key = span_of("");
+		} else if (validate("^--key=((.+))$", arg)) {
+			key = extract_data("^--key=((.+))$", arg);
+		} else if (validate("^--message=((.+))$", arg)) {
+			message = extract_data("^--message=((.+))$", arg);
+		} else if (validate("^--decrypt$", arg)) {
+			encrypt = false;
+		} else {
+			printf("\nError: Unexpected argument detected `%.*s`\n", arg.length, arg.data);
+			exit(-10);
+		}
+	}
+
+	struct sockaddr_un address = {0};
+	address.sun_family = AF_UNIX;
+
+	if (socket_path.data == NULL || socket_path.length >= sizeof(address.sun_path)) {
+		printf("\nError: A valid `--socket=PATH` is needed\n");
+		exit(-10);
+	}
+
+	memcpy(address.sun_path, socket_path.data, socket_path.length);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0 || connect(fd, (struct sockaddr *) &address, sizeof(address)) < 0) {
+		printf("\nError: Could not connect to `%s`\n", address.sun_path);
+		exit(-10);
+	}
+
+	// Building the request once - it is sent as-is every time.
+	if (by_id)
+		key = make_span((string) &key_id, sizeof(key_id));
+
+	struct frame_request header = {0};
+	header.length = key.length + message.length;
+	header.key_length = key.length;
+	header.cipher = cipher;
+	header.flags = (encrypt ? FRAME_ENCRYPT : 0) | (by_id ? FRAME_KEY_ID : 0);
+
+	unsigned int frame_length = sizeof(header) + header.length;
+	string frame = (string) malloc(frame_length);
+	memcpy(frame, &header, sizeof(header));
+	memcpy(frame + sizeof(header), key.data, key.length);
+	memcpy(frame + sizeof(header) + key.length, message.data, message.length);
+
+	// Time at which each request was sent, and the time it took to be answered.
+	unsigned long long *latency = (unsigned long long *) malloc(sizeof(unsigned long long) * requests);
+
+	string result = NULL;
+	unsigned int result_capacity = 0;
+	unsigned int failed = 0;
+
+	unsigned int sent = 0, received = 0;
+	unsigned long long started = now_ns();
+
+	while (received < requests) {
+		// Keeping the pipeline full.
+		while (sent < requests && sent - received < depth) {
+			latency[sent++] = now_ns();
+			write_exact(fd, frame, frame_length);
+		}
+
+		struct frame_response response;
+		read_exact(fd, (string) &response, sizeof(response));
+
+		if (response.length > result_capacity) {
+			result_capacity = response.length;
+			result = (string) realloc(result, result_capacity);
+		}
+
+		read_exact(fd, result, response.length);
+		latency[received] = now_ns() - latency[received];
+
+		if (response.status != FRAME_OK)
+			failed++;
+
+		if (received++ == 0) {
+			if (response.status == FRAME_OK)
+				printf("\nFirst result: %.*s\n", response.length, result);
+			else
+				printf("\nFirst request failed with status %d\n", response.status);
+		}
+	}
+
+	double elapsed = (now_ns() - started) / 1e9;
+	close(fd);
+
+	qsort(latency, requests, sizeof(unsigned long long), compare_latency);
+
+	printf("\nRequests: %u (%u failed), depth %u", requests, failed, depth);
+	printf("\nThroughput: %.0f requests/second", requests / elapsed);
+	printf(
+		"\nLatency (us): p50 %.1f, p99 %.1f, max %.1f\n\n",
+		latency[requests / 2] / 1e3,
+		latency[(unsigned long long) requests * 99 / 100] / 1e3,
+		latency[requests - 1] / 1e3
+	);
+
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+// Builds the n-gram tables used by the crack modes - counts every n-gram (of every length
+// up to `NGRAM_MAX`) in a text corpus, and saves the tables to a single file that the
+// crack modes map instead of counting the corpus on every run.
+//
+// Usage:
+// 	encryptor_ngrams --corpus=FILE --out=FILE
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "commons.h"
+#include "scoring.h"
+
+#define true 1
+#define false 0
+
+typedef short bool;
+typedef char *string;
+
+int main(int argc, string *argv) {
+	struct span corpus_path = make_span(NULL, 0);
+	struct span output_path = make_span(NULL, 0);
+
+	for (int i = 1; i < argc; i++) {
+		struct span arg = span_of(argv[i]);
+
+		if (validate("^--corpus=((.+))$", arg))
+			corpus_path = extract_data("^--corpus=((.+))$", arg);
+		else if (validate("^--out=((.+))$", arg))
+			output_path = extract_data("^--out=((.+))$", arg);
+		else {
+			printf("\nError: Unexpected argument detected `%.*s`\n", arg.length, arg.data);
+			exit(-10);
+		}
+	}
+
+	if (corpus_path.data == NULL || output_path.data == NULL) {
+		printf("\nError: Both `--corpus=FILE` and `--out=FILE` are needed\n");
+		exit(-10);
+	}
+
+	string path = gen_str(corpus_path).data;
+	FILE *file = fopen(path, "rb");
+
+	if (file == NULL) {
+		printf("\nError: Could not open the corpus `%s`\n", path);
+		exit(-10);
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	string contents = (string) malloc(size > 0 ? size : 1);
+	size_t length = fread(contents, sizeof(char), size > 0 ? size : 0, file);
+	fclose(file);
+
+	struct ngram_table tables[NGRAM_MAX];
+
+	for (unsigned int n = 1; n <= NGRAM_MAX; n++)
+		if (!ngram_build(&tables[n - 1], n, make_span(contents, (unsigned int) length))) {
+			printf("\nError: The corpus `%s` does not contain enough text\n", path);
+			exit(-10);
+		}
+
+	string output = gen_str(output_path).data;
+
+	if (!ngram_save(tables, NGRAM_MAX, output)) {
+		printf("\nError: Could not write the tables to `%s`\n", output);
+		exit(-10);
+	}
+
+	printf("Counted %zu characters of `%s`, tables written to `%s`\n", length, path, output);
+
+	for (unsigned int n = 1; n <= NGRAM_MAX; n++)
+		ngram_free(&tables[n - 1]);
+
+	free(contents);
+	free(output);
+	free(path);
+
+	return 0;
+}
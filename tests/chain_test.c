@@ -0,0 +1,76 @@
+// Round-trips messages through chains of ciphers (see `engine_chain_into`) - every chain
+// should give back the message it was handed (followed by the padding of the last block),
+// and chains that could not be undone should be refused as they are prepared.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "commons.h"
+#include "engine.h"
+
+#define true 1
+#define false 0
+
+/**
+ * Internal method to run a message through a chain and back.
+ *
+ * @return
+ * 		Boolean indicating if the message came back as it was.
+ */
+bool round_trip(const enum crypt *ciphers, unsigned int count, string keys, string message) {
+	struct cipher_chain chain;
+	if (!engine_prepare_chain(&chain, ciphers, count, span_of(keys))) {
+		printf("FAIL: Could not prepare the chain for `%s`\n", keys);
+		return false;
+	}
+
+	struct span text = span_of(message);
+	unsigned int size = engine_chain_into(&chain, true, NULL, 0, text);
+
+	string cipher = (string) malloc(size + 1);
+	string plain = (string) malloc(size + 1);
+
+	engine_chain_into(&chain, true, cipher, size + 1, text);
+	unsigned int length = engine_chain_into(&chain, false, plain, size + 1, make_span(cipher, size));
+
+	// Only the padding (`x`) can follow the message.
+	bool same = length == size && memcmp(plain, message, text.length) == 0;
+	for (unsigned int i = text.length; same && i < length; i++)
+		same = plain[i] == 'x';
+
+	if (!same)
+		printf("FAIL: `%s` came back as `%.*s` through `%s`\n", message, length, plain, keys);
+
+	free(cipher);
+	free(plain);
+
+	return same;
+}
+
+int main() {
+	unsigned int failures = 0;
+	string message = "meetmetomorrowatnoonpleasebringthemaps";
+
+	enum crypt first[] = {PLAYFAIR, VIGENERE, COLUMNAR};
+	failures += !round_trip(first, 3, "monarchy,lemon,zebras", message);
+
+	enum crypt fused[] = {PLAYFAIR, HILL_CIPHER, RAILFENCE, CAESAR};
+	failures += !round_trip(fused, 4, "monarchy,gybnqkurp,3,7", message);
+
+	enum crypt letters[] = {HILL_CIPHER, DOUBLE_COLUMNAR, ATBASH};
+	failures += !round_trip(letters, 3, "gybnqkurp,zebras cargo,", message);
+
+	// A stage before play-fair can write a `j`, which play-fair folds into `i`.
+	struct cipher_chain chain;
+	enum crypt folded[] = {VIGENERE, PLAYFAIR};
+	if (engine_prepare_chain(&chain, folded, 2, span_of("lemon,monarchy"))) {
+		printf("FAIL: Play-fair after another stage should be refused\n");
+		failures++;
+	}
+
+	if (failures == 0)
+		printf("All chains came back\n");
+
+	return failures == 0 ? 0 : 1;
+}